@@ -0,0 +1,123 @@
+#include "baseline.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace bench
+{
+	std::string Baseline::Entry::getKey() const
+	{
+		return scenario + '/' + std::to_string(static_cast<uint32_t>(samplerate)) + '/' + std::to_string(blockSize);
+	}
+
+	bool Baseline::load(const std::string& _filename)
+	{
+		m_romHash.clear();
+		m_entries.clear();
+
+		std::ifstream file(_filename, std::ios::in);
+		if(!file.is_open())
+			return false;
+
+		std::string line;
+
+		while(std::getline(file, line))
+		{
+			if(line.empty() || line.front() == '#')
+				continue;
+
+			std::stringstream ss(line);
+
+			std::string type;
+			ss >> type;
+
+			if(type == "rom")
+			{
+				ss >> m_romHash;
+			}
+			else if(type == "result")
+			{
+				Entry e;
+				ss >> e.scenario >> e.samplerate >> e.blockSize >> e.realtimeFactor >> e.p99Us;
+				if(ss.fail())
+					return false;
+				m_entries.push_back(e);
+			}
+		}
+
+		return true;
+	}
+
+	bool Baseline::save(const std::string& _filename) const
+	{
+		std::ofstream file(_filename, std::ios::out | std::ios::trunc);
+		if(!file.is_open())
+			return false;
+
+		file << "# gearmulatorBench performance baseline, only valid for the machine it has been recorded on" << '\n';
+		file << "# result <scenario> <samplerate> <blocksize> <realtime factor> <p99 block duration in us>" << '\n';
+		file << "rom " << m_romHash << '\n';
+
+		for (const auto& e : m_entries)
+			file << "result " << e.scenario << ' ' << e.samplerate << ' ' << e.blockSize << ' ' << e.realtimeFactor << ' ' << e.p99Us << '\n';
+
+		return file.good();
+	}
+
+	void Baseline::set(const std::string& _romHash, const std::vector<BenchRunner::Result>& _results)
+	{
+		m_romHash = _romHash;
+		m_entries.clear();
+
+		for (const auto& r : _results)
+			m_entries.push_back(toEntry(r));
+	}
+
+	std::vector<Baseline::Regression> Baseline::compare(const std::vector<BenchRunner::Result>& _results, const double _tolerance, std::vector<std::string>& _missing) const
+	{
+		std::vector<Regression> regressions;
+
+		for (const auto& r : _results)
+		{
+			const auto current = toEntry(r);
+			const auto key = current.getKey();
+
+			const auto* base = find(key);
+
+			if(!base)
+			{
+				_missing.push_back(key);
+				continue;
+			}
+
+			if(current.realtimeFactor < base->realtimeFactor * (1.0 - _tolerance))
+				regressions.push_back({key, "realtimeFactor", base->realtimeFactor, current.realtimeFactor});
+
+			if(current.p99Us > base->p99Us * (1.0 + _tolerance))
+				regressions.push_back({key, "p99Us", base->p99Us, current.p99Us});
+		}
+
+		return regressions;
+	}
+
+	Baseline::Entry Baseline::toEntry(const BenchRunner::Result& _result)
+	{
+		Entry e;
+		e.scenario = _result.scenario;
+		e.samplerate = _result.samplerate;
+		e.blockSize = _result.blockSize;
+		e.realtimeFactor = _result.realtimeFactor;
+		e.p99Us = _result.p99Us;
+		return e;
+	}
+
+	const Baseline::Entry* Baseline::find(const std::string& _key) const
+	{
+		for (const auto& e : m_entries)
+		{
+			if(e.getKey() == _key)
+				return &e;
+		}
+		return nullptr;
+	}
+}
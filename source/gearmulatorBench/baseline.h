@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "benchRunner.h"
+
+namespace bench
+{
+	// Stores the results of a benchmark run to be able to detect performance regressions in later runs on the same
+	// machine. Results are only comparable for the same machine and ROM, which is why baselines are stored per machine
+	// and include the ROM hash
+	class Baseline
+	{
+	public:
+		struct Entry
+		{
+			std::string scenario;
+			float samplerate = 0.0f;
+			uint32_t blockSize = 0;
+
+			double realtimeFactor = 0.0;
+			double p99Us = 0.0;
+
+			std::string getKey() const;
+		};
+
+		struct Regression
+		{
+			std::string key;
+			std::string metric;
+			double baseline = 0.0;
+			double current = 0.0;
+		};
+
+		bool load(const std::string& _filename);
+		bool save(const std::string& _filename) const;
+
+		void set(const std::string& _romHash, const std::vector<BenchRunner::Result>& _results);
+
+		// Compares results against the baseline. A result regresses if its realtime factor drops or its p99 block
+		// duration increases by more than the given tolerance, 0.1 = 10%. Results without baseline are returned in _missing
+		std::vector<Regression> compare(const std::vector<BenchRunner::Result>& _results, double _tolerance, std::vector<std::string>& _missing) const;
+
+		const std::string& getRomHash() const { return m_romHash; }
+		bool empty() const { return m_entries.empty(); }
+
+		static Entry toEntry(const BenchRunner::Result& _result);
+
+	private:
+		const Entry* find(const std::string& _key) const;
+
+		std::string m_romHash;
+		std::vector<Entry> m_entries;
+	};
+}
@@ -0,0 +1,299 @@
+#include "benchRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "jsonWriter.h"
+#include "scenarios.h"
+
+#include "../synthLib/deviceException.h"
+#include "../synthLib/plugin.h"
+
+#include "../virusLib/device.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bench
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		double toSeconds(const Clock::duration& _d)
+		{
+			return std::chrono::duration<double>(_d).count();
+		}
+
+		double percentile(const std::vector<double>& _sorted, const double _p)
+		{
+			if(_sorted.empty())
+				return 0.0;
+			const auto index = static_cast<size_t>(_p * static_cast<double>(_sorted.size() - 1) + 0.5);
+			return _sorted[std::min(index, _sorted.size() - 1)];
+		}
+	}
+
+	BenchRunner::BenchRunner(virusLib::ROMFile _rom, Config _config) : m_rom(std::move(_rom)), m_config(std::move(_config))
+	{
+	}
+
+	BenchRunner::~BenchRunner()
+	{
+		m_plugin.reset();
+		m_device.reset();
+	}
+
+	bool BenchRunner::boot()
+	{
+		const auto hostSamplerate = m_config.samplerates.empty() ? 0.0f : m_config.samplerates.front();
+
+		const auto start = Clock::now();
+
+		try
+		{
+			m_device.reset(new virusLib::Device(m_rom, 0.0f, hostSamplerate));
+		}
+		catch(const synthLib::DeviceException& _e)
+		{
+			std::cout << "Failed to boot device: " << _e.what() << std::endl;
+			return false;
+		}
+
+		m_bootSeconds = toSeconds(Clock::now() - start);
+
+		if(!m_device->isValid())
+		{
+			std::cout << "Device is not valid after boot" << std::endl;
+			return false;
+		}
+
+		m_plugin.reset(new synthLib::Plugin(m_device.get()));
+
+		return true;
+	}
+
+	bool BenchRunner::run()
+	{
+		if(!m_plugin && !boot())
+			return false;
+
+		for (const auto& name : m_config.scenarios)
+		{
+			Scenario scenario;
+
+			if(!createScenario(scenario, name, m_config.seconds))
+			{
+				std::cout << "Unknown scenario '" << name << "'" << std::endl;
+				return false;
+			}
+
+			for (const auto samplerate : m_config.samplerates)
+			{
+				for (const auto blockSize : m_config.blockSizes)
+				{
+					Result result;
+
+					if(!runScenario(result, scenario, samplerate, blockSize))
+						return false;
+
+					std::cout << "Scenario " << result.scenario << ", " << samplerate << " Hz, block size " << blockSize << ": " <<
+						"realtime factor " << result.realtimeFactor << ", p50 " << result.p50Us << " us, p99 " << result.p99Us << " us, max " << result.maxUs << " us" << std::endl;
+
+					m_results.push_back(std::move(result));
+				}
+			}
+		}
+		return true;
+	}
+
+	bool BenchRunner::runScenario(Result& _result, const Scenario& _scenario, const float _samplerate, const uint32_t _blockSize)
+	{
+		if(!_blockSize || _samplerate <= 0.0f)
+		{
+			std::cout << "Invalid block size " << _blockSize << " or samplerate " << _samplerate << std::endl;
+			return false;
+		}
+
+		m_plugin->setHostSamplerate(_samplerate, 0.0f);
+		m_plugin->setBlockSize(_blockSize);
+
+		m_outputBuffers.resize(2);
+		for (auto& b : m_outputBuffers)
+			b.resize(_blockSize);
+
+		// silence everything that the previous run left playing and let the resampler and the DSP settle
+		m_plugin->addMidiEvent(synthLib::SMidiEvent(synthLib::M_CONTROLCHANGE, synthLib::M_ALLNOTESOFF, 0));
+		render(nullptr, m_config.warmupSeconds, _blockSize, _samplerate, nullptr);
+
+		std::vector<double> durations;
+		durations.reserve(static_cast<size_t>(m_config.seconds * _samplerate / _blockSize) + 1);
+
+		synthLib::PerfCounters::reset();
+
+		render(&_scenario, m_config.seconds, _blockSize, _samplerate, &durations);
+
+		synthLib::PerfCounters::getSnapshot(_result.perfCounters);
+
+		_result.scenario = _scenario.name;
+		_result.samplerate = _samplerate;
+		_result.blockSize = _blockSize;
+		_result.blockCount = durations.size();
+		_result.renderedSeconds = static_cast<double>(durations.size()) * _blockSize / _samplerate;
+		_result.blockDeadlineUs = 1000000.0 * _blockSize / _samplerate;
+
+		for (const auto d : durations)
+		{
+			_result.wallSeconds += d;
+			if(d * 1000000.0 > _result.blockDeadlineUs)
+				++_result.overrunCount;
+		}
+
+		_result.realtimeFactor = _result.wallSeconds > 0.0 ? _result.renderedSeconds / _result.wallSeconds : 0.0;
+
+		std::sort(durations.begin(), durations.end());
+
+		_result.p50Us = percentile(durations, 0.5) * 1000000.0;
+		_result.p99Us = percentile(durations, 0.99) * 1000000.0;
+		_result.maxUs = durations.empty() ? 0.0 : durations.back() * 1000000.0;
+
+		return true;
+	}
+
+	void BenchRunner::render(const Scenario* _scenario, const double _seconds, const uint32_t _blockSize, const float _samplerate, std::vector<double>* _blockDurations)
+	{
+		const auto totalSamples = static_cast<uint64_t>(_seconds * static_cast<double>(_samplerate));
+
+		synthLib::TAudioInputs inputs{};
+		synthLib::TAudioOutputs outputs{};
+
+		for(size_t i=0; i<m_outputBuffers.size(); ++i)
+			outputs[i] = m_outputBuffers[i].data();
+
+		std::vector<synthLib::SMidiEvent> midiOut;
+
+		size_t nextEvent = 0;
+
+		for(uint64_t pos = 0; pos < totalSamples; pos += _blockSize)
+		{
+			if(_scenario)
+			{
+				const auto& events = _scenario->events;
+
+				while(nextEvent < events.size())
+				{
+					const auto& e = events[nextEvent];
+					const auto samplePos = static_cast<uint64_t>(e.time * static_cast<double>(_samplerate));
+
+					if(samplePos >= pos + _blockSize)
+						break;
+
+					auto ev = e.event;
+					ev.offset = samplePos > pos ? static_cast<uint32_t>(samplePos - pos) : 0;
+					m_plugin->addMidiEvent(ev);
+
+					++nextEvent;
+				}
+			}
+
+			const auto start = Clock::now();
+
+			m_plugin->process(inputs, outputs, _blockSize, 0.0f, 0.0f, false);
+
+			if(_blockDurations)
+				_blockDurations->push_back(toSeconds(Clock::now() - start));
+
+			m_plugin->getMidiOut(midiOut);
+		}
+	}
+
+	void BenchRunner::writeJson(JsonWriter& _writer) const
+	{
+		_writer.beginObject("rom");
+		_writer.add("filename", m_rom.getFilename());
+		_writer.add("model", m_rom.getModelName());
+		_writer.add("hash", m_rom.getHash().toString());
+		_writer.endObject();
+
+		_writer.beginObject("system");
+		_writer.add("hardwareThreads", std::thread::hardware_concurrency());
+		_writer.endObject();
+
+		_writer.beginObject("config");
+		_writer.add("seconds", m_config.seconds);
+		_writer.add("warmupSeconds", m_config.warmupSeconds);
+		_writer.endObject();
+
+		_writer.add("bootSeconds", m_bootSeconds);
+		_writer.add("deviceSamplerate", static_cast<double>(m_device ? m_device->getSamplerate() : 0.0f));
+		_writer.add("peakMemoryBytes", static_cast<uint64_t>(getPeakMemoryUsage()));
+
+		_writer.beginArray("results");
+
+		for (const auto& r : m_results)
+		{
+			_writer.beginObject();
+			_writer.add("scenario", r.scenario);
+			_writer.add("samplerate", static_cast<double>(r.samplerate));
+			_writer.add("blockSize", r.blockSize);
+			_writer.add("blockCount", r.blockCount);
+			_writer.add("renderedSeconds", r.renderedSeconds);
+			_writer.add("wallSeconds", r.wallSeconds);
+			_writer.add("realtimeFactor", r.realtimeFactor);
+			_writer.add("blockDeadlineUs", r.blockDeadlineUs);
+			_writer.add("p50Us", r.p50Us);
+			_writer.add("p99Us", r.p99Us);
+			_writer.add("maxUs", r.maxUs);
+			_writer.add("overruns", r.overrunCount);
+
+			if constexpr (synthLib::PerfCounters::Enabled)
+			{
+				_writer.beginObject("perfCounters");
+
+				for(size_t i=0; i<r.perfCounters.values.size(); ++i)
+				{
+					const auto& v = r.perfCounters.values[i];
+
+					_writer.beginObject(synthLib::PerfCounters::getName(static_cast<synthLib::PerfCounterId>(i)));
+					_writer.add("count", v.count);
+					_writer.add("total", v.total);
+					_writer.add("max", v.max);
+					_writer.add("last", v.last);
+					_writer.endObject();
+				}
+
+				_writer.endObject();
+			}
+
+			_writer.endObject();
+		}
+
+		_writer.endArray();
+	}
+
+	size_t BenchRunner::getPeakMemoryUsage()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+		return counters.PeakWorkingSetSize;
+#else
+		rusage usage{};
+		if(getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+#ifdef __APPLE__
+		return static_cast<size_t>(usage.ru_maxrss);			// bytes
+#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;	// kilobytes
+#endif
+#endif
+	}
+}
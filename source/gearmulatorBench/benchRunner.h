@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../synthLib/perfCounters.h"
+
+#include "../virusLib/romfile.h"
+
+namespace synthLib
+{
+	class Plugin;
+}
+
+namespace virusLib
+{
+	class Device;
+}
+
+namespace bench
+{
+	class JsonWriter;
+	struct Scenario;
+
+	class BenchRunner
+	{
+	public:
+		struct Config
+		{
+			std::vector<uint32_t> blockSizes{64, 256, 1024};
+			std::vector<float> samplerates{44100.0f, 48000.0f};
+			std::vector<std::string> scenarios;
+			double seconds = 10.0;			// measured duration per scenario, in seconds of rendered audio
+			double warmupSeconds = 1.0;		// rendered before measuring, not part of the result
+		};
+
+		struct Result
+		{
+			std::string scenario;
+			float samplerate = 0.0f;
+			uint32_t blockSize = 0;
+
+			uint64_t blockCount = 0;
+			uint64_t overrunCount = 0;		// number of blocks that took longer than their duration in realtime
+			double renderedSeconds = 0.0;
+			double wallSeconds = 0.0;
+			double realtimeFactor = 0.0;	// rendered / wall time, values above 1 are faster than realtime
+
+			// per block process() duration in microseconds
+			double blockDeadlineUs = 0.0;
+			double p50Us = 0.0;
+			double p99Us = 0.0;
+			double maxUs = 0.0;
+
+			synthLib::PerfCounterSnapshot perfCounters;
+		};
+
+		BenchRunner(virusLib::ROMFile _rom, Config _config);
+		~BenchRunner();
+
+		bool boot();
+		bool run();
+
+		void writeJson(JsonWriter& _writer) const;
+
+		double getBootSeconds() const { return m_bootSeconds; }
+		const std::vector<Result>& getResults() const { return m_results; }
+
+		static size_t getPeakMemoryUsage();
+
+	private:
+		bool runScenario(Result& _result, const Scenario& _scenario, float _samplerate, uint32_t _blockSize);
+		void render(const Scenario* _scenario, double _seconds, uint32_t _blockSize, float _samplerate, std::vector<double>* _blockDurations);
+
+		const virusLib::ROMFile m_rom;
+		const Config m_config;
+
+		std::unique_ptr<virusLib::Device> m_device;
+		std::unique_ptr<synthLib::Plugin> m_plugin;
+
+		double m_bootSeconds = 0.0;
+		std::vector<Result> m_results;
+
+		std::vector<std::vector<float>> m_outputBuffers;
+	};
+}
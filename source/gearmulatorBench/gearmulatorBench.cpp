@@ -0,0 +1,210 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "baseline.h"
+#include "benchRunner.h"
+#include "jsonWriter.h"
+#include "scenarios.h"
+
+#include "../synthLib/tracer.h"
+
+#include "../virusLib/romloader.h"
+
+#include "../dsp56300/source/disassemble/commandline.h"
+
+namespace
+{
+	// same default as the performance test in CMakeLists.txt
+	constexpr double g_defaultTolerance = 0.15;
+
+	// returned if there is nothing to compare with, the performance test reports itself as skipped in this case
+	constexpr int g_exitCodeNoBaseline = 2;
+
+	std::vector<std::string> split(const std::string& _s)
+	{
+		std::vector<std::string> res;
+		std::stringstream ss(_s);
+		std::string item;
+		while(std::getline(ss, item, ','))
+		{
+			if(!item.empty())
+				res.push_back(item);
+		}
+		return res;
+	}
+
+	int checkBaseline(const CommandLine& _cmd, const bench::BenchRunner& _runner, const virusLib::ROMFile& _rom)
+	{
+		const auto filename = _cmd.get("baseline");
+		const auto romHash = _rom.getHash().toString();
+		const auto tolerance = _cmd.contains("tolerance") ? std::stod(_cmd.get("tolerance")) : g_defaultTolerance;
+
+		bench::Baseline baseline;
+
+		if(_cmd.contains("updatebaseline"))
+		{
+			baseline.set(romHash, _runner.getResults());
+
+			if(!baseline.save(filename))
+			{
+				std::cout << "Failed to write baseline " << filename << std::endl;
+				return -1;
+			}
+			std::cout << "Baseline written to " << filename << std::endl;
+			return 0;
+		}
+
+		// a run without a baseline has nothing to compare with, recording one silently would let every run pass
+		if(!baseline.load(filename) || baseline.empty())
+		{
+			std::cout << "No performance baseline found at " << filename << ", run with -updatebaseline to record one" << std::endl;
+			return g_exitCodeNoBaseline;
+		}
+
+		if(baseline.getRomHash() != romHash)
+		{
+			std::cout << "Baseline " << filename << " has been recorded with a different ROM, run with -updatebaseline to replace it" << std::endl;
+			return -1;
+		}
+
+		std::vector<std::string> missing;
+		const auto regressions = baseline.compare(_runner.getResults(), tolerance, missing);
+
+		for (const auto& m : missing)
+			std::cout << "No baseline for " << m << ", run with -updatebaseline to add it" << std::endl;
+
+		for (const auto& r : regressions)
+		{
+			const auto percent = r.baseline > 0.0 ? (r.current / r.baseline - 1.0) * 100.0 : 0.0;
+			std::cout << "Performance regression in " << r.key << ": " << r.metric << " " << r.baseline << " => " << r.current << " (" << (percent >= 0.0 ? "+" : "") << percent << "%)" << std::endl;
+		}
+
+		if(!regressions.empty())
+		{
+			std::cout << regressions.size() << " performance regressions beyond tolerance of " << tolerance * 100.0 << "%" << std::endl;
+			return -1;
+		}
+
+		std::cout << "No performance regressions compared to baseline " << filename << std::endl;
+		return 0;
+	}
+
+	void printUsage()
+	{
+		std::cout << "Usage: gearmulatorBench [-rom file] [-scenarios a,b,...] [-blocksizes 64,256,...] [-samplerates 44100,48000,...] [-seconds n] [-warmup n] [-json file] [-trace file] [-baseline file [-tolerance " << g_defaultTolerance << "] [-updatebaseline]]" << std::endl;
+		std::cout << "Available scenarios:";
+		for (const auto& name : bench::getScenarioNames())
+			std::cout << ' ' << name;
+		std::cout << std::endl;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	try
+	{
+		const CommandLine cmd(_argc, _argv);
+
+		if(cmd.contains("help"))
+		{
+			printUsage();
+			return 0;
+		}
+
+		bench::BenchRunner::Config config;
+
+		config.scenarios = cmd.contains("scenarios") ? split(cmd.get("scenarios")) : bench::getScenarioNames();
+
+		if(cmd.contains("blocksizes"))
+		{
+			config.blockSizes.clear();
+			for (const auto& s : split(cmd.get("blocksizes")))
+				config.blockSizes.push_back(static_cast<uint32_t>(std::stoul(s)));
+		}
+
+		if(cmd.contains("samplerates"))
+		{
+			config.samplerates.clear();
+			for (const auto& s : split(cmd.get("samplerates")))
+				config.samplerates.push_back(std::stof(s));
+		}
+
+		if(cmd.contains("seconds"))
+			config.seconds = std::stod(cmd.get("seconds"));
+		if(cmd.contains("warmup"))
+			config.warmupSeconds = std::stod(cmd.get("warmup"));
+
+		if(config.blockSizes.empty() || config.samplerates.empty() || config.scenarios.empty() || config.seconds <= 0.0)
+		{
+			printUsage();
+			return -1;
+		}
+
+		const auto rom = cmd.contains("rom") ? virusLib::ROMLoader::findROM(cmd.get("rom")) : virusLib::ROMLoader::findROM();
+
+		if(!rom.isValid())
+		{
+			std::cout << "Failed to find a valid ROM" << std::endl;
+			return -1;
+		}
+
+		bench::BenchRunner runner(rom, config);
+
+		if(!runner.boot())
+			return -1;
+
+		std::cout << "Device booted in " << runner.getBootSeconds() << " seconds" << std::endl;
+
+		const bool trace = cmd.contains("trace");
+
+		if(trace)
+			synthLib::Tracer::start();
+
+		if(!runner.run())
+			return -1;
+
+		if(trace)
+		{
+			synthLib::Tracer::stop();
+
+			const auto filename = cmd.get("trace");
+			if(!synthLib::Tracer::writeFile(filename))
+				std::cout << "Failed to write trace file " << filename << std::endl;
+		}
+
+		auto writeJson = [&runner](std::ostream& _out)
+		{
+			bench::JsonWriter writer(_out);
+			writer.beginObject();
+			runner.writeJson(writer);
+			writer.endObject();
+		};
+
+		if(cmd.contains("json"))
+		{
+			const auto filename = cmd.get("json");
+			std::ofstream out(filename, std::ios::out | std::ios::trunc);
+			if(!out.is_open())
+			{
+				std::cout << "Failed to create output file " << filename << std::endl;
+				return -1;
+			}
+			writeJson(out);
+		}
+		else
+		{
+			writeJson(std::cout);
+		}
+
+		if(cmd.contains("baseline"))
+			return checkBaseline(cmd, runner, rom);
+
+		return 0;
+	}
+	catch(const std::exception& _e)
+	{
+		std::cout << _e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,134 @@
+#include "jsonWriter.h"
+
+#include <cmath>
+#include <iomanip>
+
+namespace bench
+{
+	JsonWriter::~JsonWriter()
+	{
+		m_out << std::endl;
+	}
+
+	void JsonWriter::beginObject(const char* _key)
+	{
+		begin(_key, '{');
+	}
+
+	void JsonWriter::endObject()
+	{
+		end('}');
+	}
+
+	void JsonWriter::beginArray(const char* _key)
+	{
+		begin(_key, '[');
+	}
+
+	void JsonWriter::endArray()
+	{
+		end(']');
+	}
+
+	void JsonWriter::add(const char* _key, const std::string& _value)
+	{
+		writeKey(_key);
+		writeString(_value);
+	}
+
+	void JsonWriter::add(const char* _key, const char* _value)
+	{
+		add(_key, std::string(_value));
+	}
+
+	void JsonWriter::add(const char* _key, const double _value)
+	{
+		writeKey(_key);
+
+		// JSON has no representation for inf/nan
+		if(!std::isfinite(_value))
+			m_out << "null";
+		else
+			m_out << std::setprecision(6) << _value;
+	}
+
+	void JsonWriter::add(const char* _key, const uint64_t _value)
+	{
+		writeKey(_key);
+		m_out << _value;
+	}
+
+	void JsonWriter::add(const char* _key, const bool _value)
+	{
+		writeKey(_key);
+		m_out << (_value ? "true" : "false");
+	}
+
+	void JsonWriter::begin(const char* _key, const char _bracket)
+	{
+		if(!m_hasElements.empty())
+			writeKey(_key);
+
+		m_out << _bracket;
+		m_hasElements.push_back(false);
+	}
+
+	void JsonWriter::end(const char _bracket)
+	{
+		const bool hasElements = m_hasElements.back();
+		m_hasElements.pop_back();
+
+		if(hasElements)
+		{
+			m_out << '\n';
+			indent();
+		}
+		m_out << _bracket;
+	}
+
+	void JsonWriter::writeKey(const char* _key)
+	{
+		if(m_hasElements.back())
+			m_out << ',';
+		m_hasElements.back() = true;
+
+		m_out << '\n';
+		indent();
+
+		if(_key)
+		{
+			writeString(_key);
+			m_out << ": ";
+		}
+	}
+
+	void JsonWriter::writeString(const std::string& _s) const
+	{
+		m_out << '"';
+
+		for (const char c : _s)
+		{
+			switch (c)
+			{
+			case '"':	m_out << "\\\""; break;
+			case '\\':	m_out << "\\\\"; break;
+			case '\n':	m_out << "\\n"; break;
+			case '\r':	m_out << "\\r"; break;
+			case '\t':	m_out << "\\t"; break;
+			default:
+				if(static_cast<unsigned char>(c) < 0x20)
+					m_out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+				else
+					m_out << c;
+			}
+		}
+
+		m_out << '"';
+	}
+
+	void JsonWriter::indent() const
+	{
+		for(size_t i=0; i<m_hasElements.size(); ++i)
+			m_out << '\t';
+	}
+}
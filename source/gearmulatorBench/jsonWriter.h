@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+	// Minimal streaming JSON writer. Keys are only allowed inside of objects, values inside of arrays are written
+	// without key by passing nullptr
+	class JsonWriter
+	{
+	public:
+		explicit JsonWriter(std::ostream& _out) : m_out(_out) {}
+		~JsonWriter();
+
+		void beginObject(const char* _key = nullptr);
+		void endObject();
+
+		void beginArray(const char* _key = nullptr);
+		void endArray();
+
+		void add(const char* _key, const std::string& _value);
+		void add(const char* _key, const char* _value);
+		void add(const char* _key, double _value);
+		void add(const char* _key, uint64_t _value);
+		void add(const char* _key, uint32_t _value) { add(_key, static_cast<uint64_t>(_value)); }
+		void add(const char* _key, bool _value);
+
+	private:
+		void begin(const char* _key, char _bracket);
+		void end(char _bracket);
+		void writeKey(const char* _key);
+		void writeString(const std::string& _s) const;
+		void indent() const;
+
+		std::ostream& m_out;
+		std::vector<bool> m_hasElements;	// one entry per open object/array
+	};
+}
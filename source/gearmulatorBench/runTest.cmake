@@ -0,0 +1,44 @@
+include(${CMAKE_CURRENT_LIST_DIR}/../../scripts/rclone.cmake)
+
+set(TEST_DATA_DIR integrationTestsData)
+
+if(EXISTS ${RCLONE_CONF})
+	copyDataFrom("integrationtests" ${TEST_DATA_DIR})
+
+	file(GLOB_RECURSE ROM_FILES ${TEST_DATA_DIR}/*.bin)
+
+	if(NOT ROM_FILES)
+		message(FATAL_ERROR "No ROM found in ${TEST_DATA_DIR}, unable to run performance tests")
+	endif()
+
+	list(GET ROM_FILES 0 ROM_FILE)
+
+	# results are only comparable on the same machine, each machine gets its own baseline
+	cmake_host_system_information(RESULT HOST_NAME QUERY HOSTNAME)
+	file(MAKE_DIRECTORY ${BASELINE_DIR})
+	set(BASELINE_FILE ${BASELINE_DIR}/${HOST_NAME}.txt)
+
+	if(UPDATE_BASELINE)
+		set(UPDATE_BASELINE_ARG -updatebaseline)
+	endif()
+
+	execute_process(COMMAND ${TEST_RUNNER}
+		-rom ${ROM_FILE}
+		-scenarios idle,polyphony,controllers
+		-blocksizes 64,512
+		-samplerates 44100
+		-seconds 10
+		-json ${ROOT_DIR}/virusPerformanceTests.json
+		-baseline ${BASELINE_FILE}
+		-tolerance ${TOLERANCE}
+		${UPDATE_BASELINE_ARG}
+		COMMAND_ECHO STDOUT RESULT_VARIABLE TEST_RESULT)
+	# 2 = no baseline recorded for this machine yet
+	if(TEST_RESULT EQUAL 2)
+		message("Performance test skipped: no baseline at ${BASELINE_FILE}, enable the PERF_UPDATE_BASELINE option to record one")
+	elseif(TEST_RESULT)
+		message(FATAL_ERROR "Performance test failed: " ${TEST_RESULT})
+	endif()
+else()
+	message(FATAL_ERROR "rclone.conf not found at ${RCLONE_CONF}, unable to run performance tests")
+endif()
@@ -0,0 +1,143 @@
+#include "scenarios.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bench
+{
+	namespace
+	{
+		constexpr uint8_t g_velocity = 100;
+
+		void noteOn(Scenario& _s, const double _time, const uint8_t _note)
+		{
+			_s.events.push_back({_time, synthLib::SMidiEvent(synthLib::M_NOTEON, _note, g_velocity)});
+		}
+
+		void noteOff(Scenario& _s, const double _time, const uint8_t _note)
+		{
+			_s.events.push_back({_time, synthLib::SMidiEvent(synthLib::M_NOTEOFF, _note, 0)});
+		}
+
+		void controlChange(Scenario& _s, const double _time, const uint8_t _cc, const uint8_t _value)
+		{
+			_s.events.push_back({_time, synthLib::SMidiEvent(synthLib::M_CONTROLCHANGE, _cc, _value)});
+		}
+
+		void createIdle(Scenario&, double)
+		{
+			// no events, measures the base load of the DSP emulation
+		}
+
+		void createNotes(Scenario& _s, const double _length)
+		{
+			constexpr uint8_t notes[] = {48, 52, 55, 60, 64, 67, 72, 67, 64, 60, 55, 52};
+
+			size_t i = 0;
+			for(double t = 0.0; t < _length; t += 0.25, ++i)
+			{
+				const auto note = notes[i % std::size(notes)];
+				noteOn(_s, t, note);
+				noteOff(_s, t + 0.125, note);
+			}
+		}
+
+		void createChords(Scenario& _s, const double _length)
+		{
+			constexpr uint8_t roots[] = {48, 53, 55, 50};
+			constexpr uint8_t intervals[] = {0, 4, 7, 11};
+
+			size_t i = 0;
+			for(double t = 0.0; t < _length; t += 0.5, ++i)
+			{
+				const auto root = roots[i % std::size(roots)];
+
+				for (const auto interval : intervals)
+				{
+					noteOn(_s, t, static_cast<uint8_t>(root + interval));
+					noteOff(_s, t + 0.45, static_cast<uint8_t>(root + interval));
+				}
+			}
+		}
+
+		void createPolyphony(Scenario& _s, const double _length)
+		{
+			// hold 16 notes for the whole scenario, staggered a bit to avoid that all voices start in the same block
+			for(uint8_t i=0; i<16; ++i)
+			{
+				const auto note = static_cast<uint8_t>(36 + i * 3);
+				noteOn(_s, i * 0.01, note);
+				noteOff(_s, _length, note);
+			}
+		}
+
+		void createControllers(Scenario& _s, const double _length)
+		{
+			constexpr uint8_t notes[] = {48, 55, 60, 64};
+
+			for (const auto note : notes)
+				noteOn(_s, 0.0, note);
+
+			// sweep modwheel and pitch bend every 5 ms to stress the MIDI path
+			for(double t = 0.0; t < _length; t += 0.005)
+			{
+				const auto phase = std::sin(t * 2.0 * 3.14159265358979);
+				const auto value = static_cast<uint8_t>(std::clamp(64.0 + phase * 63.0, 0.0, 127.0));
+
+				controlChange(_s, t, synthLib::MC_MODULATION, value);
+
+				const auto bend = static_cast<uint16_t>(std::clamp(8192.0 + phase * 4096.0, 0.0, 16383.0));
+				_s.events.push_back({t, synthLib::SMidiEvent(synthLib::M_PITCHBEND, bend & 0x7f, (bend >> 7) & 0x7f)});
+			}
+
+			for (const auto note : notes)
+				noteOff(_s, _length, note);
+		}
+
+		struct ScenarioDefinition
+		{
+			const char* name;
+			const char* description;
+			void (*create)(Scenario&, double);
+		};
+
+		constexpr ScenarioDefinition g_scenarios[] =
+		{
+			{"idle",		"No MIDI input",											&createIdle},
+			{"notes",		"Monophonic note sequence, 4 notes per second",			&createNotes},
+			{"chords",		"Four note chords, two chords per second",				&createChords},
+			{"polyphony",	"16 notes held for the whole duration",					&createPolyphony},
+			{"controllers",	"Held chord with modwheel and pitch bend every 5 ms",	&createControllers},
+		};
+	}
+
+	std::vector<std::string> getScenarioNames()
+	{
+		std::vector<std::string> names;
+		for (const auto& s : g_scenarios)
+			names.emplace_back(s.name);
+		return names;
+	}
+
+	bool createScenario(Scenario& _scenario, const std::string& _name, const double _lengthSeconds)
+	{
+		for (const auto& s : g_scenarios)
+		{
+			if(_name != s.name)
+				continue;
+
+			_scenario.name = s.name;
+			_scenario.description = s.description;
+			_scenario.events.clear();
+
+			s.create(_scenario, _lengthSeconds);
+
+			std::stable_sort(_scenario.events.begin(), _scenario.events.end(), [](const TimedMidiEvent& _a, const TimedMidiEvent& _b)
+			{
+				return _a.time < _b.time;
+			});
+			return true;
+		}
+		return false;
+	}
+}
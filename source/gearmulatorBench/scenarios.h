@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../synthLib/midiTypes.h"
+
+namespace bench
+{
+	struct TimedMidiEvent
+	{
+		double time;	// seconds since the start of the scenario
+		synthLib::SMidiEvent event;
+	};
+
+	// A fixed MIDI sequence that is played while measuring. Sequences are defined in seconds so that they produce the
+	// same musical content regardless of block size and sample rate
+	struct Scenario
+	{
+		std::string name;
+		std::string description;
+		std::vector<TimedMidiEvent> events;	// sorted by time
+	};
+
+	std::vector<std::string> getScenarioNames();
+
+	// returns false if there is no scenario with the given name
+	bool createScenario(Scenario& _scenario, const std::string& _name, double _lengthSeconds);
+}
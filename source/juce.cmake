@@ -136,6 +136,32 @@ macro(createJucePlugin targetName productName isSynth plugin4CC binaryDataProjec
 		endif()
 	endif()
 	
+	if(${isSynth})
+		# headless host that drives the processor with scripted host callbacks and measures their timing
+		set(harnessSources
+			${JUCE_CMAKE_DIR}/jucePluginHarness/hostHarness.cpp ${JUCE_CMAKE_DIR}/jucePluginHarness/hostHarness.h
+			${JUCE_CMAKE_DIR}/jucePluginHarness/hostScript.cpp ${JUCE_CMAKE_DIR}/jucePluginHarness/hostScript.h
+			${JUCE_CMAKE_DIR}/jucePluginHarness/jucePluginHarness.cpp
+			${JUCE_CMAKE_DIR}/gearmulatorBench/jsonWriter.cpp ${JUCE_CMAKE_DIR}/gearmulatorBench/jsonWriter.h
+			${JUCE_CMAKE_DIR}/dsp56300/source/disassemble/commandline.cpp
+			${JUCE_CMAKE_DIR}/dsp56300/source/disassemble/commandline.h
+		)
+
+		add_executable(${targetName}_Harness)
+		target_sources(${targetName}_Harness PRIVATE ${harnessSources})
+		source_group("source" FILES ${harnessSources})
+		target_link_libraries(${targetName}_Harness PRIVATE ${targetName} jucePluginLib)
+		target_compile_definitions(${targetName}_Harness PRIVATE JUCE_GLOBAL_MODULE_SETTINGS_INCLUDED=1)
+		set_property(TARGET ${targetName}_Harness PROPERTY FOLDER ${targetName})
+
+		add_test(NAME ${targetName}_Harness COMMAND ${CMAKE_COMMAND}
+			-DTEST_RUNNER=$<TARGET_FILE:${targetName}_Harness>
+			-DTEST_NAME=${targetName}_Harness
+			-DROOT_DIR=${CMAKE_BINARY_DIR}
+			-P ${JUCE_CMAKE_DIR}/jucePluginHarness/runTest.cmake)
+		set_tests_properties(${targetName}_Harness PROPERTIES LABELS "PluginTest")
+	endif()
+
 	if(APPLE AND ${isSynth})
 		add_test(NAME ${targetName}_AU_Validate COMMAND ${CMAKE_COMMAND} 
 			-DIDCOMPANY=TusP
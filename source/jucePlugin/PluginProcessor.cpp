@@ -8,6 +8,8 @@
 #include "../synthLib/binarystream.h"
 #include "../synthLib/os.h"
 
+#include "dsp56kEmu/logging.h"
+
 namespace
 {
 	juce::PropertiesFile::Options getConfigOptions()
@@ -43,6 +45,9 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor() :
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor()
 {
+	stopLatencyCalibration();
+	cancelPendingUpdate();
+
 	destroyEditorState();
 }
 
@@ -80,6 +85,8 @@ bool AudioPluginAudioProcessor::setSelectedRom(const uint32_t _index)
 		(void)m_device.release();
 		m_device.reset(device);
 
+		updateLatencySamples();
+
 		evRomChanged.retain(getSelectedRom());
 
 		return true;
@@ -101,6 +108,78 @@ synthLib::Device* AudioPluginAudioProcessor::createDevice()
 	return new virusLib::Device(rom ? *rom : virusLib::ROMFile::invalid(), getPreferredDeviceSamplerate(), getHostSamplerate());
 }
 
+void AudioPluginAudioProcessor::updateLatencySamples()
+{
+	Processor::updateLatencySamples();
+
+	// called whenever the device or its samplerate changes
+	startLatencyCalibration();
+}
+
+void AudioPluginAudioProcessor::startLatencyCalibration()
+{
+	std::lock_guard lock(m_calibrationMutex);
+
+	// one measurement at a time, the next one is started when it has finished if the samplerate changed in between
+	if(m_calibrationRunning)
+		return;
+
+	const auto* device = dynamic_cast<const virusLib::Device*>(m_device.get());
+	const auto* rom = getSelectedRom();
+
+	if(!device || !rom || device->hasLatencyCalibration())
+		return;
+
+	const auto samplerate = device->getSamplerate();
+
+	if(!m_calibrationAttempts.insert({m_selectedRom, samplerate}).second)
+		return;
+
+	// the previous thread has finished already, it only needs to be cleaned up
+	if(m_calibrationThread.joinable())
+		m_calibrationThread.join();
+
+	m_calibrationRunning = true;
+
+	// booting a device and measuring takes a while, the cached result is used by the device that is used for playback
+	m_calibrationThread = std::thread([this, rom = *rom, samplerate]
+	{
+		try
+		{
+			virusLib::Device calibrationDevice(rom, samplerate, samplerate);
+
+			if(!m_calibrationCancel)
+				calibrationDevice.calibrateLatency(false, &m_calibrationCancel);
+		}
+		catch(const synthLib::DeviceException& e)
+		{
+			LOG("Latency calibration failed: " << e.what());
+		}
+
+		m_calibrationRunning = false;
+
+		if(!m_calibrationCancel)
+			triggerAsyncUpdate();
+	});
+}
+
+void AudioPluginAudioProcessor::stopLatencyCalibration()
+{
+	std::lock_guard lock(m_calibrationMutex);
+
+	// a running measurement stops after the current block, only the boot of the device cannot be interrupted
+	m_calibrationCancel = true;
+
+	if(m_calibrationThread.joinable())
+		m_calibrationThread.join();
+}
+
+void AudioPluginAudioProcessor::handleAsyncUpdate()
+{
+	getPlugin().refreshDeviceLatency();
+	updateLatencySamples();
+}
+
 pluginLib::Controller* AudioPluginAudioProcessor::createController()
 {
 	// force creation of device as the controller decides how to initialize based on the used ROM
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
 #include "../synthLib/plugin.h"
 #include "../virusLib/device.h"
 
@@ -10,7 +16,7 @@
 #include "../jucePluginEditorLib/pluginProcessor.h"
 
 //==============================================================================
-class AudioPluginAudioProcessor : public jucePluginEditorLib::Processor
+class AudioPluginAudioProcessor : public jucePluginEditorLib::Processor, juce::AsyncUpdater
 {
 public:
     AudioPluginAudioProcessor();
@@ -20,6 +26,8 @@ public:
 
     void processBpm(float _bpm) override;
 
+    void updateLatencySamples() override;
+
 	// _____________
 	//
 
@@ -64,6 +72,10 @@ private:
     void saveChunkData(synthLib::BinaryStream& s) override;
     void loadChunkData(synthLib::ChunkReader& _cr) override;
 
+    void startLatencyCalibration();
+    void stopLatencyCalibration();
+    void handleAsyncUpdate() override;
+
     //==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessor)
 
@@ -72,6 +84,14 @@ private:
 
 	uint32_t							m_clockTempoParam = 0xffffffff;
 
+    // latencies are measured on a separate device as the one used for playback is running on the audio thread. The
+    // thread is started from the message thread and from prepareToPlay, the mutex guards the thread and the attempts
+    std::mutex                          m_calibrationMutex;
+    std::thread                         m_calibrationThread;
+    std::atomic<bool>                   m_calibrationRunning{false};
+    std::atomic<bool>                   m_calibrationCancel{false};
+    std::set<std::pair<uint32_t, float>> m_calibrationAttempts;	// ROM index and device samplerate, measured once per session
+
 public:
     pluginLib::Event<const virusLib::ROMFile*> evRomChanged;
 };
@@ -0,0 +1,131 @@
+#include "performanceOverlay.h"
+
+#include "../jucePluginLib/processor.h"
+
+namespace jucePluginEditorLib
+{
+	namespace
+	{
+		constexpr int g_width = 320;
+		constexpr int g_height = 190;
+		constexpr int g_lineHeight = 14;
+		constexpr int g_margin = 6;
+		constexpr int g_perfCounterLines = synthLib::PerfCounters::Enabled ? static_cast<int>(synthLib::PerfCounterId::Count) + 1 : 0;
+
+		void drawHistogram(juce::Graphics& _g, const synthLib::DeadlineMonitor::Histogram& _hist, const juce::Rectangle<int>& _area, const juce::Colour& _colour)
+		{
+			uint64_t maxCount = 0;
+			for (const auto c : _hist)
+				maxCount = std::max(maxCount, c);
+
+			if(!maxCount)
+				return;
+
+			const auto binWidth = static_cast<float>(_area.getWidth()) / static_cast<float>(_hist.size());
+
+			for(size_t i=0; i<_hist.size(); ++i)
+			{
+				if(!_hist[i])
+					continue;
+
+				// log scale, rare slow blocks are the interesting ones and would not be visible otherwise
+				const auto h = std::log1p(static_cast<float>(_hist[i])) / std::log1p(static_cast<float>(maxCount)) * static_cast<float>(_area.getHeight());
+
+				// everything above the deadline is drawn in red
+				_g.setColour(i >= 10 ? juce::Colours::red : _colour);
+				_g.fillRect(static_cast<float>(_area.getX()) + binWidth * static_cast<float>(i) + 1.0f, static_cast<float>(_area.getBottom()) - h, binWidth - 2.0f, h);
+			}
+		}
+	}
+
+	PerformanceOverlay::PerformanceOverlay(pluginLib::Processor& _processor) : m_processor(_processor)
+	{
+		setSize(g_width, g_height + g_perfCounterLines * g_lineHeight);
+		startTimer(250);
+	}
+
+	void PerformanceOverlay::paint(juce::Graphics& _g)
+	{
+		_g.fillAll(juce::Colours::black.withAlpha(0.75f));
+
+		_g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+		_g.setColour(juce::Colours::white);
+
+		auto area = getLocalBounds().reduced(g_margin);
+
+		auto line = [&](const juce::String& _text)
+		{
+			_g.drawText(_text, area.removeFromTop(g_lineHeight), juce::Justification::centredLeft);
+		};
+
+		line("Load " + juce::String(m_stats.lastLoad * 100.0f, 1) + "%  max " + juce::String(m_stats.maxLoad * 100.0f, 1) + "%");
+		line("Blocks " + juce::String(static_cast<juce::int64>(m_stats.blocks)) + "  overruns " + juce::String(static_cast<juce::int64>(m_stats.overruns)));
+
+		if(!m_overruns.empty())
+		{
+			const auto& o = m_overruns.back();
+			line("Last overrun at block " + juce::String(static_cast<juce::int64>(o.block)) + ", " + juce::String(o.blockSize) + " samples");
+			line("  " + juce::String(o.processUs) + "us of " + juce::String(o.deadlineUs) + "us, DSP wait " + juce::String(o.dspWaitUs) + "us");
+			line("  MIDI in " + juce::String(o.midiIn) + " out " + juce::String(o.midiOut) + " pending " + juce::String(o.midiPending) + ", latency " + juce::String(o.latencyBlocks));
+		}
+		else
+		{
+			line("No overruns");
+			area.removeFromTop(g_lineHeight * 2);
+		}
+
+		if constexpr (synthLib::PerfCounters::Enabled)
+		{
+			area.removeFromTop(g_margin);
+			line("Counters since reset, avg / max");
+
+			for(size_t i=0; i<static_cast<size_t>(synthLib::PerfCounterId::Count); ++i)
+			{
+				const auto id = static_cast<synthLib::PerfCounterId>(i);
+				const auto& v = m_perfCounters[id];
+				const juce::String name = juce::String("  ") + synthLib::PerfCounters::getName(id);
+
+				if(!v.count)
+					line(name.paddedRight(' ', 26) + "-");
+				else if(synthLib::PerfCounters::isTimer(id))
+					line(name.paddedRight(' ', 26) + juce::String(v.getAverage() / 1000.0, 1) + " / " + juce::String(static_cast<double>(v.max) / 1000.0, 1) + " us");
+				else
+					line(name.paddedRight(' ', 26) + juce::String(v.getAverage(), 1) + " / " + juce::String(static_cast<juce::int64>(v.max)));
+			}
+		}
+
+		area.removeFromTop(g_margin);
+
+		const auto histWidth = (area.getWidth() - g_margin) / 2;
+
+		auto histProcess = area.removeFromLeft(histWidth);
+		area.removeFromLeft(g_margin);
+		auto histDspWait = area;
+
+		_g.setColour(juce::Colours::white);
+		_g.drawText("Process / deadline", histProcess.removeFromTop(g_lineHeight), juce::Justification::centredLeft);
+		_g.drawText("DSP wait / deadline", histDspWait.removeFromTop(g_lineHeight), juce::Justification::centredLeft);
+
+		drawHistogram(_g, m_stats.process, histProcess, juce::Colours::lightgreen);
+		drawHistogram(_g, m_stats.dspWait, histDspWait, juce::Colours::lightblue);
+	}
+
+	void PerformanceOverlay::mouseDown(const juce::MouseEvent& _e)
+	{
+		// click to reset the statistics
+		m_processor.getDeadlineMonitor().reset();
+		pluginLib::Processor::resetPerfCounters();
+		timerCallback();
+	}
+
+	void PerformanceOverlay::timerCallback()
+	{
+		auto& monitor = m_processor.getDeadlineMonitor();
+		monitor.getStats(m_stats);
+		monitor.getOverruns(m_overruns);
+
+		if constexpr (synthLib::PerfCounters::Enabled)
+			pluginLib::Processor::getPerfCounters(m_perfCounters);
+		repaint();
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "juce_gui_basics/juce_gui_basics.h"
+
+#include "../synthLib/deadlineMonitor.h"
+#include "../synthLib/perfCounters.h"
+
+namespace pluginLib
+{
+	class Processor;
+}
+
+namespace jucePluginEditorLib
+{
+	// Small overlay that shows the load of the audio thread relative to the host block deadline, histograms of the
+	// process and DSP wait times, the most recent overrun and the performance counters if they are enabled
+	class PerformanceOverlay : public juce::Component, juce::Timer
+	{
+	public:
+		explicit PerformanceOverlay(pluginLib::Processor& _processor);
+
+		void paint(juce::Graphics& _g) override;
+		void mouseDown(const juce::MouseEvent& _e) override;
+
+	private:
+		void timerCallback() override;
+
+		pluginLib::Processor& m_processor;
+
+		synthLib::DeadlineMonitor::Stats m_stats;
+		std::vector<synthLib::DeadlineOverrun> m_overruns;
+		synthLib::PerfCounterSnapshot m_perfCounters;
+	};
+}
@@ -1,7 +1,9 @@
 #include "pluginEditorState.h"
 
+#include "performanceOverlay.h"
 #include "pluginProcessor.h"
 #include "../synthLib/os.h"
+#include "../synthLib/tracer.h"
 #include "dsp56kEmu/logging.h"
 
 #include "../juceUiLib/editor.h"
@@ -14,6 +16,8 @@ PluginEditorState::PluginEditorState(Processor& _processor, pluginLib::Controlle
 {
 }
 
+PluginEditorState::~PluginEditorState() = default;
+
 int PluginEditorState::getWidth() const
 {
 	return m_editor ? m_editor->getWidth() : 0;
@@ -91,6 +95,8 @@ void PluginEditorState::loadSkin(const Skin& _skin)
 
 		m_parameterBinding.clearBindings();
 
+		m_performanceOverlay.reset();
+
 		auto* parent = m_editor->getParentComponent();
 
 		if(parent && parent->getIndexOfChildComponent(m_editor.get()) > -1)
@@ -113,6 +119,8 @@ void PluginEditorState::loadSkin(const Skin& _skin)
 
 		if(!m_instanceConfig.empty())
 			getEditor()->setPerInstanceConfig(m_instanceConfig);
+
+		updatePerformanceOverlay();
 	}
 	catch(const std::runtime_error& _err)
 	{
@@ -131,6 +139,35 @@ void PluginEditorState::setGuiScale(const int _scale) const
 		evSetGuiScale(_scale);
 }
 
+void PluginEditorState::setPerformanceOverlayVisible(const bool _visible)
+{
+	m_processor.getConfig().setValue("show_performance_overlay", _visible);
+	updatePerformanceOverlay();
+}
+
+void PluginEditorState::updatePerformanceOverlay()
+{
+	const auto visible = m_processor.getConfig().getBoolValue("show_performance_overlay", false);
+
+	if(!visible || !m_editor)
+	{
+		m_performanceOverlay.reset();
+		return;
+	}
+
+	if(m_performanceOverlay)
+		return;
+
+	m_performanceOverlay.reset(new PerformanceOverlay(m_processor));
+
+	// keep the overlay at a readable size regardless of the skin scale
+	if(m_rootScale > 0.0f)
+		m_performanceOverlay->setTransform(juce::AffineTransform::scale(1.0f / m_rootScale));
+
+	m_editor->addAndMakeVisible(m_performanceOverlay.get());
+	m_performanceOverlay->toFront(false);
+}
+
 genericUI::Editor* PluginEditorState::getEditor() const
 {
 	return static_cast<genericUI::Editor*>(m_editor.get());
@@ -239,6 +276,52 @@ void PluginEditorState::openMenu()
 	menu.addSubMenu("GUI Scale", scaleMenu);
 	menu.addSubMenu("Latency (blocks)", latencyMenu);
 
+	const auto showOverlay = static_cast<bool>(m_performanceOverlay);
+	menu.addItem("Show Performance Overlay", true, showOverlay, [this, showOverlay] { setPerformanceOverlayVisible(!showOverlay); });
+
+	const auto isRecording = m_processor.getPlugin().isRecording();
+	menu.addItem("Record Device Session", true, isRecording, [this, isRecording]
+	{
+		auto& plugin = m_processor.getPlugin();
+
+		if(isRecording)
+		{
+			plugin.stopRecording();
+			return;
+		}
+
+		// captures can be replayed offline with bit-identical output, they are written to the desktop to be easy to find.
+		// Recording reboots the device, notes that are playing are stopped
+		const auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile(
+			juce::String(m_processor.getProperties().name) + "_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".drec");
+
+		if(!m_processor.startRecording(file.getFullPathName().toStdString()))
+			juce::NativeMessageBox::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Error", "Failed to create " + file.getFullPathName());
+	});
+
+	if constexpr (synthLib::Tracer::Enabled)
+	{
+		const auto isTracing = synthLib::Tracer::isRunning();
+		menu.addItem("Record Trace", true, isTracing, [this, isTracing]
+		{
+			if(!isTracing)
+			{
+				synthLib::Tracer::clear();
+				synthLib::Tracer::start();
+				return;
+			}
+
+			synthLib::Tracer::stop();
+
+			// the trace is process wide and covers all plugin instances, it can be opened in chrome://tracing or Perfetto
+			const auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile(
+				juce::String(m_processor.getProperties().name) + "_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".json");
+
+			if(!synthLib::Tracer::writeFile(file.getFullPathName().toStdString()))
+				juce::NativeMessageBox::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Error", "Failed to write " + file.getFullPathName());
+		});
+	}
+
 	initContextMenu(menu);
 
 	auto& regions = m_processor.getController().getParameterDescriptions().getRegions();
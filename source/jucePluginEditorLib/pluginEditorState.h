@@ -22,6 +22,7 @@ class AudioPluginAudioProcessor;
 namespace jucePluginEditorLib
 {
 	class Processor;
+	class PerformanceOverlay;
 
 	class PluginEditorState
 	{
@@ -39,7 +40,7 @@ namespace jucePluginEditorLib
 		};
 
 		explicit PluginEditorState(Processor& _processor, pluginLib::Controller& _controller, std::vector<Skin> _includedSkins);
-		virtual ~PluginEditorState() = default;
+		virtual ~PluginEditorState();
 
 		PluginEditorState(PluginEditorState&&) = delete;
 		PluginEditorState(const PluginEditorState&) = delete;
@@ -86,10 +87,13 @@ namespace jucePluginEditorLib
 	private:
 		void loadSkin(const Skin& _skin);
 		void setGuiScale(int _scale) const;
+		void setPerformanceOverlayVisible(bool _visible);
+		void updatePerformanceOverlay();
 
 		genericUI::Editor* getEditor() const;
 
 		std::unique_ptr<juce::Component> m_editor;
+		std::unique_ptr<PerformanceOverlay> m_performanceOverlay;
 		Skin m_currentSkin;
 		float m_rootScale = 1.0f;
 		std::vector<Skin> m_includedSkins;
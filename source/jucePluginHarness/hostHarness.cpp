@@ -0,0 +1,426 @@
+#include "hostHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "../jucePluginLib/processor.h"
+
+#include "../gearmulatorBench/jsonWriter.h"
+
+namespace pluginHarness
+{
+	namespace
+	{
+		bool toInt(const std::string& _s, int& _result)
+		{
+			try
+			{
+				size_t pos = 0;
+				_result = std::stoi(_s, &pos);
+				return pos == _s.size();
+			}
+			catch(...)
+			{
+				return false;
+			}
+		}
+
+		bool toFloat(const std::string& _s, float& _result)
+		{
+			try
+			{
+				size_t pos = 0;
+				_result = std::stof(_s, &pos);
+				return pos == _s.size();
+			}
+			catch(...)
+			{
+				return false;
+			}
+		}
+
+		bool toChannel(const std::string& _s, int& _channel)
+		{
+			return toInt(_s, _channel) && _channel >= 1 && _channel <= 16;
+		}
+
+		bool toMidiValue(const std::string& _s, int& _value)
+		{
+			return toInt(_s, _value) && _value >= 0 && _value <= 127;
+		}
+	}
+
+	float HostHarness::Timing::getPercentile(const float _percentile) const
+	{
+		if(microseconds.empty())
+			return 0.0f;
+
+		auto sorted = microseconds;
+		const auto index = std::min(sorted.size() - 1, static_cast<size_t>(_percentile * 0.01f * static_cast<float>(sorted.size())));
+		std::nth_element(sorted.begin(), sorted.begin() + static_cast<ptrdiff_t>(index), sorted.end());
+		return sorted[index];
+	}
+
+	float HostHarness::Timing::getAverage() const
+	{
+		if(microseconds.empty())
+			return 0.0f;
+
+		double sum = 0.0;
+		for (const auto us : microseconds)
+			sum += us;
+		return static_cast<float>(sum / static_cast<double>(microseconds.size()));
+	}
+
+	float HostHarness::Timing::getMax() const
+	{
+		return microseconds.empty() ? 0.0f : *std::max_element(microseconds.begin(), microseconds.end());
+	}
+
+	HostHarness::HostHarness(pluginLib::Processor& _processor) : m_processor(_processor), m_host(_processor)
+	{
+	}
+
+	bool HostHarness::run(const HostScript& _script)
+	{
+		m_error.clear();
+
+		if(!run(_script.getCommands()))
+			return false;
+
+		// a script might end without releasing, do what a host does when the plugin is removed
+		if(m_prepared)
+			release();
+
+		return true;
+	}
+
+	bool HostHarness::run(const std::vector<HostCommand>& _commands)
+	{
+		for (const auto& c : _commands)
+		{
+			if(!execute(c))
+				return false;
+		}
+		return true;
+	}
+
+	bool HostHarness::execute(const HostCommand& _command)
+	{
+		const auto& name = _command.name;
+		const auto& args = _command.args;
+
+		if(name == "prepare")
+		{
+			int samplerate = 0, blockSize = 0;
+
+			if(!toInt(args[0], samplerate) || samplerate <= 0 || !toInt(args[1], blockSize) || blockSize <= 0)
+				return fail(_command, "Invalid samplerate or block size");
+
+			return prepare(samplerate, blockSize) || fail(_command, m_error);
+		}
+
+		if(name == "release")
+		{
+			release();
+			return true;
+		}
+
+		if(name == "process")
+		{
+			int blocks = 0;
+			if(!toInt(args[0], blocks) || blocks < 0)
+				return fail(_command, "Invalid block count");
+			return process(static_cast<uint32_t>(blocks)) || fail(_command, m_error);
+		}
+
+		if(name == "noteon" || name == "noteoff" || name == "cc")
+		{
+			int channel = 0, a = 0, b = 0;
+
+			if(!toChannel(args[0], channel) || !toMidiValue(args[1], a) || (args.size() > 2 && !toMidiValue(args[2], b)))
+				return fail(_command, "Invalid MIDI channel or data byte");
+
+			if(name == "noteon")
+				m_midi.addEvent(juce::MidiMessage::noteOn(channel, a, static_cast<juce::uint8>(b)), 0);
+			else if(name == "noteoff")
+				m_midi.addEvent(juce::MidiMessage::noteOff(channel, a), 0);
+			else
+				m_midi.addEvent(juce::MidiMessage::controllerEvent(channel, a, b), 0);
+			return true;
+		}
+
+		if(name == "automate")
+		{
+			float value = 0.0f;
+			int blocks = 0;
+
+			if(!toFloat(args[1], value) || value < 0.0f || value > 1.0f || !toInt(args[2], blocks) || blocks < 0)
+				return fail(_command, "Invalid value or block count");
+
+			return automate(args[0], value, static_cast<uint32_t>(blocks)) || fail(_command, m_error);
+		}
+
+		if(name == "program")
+		{
+			int program = 0, channel = 1;
+
+			if(!toMidiValue(args[0], program) || (args.size() > 1 && !toChannel(args[1], channel)))
+				return fail(_command, "Invalid program or channel");
+
+			m_midi.addEvent(juce::MidiMessage::programChange(channel, program), 0);
+			return setProgram(program) || fail(_command, m_error);
+		}
+
+		if(name == "save")
+		{
+			saveState();
+			return true;
+		}
+
+		if(name == "restore")
+			return restoreState() || fail(_command, m_error);
+
+		if(name == "gain")
+		{
+			float gain = 0.0f;
+			if(!toFloat(args[0], gain) || gain < 0.0f)
+				return fail(_command, "Invalid gain");
+			m_processor.setOutputGain(gain);
+			return true;
+		}
+
+		if(name == "repeat")
+		{
+			int count = 0;
+			if(!toInt(args[0], count) || count < 0)
+				return fail(_command, "Invalid repeat count");
+
+			for(int i=0; i<count; ++i)
+			{
+				if(!run(_command.children))
+					return false;
+			}
+			return true;
+		}
+
+		return fail(_command, "Unknown command");
+	}
+
+	bool HostHarness::prepare(const double _samplerate, const int _blockSize)
+	{
+		// hosts release the processor before preparing it again with different settings
+		if(m_prepared)
+			release();
+
+		const auto channels = std::max(m_host.getTotalNumInputChannels(), m_host.getTotalNumOutputChannels());
+
+		if(channels <= 0)
+		{
+			m_error = "Processor has no channels";
+			return false;
+		}
+
+		m_samplerate = _samplerate;
+		m_blockSize = _blockSize;
+
+		m_buffer.setSize(channels, _blockSize);
+
+		measure("prepareToPlay", [&]
+		{
+			m_host.setRateAndBufferSizeDetails(_samplerate, _blockSize);
+			m_host.prepareToPlay(_samplerate, _blockSize);
+		});
+
+		m_prepared = true;
+		return true;
+	}
+
+	void HostHarness::release()
+	{
+		measure("releaseResources", [&]
+		{
+			m_host.releaseResources();
+		});
+
+		m_prepared = false;
+	}
+
+	bool HostHarness::process(const uint32_t _blocks)
+	{
+		if(!m_prepared)
+		{
+			m_error = "Processor needs to be prepared before processing";
+			return false;
+		}
+
+		const auto deadlineUs = static_cast<float>(static_cast<double>(m_blockSize) * 1e6 / m_samplerate);
+
+		for(uint32_t b=0; b<_blocks; ++b)
+		{
+			m_buffer.clear();
+
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			{
+				const juce::ScopedLock lock(m_host.getCallbackLock());
+				m_host.processBlock(m_buffer, m_midi);
+			}
+			const auto t1 = std::chrono::high_resolution_clock::now();
+
+			const auto us = std::chrono::duration<float, std::micro>(t1 - t0).count();
+
+			m_timings["processBlock"].add(us);
+
+			if(us > deadlineUs)
+				++m_overruns;
+
+			++m_blocks;
+
+			// hosts discard MIDI output of the plugin after each block
+			m_midi.clear();
+
+			for(int c=0; c<m_buffer.getNumChannels(); ++c)
+			{
+				const auto* data = m_buffer.getReadPointer(c);
+
+				for(int i=0; i<m_buffer.getNumSamples(); ++i)
+				{
+					if(!std::isfinite(data[i]))
+						++m_invalidSamples;
+					else
+						m_peak = std::max(m_peak, std::abs(data[i]));
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool HostHarness::automate(const std::string& _param, const float _value, const uint32_t _blocks)
+	{
+		auto* p = findParameter(_param);
+
+		if(!p)
+		{
+			m_error = "Parameter " + _param + " not found";
+			return false;
+		}
+
+		// a ramp with one parameter change per block, as hosts do when playing back automation
+		const auto start = p->getValue();
+		const auto steps = std::max(1u, _blocks);
+
+		for(uint32_t i=1; i<=steps; ++i)
+		{
+			const auto v = start + (_value - start) * static_cast<float>(i) / static_cast<float>(steps);
+
+			measure("setParameter", [&]
+			{
+				p->setValueNotifyingHost(v);
+			});
+
+			if(_blocks && !process(1))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool HostHarness::setProgram(const int _program)
+	{
+		if(_program >= m_host.getNumPrograms())
+			return true;	// the program change via MIDI is all we can do
+
+		measure("setCurrentProgram", [&]
+		{
+			m_host.setCurrentProgram(_program);
+		});
+		return true;
+	}
+
+	void HostHarness::saveState()
+	{
+		m_savedState.reset();
+
+		measure("getStateInformation", [&]
+		{
+			m_host.getStateInformation(m_savedState);
+		});
+	}
+
+	bool HostHarness::restoreState()
+	{
+		if(m_savedState.isEmpty())
+		{
+			m_error = "No state has been saved";
+			return false;
+		}
+
+		measure("setStateInformation", [&]
+		{
+			m_host.setStateInformation(m_savedState.getData(), static_cast<int>(m_savedState.getSize()));
+		});
+		return true;
+	}
+
+	juce::AudioProcessorParameter* HostHarness::findParameter(const std::string& _nameOrIndex) const
+	{
+		const auto& params = m_host.getParameters();
+
+		int index = 0;
+		if(toInt(_nameOrIndex, index))
+			return index >= 0 && index < params.size() ? params[index] : nullptr;
+
+		for (auto* p : params)
+		{
+			if(p->getName(256).equalsIgnoreCase(juce::String(_nameOrIndex)))
+				return p;
+		}
+		return nullptr;
+	}
+
+	bool HostHarness::fail(const HostCommand& _command, const std::string& _message)
+	{
+		m_error = "Line " + std::to_string(_command.line) + ", '" + _command.name + "': " + _message;
+		return false;
+	}
+
+	void HostHarness::writeReport(bench::JsonWriter& _json) const
+	{
+		_json.beginObject();
+
+		_json.add("plugin", m_host.getName().toStdString());
+		_json.add("blocks", m_blocks);
+		_json.add("overruns", m_overruns);
+		_json.add("invalidSamples", m_invalidSamples);
+		_json.add("peak", static_cast<double>(m_peak));
+
+		_json.beginArray("callbacks");
+
+		for (const auto& [name, timing] : m_timings)
+		{
+			_json.beginObject();
+			_json.add("name", name);
+			_json.add("count", static_cast<uint64_t>(timing.microseconds.size()));
+			_json.add("avgUs", static_cast<double>(timing.getAverage()));
+			_json.add("p50Us", static_cast<double>(timing.getPercentile(50.0f)));
+			_json.add("p99Us", static_cast<double>(timing.getPercentile(99.0f)));
+			_json.add("maxUs", static_cast<double>(timing.getMax()));
+			_json.endObject();
+		}
+
+		_json.endArray();
+		_json.endObject();
+	}
+
+	void HostHarness::printReport() const
+	{
+		std::cout << m_host.getName() << ": " << m_blocks << " blocks, " << m_overruns << " overruns, " << m_invalidSamples << " invalid samples, peak " << m_peak << '\n';
+
+		for (const auto& [name, timing] : m_timings)
+		{
+			std::cout << "  " << name << ": " << timing.microseconds.size() << " calls, avg " << timing.getAverage() << "us, p50 " << timing.getPercentile(50.0f) << "us, p99 " << timing.getPercentile(99.0f) << "us, max " << timing.getMax() << "us\n";
+		}
+	}
+}
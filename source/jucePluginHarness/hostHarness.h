@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hostScript.h"
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+namespace bench
+{
+	class JsonWriter;
+}
+
+namespace pluginLib
+{
+	class Processor;
+}
+
+namespace pluginHarness
+{
+	// Acts as a host for a plugin processor without any GUI or audio device. Host callbacks are driven by a script,
+	// the time spent in each callback is measured
+	class HostHarness
+	{
+	public:
+		struct Timing
+		{
+			std::vector<float> microseconds;
+
+			void add(float _us) { microseconds.push_back(_us); }
+			float getPercentile(float _percentile) const;
+			float getAverage() const;
+			float getMax() const;
+		};
+
+		explicit HostHarness(pluginLib::Processor& _processor);
+
+		bool run(const HostScript& _script);
+
+		void writeReport(bench::JsonWriter& _json) const;
+		void printReport() const;
+
+		const std::string& getError() const { return m_error; }
+
+		uint64_t getOverruns() const { return m_overruns; }
+		uint64_t getInvalidSamples() const { return m_invalidSamples; }
+
+	private:
+		bool run(const std::vector<HostCommand>& _commands);
+		bool execute(const HostCommand& _command);
+
+		bool prepare(double _samplerate, int _blockSize);
+		void release();
+		bool process(uint32_t _blocks);
+		bool automate(const std::string& _param, float _value, uint32_t _blocks);
+		bool setProgram(int _program);
+		void saveState();
+		bool restoreState();
+
+		juce::AudioProcessorParameter* findParameter(const std::string& _nameOrIndex) const;
+
+		bool fail(const HostCommand& _command, const std::string& _message);
+
+		template<typename TFunc> void measure(const char* _name, TFunc _func)
+		{
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			_func();
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			m_timings[_name].add(std::chrono::duration<float, std::micro>(t1 - t0).count());
+		}
+
+		pluginLib::Processor& m_processor;
+		juce::AudioProcessor& m_host;	// the processor seen through the interface that hosts use
+
+		juce::AudioBuffer<float> m_buffer;
+		juce::MidiBuffer m_midi;
+
+		double m_samplerate = 0.0;
+		int m_blockSize = 0;
+		bool m_prepared = false;
+
+		juce::MemoryBlock m_savedState;
+
+		std::map<std::string, Timing> m_timings;
+
+		uint64_t m_blocks = 0;
+		uint64_t m_overruns = 0;
+		uint64_t m_invalidSamples = 0;
+		float m_peak = 0.0f;
+
+		std::string m_error;
+	};
+}
@@ -0,0 +1,168 @@
+#include "hostScript.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace pluginHarness
+{
+	namespace
+	{
+		// minimum number of arguments per command
+		const std::map<std::string, size_t> g_commands =
+		{
+			{"prepare", 2},
+			{"release", 0},
+			{"process", 1},
+			{"noteon", 3},
+			{"noteoff", 2},
+			{"cc", 3},
+			{"automate", 3},
+			{"program", 1},
+			{"save", 0},
+			{"restore", 0},
+			{"gain", 1},
+			{"repeat", 1},
+			{"end", 0}
+		};
+
+		const char* const g_defaultScript = R"(
+# boot and render some silence
+prepare 44100 512
+process 100
+
+# play a chord and automate a few parameters while it is playing
+noteon 1 60 100
+noteon 1 64 100
+noteon 1 67 100
+process 50
+automate 40 0.2 100
+automate 40 0.8 100
+cc 1 1 127
+process 50
+
+# switch presets while notes are playing
+repeat 8
+	program 1
+	process 20
+	program 0
+	process 20
+end
+
+noteoff 1 60
+noteoff 1 64
+noteoff 1 67
+process 50
+
+# state save & restore
+save
+restore
+process 50
+
+# sample rate and block size changes like when the user changes the audio settings of the host
+prepare 48000 256
+process 200
+prepare 96000 1024
+process 100
+prepare 44100 64
+process 400
+
+gain 0.5
+noteon 1 48 127
+process 100
+noteoff 1 48
+process 100
+
+release
+)";
+	}
+
+	bool HostScript::loadFile(const std::string& _filename)
+	{
+		std::ifstream file(_filename, std::ios::in);
+
+		if(!file.is_open())
+		{
+			m_error = "Failed to open " + _filename;
+			return false;
+		}
+
+		std::stringstream ss;
+		ss << file.rdbuf();
+		return parse(ss.str());
+	}
+
+	bool HostScript::parse(const std::string& _script)
+	{
+		m_commands.clear();
+		m_error.clear();
+
+		// stack of command lists, repeat blocks add a new level
+		std::vector<std::vector<HostCommand>*> stack{&m_commands};
+
+		std::stringstream ss(_script);
+		std::string line;
+		uint32_t lineNumber = 0;
+
+		while(std::getline(ss, line))
+		{
+			++lineNumber;
+
+			std::stringstream ls(line);
+
+			HostCommand c;
+			c.line = lineNumber;
+
+			if(!(ls >> c.name) || c.name.front() == '#')
+				continue;
+
+			std::string arg;
+			while(ls >> arg)
+				c.args.push_back(arg);
+
+			const auto it = g_commands.find(c.name);
+
+			if(it == g_commands.end())
+			{
+				m_error = "Unknown command '" + c.name + "' in line " + std::to_string(lineNumber);
+				return false;
+			}
+
+			if(c.args.size() < it->second)
+			{
+				m_error = "Command '" + c.name + "' in line " + std::to_string(lineNumber) + " needs " + std::to_string(it->second) + " arguments";
+				return false;
+			}
+
+			if(c.name == "end")
+			{
+				if(stack.size() < 2)
+				{
+					m_error = "'end' without 'repeat' in line " + std::to_string(lineNumber);
+					return false;
+				}
+				stack.pop_back();
+				continue;
+			}
+
+			auto& list = *stack.back();
+			list.push_back(std::move(c));
+
+			if(list.back().name == "repeat")
+				stack.push_back(&list.back().children);
+		}
+
+		if(stack.size() > 1)
+		{
+			m_error = "'repeat' without 'end'";
+			return false;
+		}
+
+		return true;
+	}
+
+	const char* HostScript::getDefaultScript()
+	{
+		return g_defaultScript;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pluginHarness
+{
+	// A host script is a list of commands, one per line, that describes how a host drives the plugin:
+	//
+	//   prepare <samplerate> <blocksize>		prepareToPlay, also used to change the sample rate or block size
+	//   release								releaseResources
+	//   process <blocks>						process the given number of blocks
+	//   noteon <channel> <note> <velocity>	MIDI events are sent with the next processed block
+	//   noteoff <channel> <note>
+	//   cc <channel> <controller> <value>
+	//   automate <parameter> <value> <blocks>	ramp a host parameter (index or name) to a normalized value
+	//   program <index> [channel]			setCurrentProgram plus a MIDI program change on the given channel (default 1)
+	//   save									getStateInformation, the state is kept for restore
+	//   restore								setStateInformation with the last saved state
+	//   gain <gain>							output gain of the processor
+	//   repeat <count> ... end				repeat the enclosed commands
+	//
+	// Empty lines and lines starting with # are ignored. Channels are 1-16
+	struct HostCommand
+	{
+		std::string name;
+		std::vector<std::string> args;
+		uint32_t line = 0;
+
+		std::vector<HostCommand> children;	// repeat only
+	};
+
+	class HostScript
+	{
+	public:
+		bool loadFile(const std::string& _filename);
+		bool parse(const std::string& _script);
+
+		const std::vector<HostCommand>& getCommands() const { return m_commands; }
+		const std::string& getError() const { return m_error; }
+
+		// A script that exercises all commands, used if no script is given
+		static const char* getDefaultScript();
+
+	private:
+		std::vector<HostCommand> m_commands;
+		std::string m_error;
+	};
+}
@@ -0,0 +1,114 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "hostHarness.h"
+#include "hostScript.h"
+
+#include "../jucePluginLib/processor.h"
+
+#include "../gearmulatorBench/jsonWriter.h"
+
+#include "../dsp56300/source/disassemble/commandline.h"
+
+// implemented by each plugin
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+	void printUsage()
+	{
+		std::cout << "Usage: pluginHarness [-script file] [-json file] [-maxoverruns n]" << std::endl;
+		std::cout << "Without a script, a default script is used that exercises all host callbacks" << std::endl;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	try
+	{
+		const CommandLine cmd(_argc, _argv);
+
+		if(cmd.contains("help"))
+		{
+			printUsage();
+			return 0;
+		}
+
+		pluginHarness::HostScript script;
+
+		const bool scriptOk = cmd.contains("script") ? script.loadFile(cmd.get("script")) : script.parse(pluginHarness::HostScript::getDefaultScript());
+
+		if(!scriptOk)
+		{
+			std::cout << "Invalid script: " << script.getError() << std::endl;
+			return -1;
+		}
+
+		// a message thread is needed for parameter change notifications and async updates, we do not create any UI
+		const juce::ScopedJuceInitialiser_GUI juceInit;
+
+		std::unique_ptr<juce::AudioProcessor> audioProcessor(createPluginFilter());
+
+		auto* processor = dynamic_cast<pluginLib::Processor*>(audioProcessor.get());
+
+		if(!processor)
+		{
+			std::cout << "Plugin is not a pluginLib processor" << std::endl;
+			return -1;
+		}
+
+		if(!processor->isPluginValid())
+		{
+			std::cout << "Plugin failed to create its device, make sure that a ROM is available" << std::endl;
+			return -1;
+		}
+
+		pluginHarness::HostHarness harness(*processor);
+
+		const auto success = harness.run(script);
+
+		harness.printReport();
+
+		if(cmd.contains("json"))
+		{
+			const auto filename = cmd.get("json");
+			std::ofstream file(filename, std::ios::out | std::ios::trunc);
+
+			if(!file.is_open())
+			{
+				std::cout << "Failed to create " << filename << std::endl;
+				return -1;
+			}
+
+			bench::JsonWriter json(file);
+			harness.writeReport(json);
+		}
+
+		if(!success)
+		{
+			std::cout << "Script failed: " << harness.getError() << std::endl;
+			return -1;
+		}
+
+		if(harness.getInvalidSamples())
+		{
+			std::cout << "Plugin produced " << harness.getInvalidSamples() << " invalid samples" << std::endl;
+			return -1;
+		}
+
+		// overruns depend on the machine that runs the test, they only fail the run if a limit has been specified
+		if(cmd.contains("maxoverruns") && harness.getOverruns() > static_cast<uint64_t>(cmd.getInt("maxoverruns")))
+		{
+			std::cout << "Too many overruns: " << harness.getOverruns() << std::endl;
+			return -1;
+		}
+
+		return 0;
+	}
+	catch(const std::exception& e)
+	{
+		std::cout << "Exception: " << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,24 @@
+include(${CMAKE_CURRENT_LIST_DIR}/../../scripts/rclone.cmake)
+
+set(TEST_DATA_DIR integrationTestsData)
+
+if(EXISTS ${RCLONE_CONF})
+	copyDataFrom("integrationtests" ${TEST_DATA_DIR})
+
+	# the plugin searches for its ROM in the current directory if there is none next to the executable
+	file(GLOB_RECURSE ROM_FILES ${TEST_DATA_DIR}/*.bin)
+
+	if(NOT ROM_FILES)
+		message(FATAL_ERROR "No ROM found in ${TEST_DATA_DIR}, unable to run plugin harness")
+	endif()
+
+	list(GET ROM_FILES 0 ROM_FILE)
+	get_filename_component(ROM_DIR ${ROM_FILE} DIRECTORY)
+
+	execute_process(COMMAND ${TEST_RUNNER} -json ${ROOT_DIR}/${TEST_NAME}.json WORKING_DIRECTORY ${ROM_DIR} COMMAND_ECHO STDOUT RESULT_VARIABLE TEST_RESULT)
+	if(TEST_RESULT)
+		message(FATAL_ERROR "Plugin harness failed: " ${TEST_RESULT})
+	endif()
+else()
+	message(FATAL_ERROR "rclone.conf not found at ${RCLONE_CONF}, unable to run plugin harness")
+endif()
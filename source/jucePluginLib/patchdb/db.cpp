@@ -10,6 +10,7 @@
 #include "../../synthLib/midiToSysex.h"
 #include "../../synthLib/hybridcontainer.h"
 #include "../../synthLib/binarystream.h"
+#include "../../synthLib/tracer.h"
 
 #include "dsp56kEmu/logging.h"
 
@@ -684,6 +685,8 @@ namespace pluginLib::patchDB
 
 	bool DB::loadData(DataList& _results, const DataSource& _ds)
 	{
+		SYNTHLIB_TRACE_SCOPE("DB::loadData");
+
 		switch (_ds.type)
 		{
 		case SourceType::Rom:
@@ -763,6 +766,8 @@ namespace pluginLib::patchDB
 
 		runOnLoaderThread([this]
 		{
+			SYNTHLIB_TRACE_SCOPE("DB::loadCache");
+
 			if(!g_cacheEnabled || !loadCache())
 				loadJson();
 		});
@@ -1060,12 +1065,6 @@ namespace pluginLib::patchDB
 
 		auto searchInDs = [&](const DataSourceNodePtr& _ds)
 		{
-			if(!_search.request.sourceNode && _search.getSourceType() != SourceType::Invalid)
-			{
-				if(_ds->type != _search.request.sourceType)
-					return true;
-			}
-
 			bool isCancelled;
 			{
 				std::shared_lock lockSearches(m_searchesMutex);
@@ -1083,17 +1082,7 @@ namespace pluginLib::patchDB
 				return false;
 			}
 
-			for (const auto& patchPtr : _ds->patches)
-			{
-				const auto* patch = patchPtr.get();
-				assert(patch);
-
-				if(_search.request.match(*patch))
-				{
-					std::unique_lock searchLock(_search.resultsMutex);
-					_search.results.insert(patchPtr);
-				}
-			}
+			_search.addMatches(*_ds);
 			return true;
 		};
 
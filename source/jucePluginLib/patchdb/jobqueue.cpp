@@ -4,6 +4,8 @@
 
 #include "dsp56kEmu/threadtools.h"
 
+#include "../../synthLib/tracer.h"
+
 namespace pluginLib::patchDB
 {
 	JobQueue::JobQueue(std::string _name, const bool _start/* = true*/, const dsp56k::ThreadPriority& _prio/* = dsp56k::ThreadPriority::Normal*/, const uint32_t _threadCount/* = 1*/)
@@ -35,7 +37,10 @@ namespace pluginLib::patchDB
 			m_threads.emplace_back(new std::thread([this, idx]
 			{
 				if (!m_name.empty())
+				{
 					dsp56k::ThreadTools::setCurrentThreadName(m_name + std::to_string(idx));
+					SYNTHLIB_TRACE_THREAD_NAME(m_name + std::to_string(idx));
+				}
 				dsp56k::ThreadTools::setCurrentThreadPriority(m_threadPriority);
 				threadFunc();
 			}));
@@ -107,7 +112,10 @@ namespace pluginLib::patchDB
 			m_funcs.pop_front();
 
 			lock.unlock();
-			func();
+			{
+				SYNTHLIB_TRACE_SCOPE("JobQueue::job");
+				func();
+			}
 			lock.lock();
 
 			--m_numRunning;
@@ -1,5 +1,8 @@
 #include "search.h"
 
+#include <cassert>
+#include <mutex>
+
 #include "patch.h"
 
 namespace pluginLib::patchDB
@@ -127,6 +130,27 @@ namespace pluginLib::patchDB
 		return true;
 	}
 
+	void Search::addMatches(const DataSourceNode& _ds)
+	{
+		if(!request.sourceNode && getSourceType() != SourceType::Invalid)
+		{
+			if(_ds.type != request.sourceType)
+				return;
+		}
+
+		for (const auto& patchPtr : _ds.patches)
+		{
+			const auto* patch = patchPtr.get();
+			assert(patch);
+
+			if(request.match(*patch))
+			{
+				std::unique_lock searchLock(resultsMutex);
+				results.insert(patchPtr);
+			}
+		}
+	}
+
 	bool SearchRequest::isValid() const
 	{
 		return !name.empty() || !tags.empty() || sourceNode || patch;
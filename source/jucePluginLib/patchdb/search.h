@@ -64,6 +64,10 @@ namespace pluginLib::patchDB
 			return request.sourceType;
 		}
 
+		// adds all patches of a data source that match the request to the results. Data sources of another type than
+		// the requested one are skipped
+		void addMatches(const DataSourceNode& _ds);
+
 		void setCompleted()
 		{
 			state = SearchState::Completed;
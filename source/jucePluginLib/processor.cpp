@@ -158,9 +158,10 @@ namespace pluginLib
 		{
 			LOG("Failed to create device: " << e.what());
 
-			// Juce loads the LV2/VST3 versions of the plugin as part of the build process, if we open a message box in this case, the build process gets stuck
+			// Juce loads the LV2/VST3 versions of the plugin as part of the build process, if we open a message box in this case, the build process gets stuck.
+			// The same applies to the headless plugin harness
 			const auto host = juce::PluginHostType::getHostPath();
-			if(!host.contains("juce_vst3_helper") && !host.contains("juce_lv2_helper"))
+			if(!host.contains("juce_vst3_helper") && !host.contains("juce_lv2_helper") && !host.contains("_Harness"))
 			{
 				std::string msg = e.what();
 
@@ -199,7 +200,38 @@ namespace pluginLib
 		return *m_plugin;
 	}
 
-	bool Processor::setLatencyBlocks(uint32_t _blocks)
+	bool Processor::startRecording(const std::string& _filename)
+	{
+		getPlugin();
+
+		synthLib::Device* device;
+
+		try
+		{
+			device = createDevice();
+		}
+		catch(const synthLib::DeviceException& e)
+		{
+			LOG("Failed to create device for recording: " << e.what());
+			return false;
+		}
+
+		if(!device)
+			return false;
+
+		device->setDspClockPercent(m_dspClockPercent);
+
+		// the plugin owns the new device and has deleted the old one
+		const auto started = getPlugin().startRecording(_filename, device);
+		(void)m_device.release();
+		m_device.reset(device);
+
+		updateLatencySamples();
+
+		return started;
+	}
+
+		bool Processor::setLatencyBlocks(uint32_t _blocks)
 	{
 		if (!getPlugin().setLatencyBlocks(_blocks))
 			return false;
@@ -340,7 +372,11 @@ namespace pluginLib
 		if(!m_device)
 			return false;
 
-		return getPlugin().setPreferredDeviceSamplerate(_samplerate);
+		if(!getPlugin().setPreferredDeviceSamplerate(_samplerate))
+			return false;
+
+		updateLatencySamples();
+		return true;
 	}
 
 	float Processor::getPreferredDeviceSamplerate() const
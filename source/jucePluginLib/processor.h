@@ -5,6 +5,7 @@
 
 #include "controller.h"
 
+#include "../synthLib/perfCounters.h"
 #include "../synthLib/plugin.h"
 
 namespace synthLib
@@ -47,6 +48,13 @@ namespace pluginLib
 
 		synthLib::Plugin& getPlugin();
 
+		synthLib::DeadlineMonitor& getDeadlineMonitor() { return getPlugin().getDeadlineMonitor(); }
+
+		// counters of the audio path, they are process wide as they include the DSP threads. All zero if
+		// SYNTHLIB_PERF_COUNTERS is disabled
+		static void getPerfCounters(synthLib::PerfCounterSnapshot& _snapshot) { synthLib::PerfCounters::getSnapshot(_snapshot); }
+		static void resetPerfCounters() { synthLib::PerfCounters::reset(); }
+
 		virtual synthLib::Device* createDevice() = 0;
 
 		bool hasController() const
@@ -54,6 +62,9 @@ namespace pluginLib
 			return m_controller.get();
 		}
 
+		// boots a new device that replaces the current one and records the session from there on, see Plugin::startRecording
+		bool startRecording(const std::string& _filename);
+
 		virtual bool setLatencyBlocks(uint32_t _blocks);
 		virtual void updateLatencySamples();
 
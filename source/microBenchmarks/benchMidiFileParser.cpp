@@ -0,0 +1,259 @@
+#include <cstdio>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "../synthLib/midiFileParser.h"
+#include "../synthLib/midiToSysex.h"
+#include "../synthLib/os.h"
+
+namespace microBenchmarks
+{
+	namespace
+	{
+		// Reference implementation of the previous FILE* based reader, kept to compare against
+		namespace legacy
+		{
+			bool checkChunk(FILE* hFile, const char* _pCompareChunk)
+			{
+				char readChunk[4];
+				if (fread(readChunk, 1, 4, hFile) != 4)
+					return false;
+				return readChunk[0] == _pCompareChunk[0] && readChunk[1] == _pCompareChunk[1] && readChunk[2] == _pCompareChunk[2] && readChunk[3] == _pCompareChunk[3];
+			}
+
+			bool ignoreChunk(FILE* hFile)
+			{
+				const auto a = getc(hFile), b = getc(hFile), c = getc(hFile), d = getc(hFile);
+				if(a == EOF || b == EOF || c == EOF || d == EOF)
+					return false;
+				fseek(hFile, (a << 24 | b << 16 | c << 8 | d), SEEK_CUR);
+				return !feof(hFile);
+			}
+
+			int32_t readVarLen(FILE* hFile)
+			{
+				if (feof(hFile))
+					return -1;
+
+				uint32_t value;
+				uint8_t c;
+
+				if ((value = getc(hFile)) & 0x80)
+				{
+					value &= 0x7F;
+					do
+					{
+						value = (value << 7) + ((c = getc(hFile)) & 0x7F);
+						if (feof(hFile))
+							return -1;
+					} while (c & 0x80);
+				}
+				return static_cast<int32_t>(value);
+			}
+
+			bool readFile(std::vector<uint8_t>& _sysexMessages, const char* _filename)
+			{
+				FILE* hFile = fopen(_filename, "rb");
+				if (!hFile)
+					return false;
+
+				if (!checkChunk(hFile, "MThd"))
+				{
+					fclose(hFile);
+					return false;
+				}
+
+				ignoreChunk(hFile);
+
+				while (!feof(hFile))
+				{
+					if (checkChunk(hFile, "MTrk"))
+					{
+						char temp[4];
+						fread(temp, 4, 1, hFile);
+
+						bool bReadNextEvent = true;
+						while (bReadNextEvent)
+						{
+							if (readVarLen(hFile) == -1)
+							{
+								fclose(hFile);
+								return false;
+							}
+
+							const auto ch = getc(hFile);
+							if (ch == EOF)
+								break;
+
+							switch (static_cast<uint8_t>(ch))
+							{
+							case 0xf0:
+								{
+									readVarLen(hFile);
+
+									std::vector<uint8_t> sysex;
+									sysex.push_back(0xf0);
+
+									while(true)
+									{
+										const auto c = getc(hFile);
+										if(c == 0xf7 || c == 0xf8)
+										{
+											sysex.push_back(0xf7);
+											_sysexMessages.insert(_sysexMessages.end(), sysex.begin(), sysex.end());
+											break;
+										}
+										sysex.push_back(static_cast<uint8_t>(c));
+										if (feof(hFile))
+											break;
+									}
+								}
+								break;
+							case 0xff:
+								{
+									const auto metaEvent = getc(hFile);
+									const auto eventLen = getc(hFile);
+
+									if(metaEvent == 0x2f)
+									{
+										bReadNextEvent = false;
+									}
+									else
+									{
+										std::vector<char> buffer;
+										buffer.resize(eventLen);
+										fread(&buffer[0], eventLen, 1, hFile);
+									}
+								}
+								break;
+							default:
+								break;
+							}
+						}
+					}
+					else if (!ignoreChunk(hFile))
+						break;
+				}
+				fclose(hFile);
+				return true;
+			}
+		}
+
+		void writeVarLen(std::vector<uint8_t>& _dst, const uint32_t _value)
+		{
+			uint8_t bytes[4];
+			int count = 0;
+			auto v = _value;
+			do
+			{
+				bytes[count++] = v & 0x7f;
+				v >>= 7;
+			}
+			while(v && count < 4);
+
+			while(count > 1)
+				_dst.push_back(bytes[--count] | 0x80);
+			_dst.push_back(bytes[0]);
+		}
+
+		void writeU32(std::vector<uint8_t>& _dst, const uint32_t _value)
+		{
+			_dst.push_back(static_cast<uint8_t>(_value >> 24));
+			_dst.push_back(static_cast<uint8_t>(_value >> 16));
+			_dst.push_back(static_cast<uint8_t>(_value >> 8));
+			_dst.push_back(static_cast<uint8_t>(_value));
+		}
+
+		// Creates a single track MIDI file that looks like a large bank dump
+		std::vector<uint8_t> createBankDump(const uint32_t _messageCount, const uint32_t _messageSize)
+		{
+			std::vector<uint8_t> track;
+			track.reserve(static_cast<size_t>(_messageCount) * (_messageSize + 4) + 4);
+
+			for(uint32_t m=0; m<_messageCount; ++m)
+			{
+				writeVarLen(track, m ? 10 : 0);
+				track.push_back(0xf0);
+				writeVarLen(track, _messageSize - 1);
+
+				track.insert(track.end(), {0x00, 0x20, 0x33, 0x01, 0x00, 0x10, static_cast<uint8_t>((m >> 7) & 0x7f), static_cast<uint8_t>(m & 0x7f)});
+				for(uint32_t i=8; i<_messageSize - 2; ++i)
+					track.push_back(static_cast<uint8_t>((i * 7 + m) & 0x7f));
+				track.push_back(0xf7);
+			}
+
+			track.insert(track.end(), {0x00, 0xff, 0x2f, 0x00});
+
+			std::vector<uint8_t> file = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96, 'M', 'T', 'r', 'k'};
+			writeU32(file, static_cast<uint32_t>(track.size()));
+			file.insert(file.end(), track.begin(), track.end());
+			return file;
+		}
+	}
+
+	void runMidiFileParserBenchmarks(const Benchmark& _bench)
+	{
+		if(!_bench.isGroupEnabled("smf/"))
+			return;
+
+		const auto data = createBankDump(20000, 267);
+		const std::string filename = "microBenchmarks_bankDump.mid";
+
+		if(!synthLib::writeFile(filename, data))
+		{
+			printf("Failed to write %s\n", filename.c_str());
+			return;
+		}
+
+		_bench.run("smf/legacy readFile (FILE*, getc)", [&]
+		{
+			std::vector<uint8_t> sysex;
+			legacy::readFile(sysex, filename.c_str());
+			doNotOptimize(sysex.data());
+		}, data.size());
+
+		_bench.run("smf/MidiToSysex::readFile (mapped)", [&]
+		{
+			std::vector<uint8_t> sysex;
+			synthLib::MidiToSysex::readFile(sysex, filename.c_str());
+			doNotOptimize(sysex.data());
+		}, data.size());
+
+		_bench.run("smf/MidiFileParser::parseFile streaming", [&]
+		{
+			size_t count = 0;
+			synthLib::MidiFileParser parser;
+			parser.parseFile(filename, [&count](const synthLib::MidiFileParser::Event& _e)
+			{
+				count += _e.size;
+				return true;
+			});
+			doNotOptimize(&count);
+		}, data.size());
+
+		_bench.run("smf/MidiFileParser::parse events", [&]
+		{
+			std::vector<synthLib::MidiFileParser::Event> events;
+			synthLib::MidiFileParser parser;
+			parser.parse(events, data.data(), data.size());
+			doNotOptimize(events.data());
+		}, data.size());
+
+		_bench.run("smf/splitMultipleSysex vectors", [&]
+		{
+			std::vector<std::vector<uint8_t>> messages;
+			synthLib::MidiToSysex::splitMultipleSysex(messages, data, true);
+			doNotOptimize(messages.data());
+		}, data.size());
+
+		_bench.run("smf/splitMultipleSysex spans", [&]
+		{
+			std::vector<synthLib::SysexSpan> messages;
+			synthLib::MidiToSysex::splitMultipleSysex(messages, data.data(), data.size(), true);
+			doNotOptimize(messages.data());
+		}, data.size());
+
+		std::remove(filename.c_str());
+	}
+}
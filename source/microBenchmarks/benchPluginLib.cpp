@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "../jucePluginLib/parameterdescriptions.h"
+#include "../jucePluginLib/patchdb/patch.h"
+#include "../jucePluginLib/patchdb/search.h"
+
+#include "../synthLib/os.h"
+
+namespace microBenchmarks
+{
+	namespace
+	{
+		void runMidiPacket(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("midipacket/"))
+				return;
+
+			std::vector<uint8_t> json;
+			if(!synthLib::readFile(json, MICROBENCHMARKS_PARAMETER_DESCRIPTIONS))
+			{
+				printf("Failed to load parameter descriptions from %s\n", MICROBENCHMARKS_PARAMETER_DESCRIPTIONS);
+				return;
+			}
+
+			const pluginLib::ParameterDescriptions descriptions(std::string(json.begin(), json.end()));
+
+			const auto* packet = descriptions.getMidiPacket("singledump");
+			if(!packet)
+			{
+				printf("Midi packet singledump not found\n");
+				return;
+			}
+
+			// a single dump as sent by the device, header, 256 parameter bytes, checksum, end of sysex
+			pluginLib::MidiPacket::Sysex sysex(packet->size(), 0);
+			const uint8_t header[] = {0xf0, 0x00, 0x20, 0x33, 0x01, 0x00, 0x10, 0x01, 0x00};
+			std::copy(std::begin(header), std::end(header), sysex.begin());
+			for(size_t i=std::size(header); i<sysex.size() - 1; ++i)
+				sysex[i] = static_cast<uint8_t>((i * 7) & 0x7f);
+			sysex.back() = 0xf7;
+
+			pluginLib::MidiPacket::Data data;
+			pluginLib::MidiPacket::ParamValues paramValues;
+
+			_bench.run("midipacket/parse singledump, ParamValues", [&]
+			{
+				data.clear();
+				paramValues.clear();
+				packet->parse(data, paramValues, descriptions, sysex);
+				doNotOptimize(&paramValues);
+			}, sysex.size());
+
+			pluginLib::MidiPacket::AnyPartParamValues anyPartValues;
+
+			_bench.run("midipacket/parse singledump, AnyPartParamValues", [&]
+			{
+				data.clear();
+				anyPartValues.clear();
+				packet->parse(data, anyPartValues, descriptions, sysex);
+				doNotOptimize(anyPartValues.data());
+			}, sysex.size());
+		}
+
+		void runPatchDbSearch(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("patchdb/"))
+				return;
+
+			using namespace pluginLib::patchDB;
+
+			constexpr uint32_t patchCount = 1000000;
+
+			const char* categories[] = {"Acid", "Arpeggiator", "Atomizer", "Bass", "Classic", "Decay", "Digital", "Drums", "EFX", "FM", "Input", "Lead", "Organ", "Pad", "Percussion", "Piano", "Pluck", "String", "Vocoder", "Favourites"};
+			const char* words[] = {"Deep", "Bright", "Warm", "Dark", "Soft", "Hard", "Fat", "Thin", "Wide", "Sweep", "Noise", "Glass", "Metal", "Dream", "Space"};
+
+			// the patch manager keeps datasources per bank, with 128 patches each
+			std::vector<DataSourceNodePtr> dataSources;
+
+			for(uint32_t i=0; i<patchCount; ++i)
+			{
+				if((i & 127) == 0)
+				{
+					auto ds = std::make_shared<DataSourceNode>();
+					ds->type = SourceType::File;
+					ds->name = "Bank " + std::to_string(i >> 7);
+					dataSources.push_back(ds);
+				}
+
+				auto p = std::make_shared<Patch>();
+
+				p->name = std::string(words[i % std::size(words)]) + ' ' + words[(i / 7) % std::size(words)] + ' ' + std::to_string(i % 1000);
+				p->program = i & 127;
+				p->bank = i >> 7;
+				p->source = dataSources.back();
+				p->tags.add(TagType::Category, categories[i % std::size(categories)]);
+				if((i % 13) == 0)
+					p->tags.add(TagType::Tag, "Favourite");
+
+				dataSources.back()->patches.insert(std::move(p));
+			}
+
+			// the patch DB runs a search on all of its data sources, or only on the requested one if it is a file
+			auto runSearch = [&](const SearchRequest& _request)
+			{
+				Search search;
+				search.request = _request;
+
+				if(_request.sourceNode && _request.sourceNode->type == SourceType::File)
+				{
+					search.addMatches(*_request.sourceNode);
+				}
+				else
+				{
+					for (const auto& ds : dataSources)
+						search.addMatches(*ds);
+				}
+				return search.getResultSize();
+			};
+
+			SearchRequest byName;
+			byName.name = "sweep";
+
+			_bench.run("patchdb/search 1M patches by name", [&]
+			{
+				const auto count = runSearch(byName);
+				doNotOptimize(&count);
+			});
+
+			SearchRequest byTag;
+			byTag.tags.add(TagType::Category, "Pad");
+
+			_bench.run("patchdb/search 1M patches by category", [&]
+			{
+				const auto count = runSearch(byTag);
+				doNotOptimize(&count);
+			});
+
+			SearchRequest byNameAndTag;
+			byNameAndTag.name = "dark";
+			byNameAndTag.tags.add(TagType::Tag, "Favourite");
+
+			_bench.run("patchdb/search 1M patches by name and tag", [&]
+			{
+				const auto count = runSearch(byNameAndTag);
+				doNotOptimize(&count);
+			});
+
+			SearchRequest bySource;
+			bySource.sourceNode = dataSources[dataSources.size() / 2];
+			bySource.sourceType = SourceType::File;
+
+			_bench.run("patchdb/search 1M patches by datasource", [&]
+			{
+				const auto count = runSearch(bySource);
+				doNotOptimize(&count);
+			});
+		}
+	}
+
+	void runPluginLibBenchmarks(const Benchmark& _bench)
+	{
+		runMidiPacket(_bench);
+		runPatchDbSearch(_bench);
+	}
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "../synthLib/audioDiff.h"
+#include "../synthLib/audiobuffer.h"
+#include "../synthLib/binarystream.h"
+#include "../synthLib/midiBufferParser.h"
+#include "../synthLib/midiToSysex.h"
+#include "../synthLib/resampler.h"
+
+namespace microBenchmarks
+{
+	namespace
+	{
+		constexpr uint32_t g_blockSize = 512;
+
+		// sine with a bit of harmonics, the content does not matter for the resampler but denormals and silence might
+		void fillSignal(float* _dst, const size_t _count, const float _frequency)
+		{
+			for(size_t i=0; i<_count; ++i)
+			{
+				const auto t = static_cast<float>(i) * _frequency;
+				_dst[i] = 0.5f * std::sin(t) + 0.25f * std::sin(t * 3.0f);
+			}
+		}
+
+		void runResampler(const Benchmark& _bench, const float _samplerateIn, const float _samplerateOut)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "resampler/%.0f -> %.0f, stereo, %u", _samplerateIn, _samplerateOut, g_blockSize);
+
+			if(!_bench.isEnabled(name))
+				return;
+
+			synthLib::Resampler resampler(_samplerateIn, _samplerateOut);
+
+			// large enough to deliver input for any of the ratios below
+			std::vector<float> input(g_blockSize * 4);
+			fillSignal(input.data(), input.size(), 0.01f);
+
+			std::vector<float> outL(g_blockSize), outR(g_blockSize);
+
+			synthLib::TAudioOutputs outputs{};
+			outputs[0] = outL.data();
+			outputs[1] = outR.data();
+
+			const auto processFunc = [&input](const synthLib::TAudioOutputs& _in, const uint32_t _count)
+			{
+				std::copy_n(input.data(), _count, _in[0]);
+				std::copy_n(input.data(), _count, _in[1]);
+			};
+
+			_bench.run(name, [&]
+			{
+				resampler.process(outputs, 2, g_blockSize, false, processFunc);
+				doNotOptimize(outL.data());
+			}, g_blockSize * 2 * sizeof(float));
+		}
+
+		void runAudioBuffer(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("audiobuffer/"))
+				return;
+
+			// the plugin keeps a few blocks of latency in its buffers and moves one host block per process call
+			constexpr size_t channels = 2;
+			constexpr size_t latency = 4 * g_blockSize;
+
+			std::vector<float> inL(g_blockSize), inR(g_blockSize);
+			fillSignal(inL.data(), inL.size(), 0.01f);
+			fillSignal(inR.data(), inR.size(), 0.02f);
+
+			synthLib::TAudioInputs inputs{};
+			inputs[0] = inL.data();
+			inputs[1] = inR.data();
+
+			synthLib::AudioBuffer buffer(channels, latency + g_blockSize);
+			buffer.insertZeroes(latency);
+
+			_bench.run("audiobuffer/append + remove, stereo, 512", [&]
+			{
+				buffer.append(inputs, g_blockSize);
+				buffer.remove(g_blockSize);
+				doNotOptimize(buffer.getChannel(0));
+			}, g_blockSize * channels * sizeof(float));
+
+			synthLib::AudioBuffer buffer6(6, latency + g_blockSize);
+			buffer6.insertZeroes(latency);
+
+			std::array<std::vector<float>, 6> in6;
+			for (auto& in : in6)
+				in.assign(g_blockSize, 0.1f);
+
+			_bench.run("audiobuffer/append + remove, 6 channels, 512", [&]
+			{
+				const float* ptrs[6] = {in6[0].data(), in6[1].data(), in6[2].data(), in6[3].data(), in6[4].data(), in6[5].data()};
+				buffer6.append(ptrs, g_blockSize);
+				buffer6.remove(g_blockSize);
+				doNotOptimize(buffer6.getChannel(0));
+			}, g_blockSize * 6 * sizeof(float));
+		}
+
+		void runAudioDiff(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("audiodiff/"))
+				return;
+
+			// ten seconds of 24 bit stereo at the rate of the Virus models, the size of a typical integration test render
+			constexpr size_t frames = 468750;
+			constexpr uint32_t channels = 2;
+
+			std::vector<float> signal(frames);
+			fillSignal(signal.data(), signal.size(), 0.01f);
+
+			std::vector<uint8_t> a(frames * channels * 3);
+			for(size_t i=0; i<frames * channels; ++i)
+			{
+				const auto v = static_cast<int32_t>(signal[i / channels] * 8388607.0f);
+				a[i * 3 + 0] = static_cast<uint8_t>(v);
+				a[i * 3 + 1] = static_cast<uint8_t>(v >> 8);
+				a[i * 3 + 2] = static_cast<uint8_t>(v >> 16);
+			}
+
+			const auto identical = a;
+
+			// second copy with a regression in one percent of the frames, spread across the file
+			auto b = a;
+			for(size_t f=0; f<frames; f += 100)
+				b[f * channels * 3] ^= 1;
+
+			const synthLib::AudioDiff::Config config;
+
+			_bench.run("audiodiff/identical, 24 bit stereo, 10s", [&]
+			{
+				synthLib::AudioDiff::Result r;
+				synthLib::AudioDiff::compare(r, a.data(), frames, synthLib::SampleFormat::Int24, identical.data(), frames, synthLib::SampleFormat::Int24, channels, config);
+				doNotOptimize(&r);
+			}, a.size() * 2);
+
+			_bench.run("audiodiff/1% mismatch, 24 bit stereo, 10s", [&]
+			{
+				synthLib::AudioDiff::Result r;
+				synthLib::AudioDiff::compare(r, a.data(), frames, synthLib::SampleFormat::Int24, b.data(), frames, synthLib::SampleFormat::Int24, channels, config);
+				doNotOptimize(&r);
+			}, a.size() * 2);
+		}
+
+		// Writes data in the layout of the patch manager cache: one chunk per patch containing name, bank, hash and sysex
+		void writePatches(synthLib::BinaryStream& _s, const uint32_t _count, const std::vector<uint8_t>& _sysex)
+		{
+			synthLib::ChunkWriter cw(_s, "PTCS", 1);
+
+			_s.write(_count);
+
+			for(uint32_t i=0; i<_count; ++i)
+			{
+				synthLib::ChunkWriter cwPatch(_s, "PTCH", 1);
+				_s.write(std::string("Patch ") + std::to_string(i));
+				_s.write(i >> 7);
+				std::array<uint8_t, 16> hash{};
+				hash[0] = static_cast<uint8_t>(i);
+				_s.write(hash);
+				_s.write(_sysex);
+			}
+		}
+
+		void runBinaryStream(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("binarystream/"))
+				return;
+
+			constexpr uint32_t patchCount = 1024;
+
+			std::vector<uint8_t> sysex(267);
+			for(size_t i=0; i<sysex.size(); ++i)
+				sysex[i] = static_cast<uint8_t>(i & 0x7f);
+
+			std::vector<uint8_t> data;
+			{
+				synthLib::BinaryStream s;
+				writePatches(s, patchCount, sysex);
+				s.toVector(data);
+			}
+
+			_bench.run("binarystream/write 1024 patch chunks", [&]
+			{
+				synthLib::BinaryStream s;
+				writePatches(s, patchCount, sysex);
+				doNotOptimize(&s);
+			}, data.size());
+
+			_bench.run("binarystream/read 1024 patch chunks", [&]
+			{
+				synthLib::BinaryStream s(data);
+
+				size_t total = 0;
+
+				auto in = s.tryReadChunk("PTCS", 1);
+				if(!in)
+					return;
+
+				const auto count = in.read<uint32_t>();
+
+				std::vector<uint8_t> patchSysex;
+
+				for(uint32_t i=0; i<count; ++i)
+				{
+					auto p = in.tryReadChunk("PTCH", 1);
+					if(!p)
+						break;
+					const auto name = p.readString();
+					const auto bank = p.read<uint32_t>();
+					const auto hash = p.read<std::array<uint8_t, 16>>();
+					p.read(patchSysex);
+					total += name.size() + bank + hash[0] + patchSysex.size();
+				}
+				doNotOptimize(&total);
+			}, data.size());
+		}
+
+		void runSysex(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("sysex/"))
+				return;
+
+			// a plain .syx bank dump, 1024 Virus single dumps back to back
+			std::vector<uint8_t> data;
+			for(uint32_t m=0; m<1024; ++m)
+			{
+				data.insert(data.end(), {0xf0, 0x00, 0x20, 0x33, 0x01, 0x00, 0x10, static_cast<uint8_t>((m >> 7) & 0x7f), static_cast<uint8_t>(m & 0x7f)});
+				for(uint32_t i=0; i<256; ++i)
+					data.push_back(static_cast<uint8_t>((i * 7 + m) & 0x7f));
+				data.push_back(0x00);
+				data.push_back(0xf7);
+			}
+
+			_bench.run("sysex/MidiToSysex::extractSysexFromData .syx", [&]
+			{
+				std::vector<std::vector<uint8_t>> messages;
+				synthLib::MidiToSysex::extractSysexFromData(messages, data);
+				doNotOptimize(messages.data());
+			}, data.size());
+
+			_bench.run("sysex/splitMultipleSysex spans .syx", [&]
+			{
+				std::vector<synthLib::SysexSpan> messages;
+				synthLib::MidiToSysex::splitMultipleSysex(messages, data.data(), data.size(), false);
+				doNotOptimize(messages.data());
+			}, data.size());
+		}
+
+		void runMidiBufferParser(const Benchmark& _bench)
+		{
+			if(!_bench.isGroupEnabled("midiparser/"))
+				return;
+
+			// dense controller stream as sent by a hardware controller: running status, interleaved with clock ticks
+			std::vector<uint8_t> controllers{synthLib::M_CONTROLCHANGE};
+			for(uint32_t i=0; i<4096; ++i)
+			{
+				controllers.push_back(static_cast<uint8_t>(i & 0x1f));
+				controllers.push_back(static_cast<uint8_t>((i * 3) & 0x7f));
+				if((i & 31) == 0)
+					controllers.push_back(synthLib::M_TIMINGCLOCK);
+			}
+
+			// 64 Virus single dumps back to back
+			std::vector<uint8_t> sysex;
+			for(uint32_t m=0; m<64; ++m)
+			{
+				sysex.insert(sysex.end(), {0xf0, 0x00, 0x20, 0x33, 0x01, 0x00, 0x10, 0x01, static_cast<uint8_t>(m)});
+				for(uint32_t i=0; i<256; ++i)
+					sysex.push_back(static_cast<uint8_t>((i * 7 + m) & 0x7f));
+				sysex.push_back(0x00);
+				sysex.push_back(0xf7);
+			}
+
+			synthLib::MidiBufferParser parser;
+
+			// chunks of 64 bytes with one timestamp each, the size of a typical USB MIDI transfer
+			auto parse = [&parser](const std::vector<uint8_t>& _data)
+			{
+				parser.clear();
+				for(size_t i=0; i<_data.size(); i += 64)
+					parser.write(_data.data() + i, std::min<size_t>(64, _data.size() - i), static_cast<uint32_t>(i));
+				doNotOptimize(parser.begin());
+			};
+
+			_bench.run("midiparser/running status controllers", [&] { parse(controllers); }, controllers.size());
+			_bench.run("midiparser/sysex single dumps", [&] { parse(sysex); }, sysex.size());
+		}
+	}
+
+	void runSynthLibBenchmarks(const Benchmark& _bench)
+	{
+		// common host rates against the rates that the Virus models run at
+		runResampler(_bench, 46875.0f, 44100.0f);
+		runResampler(_bench, 46875.0f, 48000.0f);
+		runResampler(_bench, 46875.0f, 96000.0f);
+		runResampler(_bench, 44100.0f, 48000.0f);
+		runResampler(_bench, 48000.0f, 44100.0f);
+
+		runAudioBuffer(_bench);
+		runAudioDiff(_bench);
+		runBinaryStream(_bench);
+		runSysex(_bench);
+		runMidiBufferParser(_bench);
+	}
+}
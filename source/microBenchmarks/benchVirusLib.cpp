@@ -0,0 +1,52 @@
+#include <vector>
+
+#include "benchmark.h"
+
+#include "../virusLib/hdi08TxParser.h"
+#include "../virusLib/romfile.h"
+
+namespace microBenchmarks
+{
+	void runVirusLibBenchmarks(const Benchmark& _bench)
+	{
+		if(!_bench.isGroupEnabled("hdi08tx/"))
+			return;
+
+		// The parser only needs the ROM for status reports and presets without a known size, neither happens here
+		const auto rom = virusLib::ROMFile::invalid();
+
+		// Words that the DSP sends while running that are not MIDI, presets or status reports
+		std::vector<dsp56k::TWord> dspWords;
+		dspWords.reserve(4096);
+		for(uint32_t i=0; i<4096; ++i)
+			dspWords.push_back(0x010000 + ((i * 0x1357) & 0x0fffff));
+
+		virusLib::Hdi08TxParser parser(rom);
+
+		_bench.run("hdi08tx/append 4096 DSP words", [&]
+		{
+			for (const auto w : dspWords)
+				parser.append(w);
+			doNotOptimize(&parser);
+		}, dspWords.size() * sizeof(dsp56k::TWord));
+
+		// A preset upgrade as requested by the microcontroller: start marker, then three bytes per word
+		const auto presetSize = virusLib::ROMFile::getSinglePresetSize();
+
+		std::vector<dsp56k::TWord> presetWords;
+		presetWords.push_back(0xf400f4);
+		for(uint32_t i=0; i<presetSize; i += 3)
+			presetWords.push_back(((i & 0x7f) << 16) | (((i + 1) & 0x7f) << 8) | ((i + 2) & 0x7f));
+
+		std::vector<uint8_t> preset;
+
+		_bench.run("hdi08tx/append single preset upgrade", [&]
+		{
+			parser.waitForPreset(presetSize);
+			for (const auto w : presetWords)
+				parser.append(w);
+			parser.getPresetData(preset);
+			doNotOptimize(preset.data());
+		}, presetWords.size() * sizeof(dsp56k::TWord));
+	}
+}
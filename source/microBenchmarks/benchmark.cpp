@@ -0,0 +1,80 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace microBenchmarks
+{
+	constexpr uint32_t g_runCount = 5;
+
+	namespace
+	{
+		const void* volatile g_sink = nullptr;
+	}
+	constexpr double g_minRunSeconds = 0.1;
+
+	void Benchmark::run(const std::string& _name, const TFunc& _func, const size_t _bytesPerIteration) const
+	{
+		if(!isEnabled(_name))
+			return;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		auto measure = [&_func](const uint64_t _iterations)
+		{
+			const auto start = Clock::now();
+			for(uint64_t i=0; i<_iterations; ++i)
+				_func();
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		};
+
+		// warm up and find an iteration count that is large enough to be measured reliably
+		uint64_t iterations = 1;
+		while(true)
+		{
+			const auto t = measure(iterations);
+			if(t >= g_minRunSeconds || iterations >= (1ull<<30))
+				break;
+			iterations = t > 0.0 ? std::max(iterations * 2, static_cast<uint64_t>(static_cast<double>(iterations) * g_minRunSeconds / t * 1.2)) : iterations * 10;
+		}
+
+		std::vector<double> results;
+		results.reserve(g_runCount);
+
+		for(uint32_t r=0; r<g_runCount; ++r)
+			results.push_back(measure(iterations) / static_cast<double>(iterations));
+
+		std::sort(results.begin(), results.end());
+
+		const auto best = results.front();
+		const auto median = results[results.size()>>1];
+
+		printf("%-48s %12.1f ns %12.1f ns median", _name.c_str(), best * 1e9, median * 1e9);
+
+		if(_bytesPerIteration)
+			printf(" %10.1f MB/s", static_cast<double>(_bytesPerIteration) / best / (1024.0 * 1024.0));
+
+		printf("\n");
+		fflush(stdout);
+	}
+
+	bool Benchmark::isEnabled(const std::string& _name) const
+	{
+		return m_filter.empty() || _name.find(m_filter) != std::string::npos;
+	}
+
+	bool Benchmark::isGroupEnabled(const std::string& _group) const
+	{
+		if(m_filter.empty() || m_filter.find('/') == std::string::npos)
+			return true;
+
+		return _group.find(m_filter) != std::string::npos || m_filter.compare(0, _group.size(), _group) == 0;
+	}
+
+	void doNotOptimize(const void* _p)
+	{
+		g_sink = _p;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace microBenchmarks
+{
+	// Runs a function repeatedly and reports the time per iteration. The iteration count is chosen automatically so that
+	// a single run takes long enough to be measurable, the best of several runs is reported to reduce noise
+	class Benchmark
+	{
+	public:
+		using TFunc = std::function<void()>;
+
+		explicit Benchmark(std::string _filter) : m_filter(std::move(_filter)) {}
+
+		// _bytesPerIteration is optional and used to report throughput
+		void run(const std::string& _name, const TFunc& _func, size_t _bytesPerIteration = 0) const;
+
+		bool isEnabled(const std::string& _name) const;
+
+		// Returns false if the filter excludes all benchmarks whose names start with _group, such as "smf/", to skip
+		// their setup. The filter may be a part of the group or a full benchmark name, a filter without a group
+		// separator may match any benchmark and never excludes a group
+		bool isGroupEnabled(const std::string& _group) const;
+
+	private:
+		const std::string m_filter;
+	};
+
+	// prevents the compiler from optimizing away results that are not used otherwise
+	void doNotOptimize(const void* _p);
+}
@@ -0,0 +1,34 @@
+#include <cstdio>
+
+#include "benchmark.h"
+
+namespace microBenchmarks
+{
+	void runMidiFileParserBenchmarks(const Benchmark& _bench);
+	void runSynthLibBenchmarks(const Benchmark& _bench);
+#if MICROBENCHMARKS_VIRUSLIB
+	void runVirusLibBenchmarks(const Benchmark& _bench);
+#endif
+#if MICROBENCHMARKS_PLUGINLIB
+	void runPluginLibBenchmarks(const Benchmark& _bench);
+#endif
+}
+
+int main(const int _argc, char* _argv[])
+{
+	// optional argument: only run benchmarks whose name contains the given string
+	const microBenchmarks::Benchmark bench(_argc > 1 ? _argv[1] : "");
+
+	printf("%-48s %15s %22s\n", "benchmark", "best", "median");
+
+	microBenchmarks::runMidiFileParserBenchmarks(bench);
+	microBenchmarks::runSynthLibBenchmarks(bench);
+#if MICROBENCHMARKS_VIRUSLIB
+	microBenchmarks::runVirusLibBenchmarks(bench);
+#endif
+#if MICROBENCHMARKS_PLUGINLIB
+	microBenchmarks::runPluginLibBenchmarks(bench);
+#endif
+
+	return 0;
+}
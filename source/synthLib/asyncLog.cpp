@@ -0,0 +1,317 @@
+#include "asyncLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "spscRingBuffer.h"
+
+#include "dsp56kEmu/logging.h"
+
+namespace synthLib
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		constexpr auto g_drainInterval = std::chrono::milliseconds(20);
+
+		uint64_t getTimeNs()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+		}
+
+		// formats into a fixed size buffer, messages that are too long are truncated
+		class FixedStreamBuf : public std::streambuf
+		{
+		public:
+			void reset(char* _buffer, const size_t _size)
+			{
+				setp(_buffer, _buffer + _size);
+			}
+
+			size_t size() const
+			{
+				return static_cast<size_t>(pptr() - pbase());
+			}
+
+		protected:
+			int_type overflow(const int_type _c) override
+			{
+				return traits_type::eof();
+			}
+		};
+
+		struct ThreadRing
+		{
+			SpscRingBuffer<AsyncLog::Message> messages{AsyncLog::MessagesPerThread};
+		};
+
+		struct ThreadState
+		{
+			ThreadState() : stream(&buf) {}
+
+			AsyncLog::Message message;
+			FixedStreamBuf buf;
+			std::ostream stream;
+			std::shared_ptr<ThreadRing> ring;
+		};
+
+		struct State
+		{
+			std::mutex mutex;	// guards the list of rings and the consumer side of all rings
+			std::vector<std::shared_ptr<ThreadRing>> rings;
+
+			std::mutex drainMutex;	// drain() is called by the drain thread and by flush()
+
+			std::mutex sinkMutex;
+			AsyncLog::Sink sink;
+
+			std::mutex threadMutex;
+			std::condition_variable cv;
+			std::thread thread;
+			uint32_t refCount = 0;
+			bool quit = false;
+
+			std::atomic<bool> running{false};
+			std::atomic<uint64_t> dropped{0};
+			uint64_t reportedDropped = 0;
+
+			std::vector<AsyncLog::Message> pending;
+		};
+
+		State& getState()
+		{
+			static State state;
+			return state;
+		}
+
+		ThreadState& getThreadState()
+		{
+			thread_local ThreadState state;
+			return state;
+		}
+
+		ThreadRing& getThreadRing(ThreadState& _ts)
+		{
+			// the ring is created on first use only, threads that never log do not pay for it
+			if(!_ts.ring)
+			{
+				auto& state = getState();
+				std::lock_guard lock(state.mutex);
+				_ts.ring = std::make_shared<ThreadRing>();
+				state.rings.push_back(_ts.ring);
+			}
+			return *_ts.ring;
+		}
+
+		void writeToSink(const AsyncLog::Message& _message)
+		{
+			auto& state = getState();
+
+			std::lock_guard lock(state.sinkMutex);
+
+			if(state.sink)
+			{
+				state.sink(_message);
+				return;
+			}
+
+			const char* prefix = _message.level >= LogLevel::Warning ? AsyncLog::getLevelName(_message.level) : nullptr;
+
+			if(prefix && _message.suppressed)
+				LOG(prefix << ": " << _message.text << " (" << _message.suppressed << " messages suppressed)");
+			else if(prefix)
+				LOG(prefix << ": " << _message.text);
+			else if(_message.suppressed)
+				LOG(_message.text << " (" << _message.suppressed << " messages suppressed)");
+			else
+				LOG(_message.text);
+		}
+
+		void drain()
+		{
+			auto& state = getState();
+
+			std::lock_guard drainLock(state.drainMutex);
+
+			{
+				std::lock_guard lock(state.mutex);
+
+				AsyncLog::Message m;
+
+				for (const auto& ring : state.rings)
+				{
+					while(ring->messages.read(&m, 1))
+						state.pending.push_back(m);
+				}
+
+				// rings that are only referenced by us belong to threads that do not exist anymore
+				state.rings.erase(std::remove_if(state.rings.begin(), state.rings.end(), [](const std::shared_ptr<ThreadRing>& _r)
+				{
+					return _r.use_count() == 1 && _r->messages.empty();
+				}), state.rings.end());
+			}
+
+			if(!state.pending.empty())
+			{
+				// rings are drained one after another, restore the order in which messages have been logged
+				std::stable_sort(state.pending.begin(), state.pending.end(), [](const AsyncLog::Message& _a, const AsyncLog::Message& _b)
+				{
+					return _a.timeNs < _b.timeNs;
+				});
+
+				for (const auto& m : state.pending)
+					writeToSink(m);
+
+				state.pending.clear();
+			}
+
+			const auto dropped = state.dropped.load(std::memory_order_relaxed);
+
+			if(dropped != state.reportedDropped)
+			{
+				LOG("Warning: " << (dropped - state.reportedDropped) << " log messages dropped, log buffer full");
+				state.reportedDropped = dropped;
+			}
+		}
+
+		void drainThreadFunc()
+		{
+			auto& state = getState();
+
+			std::unique_lock lock(state.threadMutex);
+
+			while(!state.quit)
+			{
+				state.cv.wait_for(lock, g_drainInterval, [&state] { return state.quit; });
+
+				lock.unlock();
+				drain();
+				lock.lock();
+			}
+		}
+	}
+
+	std::ostream& AsyncLog::begin()
+	{
+		auto& ts = getThreadState();
+		ts.buf.reset(ts.message.text, MaxMessageLength);
+		ts.stream.clear();
+		return ts.stream;
+	}
+
+	void AsyncLog::commit(const LogLevel _level, const char* _file, const uint32_t _line, const uint32_t _suppressed)
+	{
+		auto& ts = getThreadState();
+		auto& m = ts.message;
+
+		m.length = static_cast<uint16_t>(ts.buf.size());
+		m.text[m.length] = 0;
+		m.level = _level;
+		m.file = _file;
+		m.line = _line;
+		m.timeNs = getTimeNs();
+		m.suppressed = _suppressed;
+
+		auto& state = getState();
+
+		if(!state.running.load(std::memory_order_acquire))
+		{
+			writeToSink(m);
+			return;
+		}
+
+		if(!getThreadRing(ts).messages.write(&m, 1))
+			state.dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void AsyncLog::acquire()
+	{
+		auto& state = getState();
+
+		std::lock_guard lock(state.threadMutex);
+
+		if(state.refCount++)
+			return;
+
+		state.quit = false;
+		state.running.store(true, std::memory_order_release);
+		state.thread = std::thread(&drainThreadFunc);
+	}
+
+	void AsyncLog::release()
+	{
+		auto& state = getState();
+
+		std::unique_lock lock(state.threadMutex);
+
+		if(!state.refCount || --state.refCount)
+			return;
+
+		state.running.store(false, std::memory_order_release);
+		state.quit = true;
+		state.cv.notify_one();
+
+		auto thread = std::move(state.thread);
+		lock.unlock();
+
+		if(thread.joinable())
+			thread.join();
+
+		flush();
+	}
+
+	void AsyncLog::flush()
+	{
+		drain();
+	}
+
+	void AsyncLog::setSink(Sink _sink)
+	{
+		auto& state = getState();
+		std::lock_guard lock(state.sinkMutex);
+		state.sink = std::move(_sink);
+	}
+
+	uint64_t AsyncLog::getDroppedCount()
+	{
+		return getState().dropped.load(std::memory_order_relaxed);
+	}
+
+	const char* AsyncLog::getLevelName(const LogLevel _level)
+	{
+		switch (_level)
+		{
+		case LogLevel::Debug:	return "Debug";
+		case LogLevel::Info:	return "Info";
+		case LogLevel::Warning:	return "Warning";
+		case LogLevel::Error:	return "Error";
+		default:				return "";
+		}
+	}
+
+	bool LogRateLimiter::allow(uint32_t& _suppressed)
+	{
+		const auto now = getTimeNs();
+
+		auto start = m_intervalStartNs.load(std::memory_order_relaxed);
+
+		// the first caller that notices an expired interval starts a new one
+		if(now - start >= IntervalNs && m_intervalStartNs.compare_exchange_strong(start, now, std::memory_order_relaxed))
+			m_count.store(0, std::memory_order_relaxed);
+
+		if(m_count.fetch_add(1, std::memory_order_relaxed) < MaxMessagesPerInterval)
+		{
+			_suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+
+		m_suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+}
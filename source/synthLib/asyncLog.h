@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+#include "buildconfig.h"
+
+namespace synthLib
+{
+	enum class LogLevel : uint8_t
+	{
+		Debug,
+		Info,
+		Warning,
+		Error,
+		Off
+	};
+
+	// Logging backend for code that runs on the audio or DSP threads. Messages are formatted into a fixed size buffer
+	// on the calling thread and pushed into a ring buffer owned by that thread, a background thread drains all rings and
+	// writes the messages. Logging a message does not lock or allocate, except for the first message on a thread, which
+	// allocates the ring. If a ring is full, messages are dropped and counted.
+	//
+	// The drain thread runs while at least one device exists, see acquire()/release(). Without it, messages are written
+	// synchronously on the calling thread, which is what tools and tests want
+	class AsyncLog
+	{
+	public:
+		static constexpr uint32_t MaxMessageLength = 255;
+		static constexpr uint32_t MessagesPerThread = 256;
+
+		struct Message
+		{
+			LogLevel level = LogLevel::Info;
+			uint32_t line = 0;
+			const char* file = nullptr;
+			uint64_t timeNs = 0;
+			uint32_t suppressed = 0;	// number of messages dropped by the rate limiter before this one
+			uint16_t length = 0;
+			char text[MaxMessageLength + 1]{};
+		};
+
+		using Sink = std::function<void(const Message&)>;
+
+		// Returns a stream that formats into the buffer of the calling thread, needs to be followed by commit()
+		static std::ostream& begin();
+		static void commit(LogLevel _level, const char* _file, uint32_t _line, uint32_t _suppressed);
+
+		// Reference counted, the drain thread runs while the count is above zero and all pending messages are written
+		// when it stops
+		static void acquire();
+		static void release();
+
+		// Writes all pending messages on the calling thread
+		static void flush();
+
+		// Replaces the default sink that writes via dsp56k LOG(). Called from the drain thread
+		static void setSink(Sink _sink);
+
+		static uint64_t getDroppedCount();
+
+		static const char* getLevelName(LogLevel _level);
+	};
+
+	// Allows a limited number of messages per second per call site, the number of suppressed messages is reported with
+	// the next message that passes. Constant-initialized, a function-local static does not need a guard
+	class LogRateLimiter
+	{
+	public:
+		static constexpr uint64_t IntervalNs = 1000000000;
+		static constexpr uint32_t MaxMessagesPerInterval = 20;
+
+		constexpr LogRateLimiter() = default;
+
+		bool allow(uint32_t& _suppressed);
+
+	private:
+		std::atomic<uint64_t> m_intervalStartNs{0};
+		std::atomic<uint32_t> m_count{0};
+		std::atomic<uint32_t> m_suppressed{0};
+	};
+}
+
+// Messages below SYNTHLIB_LOG_LEVEL are removed at compile time, including the evaluation of their arguments
+#define SYNTHLIB_LOG_AT(LEVEL, S)																		\
+	do																									\
+	{																									\
+		if constexpr (static_cast<int>(LEVEL) >= SYNTHLIB_LOG_LEVEL)									\
+		{																								\
+			static ::synthLib::LogRateLimiter logRateLimiter;											\
+			uint32_t logSuppressed;																		\
+			if(logRateLimiter.allow(logSuppressed))														\
+			{																							\
+				::synthLib::AsyncLog::begin() << S;														\
+				::synthLib::AsyncLog::commit(LEVEL, __FILE__, __LINE__, logSuppressed);					\
+			}																							\
+		}																								\
+	} while(false)
+
+#define SYNTHLIB_LOG_DEBUG(S)	SYNTHLIB_LOG_AT(::synthLib::LogLevel::Debug, S)
+#define SYNTHLIB_LOG_INFO(S)	SYNTHLIB_LOG_AT(::synthLib::LogLevel::Info, S)
+#define SYNTHLIB_LOG_WARNING(S)	SYNTHLIB_LOG_AT(::synthLib::LogLevel::Warning, S)
+#define SYNTHLIB_LOG_ERROR(S)	SYNTHLIB_LOG_AT(::synthLib::LogLevel::Error, S)
@@ -0,0 +1,302 @@
+#include "audioDiff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#if defined(HAVE_SSE) || defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SYNTHLIB_AUDIODIFF_SSE 1
+#else
+#define SYNTHLIB_AUDIODIFF_SSE 0
+#endif
+
+namespace synthLib
+{
+	namespace
+	{
+		constexpr size_t g_blockFrames = 1024;
+
+		std::string toDb(const double _v)
+		{
+			if(_v <= 0.0)
+				return "-inf dB";
+			std::stringstream ss;
+			ss.precision(1);
+			ss << std::fixed << 20.0 * std::log10(_v) << " dB";
+			return ss.str();
+		}
+
+		std::string frameToString(const size_t _frame, const float _samplerate)
+		{
+			std::stringstream ss;
+			ss << _frame;
+			if(_samplerate > 0.0f)
+			{
+				ss.precision(3);
+				ss << " (" << std::fixed << static_cast<double>(_frame) / _samplerate << "s)";
+			}
+			return ss.str();
+		}
+	}
+
+	std::string AudioDiff::Result::toString(const float _samplerate) const
+	{
+		std::stringstream ss;
+
+		if(frameCountA != frameCountB)
+			ss << "Length differs, " << frameCountA << " frames vs " << frameCountB << " frames" << std::endl;
+
+		if(mismatchingSamples == 0)
+		{
+			ss << "Compared " << comparedFrames << " frames, no mismatches";
+			if(maxError > 0.0f)
+				ss << ", max error " << maxError << " (" << toDb(maxError) << ')';
+			ss << std::endl;
+			return ss.str();
+		}
+
+		ss << mismatchingFrames << " of " << comparedFrames << " frames mismatch, " << mismatchingSamples << " samples, first frame " << frameToString(firstFrame, _samplerate)
+			<< ", last frame " << frameToString(lastFrame, _samplerate) << ", max error " << maxError << " (" << toDb(maxError) << ')' << std::endl;
+
+		for(size_t c=0; c<channels.size(); ++c)
+		{
+			const auto& ch = channels[c];
+
+			ss << "  channel " << c << ": " << ch.mismatches << " mismatches";
+			if(ch.maxErrorFrame != InvalidFrame)
+				ss << ", max error " << ch.maxError << " (" << toDb(ch.maxError) << ") at frame " << frameToString(ch.maxErrorFrame, _samplerate);
+			ss << ", rms " << ch.rms << " (" << toDb(ch.rms) << ')' << std::endl;
+		}
+
+		ss << "  " << rangeCount << " ranges:";
+		for(size_t i=0; i<ranges.size(); ++i)
+			ss << (i ? ", " : " ") << frameToString(ranges[i].first, _samplerate) << " - " << frameToString(ranges[i].last, _samplerate);
+		if(rangeCount > ranges.size())
+			ss << " ... (" << (rangeCount - ranges.size()) << " more)";
+		ss << std::endl;
+
+		return ss.str();
+	}
+
+	bool AudioDiff::compare(Result& _result, const WavFile& _a, const WavFile& _b, const Config& _config)
+	{
+		if(!_a.isValid() || !_b.isValid())
+			return false;
+
+		if(_a.getChannelCount() != _b.getChannelCount() || _a.getSamplerate() != _b.getSamplerate())
+			return false;
+
+		return compare(_result,
+			static_cast<const uint8_t*>(_a.getData().data), _a.getFrameCount(), _a.getFormat(),
+			static_cast<const uint8_t*>(_b.getData().data), _b.getFrameCount(), _b.getFormat(),
+			_a.getChannelCount(), _config);
+	}
+
+	bool AudioDiff::compare(Result& _result, const uint8_t* _a, const size_t _frameCountA, const SampleFormat _formatA, const uint8_t* _b, const size_t _frameCountB, const SampleFormat _formatB, const uint32_t _channelCount, const Config& _config)
+	{
+		const auto sampleSizeA = getSampleSize(_formatA);
+		const auto sampleSizeB = getSampleSize(_formatB);
+
+		if(!sampleSizeA || !sampleSizeB || !_channelCount)
+			return false;
+
+		_result = Result();
+		_result.frameCountA = _frameCountA;
+		_result.frameCountB = _frameCountB;
+		_result.comparedFrames = std::min(_frameCountA, _frameCountB);
+		_result.channels.resize(_channelCount);
+
+		const auto frameSizeA = sampleSizeA * _channelCount;
+		const auto frameSizeB = sampleSizeB * _channelCount;
+
+		const bool sameFormat = _formatA == _formatB;
+		const bool bitExact = _config.tolerance <= 0.0f;
+
+		std::vector<float> a(g_blockFrames), b(g_blockFrames), diff(g_blockFrames);
+		std::vector<uint8_t> frameMismatch(g_blockFrames);
+		std::vector<double> sumSquares(_channelCount, 0.0);
+
+		Range range;
+		bool hasRange = false;
+
+		auto addRange = [&]
+		{
+			++_result.rangeCount;
+			if(_result.ranges.size() < _config.maxRanges)
+				_result.ranges.push_back(range);
+		};
+
+		for(size_t offset = 0; offset < _result.comparedFrames; offset += g_blockFrames)
+		{
+			const auto count = std::min(g_blockFrames, _result.comparedFrames - offset);
+
+			const auto* blockA = _a + offset * frameSizeA;
+			const auto* blockB = _b + offset * frameSizeB;
+
+			size_t start = 0;
+
+			// most of the data is identical in a regression test, skip it without conversion
+			if(sameFormat)
+			{
+				const auto size = count * frameSizeA;
+				const auto pos = findFirstDifference(blockA, blockB, size);
+				if(pos == size)
+					continue;
+				start = pos / frameSizeA;
+			}
+
+			std::fill_n(frameMismatch.begin(), count, 0);
+
+			for(uint32_t c=0; c<_channelCount; ++c)
+			{
+				const ChannelView viewA(blockA + c * sampleSizeA, count, frameSizeA, _formatA);
+				const ChannelView viewB(blockB + c * sampleSizeB, count, frameSizeB, _formatB);
+
+				viewA.read(a.data(), start, count - start);
+				viewB.read(b.data(), start, count - start);
+
+				const auto n = count - start;
+
+				// plain loops without dependencies between iterations, the compiler vectorizes these. Non-finite samples
+				// are reported as an infinite error, NaN would pass every comparison with the tolerance
+				for(size_t i=0; i<n; ++i)
+				{
+					const auto d = std::fabs(a[i] - b[i]);
+					diff[i] = d <= std::numeric_limits<float>::max() ? d : std::numeric_limits<float>::infinity();
+				}
+
+				double sum = 0.0;
+				float maxError = 0.0f;
+
+				for(size_t i=0; i<n; ++i)
+				{
+					sum += static_cast<double>(diff[i]) * diff[i];
+					maxError = std::max(maxError, diff[i]);
+				}
+
+				sumSquares[c] += sum;
+
+				auto& ch = _result.channels[c];
+
+				if(maxError > ch.maxError)
+				{
+					ch.maxError = maxError;
+					ch.maxErrorFrame = offset + start + static_cast<size_t>(std::find(diff.begin(), diff.begin() + static_cast<ptrdiff_t>(n), maxError) - diff.begin());
+				}
+
+				for(size_t i=0; i<n; ++i)
+				{
+					bool mismatch;
+
+					if(!bitExact)
+						mismatch = !(diff[i] <= _config.tolerance);
+					else if(sameFormat)
+						mismatch = memcmp(viewA.getRaw(start + i), viewB.getRaw(start + i), sampleSizeA) != 0;
+					else
+						mismatch = a[i] != b[i];
+
+					if(!mismatch)
+						continue;
+
+					++ch.mismatches;
+					++_result.mismatchingSamples;
+					frameMismatch[start + i] = 1;
+				}
+			}
+
+			for(size_t i=start; i<count; ++i)
+			{
+				if(!frameMismatch[i])
+					continue;
+
+				const auto frame = offset + i;
+
+				++_result.mismatchingFrames;
+
+				if(_result.firstFrame == InvalidFrame)
+					_result.firstFrame = frame;
+				_result.lastFrame = frame;
+
+				if(hasRange && frame - range.last <= _config.rangeGap)
+				{
+					range.last = frame;
+					continue;
+				}
+
+				if(hasRange)
+					addRange();
+
+				range.first = range.last = frame;
+				hasRange = true;
+			}
+		}
+
+		if(hasRange)
+			addRange();
+
+		for(size_t c=0; c<_channelCount; ++c)
+		{
+			auto& ch = _result.channels[c];
+			ch.rms = _result.comparedFrames ? std::sqrt(sumSquares[c] / static_cast<double>(_result.comparedFrames)) : 0.0;
+			_result.maxError = std::max(_result.maxError, ch.maxError);
+		}
+
+		return true;
+	}
+
+	size_t AudioDiff::findFirstDifference(const uint8_t* _a, const uint8_t* _b, const size_t _size)
+	{
+		size_t i = 0;
+
+#if SYNTHLIB_AUDIODIFF_SSE
+		// 64 bytes per iteration, the loop exits as soon as any byte differs
+		for(; i + 64 <= _size; i += 64)
+		{
+			const auto* a = reinterpret_cast<const __m128i*>(_a + i);
+			const auto* b = reinterpret_cast<const __m128i*>(_b + i);
+
+			const auto eq0 = _mm_cmpeq_epi8(_mm_loadu_si128(a + 0), _mm_loadu_si128(b + 0));
+			const auto eq1 = _mm_cmpeq_epi8(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));
+			const auto eq2 = _mm_cmpeq_epi8(_mm_loadu_si128(a + 2), _mm_loadu_si128(b + 2));
+			const auto eq3 = _mm_cmpeq_epi8(_mm_loadu_si128(a + 3), _mm_loadu_si128(b + 3));
+
+			const auto eq = _mm_and_si128(_mm_and_si128(eq0, eq1), _mm_and_si128(eq2, eq3));
+
+			if(_mm_movemask_epi8(eq) != 0xffff)
+				break;
+		}
+#else
+		// memcmp is vectorized by the C runtime, it is used to skip large identical chunks
+		constexpr size_t chunkSize = 4096;
+
+		for(; i + chunkSize <= _size; i += chunkSize)
+		{
+			if(memcmp(_a + i, _b + i, chunkSize) != 0)
+				break;
+		}
+#endif
+
+		for(; i < _size; ++i)
+		{
+			if(_a[i] != _b[i])
+				return i;
+		}
+		return _size;
+	}
+
+	uint32_t AudioDiff::getSampleSize(const SampleFormat _format)
+	{
+		switch (_format)
+		{
+		case SampleFormat::Int16:	return 2;
+		case SampleFormat::Int24:	return 3;
+		case SampleFormat::Int32:	return 4;
+		case SampleFormat::Float32:	return 4;
+		case SampleFormat::Float64:	return 8;
+		default:					return 0;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wavReader.h"
+
+namespace synthLib
+{
+	// Compares two interleaved audio buffers. Blocks of identical raw data are skipped at memory bandwidth, only blocks
+	// that differ are converted to float to gather error statistics. Without a tolerance, any difference in the raw
+	// data of a sample is a mismatch, with a tolerance only samples whose absolute difference exceeds it are
+	class AudioDiff
+	{
+	public:
+		static constexpr size_t InvalidFrame = ~static_cast<size_t>(0);
+
+		struct Config
+		{
+			float tolerance = 0.0f;		// maximum absolute difference that is accepted, full scale is 1.0. 0 = bit exact
+			size_t rangeGap = 256;		// mismatches that are no more than this number of frames apart are merged into one range
+			size_t maxRanges = 64;		// ranges that exceed this limit are counted but not stored
+		};
+
+		// inclusive frame range
+		struct Range
+		{
+			size_t first = 0;
+			size_t last = 0;
+		};
+
+		struct ChannelResult
+		{
+			size_t mismatches = 0;
+			size_t maxErrorFrame = InvalidFrame;
+			float maxError = 0.0f;
+			double rms = 0.0;			// of the difference, over all compared frames
+		};
+
+		struct Result
+		{
+			size_t frameCountA = 0;
+			size_t frameCountB = 0;
+			size_t comparedFrames = 0;
+
+			size_t mismatchingFrames = 0;
+			size_t mismatchingSamples = 0;
+			size_t firstFrame = InvalidFrame;
+			size_t lastFrame = InvalidFrame;
+			float maxError = 0.0f;
+
+			std::vector<ChannelResult> channels;
+			std::vector<Range> ranges;
+			size_t rangeCount = 0;		// including the ones that have not been stored
+
+			bool isMatch() const { return mismatchingSamples == 0 && frameCountA == frameCountB; }
+
+			// human readable summary, frame ranges are converted to seconds if a samplerate is given
+			std::string toString(float _samplerate = 0.0f) const;
+		};
+
+		// Compares two wav files with the same channel count and samplerate. The sample formats may differ, in that
+		// case a bit exact comparison is done after conversion to float. Returns false if the files cannot be compared
+		static bool compare(Result& _result, const WavFile& _a, const WavFile& _b, const Config& _config);
+
+		static bool compare(Result& _result,
+			const uint8_t* _a, size_t _frameCountA, SampleFormat _formatA,
+			const uint8_t* _b, size_t _frameCountB, SampleFormat _formatB,
+			uint32_t _channelCount, const Config& _config);
+
+		// Returns the offset of the first byte that differs or _size if both are equal
+		static size_t findFirstDifference(const uint8_t* _a, const uint8_t* _b, size_t _size);
+
+		static uint32_t getSampleSize(SampleFormat _format);
+	};
+}
@@ -0,0 +1,159 @@
+#include "deadlineMonitor.h"
+
+#include <algorithm>
+
+namespace synthLib
+{
+	namespace
+	{
+		// accumulated per thread, the monitor takes the difference between begin and end of a block
+		thread_local uint64_t t_dspWaitNs = 0;
+
+		uint32_t toMicroseconds(const uint64_t _ns)
+		{
+			return static_cast<uint32_t>(std::min<uint64_t>(_ns / 1000, 0xffffffff));
+		}
+
+		uint32_t toPermille(const double _fraction)
+		{
+			return static_cast<uint32_t>(std::min(_fraction * 1000.0 + 0.5, 4294967295.0));
+		}
+
+		void clearHistogram(std::array<std::atomic<uint64_t>, DeadlineMonitor::BinCount>& _hist)
+		{
+			for (auto& bin : _hist)
+				bin.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	DeadlineMonitor::DeadlineMonitor() : m_pendingOverruns(MaxOverruns)
+	{
+		clearHistogram(m_histProcess);
+		clearHistogram(m_histDspWait);
+	}
+
+	void DeadlineMonitor::beginBlock()
+	{
+		m_blockStart = Clock::now();
+		m_dspWaitAtStart = t_dspWaitNs;
+	}
+
+	void DeadlineMonitor::endBlock(const size_t _samples, const float _samplerate, const Context& _context)
+	{
+		if(!_samples || _samplerate <= 0.0f)
+			return;
+
+		const auto processNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_blockStart).count());
+		const auto dspWaitNs = t_dspWaitNs - m_dspWaitAtStart;
+
+		const auto deadlineNs = static_cast<double>(_samples) * 1e9 / static_cast<double>(_samplerate);
+
+		const auto load = static_cast<double>(processNs) / deadlineNs;
+		const auto waitLoad = static_cast<double>(dspWaitNs) / deadlineNs;
+
+		m_histProcess[getBinIndex(load)].fetch_add(1, std::memory_order_relaxed);
+		m_histDspWait[getBinIndex(waitLoad)].fetch_add(1, std::memory_order_relaxed);
+
+		const auto loadPermille = toPermille(load);
+		m_lastLoadPermille.store(loadPermille, std::memory_order_relaxed);
+		if(loadPermille > m_maxLoadPermille.load(std::memory_order_relaxed))
+			m_maxLoadPermille.store(loadPermille, std::memory_order_relaxed);
+
+		const auto block = m_blocks.fetch_add(1, std::memory_order_relaxed);
+
+		if(load <= 1.0)
+			return;
+
+		m_overruns.fetch_add(1, std::memory_order_relaxed);
+
+		DeadlineOverrun o;
+		o.block = block;
+		o.blockSize = static_cast<uint32_t>(_samples);
+		o.samplerate = _samplerate;
+		o.deadlineUs = toMicroseconds(static_cast<uint64_t>(deadlineNs));
+		o.processUs = toMicroseconds(processNs);
+		o.dspWaitUs = toMicroseconds(dspWaitNs);
+		o.midiIn = _context.midiIn;
+		o.midiOut = _context.midiOut;
+		o.midiPending = _context.midiPending;
+		o.latencyBlocks = _context.latencyBlocks;
+
+		// dropped if the UI does not collect them, the counter above is still correct
+		m_pendingOverruns.write(&o, 1);
+	}
+
+	void DeadlineMonitor::addDspWait(const uint64_t _nanoseconds)
+	{
+		t_dspWaitNs += _nanoseconds;
+	}
+
+	void DeadlineMonitor::getStats(Stats& _stats) const
+	{
+		_stats.blocks = m_blocks.load(std::memory_order_relaxed);
+		_stats.overruns = m_overruns.load(std::memory_order_relaxed);
+		_stats.lastLoad = static_cast<float>(m_lastLoadPermille.load(std::memory_order_relaxed)) * 0.001f;
+		_stats.maxLoad = static_cast<float>(m_maxLoadPermille.load(std::memory_order_relaxed)) * 0.001f;
+
+		for(size_t i=0; i<BinCount; ++i)
+		{
+			_stats.process[i] = m_histProcess[i].load(std::memory_order_relaxed);
+			_stats.dspWait[i] = m_histDspWait[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	void DeadlineMonitor::getOverruns(std::vector<DeadlineOverrun>& _overruns)
+	{
+		std::lock_guard lock(m_historyMutex);
+
+		DeadlineOverrun o;
+		while(m_pendingOverruns.read(&o, 1))
+		{
+			m_history.push_back(o);
+			if(m_history.size() > MaxOverruns)
+				m_history.pop_front();
+		}
+
+		_overruns.assign(m_history.begin(), m_history.end());
+	}
+
+	void DeadlineMonitor::reset()
+	{
+		// the audio thread might add a block while resetting, which is harmless for statistics
+		m_blocks.store(0, std::memory_order_relaxed);
+		m_overruns.store(0, std::memory_order_relaxed);
+		m_lastLoadPermille.store(0, std::memory_order_relaxed);
+		m_maxLoadPermille.store(0, std::memory_order_relaxed);
+
+		clearHistogram(m_histProcess);
+		clearHistogram(m_histDspWait);
+
+		std::lock_guard lock(m_historyMutex);
+
+		DeadlineOverrun o;
+		while(m_pendingOverruns.read(&o, 1))
+		{
+		}
+		m_history.clear();
+	}
+
+	uint32_t DeadlineMonitor::getBinIndex(const double _fractionOfDeadline)
+	{
+		if(_fractionOfDeadline < 1.0)
+			return static_cast<uint32_t>(std::max(0.0, _fractionOfDeadline) * 10.0);
+		if(_fractionOfDeadline < 1.5)
+			return 10;
+		if(_fractionOfDeadline < 2.0)
+			return 11;
+		return 12;
+	}
+
+	const char* DeadlineMonitor::getBinName(const uint32_t _bin)
+	{
+		constexpr const char* names[BinCount] =
+		{
+			"0-10%", "10-20%", "20-30%", "30-40%", "40-50%", "50-60%", "60-70%", "70-80%", "80-90%", "90-100%",
+			"100-150%", "150-200%", ">200%"
+		};
+		return _bin < BinCount ? names[_bin] : "";
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "spscRingBuffer.h"
+
+namespace synthLib
+{
+	// State at the end of a process call that missed its deadline
+	struct DeadlineOverrun
+	{
+		uint64_t block = 0;				// index of the process call since the last reset
+		uint32_t blockSize = 0;
+		float samplerate = 0.0f;
+		uint32_t deadlineUs = 0;		// duration of the block at the host sample rate
+		uint32_t processUs = 0;			// time spent in Plugin::process
+		uint32_t dspWaitUs = 0;			// part of it spent waiting for the DSP to deliver audio
+		uint32_t midiIn = 0;			// MIDI events passed to the device in this block
+		uint32_t midiOut = 0;			// MIDI events that the device produced in this block
+		uint32_t midiPending = 0;		// MIDI events that are still queued for later blocks
+		uint32_t latencyBlocks = 0;
+	};
+
+	// Measures every process call against the deadline given by the host block size and keeps histograms of the time
+	// spent processing and waiting for the DSP, relative to the deadline. Process calls that take longer than the
+	// deadline are recorded together with the MIDI context of that block.
+	// The audio thread only writes atomics and a lock-free queue, all other functions are meant for the UI
+	class DeadlineMonitor
+	{
+	public:
+		// 10% steps up to the deadline, then 100-150%, 150-200% and more than 200%
+		static constexpr uint32_t BinCount = 13;
+		static constexpr uint32_t MaxOverruns = 64;
+
+		using Histogram = std::array<uint64_t, BinCount>;
+
+		struct Context
+		{
+			uint32_t midiIn = 0;
+			uint32_t midiOut = 0;
+			uint32_t midiPending = 0;
+			uint32_t latencyBlocks = 0;
+		};
+
+		struct Stats
+		{
+			uint64_t blocks = 0;
+			uint64_t overruns = 0;
+			float lastLoad = 0.0f;		// process time relative to deadline of the last block, 1.0 = 100%
+			float maxLoad = 0.0f;
+			Histogram process{};
+			Histogram dspWait{};
+		};
+
+		DeadlineMonitor();
+
+		// audio thread
+		void beginBlock();
+		void endBlock(size_t _samples, float _samplerate, const Context& _context);
+
+		// Called by devices on the audio thread, adds time that has been spent waiting for the DSP in the current block
+		static void addDspWait(uint64_t _nanoseconds);
+
+		// any other thread
+		void getStats(Stats& _stats) const;
+		// Returns the most recent overruns, oldest first
+		void getOverruns(std::vector<DeadlineOverrun>& _overruns);
+		void reset();
+
+		static uint32_t getBinIndex(double _fractionOfDeadline);
+		static const char* getBinName(uint32_t _bin);
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		using AtomicHistogram = std::array<std::atomic<uint64_t>, BinCount>;
+
+		Clock::time_point m_blockStart;
+		uint64_t m_dspWaitAtStart = 0;
+
+		std::atomic<uint64_t> m_blocks{0};
+		std::atomic<uint64_t> m_overruns{0};
+		std::atomic<uint32_t> m_lastLoadPermille{0};
+		std::atomic<uint32_t> m_maxLoadPermille{0};
+		AtomicHistogram m_histProcess;
+		AtomicHistogram m_histDspWait;
+
+		SpscRingBuffer<DeadlineOverrun> m_pendingOverruns;
+
+		std::mutex m_historyMutex;
+		std::deque<DeadlineOverrun> m_history;
+	};
+
+	class ScopedDspWait
+	{
+	public:
+		ScopedDspWait() : m_start(std::chrono::steady_clock::now()) {}
+		~ScopedDspWait()
+		{
+			DeadlineMonitor::addDspWait(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()));
+		}
+
+		ScopedDspWait(const ScopedDspWait&) = delete;
+		ScopedDspWait& operator = (const ScopedDspWait&) = delete;
+
+	private:
+		const std::chrono::steady_clock::time_point m_start;
+	};
+}
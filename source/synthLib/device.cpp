@@ -1,17 +1,30 @@
 #include "device.h"
 
+#include "asyncLog.h"
 #include "audioTypes.h"
+#include "tracer.h"
 #include "../dsp56300/source/dsp56kEmu/dsp.h"
 #include "../dsp56300/source/dsp56kEmu/memory.h"
 
+#include <algorithm>
 #include <cmath>
+#include <tuple>
+#include <vector>
 
 using namespace dsp56k;
 
 namespace synthLib
 {
-	Device::Device() = default;
-	Device::~Device() = default;
+	Device::Device()
+	{
+		// messages of the audio and DSP threads are written by a background thread while a device exists
+		AsyncLog::acquire();
+	}
+
+	Device::~Device()
+	{
+		AsyncLog::release();
+	}
 
 	void Device::dummyProcess(const uint32_t _numSamples)
 	{
@@ -27,10 +40,71 @@ namespace synthLib
 		process(in, out, _numSamples, midi, midi);
 	}
 
+	bool Device::processUntilSilent(const uint32_t _silentSamples, const uint32_t _maxSamples, const float _threshold/* = 1.0f / 32768.0f*/)
+	{
+		SYNTHLIB_TRACE_SCOPE("Device::processUntilSilent");
+
+		constexpr uint32_t blockSize = 256;
+
+		std::vector<float> input(blockSize, 0.0f);
+		std::vector<std::vector<float>> outputBuffers(std::min<size_t>(getChannelCountOut(), std::tuple_size_v<TAudioOutputs>));
+
+		TAudioInputs inputs{};
+		TAudioOutputs outputs{};
+
+		for(size_t i=0; i<std::min<size_t>(getChannelCountIn(), inputs.size()); ++i)
+			inputs[i] = input.data();
+
+		for(size_t i=0; i<outputBuffers.size(); ++i)
+		{
+			outputBuffers[i].resize(blockSize);
+			outputs[i] = outputBuffers[i].data();
+		}
+
+		const std::vector<SMidiEvent> midiIn;
+		std::vector<SMidiEvent> midiOut;
+
+		uint32_t silence = 0;
+
+		for(uint32_t pos=0; pos<_maxSamples; pos += blockSize)
+		{
+			midiOut.clear();
+			process(inputs, outputs, blockSize, midiIn, midiOut);
+
+			// the silent range starts after the last sample that exceeds the threshold, NaNs are never silent
+			int lastAudible = -1;
+
+			for (const auto& out : outputBuffers)
+			{
+				for(int i=static_cast<int>(blockSize)-1; i>lastAudible; --i)
+				{
+					if(!(std::fabs(out[i]) <= _threshold))
+					{
+						lastAudible = i;
+						break;
+					}
+				}
+			}
+
+			silence = lastAudible < 0 ? silence + blockSize : blockSize - 1 - static_cast<uint32_t>(lastAudible);
+
+			if(silence >= _silentSamples)
+				return true;
+		}
+
+		return false;
+	}
+
 	void Device::process(const TAudioInputs& _inputs, const TAudioOutputs& _outputs, const size_t _size, const std::vector<SMidiEvent>& _midiIn, std::vector<SMidiEvent>& _midiOut)
 	{
-		for (const auto& ev : _midiIn)
-			sendMidi(ev, _midiOut);
+		SYNTHLIB_TRACE_SCOPE("Device::process");
+
+		{
+			SYNTHLIB_TRACE_SCOPE("Device::sendMidi");
+
+			for (const auto& ev : _midiIn)
+				sendMidi(ev, _midiOut);
+		}
 
 		processAudio(_inputs, _outputs, _size);
 
@@ -43,11 +117,11 @@ namespace synthLib
 
 		m_extraLatency = std::min(_size, maxLatency);
 
-		LOG("Latency set to " << m_extraLatency << " samples at " << getSamplerate() << " Hz");
+		SYNTHLIB_LOG_INFO("Latency set to " << m_extraLatency << " samples at " << getSamplerate() << " Hz");
 
 		if(_size > maxLatency)
 		{
-			LOG("Warning, limited requested latency " << _size << " to maximum value " << maxLatency << ", audio will be out of sync!");
+			SYNTHLIB_LOG_WARNING("Limited requested latency " << _size << " to maximum value " << maxLatency << ", audio will be out of sync!");
 		}
 	}
 
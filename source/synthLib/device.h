@@ -18,6 +18,11 @@ namespace synthLib
 		virtual ~Device();
 		virtual void process(const TAudioInputs& _inputs, const TAudioOutputs& _outputs, size_t _size, const std::vector<SMidiEvent>& _midiIn, std::vector<SMidiEvent>& _midiOut);
 
+		// Processes silence until all outputs stay below the threshold for the given number of samples in a row, used by
+		// offline renderers to let the tail of a previous render decay. Returns false if the output did not become
+		// silent within the maximum number of samples
+		bool processUntilSilent(uint32_t _silentSamples, uint32_t _maxSamples, float _threshold = 1.0f / 32768.0f);
+
 		void setExtraLatencySamples(uint32_t _size);
 		uint32_t getExtraLatencySamples() const { return m_extraLatency; }
 
@@ -0,0 +1,274 @@
+#include "deviceRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "asyncLog.h"
+#include "binarystream.h"
+#include "buildconfig.h"
+#include "device.h"
+
+namespace synthLib
+{
+	namespace
+	{
+		constexpr auto g_writeInterval = std::chrono::milliseconds(10);
+
+		bool isSilent(const float* const* _channels, const uint32_t _channelCount, const size_t _samples)
+		{
+			for(uint32_t c=0; c<_channelCount; ++c)
+			{
+				if(!_channels[c])
+					continue;
+
+				for(size_t i=0; i<_samples; ++i)
+				{
+					if(_channels[c][i] != 0.0f)
+						return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	DeviceRecorder::DeviceRecorder() = default;
+
+	DeviceRecorder::~DeviceRecorder()
+	{
+		stop();
+	}
+
+	bool DeviceRecorder::start(const std::string& _filename, Device& _device)
+	{
+		stop();
+
+		m_file.open(_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if(!m_file.is_open())
+			return false;
+
+		m_channelsIn = std::min<uint32_t>(_device.getChannelCountIn(), std::tuple_size_v<TAudioInputs>);
+		m_channelsOut = std::min<uint32_t>(_device.getChannelCountOut(), std::tuple_size_v<TAudioOutputs>);
+
+		BinaryStream header;
+		header.write4CC("DREC");
+		header.write(Version);
+		header.write(_device.getSamplerate());
+		header.write(m_channelsIn);
+		header.write(m_channelsOut);
+		header.write(_device.getExtraLatencySamples());
+
+		std::vector<uint8_t> data;
+		header.toVector(data);
+		m_file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+		if(!m_ring)
+			m_ring.reset(new SpscRingBuffer<uint8_t>(RingBufferSize));
+
+		m_overflow = false;
+		m_recording = true;
+		m_writerThread = std::thread([this] { writerThreadFunc(); });
+
+		SYNTHLIB_LOG_INFO("Started recording device session to " << _filename);
+		return true;
+	}
+
+	void DeviceRecorder::stop()
+	{
+		if(!m_writerThread.joinable())
+			return;
+
+		{
+			std::lock_guard lock(m_producerMutex);
+			if(m_recording && m_ring->freeSpace() > 0)
+				put(RecordType::End);
+			m_recording = false;
+		}
+
+		m_writerThread.join();
+
+		drain();
+		m_file.close();
+
+		if(m_overflow)
+			SYNTHLIB_LOG_WARNING("Device session recording stopped early, the writer could not keep up");
+	}
+
+	void DeviceRecorder::recordProcess(const TAudioInputs& _inputs, const TAudioOutputs& _outputs, const size_t _samples, const std::vector<SMidiEvent>& _midiIn)
+	{
+		if(!isRecording())
+			return;
+
+		const auto inputHash = hashAudio(_inputs.data(), m_channelsIn, _samples);
+		const auto outputHash = hashAudio(_outputs.data(), m_channelsOut, _samples);
+
+		// silent input, which is the common case for a synth, is not stored
+		const bool storeInput = !isSilent(_inputs.data(), m_channelsIn, _samples);
+
+		size_t size = sizeof(RecordType) + sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2 + sizeof(uint8_t);
+
+		for (const auto& e : _midiIn)
+			size += 3 + sizeof(uint32_t) + sizeof(uint8_t) + sizeof(StreamSizeType) + e.sysex.size();
+
+		if(storeInput)
+			size += m_channelsIn * _samples * sizeof(float);
+
+		std::lock_guard lock(m_producerMutex);
+
+		if(!beginRecord(size))
+			return;
+
+		put(RecordType::Process);
+		put(static_cast<uint32_t>(_samples));
+		put(static_cast<uint32_t>(_midiIn.size()));
+
+		for (const auto& e : _midiIn)
+		{
+			put(e.a);
+			put(e.b);
+			put(e.c);
+			put(e.offset);
+			put(static_cast<uint8_t>(e.source));
+			put(e.sysex);
+		}
+
+		put(inputHash);
+		put(static_cast<uint8_t>(storeInput ? 1 : 0));
+
+		if(storeInput)
+		{
+			for(uint32_t c=0; c<m_channelsIn; ++c)
+			{
+				if(_inputs[c])
+				{
+					m_ring->write(reinterpret_cast<const uint8_t*>(_inputs[c]), _samples * sizeof(float));
+				}
+				else
+				{
+					for(size_t i=0; i<_samples; ++i)
+						put(0.0f);
+				}
+			}
+		}
+
+		put(outputHash);
+	}
+
+	void DeviceRecorder::recordState(const std::vector<uint8_t>& _state, const StateType _type)
+	{
+		if(!isRecording())
+			return;
+
+		std::lock_guard lock(m_producerMutex);
+
+		if(!beginRecord(sizeof(RecordType) + sizeof(uint8_t) + sizeof(StreamSizeType) + _state.size()))
+			return;
+
+		put(RecordType::State);
+		put(static_cast<uint8_t>(_type));
+		put(_state);
+	}
+
+	void DeviceRecorder::recordUnknownState(const std::vector<uint8_t>& _state)
+	{
+		if(!isRecording())
+			return;
+
+		std::lock_guard lock(m_producerMutex);
+
+		if(!beginRecord(sizeof(RecordType) + sizeof(StreamSizeType) + _state.size()))
+			return;
+
+		put(RecordType::UnknownState);
+		put(_state);
+	}
+
+	void DeviceRecorder::recordSamplerate(const float _samplerate)
+	{
+		if(!isRecording())
+			return;
+
+		std::lock_guard lock(m_producerMutex);
+
+		if(!beginRecord(sizeof(RecordType) + sizeof(float)))
+			return;
+
+		put(RecordType::Samplerate);
+		put(_samplerate);
+	}
+
+	void DeviceRecorder::recordLatency(const uint32_t _samples)
+	{
+		if(!isRecording())
+			return;
+
+		std::lock_guard lock(m_producerMutex);
+
+		if(!beginRecord(sizeof(RecordType) + sizeof(uint32_t)))
+			return;
+
+		put(RecordType::Latency);
+		put(_samples);
+	}
+
+	uint64_t DeviceRecorder::hashAudio(const float* const* _channels, const uint32_t _channelCount, const size_t _samples, uint64_t _hash)
+	{
+		// FNV-1a over the bit patterns of the samples, bit-identical audio is what we are after
+		for(uint32_t c=0; c<_channelCount; ++c)
+		{
+			if(!_channels[c])
+				continue;
+
+			for(size_t i=0; i<_samples; ++i)
+			{
+				uint32_t bits;
+				memcpy(&bits, &_channels[c][i], sizeof(bits));
+				_hash = (_hash ^ bits) * 0x100000001b3ull;
+			}
+		}
+		return _hash;
+	}
+
+	void DeviceRecorder::put(const std::vector<uint8_t>& _data)
+	{
+		put(static_cast<StreamSizeType>(_data.size()));
+		if(!_data.empty())
+			m_ring->write(_data.data(), _data.size());
+	}
+
+	bool DeviceRecorder::beginRecord(const size_t _size)
+	{
+		if(!m_recording.load(std::memory_order_relaxed))
+			return false;
+
+		// one byte is kept for the end marker
+		if(m_ring->freeSpace() >= _size + 1)
+			return true;
+
+		put(RecordType::End);
+		m_overflow = true;
+		m_recording = false;
+		return false;
+	}
+
+	void DeviceRecorder::writerThreadFunc()
+	{
+		while(m_recording.load(std::memory_order_relaxed))
+		{
+			drain();
+			std::this_thread::sleep_for(g_writeInterval);
+		}
+	}
+
+	void DeviceRecorder::drain()
+	{
+		const uint8_t* data;
+
+		while(const auto count = m_ring->readRegion(data))
+		{
+			m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count));
+			m_ring->commitRead(count);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audioTypes.h"
+#include "deviceTypes.h"
+#include "midiTypes.h"
+#include "spscRingBuffer.h"
+
+namespace synthLib
+{
+	class Device;
+
+	// Records everything that is passed to a device, to be able to reproduce a session with bit-identical output via
+	// DeviceReplay. Recording has to start right after the device has booted, as its runtime state cannot be captured.
+	// The session contains all process calls (block size, MIDI, input audio) and all state and samplerate changes.
+	//
+	// Records are serialized into a ring buffer and written to disk by a background thread. If the ring buffer
+	// overflows, recording stops and the capture ends at the last complete record. The ring buffer is allocated when
+	// recording starts for the first time, an idle recorder does not use any memory
+	class DeviceRecorder
+	{
+	public:
+		static constexpr uint32_t Version = 2;	// version 1 started mid-session with a snapshot of the global state
+		static constexpr size_t RingBufferSize = 32 * 1024 * 1024;
+
+		enum class RecordType : uint8_t
+		{
+			Process = 1,
+			State = 2,
+			UnknownState = 3,
+			Samplerate = 4,
+			Latency = 5,
+			End = 0xff
+		};
+
+		DeviceRecorder();
+		~DeviceRecorder();
+
+		DeviceRecorder(const DeviceRecorder&) = delete;
+		DeviceRecorder& operator = (const DeviceRecorder&) = delete;
+
+		// the device needs to be freshly booted, nothing may have been processed yet
+		bool start(const std::string& _filename, Device& _device);
+		void stop();
+
+		bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+		bool hasOverflow() const { return m_overflow.load(std::memory_order_relaxed); }
+
+		// needs to be called after the device processed the block so that the output can be hashed
+		void recordProcess(const TAudioInputs& _inputs, const TAudioOutputs& _outputs, size_t _samples, const std::vector<SMidiEvent>& _midiIn);
+		void recordState(const std::vector<uint8_t>& _state, StateType _type);
+		void recordUnknownState(const std::vector<uint8_t>& _state);
+		void recordSamplerate(float _samplerate);
+		void recordLatency(uint32_t _samples);
+
+		static uint64_t hashAudio(const float* const* _channels, uint32_t _channelCount, size_t _samples, uint64_t _hash = 0xcbf29ce484222325ull);
+
+	private:
+		template<typename T> void put(const T& _value)
+		{
+			m_ring->write(reinterpret_cast<const uint8_t*>(&_value), sizeof(T));
+		}
+
+		void put(const std::vector<uint8_t>& _data);
+
+		// returns false if the record does not fit, which ends the recording
+		bool beginRecord(size_t _size);
+
+		void writerThreadFunc();
+		void drain();
+
+		std::unique_ptr<SpscRingBuffer<uint8_t>> m_ring;
+		std::mutex m_producerMutex;		// records are added from the audio thread and from the thread that sets the state
+
+		std::ofstream m_file;
+		std::thread m_writerThread;
+		std::atomic<bool> m_recording{false};
+		std::atomic<bool> m_overflow{false};
+
+		uint32_t m_channelsIn = 0;
+		uint32_t m_channelsOut = 0;
+	};
+}
@@ -0,0 +1,224 @@
+#include "deviceReplay.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "binarystream.h"
+#include "buildconfig.h"
+#include "device.h"
+#include "deviceRecorder.h"
+#include "os.h"
+
+namespace synthLib
+{
+	bool DeviceReplay::load(const std::string& _filename)
+	{
+		m_error.clear();
+
+		if(!readFile(m_data, _filename) || m_data.empty())
+		{
+			m_error = "Failed to read " + _filename;
+			return false;
+		}
+
+		try
+		{
+			BinaryStream s(m_data);
+
+			char fourCC[5];
+			s.read4CC(fourCC);
+
+			if(strcmp(fourCC, "DREC") != 0)
+			{
+				m_error = _filename + " is not a device recording";
+				return false;
+			}
+
+			const auto version = s.read<uint32_t>();
+
+			if(version > DeviceRecorder::Version)
+			{
+				m_error = "Unsupported recording version " + std::to_string(version);
+				return false;
+			}
+
+			if(version < 2)
+			{
+				m_error = "Recording version " + std::to_string(version) + " started mid-session and cannot be replayed bit-identical, record it again";
+				return false;
+			}
+
+			m_samplerate = s.read<float>();
+			m_channelsIn = s.read<uint32_t>();
+			m_channelsOut = s.read<uint32_t>();
+			m_latency = s.read<uint32_t>();
+
+			if(m_channelsIn > std::tuple_size_v<TAudioInputs> || m_channelsOut > std::tuple_size_v<TAudioOutputs>)
+			{
+				m_error = "Invalid channel count";
+				return false;
+			}
+
+			m_recordsOffset = s.getReadPos();
+		}
+		catch(const std::range_error&)
+		{
+			m_error = "Recording header is truncated";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool DeviceReplay::run(Device& _device, Result& _result, const OutputCallback& _outputCallback)
+	{
+		using RecordType = DeviceRecorder::RecordType;
+
+		_result = Result();
+		m_error.clear();
+
+		if(m_data.empty())
+		{
+			m_error = "No recording loaded";
+			return false;
+		}
+
+		if(_device.getChannelCountIn() < m_channelsIn || _device.getChannelCountOut() < m_channelsOut)
+		{
+			m_error = "Device does not have enough channels for this recording";
+			return false;
+		}
+
+		_device.setSamplerate(m_samplerate);
+		_device.setExtraLatencySamples(m_latency);
+
+		std::vector<std::vector<float>> inputBuffers(m_channelsIn);
+		std::vector<std::vector<float>> outputBuffers(std::tuple_size_v<TAudioOutputs>);
+
+		std::vector<SMidiEvent> midiIn;
+		std::vector<SMidiEvent> midiOut;
+		std::vector<uint8_t> state;
+
+		BinaryStream s(m_data);
+		s.setReadPos(static_cast<uint32_t>(m_recordsOffset));
+
+		try
+		{
+			while(!s.endOfStream())
+			{
+				const auto type = s.read<RecordType>();
+
+				switch (type)
+				{
+				case RecordType::Process:
+					{
+						const auto samples = s.read<uint32_t>();
+						const auto midiCount = s.read<uint32_t>();
+
+						midiIn.resize(midiCount);
+
+						for (auto& e : midiIn)
+						{
+							e.a = s.read<uint8_t>();
+							e.b = s.read<uint8_t>();
+							e.c = s.read<uint8_t>();
+							e.offset = s.read<uint32_t>();
+							e.source = static_cast<MidiEventSource>(s.read<uint8_t>());
+							s.read(e.sysex);
+						}
+
+						const auto inputHash = s.read<uint64_t>();
+						const auto hasInput = s.read<uint8_t>() != 0;
+
+						TAudioInputs inputs{};
+						TAudioOutputs outputs{};
+
+						for(uint32_t c=0; c<m_channelsIn; ++c)
+						{
+							auto& buf = inputBuffers[c];
+							buf.resize(samples);
+
+							if(hasInput)
+							{
+								for (auto& v : buf)
+									v = s.read<float>();
+							}
+							else
+							{
+								std::fill(buf.begin(), buf.end(), 0.0f);
+							}
+							inputs[c] = buf.data();
+						}
+
+						// the device might use more channels than have been recorded, they get dummy buffers
+						for(size_t c=0; c<outputs.size(); ++c)
+						{
+							outputBuffers[c].resize(samples);
+							outputs[c] = outputBuffers[c].data();
+						}
+
+						const auto expectedOutputHash = s.read<uint64_t>();
+
+						if(DeviceRecorder::hashAudio(inputs.data(), m_channelsIn, samples) != inputHash)
+							++_result.inputMismatches;
+
+						midiOut.clear();
+
+						const auto t0 = std::chrono::steady_clock::now();
+						_device.process(inputs, outputs, samples, midiIn, midiOut);
+						_result.processSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+						if(DeviceRecorder::hashAudio(outputs.data(), m_channelsOut, samples) != expectedOutputHash)
+						{
+							if(_result.firstOutputMismatch < 0)
+								_result.firstOutputMismatch = static_cast<int64_t>(_result.blocks);
+							++_result.outputMismatches;
+						}
+
+						if(_outputCallback)
+							_outputCallback(outputs, m_channelsOut, samples);
+
+						++_result.blocks;
+						_result.samples += samples;
+					}
+					break;
+				case RecordType::State:
+					{
+						const auto stateType = static_cast<StateType>(s.read<uint8_t>());
+						s.read(state);
+#if !SYNTHLIB_DEMO_MODE
+						_device.setState(state, stateType);
+#endif
+						++_result.stateChanges;
+					}
+					break;
+				case RecordType::UnknownState:
+					s.read(state);
+#if !SYNTHLIB_DEMO_MODE
+					_device.setStateFromUnknownCustomData(state);
+#endif
+					++_result.stateChanges;
+					break;
+				case RecordType::Samplerate:
+					_device.setSamplerate(s.read<float>());
+					break;
+				case RecordType::Latency:
+					_device.setExtraLatencySamples(s.read<uint32_t>());
+					break;
+				case RecordType::End:
+					_result.complete = true;
+					return true;
+				default:
+					m_error = "Unknown record type " + std::to_string(static_cast<int>(type)) + " at offset " + std::to_string(s.getReadPos());
+					return false;
+				}
+			}
+		}
+		catch(const std::range_error&)
+		{
+			// the application might have been terminated while recording, everything up to here is still valid
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "audioTypes.h"
+
+namespace synthLib
+{
+	class Device;
+
+	// Replays a session recorded by DeviceRecorder on a device and verifies that the output is bit-identical to the
+	// output at recording time
+	class DeviceReplay
+	{
+	public:
+		struct Result
+		{
+			uint64_t blocks = 0;
+			uint64_t samples = 0;
+			uint64_t stateChanges = 0;
+			uint64_t inputMismatches = 0;	// blocks whose input audio could not be restored, unexpected
+			uint64_t outputMismatches = 0;	// blocks whose output differs from the recording
+			int64_t firstOutputMismatch = -1;
+			double processSeconds = 0.0;	// wall time spent in Device::process
+			bool complete = false;			// false if the capture ended without an end marker
+		};
+
+		// called after each processed block with the device output
+		using OutputCallback = std::function<void(const TAudioOutputs& _outputs, uint32_t _channels, size_t _samples)>;
+
+		bool load(const std::string& _filename);
+
+		float getSamplerate() const { return m_samplerate; }
+		uint32_t getChannelCountIn() const { return m_channelsIn; }
+		uint32_t getChannelCountOut() const { return m_channelsOut; }
+
+		// Replays all records. The device needs to be freshly created, same as the device that has been recorded
+		bool run(Device& _device, Result& _result, const OutputCallback& _outputCallback = {});
+
+		const std::string& getError() const { return m_error; }
+
+	private:
+		std::vector<uint8_t> m_data;
+		size_t m_recordsOffset = 0;
+
+		float m_samplerate = 0.0f;
+		uint32_t m_channelsIn = 0;
+		uint32_t m_channelsOut = 0;
+		uint32_t m_latency = 0;
+
+		std::string m_error;
+	};
+}
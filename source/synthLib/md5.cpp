@@ -2,6 +2,7 @@
 
 #include "dsp56kEmu/logging.h"
 
+#include <cctype>	// isxdigit
 #include <cstring>	// memcpy
 
 namespace synthLib
@@ -129,6 +130,11 @@ namespace synthLib
 		md5(m_h[0], m_h[1], m_h[2], m_h[3], _data.data(), static_cast<uint32_t>(_data.size()));
 	}
 
+	MD5::MD5(const uint8_t* _data, const size_t _size)
+	{
+		md5(m_h[0], m_h[1], m_h[2], m_h[3], _data, static_cast<uint32_t>(_size));
+	}
+
 	std::string MD5::toString() const
 	{
 		std::stringstream ss;
@@ -142,4 +148,23 @@ namespace synthLib
 		}
 		return ss.str();
 	}
+
+	bool MD5::fromString(const std::string& _digest)
+	{
+		if(_digest.size() != 32)
+			return false;
+
+		for (const auto c : _digest)
+		{
+			if(!isxdigit(static_cast<unsigned char>(c)))
+				return false;
+		}
+
+		const auto* d = _digest.c_str();
+
+		for(size_t i=0; i<m_h.size(); ++i, d += 8)
+			m_h[i] = parse8(d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+
+		return true;
+	}
 }
@@ -47,6 +47,7 @@ namespace synthLib
 		}
 
 		explicit MD5(const std::vector<uint8_t>& _data);
+		MD5(const uint8_t* _data, size_t _size);
 
 		MD5() : m_h({0,0,0,0}) {}
 
@@ -59,6 +60,7 @@ namespace synthLib
 		MD5& operator = (MD5&&) = default;
 
 		std::string toString() const;
+		bool fromString(const std::string& _digest);
 
 		constexpr bool operator == (const MD5& _md5) const
 		{
@@ -0,0 +1,155 @@
+#include "memoryMappedFile.h"
+
+#include <utility>	// std::swap
+
+#include "dsp56kEmu/logging.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define NOSERVICE
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace synthLib
+{
+	MemoryMappedFile::MemoryMappedFile(const std::string& _filename)
+	{
+		open(_filename);
+	}
+
+	MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& _source) noexcept
+	{
+		swap(_source);
+	}
+
+	MemoryMappedFile::~MemoryMappedFile()
+	{
+		close();
+	}
+
+	MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& _source) noexcept
+	{
+		if(this != &_source)
+		{
+			close();
+			swap(_source);
+		}
+		return *this;
+	}
+
+	bool MemoryMappedFile::open(const std::string& _filename)
+	{
+		close();
+
+#ifdef _WIN32
+		std::wstring nameW;
+		nameW.resize(_filename.size());
+		const int newSize = MultiByteToWideChar(CP_UTF8, 0, _filename.c_str(), static_cast<int>(_filename.size()), nameW.data(), static_cast<int>(_filename.size()));
+		nameW.resize(newSize);
+
+		const auto hFile = CreateFileW(nameW.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(hFile);
+			return false;
+		}
+
+		const auto hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(!hMapping)
+		{
+			LOG("Failed to create file mapping for " << _filename << ", error " << GetLastError());
+			CloseHandle(hFile);
+			return false;
+		}
+
+		const auto* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		if(!data)
+		{
+			LOG("Failed to map view of file " << _filename << ", error " << GetLastError());
+			CloseHandle(hMapping);
+			CloseHandle(hFile);
+			return false;
+		}
+
+		m_hFile = hFile;
+		m_hMapping = hMapping;
+		m_data = static_cast<const uint8_t*>(data);
+		m_size = static_cast<size_t>(size.QuadPart);
+#else
+		const int fd = ::open(_filename.c_str(), O_RDONLY);
+		if(fd < 0)
+			return false;
+
+		struct stat st{};
+		if(fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+		// the mapping keeps a reference to the file, the descriptor is no longer needed
+		::close(fd);
+
+		if(data == MAP_FAILED)
+		{
+			LOG("Failed to memory map file " << _filename);
+			return false;
+		}
+
+		m_data = static_cast<const uint8_t*>(data);
+		m_size = static_cast<size_t>(st.st_size);
+#endif
+		m_filename = _filename;
+		return true;
+	}
+
+	void MemoryMappedFile::close()
+	{
+#ifdef _WIN32
+		if(m_data)
+			UnmapViewOfFile(m_data);
+		if(m_hMapping)
+			CloseHandle(m_hMapping);
+		if(m_hFile)
+			CloseHandle(m_hFile);
+		m_hMapping = nullptr;
+		m_hFile = nullptr;
+#else
+		if(m_data)
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+		m_filename.clear();
+	}
+
+	void MemoryMappedFile::adviseSequential() const
+	{
+#ifndef _WIN32
+		if(m_data)
+			madvise(const_cast<uint8_t*>(m_data), m_size, MADV_SEQUENTIAL);
+#endif
+	}
+
+	void MemoryMappedFile::swap(MemoryMappedFile& _other) noexcept
+	{
+		std::swap(m_filename, _other.m_filename);
+		std::swap(m_data, _other.m_data);
+		std::swap(m_size, _other.m_size);
+#ifdef _WIN32
+		std::swap(m_hFile, _other.m_hFile);
+		std::swap(m_hMapping, _other.m_hMapping);
+#endif
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace synthLib
+{
+	// Read-only memory mapping of a file. The mapping stays valid until the object is destroyed or close() is called
+	class MemoryMappedFile
+	{
+	public:
+		MemoryMappedFile() = default;
+		explicit MemoryMappedFile(const std::string& _filename);
+		MemoryMappedFile(const MemoryMappedFile&) = delete;
+		MemoryMappedFile(MemoryMappedFile&& _source) noexcept;
+		~MemoryMappedFile();
+
+		MemoryMappedFile& operator = (const MemoryMappedFile&) = delete;
+		MemoryMappedFile& operator = (MemoryMappedFile&& _source) noexcept;
+
+		bool open(const std::string& _filename);
+		void close();
+
+		bool isValid() const { return m_data != nullptr; }
+
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+		const std::string& getFilename() const { return m_filename; }
+
+		// Hint that the data is going to be read sequentially, which enables aggressive read-ahead
+		void adviseSequential() const;
+
+	private:
+		void swap(MemoryMappedFile& _other) noexcept;
+
+		std::string m_filename;
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+
+#ifdef _WIN32
+		void* m_hFile = nullptr;
+		void* m_hMapping = nullptr;
+#endif
+	};
+}
@@ -4,61 +4,128 @@
 
 namespace synthLib
 {
-	void MidiBufferParser::write(const std::vector<uint8_t>& _data)
+	MidiBufferParser::MidiBufferParser(const size_t _eventCapacity, const size_t _sysexCapacity)
 	{
-		if(_data.empty())
-			return;
+		m_events.resize(_eventCapacity);
+		m_sysexBuffer.reserve(_sysexCapacity);
+	}
 
-		for (const auto d : _data)
+	void MidiBufferParser::write(const uint8_t* _data, const size_t _size, const uint32_t _offset)
+	{
+		for(size_t i=0; i<_size; ++i)
 		{
-			if(d == synthLib::M_STARTOFSYSEX)
+			const auto d = _data[i];
+
+			// realtime messages may appear anywhere and do not affect anything else that is being received
+			if(isRealtime(d))
 			{
-				flushSysex();
-				m_sysex = true;
-				m_sysexBuffer.push_back(d);
+				allocEvent(_offset).a = d;
 				continue;
 			}
 
 			if(m_sysex)
 			{
-				if(d == synthLib::M_ENDOFSYSEX)
-				{
-					flushSysex();
-					continue;
-				}
 				if(d < 0x80)
 				{
 					m_sysexBuffer.push_back(d);
 					continue;
 				}
-				if(d >= 0xf0)
+
+				if(d == M_ENDOFSYSEX)
 				{
-					// system realtime intercepting sysex
-					m_midiEvents.emplace_back(d);
+					m_sysexBuffer.push_back(d);
+					flushSysex();
 					continue;
 				}
 
-				flushSysex();	// aborted sysex
+				// any other status byte aborts the sysex and is processed regularly
+				flushSysex();
 			}
 
-			if(m_pendingEventLen == 0)
-				m_pendingEvent.a = d;
-			else if(m_pendingEventLen == 1)
-				m_pendingEvent.b = d;
-			else if(m_pendingEventLen == 2)
-				m_pendingEvent.c = d;
+			if(d & 0x80)
+			{
+				processStatus(d, _offset);
+				continue;
+			}
 
-			++m_pendingEventLen;
+			if(m_pendingLen == 0)
+			{
+				// data bytes without a preceding status byte are ignored
+				if(!m_runningStatus)
+					continue;
 
-			if(lengthFromStatusByte(m_pendingEvent.a) == m_pendingEventLen)
+				m_pending[0] = m_runningStatus;
+				m_pendingLen = 1;
+				m_pendingExpected = lengthFromStatusByte(m_runningStatus);
+				m_pendingOffset = _offset;
+			}
+
+			m_pending[m_pendingLen++] = d;
+
+			if(m_pendingLen >= m_pendingExpected)
 				flushEvent();
 		}
 	}
 
-	void MidiBufferParser::getEvents(std::vector<synthLib::SMidiEvent>& _events)
+	void MidiBufferParser::reset()
+	{
+		m_eventCount = 0;
+		m_sysexBuffer.clear();
+		m_sysex = false;
+		m_runningStatus = 0;
+		m_pendingLen = 0;
+	}
+
+	void MidiBufferParser::getEvents(std::vector<SMidiEvent>& _events)
+	{
+		_events.assign(begin(), end());
+		clear();
+	}
+
+	SMidiEvent& MidiBufferParser::allocEvent(const uint32_t _offset)
 	{
-		std::swap(m_midiEvents, _events);
-		m_midiEvents.clear();
+		if(m_eventCount == m_events.size())
+			m_events.emplace_back();
+
+		auto& e = m_events[m_eventCount++];
+
+		// the sysex buffer of a reused event keeps its capacity
+		e.a = e.b = e.c = 0;
+		e.sysex.clear();
+		e.offset = _offset;
+		e.source = MidiEventSourcePlugin;
+
+		return e;
+	}
+
+	void MidiBufferParser::processStatus(const uint8_t _status, const uint32_t _offset)
+	{
+		// a status byte discards an incomplete message
+		m_pendingLen = 0;
+
+		// only channel messages establish a running status, system common messages cancel it
+		m_runningStatus = _status < 0xf0 ? _status : 0;
+
+		if(_status == M_STARTOFSYSEX)
+		{
+			m_sysex = true;
+			m_sysexBuffer.clear();
+			m_sysexBuffer.push_back(_status);
+			m_sysexOffset = _offset;
+			return;
+		}
+
+		// end of sysex without a start
+		if(_status == M_ENDOFSYSEX)
+			return;
+
+		m_pending[0] = _status;
+		m_pendingLen = 1;
+		m_pendingExpected = lengthFromStatusByte(_status);
+		m_pendingOffset = _offset;
+
+		if(m_pendingExpected <= 1)
+			flushEvent();
 	}
 
 	void MidiBufferParser::flushSysex()
@@ -68,19 +135,23 @@ namespace synthLib
 		if(m_sysexBuffer.empty())
 			return;
 
-		synthLib::SMidiEvent ev;
-		ev.sysex.swap(m_sysexBuffer);
+		if(m_sysexBuffer.back() != M_ENDOFSYSEX)
+			m_sysexBuffer.push_back(M_ENDOFSYSEX);
 
-		if(ev.sysex.back() != synthLib::M_ENDOFSYSEX)
-			ev.sysex.push_back(synthLib::M_ENDOFSYSEX);
+		auto& e = allocEvent(m_sysexOffset);
+		e.sysex.assign(m_sysexBuffer.begin(), m_sysexBuffer.end());
 
-		m_midiEvents.push_back(ev);
 		m_sysexBuffer.clear();
 	}
 
 	void MidiBufferParser::flushEvent()
 	{
-		m_midiEvents.push_back(m_pendingEvent);
-		m_pendingEventLen = 0;
+		auto& e = allocEvent(m_pendingOffset);
+
+		e.a = m_pending[0];
+		e.b = m_pendingLen > 1 ? m_pending[1] : 0;
+		e.c = m_pendingLen > 2 ? m_pending[2] : 0;
+
+		m_pendingLen = 0;
 	}
-}
\ No newline at end of file
+}
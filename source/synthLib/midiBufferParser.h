@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -7,11 +8,32 @@
 
 namespace synthLib
 {
+	// Parses a raw MIDI byte stream into events. Supports running status, system realtime messages anywhere in the
+	// stream, including inside of sysex and channel messages, and aborted sysex messages. Parsed events are stored in
+	// a pool that is reused, once it has grown to the required size no memory is allocated anymore
 	class MidiBufferParser
 	{
 	public:
-		void write(const std::vector<uint8_t>& _data);
-		void getEvents(std::vector<synthLib::SMidiEvent>& _events);
+		explicit MidiBufferParser(size_t _eventCapacity = 256, size_t _sysexCapacity = 1024);
+
+		// _offset is the sample offset of the chunk, it is assigned to all events that start in this chunk
+		void write(const uint8_t* _data, size_t _size, uint32_t _offset = 0);
+		void write(const std::vector<uint8_t>& _data, const uint32_t _offset = 0) { write(_data.data(), _data.size(), _offset); }
+
+		// events that have been parsed since the last call to clear(). Pointers are valid until the next write
+		size_t getEventCount() const { return m_eventCount; }
+		const SMidiEvent& getEvent(const size_t _index) const { return m_events[_index]; }
+		const SMidiEvent* begin() const { return m_events.data(); }
+		const SMidiEvent* end() const { return m_events.data() + m_eventCount; }
+
+		// removes all parsed events but keeps their memory for reuse. Incomplete messages are kept
+		void clear() { m_eventCount = 0; }
+
+		// discards everything including incomplete messages and the running status
+		void reset();
+
+		// copies the parsed events to _events, replacing its content, and clears the parser
+		void getEvents(std::vector<SMidiEvent>& _events);
 
 		static constexpr uint32_t lengthFromStatusByte(const uint8_t _sb)
 		{
@@ -37,14 +59,26 @@ namespace synthLib
 		    }
 		}
 
+		static constexpr bool isRealtime(const uint8_t _b) { return _b >= 0xf8; }
+
 	private:
+		SMidiEvent& allocEvent(uint32_t _offset);
+
+		void processStatus(uint8_t _status, uint32_t _offset);
 		void flushSysex();
 		void flushEvent();
 
-		std::vector<synthLib::SMidiEvent> m_midiEvents;
+		std::vector<SMidiEvent> m_events;
+		size_t m_eventCount = 0;
+
 		std::vector<uint8_t> m_sysexBuffer;
-		synthLib::SMidiEvent m_pendingEvent;
-		uint32_t m_pendingEventLen = 0;
+		uint32_t m_sysexOffset = 0;
 		bool m_sysex = false;
+
+		uint8_t m_runningStatus = 0;
+		uint8_t m_pending[3]{};
+		uint32_t m_pendingLen = 0;
+		uint32_t m_pendingExpected = 0;
+		uint32_t m_pendingOffset = 0;
 	};
 }
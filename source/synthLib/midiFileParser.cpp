@@ -0,0 +1,231 @@
+#include "midiFileParser.h"
+
+#include <cstring>	// memcmp
+
+#include "memoryMappedFile.h"
+
+namespace synthLib
+{
+	namespace
+	{
+		uint32_t readU32(const uint8_t* _data)
+		{
+			return static_cast<uint32_t>(_data[0]) << 24 | static_cast<uint32_t>(_data[1]) << 16 | static_cast<uint32_t>(_data[2]) << 8 | _data[3];
+		}
+
+		uint16_t readU16(const uint8_t* _data)
+		{
+			return static_cast<uint16_t>(_data[0] << 8 | _data[1]);
+		}
+
+		bool readVarLen(uint32_t& _result, const uint8_t*& _data, const uint8_t* _end)
+		{
+			_result = 0;
+
+			for(uint32_t i=0; i<4 && _data < _end; ++i)
+			{
+				const auto b = *_data++;
+
+				_result = (_result << 7) | (b & 0x7f);
+
+				if(!(b & 0x80))
+					return true;
+			}
+			return false;
+		}
+	}
+
+	std::vector<uint8_t> SysexSpan::toVector() const
+	{
+		std::vector<uint8_t> res;
+
+		if(empty())
+			return res;
+
+		res.reserve(size());
+		res.push_back(0xf0);
+		res.insert(res.end(), m_payload, m_payload + m_size - 1);
+		res.push_back(0xf7);
+		return res;
+	}
+
+	bool MidiFileParser::parse(const uint8_t* _data, const size_t _size, const EventCallback& _callback)
+	{
+		if(!isMidiFile(_data, _size) || _size < 14)
+			return false;
+
+		const auto headerLen = readU32(_data + 4);
+
+		if(headerLen < 6 || headerLen > _size - 8)
+			return false;
+
+		m_format = readU16(_data + 8);
+		m_trackCount = readU16(_data + 10);
+		m_division = readU16(_data + 12);
+
+		const auto* end = _data + _size;
+		const auto* p = _data + 8 + headerLen;
+
+		uint16_t track = 0;
+
+		while(end - p >= 8)
+		{
+			const auto chunkLen = readU32(p + 4);
+
+			if(memcmp(p, "MTrk", 4) == 0)
+			{
+				const auto* body = p + 8;
+				p = body;
+
+				// The chunk length is not used to find the end of the track, there are files around that have a wrong
+				// length. Tracks end with an end-of-track meta event instead
+				if(!parseTrack(p, end, track++, _callback))
+					return true;
+
+				// fall back to the chunk length if the track is broken and we did not end up at the next chunk
+				if(chunkLen <= static_cast<size_t>(end - body) && p < body + chunkLen && (end - p < 4 || memcmp(p, "MTrk", 4) != 0))
+					p = body + chunkLen;
+			}
+			else
+			{
+				// skip unknown chunk
+				if(chunkLen > static_cast<size_t>(end - p) - 8)
+					break;
+				p += 8 + chunkLen;
+			}
+		}
+		return true;
+	}
+
+	bool MidiFileParser::parse(std::vector<Event>& _events, const uint8_t* _data, const size_t _size)
+	{
+		return parse(_data, _size, [&_events](const Event& _e)
+		{
+			_events.push_back(_e);
+			return true;
+		});
+	}
+
+	bool MidiFileParser::parseFile(const std::string& _filename, const EventCallback& _callback)
+	{
+		const MemoryMappedFile file(_filename);
+
+		if(!file.isValid())
+			return false;
+
+		return parse(file.data(), file.size(), _callback);
+	}
+
+	bool MidiFileParser::isMidiFile(const uint8_t* _data, const size_t _size)
+	{
+		return _size >= 4 && memcmp(_data, "MThd", 4) == 0;
+	}
+
+	bool MidiFileParser::parseTrack(const uint8_t*& _data, const uint8_t* _end, const uint16_t _track, const EventCallback& _callback)
+	{
+		Event e;
+		e.track = _track;
+
+		uint8_t runningStatus = 0;
+
+		while(_data < _end)
+		{
+			uint32_t delta;
+			if(!readVarLen(delta, _data, _end) || _data >= _end)
+				return true;
+
+			e.tick += delta;
+
+			uint8_t status = *_data;
+
+			if(status & 0x80)
+				++_data;
+			else if(runningStatus)
+				status = runningStatus;
+			else
+				return true;	// data byte without status, file is broken
+
+			e.status = status;
+			e.metaType = 0;
+
+			switch (status)
+			{
+			case 0xf0:
+				{
+					// we ignore the provided sysex length as there are files that do not have the length encoded properly
+					uint32_t len;
+					if(!readVarLen(len, _data, _end))
+						return true;
+
+					const auto* terminator = _data;
+					while(terminator < _end && *terminator != 0xf7 && *terminator != 0xf8)
+						++terminator;
+
+					if(terminator == _end)
+						return true;
+
+					e.data = _data;
+					e.size = static_cast<uint32_t>(terminator - _data + 1);
+
+					_data = terminator + 1;
+					runningStatus = 0;
+				}
+				break;
+			case 0xf7:	// sysex continuation or escaped data
+				{
+					uint32_t len;
+					if(!readVarLen(len, _data, _end) || len > static_cast<size_t>(_end - _data))
+						return true;
+
+					e.data = _data;
+					e.size = len;
+
+					_data += len;
+					runningStatus = 0;
+				}
+				break;
+			case 0xff:
+				{
+					if(_data >= _end)
+						return true;
+
+					e.metaType = *_data++;
+
+					uint32_t len;
+					if(!readVarLen(len, _data, _end) || len > static_cast<size_t>(_end - _data))
+						return true;
+
+					e.data = _data;
+					e.size = len;
+
+					_data += len;
+
+					if(e.metaType == 0x2f)	// end of track
+						return _callback(e);
+				}
+				break;
+			default:
+				{
+					if(status > 0xef)
+						return true;	// system messages are not allowed in MIDI files
+
+					const uint32_t len = (status & 0xf0) == 0xc0 || (status & 0xf0) == 0xd0 ? 1 : 2;
+
+					if(len > static_cast<size_t>(_end - _data))
+						return true;
+
+					e.data = _data;
+					e.size = len;
+
+					_data += len;
+					runningStatus = status;
+				}
+				break;
+			}
+
+			if(!_callback(e))
+				return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace synthLib
+{
+	// Refers to a sysex message without copying it. Sysex in MIDI files is stored without the leading 0xf0, the span
+	// stores the payload only and adds the status byte on access. The last byte is always reported as 0xf7 as some
+	// files use other terminators, for example the Virus Powercore writes 0xf8
+	class SysexSpan
+	{
+	public:
+		SysexSpan() = default;
+
+		static SysexSpan fromMessage(const uint8_t* _data, const size_t _size)
+		{
+			return _size > 1 ? SysexSpan(_data + 1, _size - 1) : SysexSpan();
+		}
+
+		static SysexSpan fromPayload(const uint8_t* _payload, const size_t _size)
+		{
+			return SysexSpan(_payload, _size);
+		}
+
+		bool empty() const { return m_size == 0; }
+		size_t size() const { return m_size ? m_size + 1 : 0; }
+
+		uint8_t operator[](const size_t _index) const
+		{
+			if(_index == 0)
+				return 0xf0;
+			if(_index == m_size)
+				return 0xf7;
+			return m_payload[_index - 1];
+		}
+
+		const uint8_t* payload() const { return m_payload; }
+		size_t payloadSize() const { return m_size; }
+
+		std::vector<uint8_t> toVector() const;
+
+	private:
+		SysexSpan(const uint8_t* _payload, const size_t _size) : m_payload(_payload), m_size(_size) {}
+
+		const uint8_t* m_payload = nullptr;
+		size_t m_size = 0;	// payload size including terminator
+	};
+
+	// Parses Standard MIDI Files from memory. Events refer to the parsed buffer, nothing is copied. The buffer needs to
+	// stay valid as long as events are in use
+	class MidiFileParser
+	{
+	public:
+		struct Event
+		{
+			uint32_t tick = 0;				// absolute time in ticks since the start of the track
+			uint16_t track = 0;
+			uint8_t status = 0;				// channel status, 0xf0 / 0xf7 for sysex or 0xff for meta events
+			uint8_t metaType = 0;			// meta events only
+			const uint8_t* data = nullptr;	// sysex: payload following 0xf0, meta: meta data, otherwise: data bytes
+			uint32_t size = 0;
+
+			bool isSysex() const { return status == 0xf0; }
+			bool isMeta() const { return status == 0xff; }
+			SysexSpan getSysex() const { return isSysex() ? SysexSpan::fromPayload(data, size) : SysexSpan(); }
+		};
+
+		// return false to stop parsing
+		using EventCallback = std::function<bool(const Event&)>;
+
+		// Streaming mode, events are passed to the callback as soon as they are parsed and are not stored
+		bool parse(const uint8_t* _data, size_t _size, const EventCallback& _callback);
+		bool parse(std::vector<Event>& _events, const uint8_t* _data, size_t _size);
+
+		// Maps the file into memory, the events are only valid during the callback
+		bool parseFile(const std::string& _filename, const EventCallback& _callback);
+
+		static bool isMidiFile(const uint8_t* _data, size_t _size);
+
+		uint16_t getFormat() const { return m_format; }
+		uint16_t getTrackCount() const { return m_trackCount; }
+		uint16_t getDivision() const { return m_division; }
+
+	private:
+		// returns false if the callback requested to stop
+		static bool parseTrack(const uint8_t*& _data, const uint8_t* _end, uint16_t _track, const EventCallback& _callback);
+
+		uint16_t m_format = 0;
+		uint16_t m_trackCount = 0;
+		uint16_t m_division = 0;
+	};
+}
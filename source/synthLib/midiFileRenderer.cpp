@@ -0,0 +1,381 @@
+#include "midiFileRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "asyncLog.h"
+#include "binarystream.h"
+#include "buildconfig.h"
+#include "device.h"
+#include "memoryMappedFile.h"
+#include "midiFileParser.h"
+#include "renderCache.h"
+#include "wavWriter.h"
+
+namespace synthLib
+{
+	namespace
+	{
+		constexpr uint32_t g_defaultTempo = 500000;	// microseconds per quarter note, 120 bpm
+	}
+
+	bool MidiFileRenderer::load(const std::string& _filename)
+	{
+		const MemoryMappedFile file(_filename);
+
+		if(!file.isValid())
+		{
+			clear();
+			SYNTHLIB_LOG_ERROR("Failed to open MIDI file " << _filename);
+			return false;
+		}
+
+		if(!load(file.data(), file.size()))
+		{
+			SYNTHLIB_LOG_ERROR("Failed to load MIDI file " << _filename);
+			return false;
+		}
+
+		SYNTHLIB_LOG_INFO("Loaded MIDI file " << _filename << ", " << m_events.size() << " events, duration " << m_duration << " seconds");
+		return true;
+	}
+
+	bool MidiFileRenderer::load(const uint8_t* _data, const size_t _size)
+	{
+		clear();
+
+		if(!MidiFileParser::isMidiFile(_data, _size))
+		{
+			SYNTHLIB_LOG_ERROR("Data is not a Standard MIDI File");
+			return false;
+		}
+
+		MidiFileParser parser;
+		std::vector<MidiFileParser::Event> events;
+
+		if(!parser.parse(events, _data, _size))
+		{
+			SYNTHLIB_LOG_ERROR("Failed to parse Standard MIDI File");
+			return false;
+		}
+
+		// tracks are parsed one after another, merge them. Events at the same tick keep the order of the tracks, the
+		// tempo track comes first
+		std::stable_sort(events.begin(), events.end(), [](const MidiFileParser::Event& _a, const MidiFileParser::Event& _b)
+		{
+			return _a.tick < _b.tick;
+		});
+
+		const auto division = parser.getDivision();
+
+		// SMPTE based division has a negative frame rate in the upper byte and ticks per frame in the lower byte,
+		// the tempo map is not used in that case
+		const bool smpte = (division & 0x8000) != 0;
+		const double smpteTicksPerSecond = smpte ? static_cast<double>(-static_cast<int8_t>(division >> 8)) * static_cast<double>(division & 0xff) : 0.0;
+
+		if((smpte && smpteTicksPerSecond <= 0.0) || (!smpte && !division))
+		{
+			SYNTHLIB_LOG_ERROR("Invalid time division " << division);
+			return false;
+		}
+
+		double secondsPerTick = smpte ? 1.0 / smpteTicksPerSecond : g_defaultTempo * 1e-6 / division;
+		double time = 0.0;
+		uint32_t lastTick = 0;
+
+		for (const auto& e : events)
+		{
+			time += static_cast<double>(e.tick - lastTick) * secondsPerTick;
+			lastTick = e.tick;
+
+			m_duration = std::max(m_duration, time);
+
+			if(e.isMeta())
+			{
+				if(e.metaType == 0x51 && e.size == 3 && !smpte)
+				{
+					const uint32_t tempo = static_cast<uint32_t>(e.data[0]) << 16 | static_cast<uint32_t>(e.data[1]) << 8 | e.data[2];
+					if(tempo)
+						secondsPerTick = tempo * 1e-6 / division;
+				}
+				continue;
+			}
+
+			TimedEvent te;
+			te.time = time;
+
+			if(e.isSysex())
+			{
+				te.event.sysex = e.getSysex().toVector();
+			}
+			else if(e.status >= 0x80 && e.status < 0xf0)
+			{
+				te.event.a = e.status;
+				te.event.b = e.size > 0 ? e.data[0] : 0;
+				te.event.c = e.size > 1 ? e.data[1] : 0;
+
+				m_channelMask |= static_cast<uint16_t>(1 << (e.status & 0x0f));
+			}
+			else
+			{
+				continue;	// escaped data
+			}
+
+			m_events.push_back(std::move(te));
+		}
+
+		return true;
+	}
+
+	void MidiFileRenderer::clear()
+	{
+		m_events.clear();
+		m_channelMask = 0;
+		m_duration = 0.0;
+	}
+
+	void MidiFileRenderer::addEvent(const double _time, const SMidiEvent& _event)
+	{
+		TimedEvent te;
+		te.time = std::max(0.0, _time);
+		te.event = _event;
+		te.event.offset = 0;
+
+		// keep events sorted, events with the same time keep the order in which they have been added
+		const auto it = std::upper_bound(m_events.begin(), m_events.end(), te.time, [](const double _t, const TimedEvent& _e)
+		{
+			return _t < _e.time;
+		});
+
+		m_duration = std::max(m_duration, te.time);
+
+		m_events.insert(it, std::move(te));
+
+		if(_event.sysex.empty() && _event.a >= 0x80 && _event.a < 0xf0)
+			m_channelMask |= static_cast<uint16_t>(1 << (_event.a & 0x0f));
+	}
+
+	uint64_t MidiFileRenderer::getFrameCount(const float _samplerate, const Config& _config) const
+	{
+		return static_cast<uint64_t>(std::ceil((m_duration + _config.tailSeconds) * _samplerate));
+	}
+
+	bool MidiFileRenderer::render(Device& _device, const std::string& _wavFilename, const Config& _config, Stats* _stats/* = nullptr*/) const
+	{
+		Stats stats;
+
+		MD5 key;
+		const bool useCache = _config.cache && createCacheKey(key, _device, _config);
+
+		if(useCache && _config.cache->fetch(key, _wavFilename))
+		{
+			stats.cached = true;
+			stats.samples = getFrameCount(_device.getSamplerate(), _config);
+
+			if(_stats)
+				*_stats = stats;
+			return true;
+		}
+
+		if(!renderToFile(_device, _wavFilename, _config, stats))
+			return false;
+
+		if(useCache)
+			_config.cache->store(key, _wavFilename);
+
+		if(_stats)
+			*_stats = stats;
+		return true;
+	}
+
+	bool MidiFileRenderer::render(Device& _device, const AudioCallback& _callback, const Config& _config, Stats* _stats/* = nullptr*/) const
+	{
+		Stats stats;
+
+		if(!renderToCallback(_device, _callback, _config, stats))
+			return false;
+
+		if(_stats)
+			*_stats = stats;
+		return true;
+	}
+
+	bool MidiFileRenderer::createCacheKey(MD5& _key, Device& _device, const Config& _config) const
+	{
+#if SYNTHLIB_DEMO_MODE
+		return false;
+#else
+		if(_config.cacheKey.empty())
+			return false;
+
+		std::vector<uint8_t> state;
+		if(!_device.getState(state, StateTypeGlobal))
+			return false;
+
+		BinaryStream s;
+
+		s.write(_config.cacheKey);
+		s.write(state);
+		s.write(_device.getSamplerate());
+		s.write(_device.getExtraLatencySamples());
+
+		s.write(_config.blockSize);
+		s.write(_config.tailSeconds);
+		s.write(_config.channelCount);
+
+		auto writeEvent = [&s](const SMidiEvent& _e)
+		{
+			s.write(_e.a);
+			s.write(_e.b);
+			s.write(_e.c);
+			s.write(_e.sysex);
+		};
+
+		s.write(static_cast<uint32_t>(_config.setupEvents.size()));
+		for (const auto& e : _config.setupEvents)
+			writeEvent(e);
+
+		s.write(static_cast<uint32_t>(m_events.size()));
+		for (const auto& e : m_events)
+		{
+			s.write(e.time);
+			writeEvent(e.event);
+		}
+
+		s.write(m_duration);
+
+		std::vector<uint8_t> data;
+		s.toVector(data);
+
+		_key = RenderCache::createKey(data);
+		return true;
+#endif
+	}
+
+	bool MidiFileRenderer::renderToFile(Device& _device, const std::string& _wavFilename, const Config& _config, Stats& _stats) const
+	{
+		const auto samplerate = _device.getSamplerate();
+		const auto channelCount = getChannelCount(_device, _config);
+
+		if(!channelCount || samplerate <= 0.0f)
+			return false;
+
+		WavStreamWriter writer;
+
+		if(!writer.open(_wavFilename, 32, true, static_cast<int>(channelCount), static_cast<int>(std::lround(samplerate))))
+		{
+			SYNTHLIB_LOG_ERROR("Failed to create output file " << _wavFilename);
+			return false;
+		}
+
+		const auto success = renderToCallback(_device, [&](const float* _interleaved, const uint32_t _frameCount)
+		{
+			if(writer.write(_interleaved, static_cast<size_t>(_frameCount) * channelCount * sizeof(float)))
+				return true;
+
+			SYNTHLIB_LOG_ERROR("Failed to write to output file " << _wavFilename);
+			return false;
+		}, _config, _stats);
+
+		if(!success)
+		{
+			writer.close();
+			return false;
+		}
+
+		return writer.close();
+	}
+
+	bool MidiFileRenderer::renderToCallback(Device& _device, const AudioCallback& _callback, const Config& _config, Stats& _stats) const
+	{
+		const auto samplerate = _device.getSamplerate();
+		const auto blockSize = std::max(_config.blockSize, 1u);
+		const auto channelCount = getChannelCount(_device, _config);
+
+		if(!channelCount || samplerate <= 0.0f)
+			return false;
+
+		const auto totalSamples = getFrameCount(samplerate, _config);
+
+		std::vector<float> inputBuffer(blockSize, 0.0f);
+		std::vector<std::vector<float>> outputBuffers(std::tuple_size_v<TAudioOutputs>);
+
+		TAudioInputs inputs{};
+		TAudioOutputs outputs{};
+
+		for(size_t i=0; i<inputs.size(); ++i)
+			inputs[i] = inputBuffer.data();
+
+		// outputs that are not written to the file are still provided, the device might write to all of them
+		for(uint32_t i=0; i<std::min<uint32_t>(_device.getChannelCountOut(), static_cast<uint32_t>(outputs.size())); ++i)
+		{
+			outputBuffers[i].resize(blockSize);
+			outputs[i] = outputBuffers[i].data();
+		}
+
+		std::vector<float> interleaved(static_cast<size_t>(blockSize) * channelCount);
+		std::vector<SMidiEvent> midiIn;
+		std::vector<SMidiEvent> midiOut;
+
+		_stats = Stats();
+		size_t eventIndex = 0;
+		bool setupSent = false;
+
+		using Clock = std::chrono::steady_clock;
+
+		for(uint64_t pos = 0; pos < totalSamples; pos += blockSize)
+		{
+			const auto count = static_cast<uint32_t>(std::min<uint64_t>(blockSize, totalSamples - pos));
+
+			midiIn.clear();
+			midiOut.clear();
+
+			if(!setupSent)
+			{
+				midiIn.insert(midiIn.end(), _config.setupEvents.begin(), _config.setupEvents.end());
+				setupSent = true;
+			}
+
+			while(eventIndex < m_events.size())
+			{
+				const auto& e = m_events[eventIndex];
+				const auto samplePos = static_cast<uint64_t>(std::llround(e.time * samplerate));
+
+				if(samplePos >= pos + count)
+					break;
+
+				auto& ev = midiIn.emplace_back(e.event);
+				ev.offset = static_cast<uint32_t>(samplePos > pos ? samplePos - pos : 0);
+
+				++eventIndex;
+			}
+
+			_stats.events += static_cast<uint32_t>(midiIn.size());
+
+			const auto t0 = Clock::now();
+			_device.process(inputs, outputs, count, midiIn, midiOut);
+			_stats.renderSeconds += std::chrono::duration<double>(Clock::now() - t0).count();
+
+			auto* dst = interleaved.data();
+
+			for(uint32_t i=0; i<count; ++i)
+			{
+				for(uint32_t c=0; c<channelCount; ++c)
+					*dst++ = outputs[c][i];
+			}
+
+			if(!_callback(interleaved.data(), count))
+				return false;
+
+			_stats.samples += count;
+		}
+
+		return true;
+	}
+
+	uint32_t MidiFileRenderer::getChannelCount(Device& _device, const Config& _config)
+	{
+		return std::min<uint32_t>(std::min(_config.channelCount, _device.getChannelCountOut()), std::tuple_size_v<TAudioOutputs>);
+	}
+}
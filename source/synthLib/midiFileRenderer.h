@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "md5.h"
+#include "midiTypes.h"
+
+namespace synthLib
+{
+	class Device;
+	class RenderCache;
+
+	// Renders a Standard MIDI File through a device into a wav file, as fast as the device can process. All tracks are
+	// merged and event times are converted to sample positions via the tempo map of the file, events are passed to the
+	// device with sample accurate offsets
+	class MidiFileRenderer
+	{
+	public:
+		struct Config
+		{
+			uint32_t blockSize = 512;
+			float tailSeconds = 3.0f;				// rendered after the last event to let the sound decay
+			uint32_t channelCount = 2;				// device outputs that are written to the wav file
+			std::vector<SMidiEvent> setupEvents;	// sent before the first event of the file, for example to select a play mode
+
+			// Optional. Renders are served from the cache if possible and stored in it otherwise. The cache key has to
+			// identify everything that influences the output but is not part of the device state, such as the ROM.
+			// Nothing is cached if the key is empty
+			const RenderCache* cache = nullptr;
+			std::vector<uint8_t> cacheKey;
+		};
+
+		struct Stats
+		{
+			uint64_t samples = 0;
+			uint32_t events = 0;
+			double renderSeconds = 0.0;				// wall clock time spent in the device
+			bool cached = false;					// output has been served from the render cache
+		};
+
+		// Receives interleaved audio of the configured channel count. Returning false aborts rendering
+		using AudioCallback = std::function<bool(const float* _interleaved, uint32_t _frameCount)>;
+
+		bool load(const std::string& _filename);
+		bool load(const uint8_t* _data, size_t _size);
+
+		// Removes all events. Events can be added manually instead of loading a file, _time is in seconds
+		void clear();
+		void addEvent(double _time, const SMidiEvent& _event);
+
+		// time of the last event or of the end of the last track, in seconds
+		double getDuration() const { return m_duration; }
+		size_t getEventCount() const { return m_events.size(); }
+
+		// one bit per MIDI channel that is used by channel messages
+		uint16_t getChannelMask() const { return m_channelMask; }
+
+		// number of frames that are rendered at the given samplerate
+		uint64_t getFrameCount(float _samplerate, const Config& _config) const;
+
+		// number of interleaved channels that are rendered with the device
+		static uint32_t getChannelCount(Device& _device, const Config& _config);
+
+		// The device does not process anything if the output is served from the render cache
+		bool render(Device& _device, const std::string& _wavFilename, const Config& _config, Stats* _stats = nullptr) const;
+
+		// Renders to a callback instead of a file, the render cache is not used
+		bool render(Device& _device, const AudioCallback& _callback, const Config& _config, Stats* _stats = nullptr) const;
+
+	private:
+		bool createCacheKey(MD5& _key, Device& _device, const Config& _config) const;
+		bool renderToFile(Device& _device, const std::string& _wavFilename, const Config& _config, Stats& _stats) const;
+		bool renderToCallback(Device& _device, const AudioCallback& _callback, const Config& _config, Stats& _stats) const;
+
+		struct TimedEvent
+		{
+			double time = 0.0;	// seconds
+			SMidiEvent event;
+		};
+
+		std::vector<TimedEvent> m_events;
+		double m_duration = 0.0;
+		uint16_t m_channelMask = 0;
+	};
+}
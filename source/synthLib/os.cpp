@@ -1,5 +1,7 @@
 #include "os.h"
 
+#include <cstdlib>
+
 #include "../dsp56300/source/dsp56kEmu/logging.h"
 
 #ifndef _WIN32
@@ -108,6 +110,38 @@ namespace synthLib
 #endif
     }
 
+    std::string getCacheDirectory()
+    {
+        std::string base;
+
+#ifdef _WIN32
+        if(const auto* appData = std::getenv("LOCALAPPDATA"))
+            base = validatePath(appData);
+#elif defined(__APPLE__)
+        if(const auto* home = std::getenv("HOME"))
+            base = validatePath(home) + "Library/Caches/";
+#else
+        if(const auto* cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+        {
+            base = validatePath(cacheHome);
+        }
+        else if(const auto* home = std::getenv("HOME"))
+        {
+            base = validatePath(home) + ".cache/";
+            createDirectory(base);
+        }
+#endif
+        if(base.empty())
+            return getModulePath();
+
+        const auto dir = base + "DSP56300 Emulator/";
+
+        if(!isDirectory(dir))
+            createDirectory(dir);
+
+        return isDirectory(dir) ? dir : getModulePath();
+    }
+
     bool createDirectory(const std::string& _dir)
     {
 #ifdef USE_DIRENT
@@ -227,11 +261,41 @@ namespace synthLib
         return size;
     }
 
+    bool getFileInfo(const std::string& _file, size_t& _size, uint64_t& _lastModified)
+    {
+#ifdef USE_DIRENT
+        struct stat statbuf{};
+        if(stat(_file.c_str(), &statbuf) != 0)
+            return false;
+        if(!S_ISREG(statbuf.st_mode))
+            return false;
+        _size = static_cast<size_t>(statbuf.st_size);
+        _lastModified = static_cast<uint64_t>(statbuf.st_mtime);
+        return true;
+#else
+        try
+        {
+            const auto u8Path = std::filesystem::u8path(_file);
+            if(!std::filesystem::is_regular_file(u8Path))
+                return false;
+            _size = static_cast<size_t>(std::filesystem::file_size(u8Path));
+            _lastModified = static_cast<uint64_t>(std::filesystem::last_write_time(u8Path).time_since_epoch().count());
+            return true;
+        }
+        catch (std::exception& e)
+        {
+            LOG(e.what());
+            return false;
+        }
+#endif
+    }
+
     bool isDirectory(const std::string& _path)
     {
 #ifdef USE_DIRENT
 		struct stat statbuf;
-		stat(_path.c_str(), &statbuf);
+		if (stat(_path.c_str(), &statbuf) != 0)
+			return false;
 		if (S_ISDIR(statbuf.st_mode))
             return true;
         return false;
@@ -283,7 +347,11 @@ namespace synthLib
                 continue;
             }
 
-            const auto size = getFileSize(file);
+            size_t size;
+            uint64_t lastModified;
+
+            if (!getFileInfo(file, size, lastModified))
+                continue;
 
             if (_minSize && size < _minSize)
 	            continue;
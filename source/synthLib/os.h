@@ -3,11 +3,16 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <cstdint>
 
 namespace synthLib
 {
     std::string getModulePath(bool _stripPluginComponentFolders = true);
 
+	// Per-user folder for data that can be recreated at any time, such as measurements and indices. The folder of the
+	// plugin is often not writable. Falls back to the module path if there is no such folder
+	std::string getCacheDirectory();
+
 	std::string getCurrentDirectory();
 	bool createDirectory(const std::string& _dir);;
 	std::string validatePath(std::string _path);
@@ -29,6 +34,7 @@ namespace synthLib
 
 	bool hasExtension(const std::string& _filename, const std::string& _extension);
 	size_t getFileSize(const std::string& _file);
+	bool getFileInfo(const std::string& _file, size_t& _size, uint64_t& _lastModified);
 	bool isDirectory(const std::string& _path);
 
 	void setFlushDenormalsToZero();
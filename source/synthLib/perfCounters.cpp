@@ -0,0 +1,215 @@
+#include "perfCounters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace synthLib
+{
+	namespace
+	{
+		constexpr auto g_counterCount = static_cast<size_t>(PerfCounterId::Count);
+
+		struct Slot
+		{
+			std::atomic<uint64_t> count{0};
+			std::atomic<uint64_t> total{0};
+			std::atomic<uint64_t> max{0};
+			std::atomic<uint64_t> last{0};
+		};
+
+		struct alignas(64) ThreadCounters
+		{
+			std::array<Slot, g_counterCount> slots;
+			std::atomic<uint32_t> epoch{0};
+
+			void clear()
+			{
+				for (auto& s : slots)
+				{
+					s.count.store(0, std::memory_order_relaxed);
+					s.total.store(0, std::memory_order_relaxed);
+					s.max.store(0, std::memory_order_relaxed);
+					s.last.store(0, std::memory_order_relaxed);
+				}
+			}
+
+			void addTo(PerfCounterSnapshot& _snapshot) const
+			{
+				for(size_t i=0; i<g_counterCount; ++i)
+				{
+					const auto& s = slots[i];
+					auto& v = _snapshot.values[i];
+
+					const auto count = s.count.load(std::memory_order_relaxed);
+					if(!count)
+						continue;
+
+					v.count += count;
+					v.total += s.total.load(std::memory_order_relaxed);
+					v.max = std::max(v.max, s.max.load(std::memory_order_relaxed));
+					v.last = s.last.load(std::memory_order_relaxed);
+				}
+			}
+		};
+
+		struct Registry
+		{
+			std::mutex mutex;
+			std::vector<const ThreadCounters*> threads;
+			PerfCounterSnapshot exitedThreads;	// counters of threads that no longer exist
+			std::atomic<uint32_t> epoch{0};
+		};
+
+		Registry& getRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		struct ThreadCountersOwner
+		{
+			ThreadCountersOwner() : registry(getRegistry())
+			{
+				counters.epoch.store(registry.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+				std::lock_guard lock(registry.mutex);
+				registry.threads.push_back(&counters);
+			}
+
+			~ThreadCountersOwner()
+			{
+				std::lock_guard lock(registry.mutex);
+
+				if(counters.epoch.load(std::memory_order_relaxed) == registry.epoch.load(std::memory_order_relaxed))
+					counters.addTo(registry.exitedThreads);
+
+				registry.threads.erase(std::remove(registry.threads.begin(), registry.threads.end(), &counters), registry.threads.end());
+			}
+
+			Registry& registry;
+			ThreadCounters counters;
+		};
+
+		ThreadCounters& getThreadCounters()
+		{
+			thread_local ThreadCountersOwner owner;
+			return owner.counters;
+		}
+	}
+
+	PerfCounterSnapshot PerfCounterSnapshot::operator-(const PerfCounterSnapshot& _previous) const
+	{
+		PerfCounterSnapshot res = *this;
+
+		for(size_t i=0; i<g_counterCount; ++i)
+		{
+			auto& v = res.values[i];
+			const auto& p = _previous.values[i];
+
+			// counters might have been reset in between
+			if(v.count < p.count || v.total < p.total)
+				continue;
+
+			v.count -= p.count;
+			v.total -= p.total;
+		}
+		return res;
+	}
+
+	std::string PerfCounterSnapshot::toString() const
+	{
+		std::stringstream ss;
+
+		for(size_t i=0; i<g_counterCount; ++i)
+		{
+			const auto id = static_cast<PerfCounterId>(i);
+			const auto& v = values[i];
+
+			if(!v.count)
+				continue;
+
+			ss << PerfCounters::getName(id) << ": ";
+
+			if(PerfCounters::isTimer(id))
+				ss << "count " << v.count << ", avg " << (v.getAverage() / 1000.0) << " us, max " << (static_cast<double>(v.max) / 1000.0) << " us";
+			else
+				ss << "last " << v.last << ", avg " << v.getAverage() << ", max " << v.max;
+
+			ss << '\n';
+		}
+		return ss.str();
+	}
+
+	void PerfCounters::add(const PerfCounterId _id, const uint64_t _value)
+	{
+		auto& counters = getThreadCounters();
+
+		const auto epoch = getRegistry().epoch.load(std::memory_order_relaxed);
+
+		if(counters.epoch.load(std::memory_order_relaxed) != epoch)
+		{
+			counters.clear();
+			counters.epoch.store(epoch, std::memory_order_relaxed);
+		}
+
+		// only the owning thread writes, no read-modify-write operations are needed
+		auto& s = counters.slots[static_cast<size_t>(_id)];
+
+		s.count.store(s.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		s.total.store(s.total.load(std::memory_order_relaxed) + _value, std::memory_order_relaxed);
+		if(_value > s.max.load(std::memory_order_relaxed))
+			s.max.store(_value, std::memory_order_relaxed);
+		s.last.store(_value, std::memory_order_relaxed);
+	}
+
+	void PerfCounters::getSnapshot(PerfCounterSnapshot& _snapshot)
+	{
+		auto& registry = getRegistry();
+
+		std::lock_guard lock(registry.mutex);
+
+		_snapshot = registry.exitedThreads;
+
+		const auto epoch = registry.epoch.load(std::memory_order_relaxed);
+
+		for (const auto* t : registry.threads)
+		{
+			// threads that did not clear their storage since the last reset only have outdated values
+			if(t->epoch.load(std::memory_order_relaxed) == epoch)
+				t->addTo(_snapshot);
+		}
+	}
+
+	void PerfCounters::reset()
+	{
+		auto& registry = getRegistry();
+
+		std::lock_guard lock(registry.mutex);
+
+		registry.exitedThreads = PerfCounterSnapshot();
+		registry.epoch.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	const char* PerfCounters::getName(const PerfCounterId _id)
+	{
+		switch (_id)
+		{
+		case PerfCounterId::PluginProcess:			return "pluginProcess";
+		case PerfCounterId::PluginLoad:				return "pluginLoad";
+		case PerfCounterId::ResamplerProcess:		return "resamplerProcess";
+		case PerfCounterId::DeviceProcessAudio:		return "deviceProcessAudio";
+		case PerfCounterId::DspAudioWait:			return "dspAudioWait";
+		case PerfCounterId::Hdi08QueueDepth:		return "hdi08QueueDepth";
+		case PerfCounterId::MicrocontrollerProcess:	return "microcontrollerProcess";
+		default:									return "unknown";
+		}
+	}
+
+	bool PerfCounters::isTimer(const PerfCounterId _id)
+	{
+		return _id != PerfCounterId::PluginLoad && _id != PerfCounterId::Hdi08QueueDepth;
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "buildconfig.h"
+
+namespace synthLib
+{
+	enum class PerfCounterId : uint8_t
+	{
+		PluginProcess,			// timer: Plugin::process
+		PluginLoad,				// value: Plugin::process duration relative to the block duration, in permille
+		ResamplerProcess,		// timer: ResamplerInOut::process, includes the time spent in the device
+		DeviceProcessAudio,		// timer: Device::processAudio
+		DspAudioWait,			// timer: time blocked in Audio::processAudioInterleaved waiting for the DSP
+		Hdi08QueueDepth,		// value: number of words waiting to be sent to the DSP via HDI08
+		MicrocontrollerProcess,	// timer: Microcontroller::process
+
+		Count
+	};
+
+	struct PerfCounterValue
+	{
+		uint64_t count = 0;		// number of samples
+		uint64_t total = 0;		// sum of all samples, timers measure in nanoseconds
+		uint64_t max = 0;
+		uint64_t last = 0;
+
+		double getAverage() const { return count ? static_cast<double>(total) / static_cast<double>(count) : 0.0; }
+	};
+
+	struct PerfCounterSnapshot
+	{
+		std::array<PerfCounterValue, static_cast<size_t>(PerfCounterId::Count)> values;
+
+		const PerfCounterValue& operator[](PerfCounterId _id) const { return values[static_cast<size_t>(_id)]; }
+		PerfCounterValue& operator[](PerfCounterId _id) { return values[static_cast<size_t>(_id)]; }
+
+		// Returns the counts and totals accumulated since _previous. max and last are taken from this snapshot
+		PerfCounterSnapshot operator - (const PerfCounterSnapshot& _previous) const;
+
+		std::string toString() const;
+	};
+
+	// Process wide counters. Each thread writes to its own storage with relaxed atomic stores, which is lock-free and
+	// does not cause cache line contention if multiple plugin instances process in parallel. A snapshot sums up the
+	// storage of all threads. The first use on a thread registers its storage once, which requires a lock
+	class PerfCounters
+	{
+	public:
+		static constexpr bool Enabled = SYNTHLIB_PERF_COUNTERS;
+
+		static void add(PerfCounterId _id, uint64_t _value);
+
+		static void getSnapshot(PerfCounterSnapshot& _snapshot);
+
+		// Clears all counters. Threads clear their own storage on the next add() that follows
+		static void reset();
+
+		static const char* getName(PerfCounterId _id);
+		static bool isTimer(PerfCounterId _id);
+	};
+
+	class PerfTimer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		PerfTimer() : m_start(Clock::now()) {}
+
+		uint64_t getElapsedNanoseconds() const
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count());
+		}
+
+	private:
+		const Clock::time_point m_start;
+	};
+
+	class ScopedPerfTimer
+	{
+	public:
+		explicit ScopedPerfTimer(const PerfCounterId _id) : m_id(_id) {}
+		~ScopedPerfTimer() { PerfCounters::add(m_id, m_timer.getElapsedNanoseconds()); }
+
+		ScopedPerfTimer(const ScopedPerfTimer&) = delete;
+		ScopedPerfTimer& operator = (const ScopedPerfTimer&) = delete;
+
+	private:
+		const PerfCounterId m_id;
+		const PerfTimer m_timer;
+	};
+}
+
+#if SYNTHLIB_PERF_COUNTERS
+#define SYNTHLIB_PERF_SCOPE(ID)			const ::synthLib::ScopedPerfTimer perfScope##ID(::synthLib::PerfCounterId::ID)
+#define SYNTHLIB_PERF_VALUE(ID, VALUE)	::synthLib::PerfCounters::add(::synthLib::PerfCounterId::ID, static_cast<uint64_t>(VALUE))
+#else
+#define SYNTHLIB_PERF_SCOPE(ID)			do{}while(false)
+#define SYNTHLIB_PERF_VALUE(ID, VALUE)	do{}while(false)
+#endif
@@ -3,13 +3,13 @@
 
 #include <cmath>
 
+#include "asyncLog.h"
 #include "os.h"
+#include "perfCounters.h"
+#include "rtAudit.h"
+#include "tracer.h"
 
-#if 0
-#define LOGMC(S)	LOG(S)
-#else
-#define LOGMC(S)	do{}while(false)
-#endif
+#define LOGMC(S)	SYNTHLIB_LOG_DEBUG(S)
 
 using namespace synthLib;
 
@@ -48,6 +48,8 @@ namespace synthLib
 		if(!m_device->setSamplerate(sr))
 			return false;
 
+		m_recorder.recordSamplerate(sr);
+
 		m_deviceSamplerate = sr;
 		m_resampler.setSamplerates(m_hostSamplerate, m_deviceSamplerate);
 
@@ -61,6 +63,7 @@ namespace synthLib
 
 		m_deviceSamplerate = m_device->getDeviceSamplerate(_preferredDeviceSamplerate, _samplerate);
 		m_device->setSamplerate(m_deviceSamplerate);
+		m_recorder.recordSamplerate(m_deviceSamplerate);
 		m_resampler.setSamplerates(_samplerate, m_deviceSamplerate);
 
 		m_hostSamplerate = _samplerate;
@@ -74,8 +77,16 @@ namespace synthLib
 		if(!m_device->isValid())
 			return;
 
-		setFlushDenormalsToZero();
+#if SYNTHLIB_PERF_COUNTERS
+		const PerfTimer perfTimer;
+#endif
+		SYNTHLIB_TRACE_THREAD_NAME("Audio");
+		SYNTHLIB_TRACE_SCOPE("Plugin::process");
+		SYNTHLIB_RT_SCOPE();
+
+		m_deadlineMonitor.beginBlock();
 
+		setFlushDenormalsToZero();
 
 		TAudioInputs inputs(_inputs);
 		TAudioOutputs outputs(_outputs);
@@ -91,13 +102,31 @@ namespace synthLib
 		processMidiInEvents();
 		processMidiClock(_bpm, _ppqPos, _isPlaying, _count);
 
+		DeadlineMonitor::Context context;
+		context.midiIn = static_cast<uint32_t>(m_midiIn.size());
+		context.midiOut = static_cast<uint32_t>(m_midiOut.size());
+
 		m_resampler.process(inputs, outputs, m_midiIn, m_midiOut, static_cast<uint32_t>(_count), 
 			[&](const TAudioInputs& _ins, const TAudioOutputs& _outs, size_t _c, const ResamplerInOut::TMidiVec& _midiIn, ResamplerInOut::TMidiVec& _midiOut)
 		{
 			m_device->process(_ins, _outs, _c, _midiIn, _midiOut);
+			m_recorder.recordProcess(_ins, _outs, _c, _midiIn);
 		});
 
 		m_midiIn.clear();
+
+		context.midiOut = static_cast<uint32_t>(m_midiOut.size()) - context.midiOut;
+		context.midiPending = static_cast<uint32_t>(m_midiInRingBuffer.size());
+		context.latencyBlocks = m_extraLatencyBlocks;
+
+		m_deadlineMonitor.endBlock(_count, m_hostSamplerate, context);
+
+#if SYNTHLIB_PERF_COUNTERS
+		const auto elapsed = perfTimer.getElapsedNanoseconds();
+		PerfCounters::add(PerfCounterId::PluginProcess, elapsed);
+		if(_count && m_hostSamplerate > 0.0f)
+			PerfCounters::add(PerfCounterId::PluginLoad, static_cast<uint64_t>(static_cast<double>(elapsed) * m_hostSamplerate / (static_cast<double>(_count) * 1000000.0)));
+#endif
 	}
 
 	void Plugin::getMidiOut(std::vector<SMidiEvent>& _midiOut)
@@ -118,6 +147,14 @@ namespace synthLib
 
 		std::lock_guard lock(m_lock);
 
+		// a recording is only valid for a single device
+		m_recorder.stop();
+
+		replaceDevice(_device);
+	}
+
+	void Plugin::replaceDevice(Device* _device)
+	{
 		std::vector<uint8_t> deviceState;
 		getState(deviceState, StateTypeGlobal);
 
@@ -126,6 +163,8 @@ namespace synthLib
 		m_device = _device;
 
 		m_device->setSamplerate(m_deviceSamplerate);
+		m_recorder.recordSamplerate(m_deviceSamplerate);
+
 		setState(deviceState);
 
 		// MIDI clock has to send the start event again, some device find it confusing and do strange things if there isn't any
@@ -154,22 +193,47 @@ namespace synthLib
 		if(_state.empty())
 			return false;
 
-		if(_state.size() < 2)
-			return m_device->setStateFromUnknownCustomData(_state);
-
-		const auto version = _state[0];
-
-		if(version != g_stateVersion)
+		if(_state.size() < 2 || _state[0] != g_stateVersion)
+		{
+			m_recorder.recordUnknownState(_state);
 			return m_device->setStateFromUnknownCustomData(_state);
+		}
 
 		const auto stateType = static_cast<StateType>(_state[1]);
 
 		auto state = _state;
 		state.erase(state.begin(), state.begin() + 2);
 
+		m_recorder.recordState(state, stateType);
+
 		return m_device->setState(state, stateType);
 	}
 #endif
+
+	bool Plugin::startRecording(const std::string& _filename, Device* _bootedDevice)
+	{
+		if(!_bootedDevice)
+			return false;
+
+		std::lock_guard lock(m_lock);
+
+		m_recorder.stop();
+
+		// the recording starts before the state of the current device is transferred, everything that happens to the
+		// new device after booting is part of the capture
+		const auto started = m_recorder.start(_filename, *_bootedDevice);
+
+		replaceDevice(_bootedDevice);
+
+		return started;
+	}
+
+	void Plugin::stopRecording()
+	{
+		std::lock_guard lock(m_lock);
+		m_recorder.stop();
+	}
+
 	void Plugin::insertMidiEvent(const SMidiEvent& _ev)
 	{
 		if(m_midiIn.empty() || m_midiIn.back().offset <= _ev.offset)
@@ -281,6 +345,7 @@ namespace synthLib
 
 		const auto latency = static_cast<uint32_t>(std::ceil(static_cast<float>(m_blockSize * m_extraLatencyBlocks) * m_device->getSamplerate() * m_hostSamplerateInv));
 		m_device->setExtraLatencySamples(latency);
+		m_recorder.recordLatency(m_device->getExtraLatencySamples());
 
 		m_deviceLatencyMidiToOutput = static_cast<uint32_t>(static_cast<float>(m_device->getInternalLatencyMidiToOutput()) * m_hostSamplerate / m_device->getSamplerate());
 		m_deviceLatencyInputToOutput = static_cast<uint32_t>(static_cast<float>(m_device->getInternalLatencyInputToOutput()) * m_hostSamplerate / m_device->getSamplerate());
@@ -288,6 +353,8 @@ namespace synthLib
 
 	void Plugin::processMidiInEvents()
 	{
+		SYNTHLIB_TRACE_SCOPE("Plugin::processMidiInEvents");
+
 		while (!m_midiInRingBuffer.empty())
 		{
 			const auto ev = m_midiInRingBuffer.pop_front();
@@ -340,6 +407,12 @@ namespace synthLib
 		updateDeviceLatency();
 	}
 
+	void Plugin::refreshDeviceLatency()
+	{
+		std::lock_guard lock(m_lock);
+		updateDeviceLatency();
+	}
+
 	uint32_t Plugin::getLatencyMidiToOutput() const
 	{
 		std::lock_guard lock(m_lock);
@@ -2,6 +2,8 @@
 
 #include <mutex>
 
+#include "deadlineMonitor.h"
+#include "deviceRecorder.h"
 #include "midiTypes.h"
 #include "resamplerInOut.h"
 #include "buildconfig.h"
@@ -31,6 +33,9 @@ namespace synthLib
 		uint32_t getLatencyMidiToOutput() const;
 		uint32_t getLatencyInputToOutput() const;
 
+		// Reads the internal latencies of the device again, for example after they have been measured
+		void refreshDeviceLatency();
+
 		void process(const TAudioInputs& _inputs, const TAudioOutputs& _outputs, size_t _count, float _bpm, float _ppqPos, bool _isPlaying);
 		void getMidiOut(std::vector<SMidiEvent>& _midiOut);
 
@@ -48,10 +53,21 @@ namespace synthLib
 		bool setLatencyBlocks(uint32_t _latencyBlocks);
 		uint32_t getLatencyBlocks() const { return m_extraLatencyBlocks; }
 
+		DeadlineMonitor& getDeadlineMonitor() { return m_deadlineMonitor; }
+
+		// Records all calls to the device for offline reproduction, see DeviceReplay. The runtime state of a running
+		// device (voices, envelopes, LFOs, effect tails) cannot be captured, which is why a recording starts on a device
+		// that has just been booted and that replaces the current one. The plugin takes ownership of the device, the
+		// global state of the current device is transferred to it and is part of the recording
+		bool startRecording(const std::string& _filename, Device* _bootedDevice);
+		void stopRecording();
+		bool isRecording() const { return m_recorder.isRecording(); }
+
 	private:
 		void processMidiClock(float _bpm, float _ppqPos, bool _isPlaying, size_t _sampleCount);
 		float* getDummyBuffer(size_t _minimumSize);
 		void updateDeviceLatency();
+		void replaceDevice(Device* _device);
 		void processMidiInEvents();
 		void processMidiInEvent(const SMidiEvent& _ev);
 
@@ -84,5 +100,8 @@ namespace synthLib
 		uint32_t m_extraLatencyBlocks = 1;
 
 		float m_deviceSamplerate = 0.0f;
+
+		DeadlineMonitor m_deadlineMonitor;
+		DeviceRecorder m_recorder;
 	};
 }
@@ -0,0 +1,161 @@
+#include "renderCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "asyncLog.h"
+#include "binarystream.h"
+#include "buildconfig.h"
+#include "os.h"
+
+namespace synthLib
+{
+	namespace
+	{
+		bool copyFile(const std::string& _src, const std::string& _dst)
+		{
+			std::ifstream in(_src, std::ios::in | std::ios::binary);
+			if(!in.is_open())
+				return false;
+
+			std::ofstream out(_dst, std::ios::out | std::ios::binary | std::ios::trunc);
+			if(!out.is_open())
+				return false;
+
+			out << in.rdbuf();
+			return out.good();
+		}
+	}
+
+	RenderCache::RenderCache(std::string _folder, const uint64_t _maxSize/* = DefaultMaxSize*/) : m_folder(std::move(_folder)), m_maxSize(_maxSize)
+	{
+	}
+
+	MD5 RenderCache::createKey(const std::vector<uint8_t>& _inputs)
+	{
+		BinaryStream s;
+		s.write4CC("RCAC");
+		s.write(Version);
+		s.write(std::string(SYNTHLIB_VERSION));
+		s.write(_inputs);
+
+		std::vector<uint8_t> data;
+		s.toVector(data);
+
+		return MD5(data);
+	}
+
+	bool RenderCache::fetch(const MD5& _key, const std::string& _dstFilename) const
+	{
+		const auto filename = getFilename(_key);
+
+		if(!copyFile(filename, _dstFilename))
+			return false;
+
+		SYNTHLIB_LOG_INFO("Render served from cache file " << filename);
+		return true;
+	}
+
+	bool RenderCache::store(const MD5& _key, const std::string& _srcFilename) const
+	{
+		createDirectory(m_folder);
+
+		if(!isDirectory(m_folder))
+		{
+			SYNTHLIB_LOG_WARNING("Failed to create render cache folder " << m_folder);
+			return false;
+		}
+
+		// copy to a temporary file first so that concurrent renders never see a partially written entry
+		const auto filename = getFilename(_key);
+		const auto tempFilename = filename + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^ static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+		if(!copyFile(_srcFilename, tempFilename))
+		{
+			std::remove(tempFilename.c_str());
+			SYNTHLIB_LOG_WARNING("Failed to store render in cache file " << filename);
+			return false;
+		}
+
+		std::remove(filename.c_str());
+
+		if(std::rename(tempFilename.c_str(), filename.c_str()) != 0)
+		{
+			std::remove(tempFilename.c_str());
+			return false;
+		}
+
+		prune();
+		return true;
+	}
+
+	void RenderCache::prune() const
+	{
+		struct Entry
+		{
+			std::string filename;
+			size_t size;
+			uint64_t lastModified;
+		};
+
+		std::vector<std::string> files;
+		getDirectoryEntries(files, m_folder);
+
+		std::vector<Entry> entries;
+		uint64_t totalSize = 0;
+
+		// temporary files belong to stores that are in progress
+		for (auto& file : files)
+		{
+			Entry e;
+
+			if(!hasExtension(file, ".wav") || !getFileInfo(file, e.size, e.lastModified))
+				continue;
+
+			e.filename = std::move(file);
+			totalSize += e.size;
+			entries.push_back(std::move(e));
+		}
+
+		if(totalSize <= m_maxSize)
+			return;
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& _a, const Entry& _b)
+		{
+			return _a.lastModified < _b.lastModified;
+		});
+
+		size_t removed = 0;
+
+		for(const auto& e : entries)
+		{
+			if(totalSize <= m_maxSize)
+				break;
+
+			if(std::remove(e.filename.c_str()) != 0)
+				continue;
+
+			totalSize -= e.size;
+			++removed;
+		}
+
+		SYNTHLIB_LOG_INFO("Removed " << removed << " entries from render cache " << m_folder << ", " << totalSize << " bytes remaining");
+	}
+
+	std::string RenderCache::getDefaultFolder()
+	{
+		return getCacheDirectory() + "renderCache/";
+	}
+
+	std::string RenderCache::getFilename(const MD5& _key) const
+	{
+		auto folder = m_folder;
+		if(!folder.empty() && folder.back() != '/' && folder.back() != '\\')
+			folder += '/';
+		return folder + _key.toString() + ".wav";
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "md5.h"
+
+namespace synthLib
+{
+	// Stores the results of offline renders on disk. A render is identified by a hash of everything that influences
+	// its output, such as the ROM, the device state, the MIDI input and the block settings. The hash includes the
+	// project version and the cache version, updating the emulator invalidates all existing entries.
+	// The size of the cache is limited, if a store exceeds it, the entries that have been stored first are removed
+	class RenderCache
+	{
+	public:
+		// increase if the output of renders changes without a change of the project version
+		static constexpr uint32_t Version = 1;
+
+		static constexpr uint64_t DefaultMaxSize = 1024ull * 1024ull * 1024ull;
+
+		explicit RenderCache(std::string _folder, uint64_t _maxSize = DefaultMaxSize);
+
+		// _inputs is a serialization of all render inputs, see BinaryStream
+		static MD5 createKey(const std::vector<uint8_t>& _inputs);
+
+		// copies a cached render to _dstFilename, returns false if there is none
+		bool fetch(const MD5& _key, const std::string& _dstFilename) const;
+
+		// copies a finished render into the cache
+		bool store(const MD5& _key, const std::string& _srcFilename) const;
+
+		const std::string& getFolder() const { return m_folder; }
+
+		// removes the oldest entries until the cache fits into the size limit
+		void prune() const;
+
+		// located in the per-user cache directory
+		static std::string getDefaultFolder();
+
+	private:
+		std::string getFilename(const MD5& _key) const;
+
+		const std::string m_folder;
+		const uint64_t m_maxSize;
+	};
+}
@@ -5,6 +5,10 @@
 #include "../dsp56300/source/dsp56kEmu/fastmath.h"
 #include "../dsp56300/source/dsp56kEmu/logging.h"
 
+#include "asyncLog.h"
+#include "perfCounters.h"
+#include "tracer.h"
+
 #include <cstring>	// memset/memcpy
 
 using namespace dsp56k;
@@ -124,6 +128,9 @@ namespace synthLib
 		if(!m_in || !m_out)
 			return;
 
+		SYNTHLIB_PERF_SCOPE(ResamplerProcess);
+		SYNTHLIB_TRACE_SCOPE("ResamplerInOut::process");
+
 		if(m_samplerateDevice == m_samplerateHost)
 		{
 			_processFunc(_inputs, _outputs, _numSamples, _midiIn, _midiOut);
@@ -165,7 +172,7 @@ namespace synthLib
 			m_inputLatency += static_cast<uint32_t>(offset);
 			if(offset)
 			{
-				LOG("Resampler input latency " << m_inputLatency << " samples");
+				SYNTHLIB_LOG_INFO("Resampler input latency " << m_inputLatency << " samples");
 			}
 		};
 
@@ -184,7 +191,7 @@ namespace synthLib
 				m_scaledInput.insertZeroes(diff);
 				m_scaledInputSize += diff;
 				m_outputLatency += static_cast<uint32_t>(diff);
-				LOG("Resampler output latency " << m_outputLatency << " samples");
+				SYNTHLIB_LOG_INFO("Resampler output latency " << m_outputLatency << " samples");
 			}
 			m_scaledInput.fillPointers(inputs);
 			_processFunc(inputs, _outs, _numProcessedSamples, m_processedMidiIn, m_midiOut);
@@ -0,0 +1,521 @@
+#include "rtAudit.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#define RTAUDIT_EXECINFO
+#include <execinfo.h>
+#include <cxxabi.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+#if SYNTHLIB_RT_AUDIT && defined(__GLIBC__)
+#define RTAUDIT_INTERCEPT_LIBC
+#include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <ctime>
+#include <unistd.h>
+#endif
+
+// The interceptors access the thread state from within malloc. The initial-exec model ensures that accessing it does
+// never allocate, which could happen with dynamic TLS
+#if defined(__GNUC__) && !defined(_WIN32)
+#define RTAUDIT_TLS __attribute__((tls_model("initial-exec"))) thread_local
+#else
+#define RTAUDIT_TLS thread_local
+#endif
+
+namespace synthLib
+{
+	namespace
+	{
+		constexpr size_t g_maxFrames = 32;
+		constexpr size_t g_skipFrames = 3;	// captureStack, onViolation and the interceptor
+
+		RTAUDIT_TLS uint32_t t_realtimeDepth = 0;
+		RTAUDIT_TLS uint32_t t_allowDepth = 0;
+		RTAUDIT_TLS bool t_inHandler = false;
+
+		std::atomic<bool> g_active{false};
+		std::atomic<bool> g_strictLocking{false};
+		std::atomic<uint64_t> g_violationCount{0};
+
+		struct Record
+		{
+			RtViolation type;
+			const char* function;
+			std::vector<void*> frames;
+			uint64_t count = 0;
+		};
+
+		struct Records
+		{
+			std::mutex mutex;
+			std::map<uint64_t, Record> records;	// key is a hash of the type and the call stack
+		};
+
+		Records& getRecords()
+		{
+			static Records records;
+			return records;
+		}
+
+		size_t captureStack(void** _frames, const size_t _maxFrames)
+		{
+#if defined(RTAUDIT_EXECINFO)
+			return static_cast<size_t>(backtrace(_frames, static_cast<int>(_maxFrames)));
+#elif defined(_WIN32)
+			return CaptureStackBackTrace(0, static_cast<DWORD>(_maxFrames), _frames, nullptr);
+#else
+			return 0;
+#endif
+		}
+
+		std::string demangle(const std::string& _symbol)
+		{
+#ifdef RTAUDIT_EXECINFO
+			// glibc: "binary(_ZN3foo3barEv+0x12) [0x1234]", macOS: "3 binary 0x1234 _ZN3foo3barEv + 18"
+			const auto begin = _symbol.find("_Z");
+			if(begin == std::string::npos)
+				return _symbol;
+
+			auto end = _symbol.find_first_of("+ )", begin);
+			if(end == std::string::npos)
+				end = _symbol.size();
+
+			const auto mangled = _symbol.substr(begin, end - begin);
+
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+
+			if(status != 0 || !demangled)
+				return _symbol;
+
+			std::string res = _symbol.substr(0, begin) + demangled + _symbol.substr(end);
+			free(demangled);
+			return res;
+#else
+			return _symbol;
+#endif
+		}
+
+		std::vector<std::string> symbolize(const std::vector<void*>& _frames)
+		{
+			std::vector<std::string> res;
+
+			if(_frames.empty())
+				return res;
+
+#ifdef RTAUDIT_EXECINFO
+			char** symbols = backtrace_symbols(_frames.data(), static_cast<int>(_frames.size()));
+
+			if(symbols)
+			{
+				for(size_t i=0; i<_frames.size(); ++i)
+					res.push_back(demangle(symbols[i]));
+				free(symbols);
+				return res;
+			}
+#endif
+			for (auto* frame : _frames)
+			{
+				char temp[32];
+				snprintf(temp, sizeof(temp), "%p", frame);
+				res.emplace_back(temp);
+			}
+			return res;
+		}
+	}
+
+	void RtAudit::setActive(const bool _active)
+	{
+#ifdef RTAUDIT_EXECINFO
+		// the first backtrace() call loads libgcc, which allocates. Do it before auditing starts
+		if(_active)
+		{
+			void* frames[1];
+			backtrace(frames, 1);
+		}
+#endif
+		g_active.store(_active, std::memory_order_relaxed);
+	}
+
+	bool RtAudit::isActive()
+	{
+		return g_active.load(std::memory_order_relaxed);
+	}
+
+	void RtAudit::setStrictLocking(const bool _strict)
+	{
+		g_strictLocking.store(_strict, std::memory_order_relaxed);
+	}
+
+	bool RtAudit::isStrictLocking()
+	{
+		return g_strictLocking.load(std::memory_order_relaxed);
+	}
+
+	void RtAudit::enterRealtime()
+	{
+		++t_realtimeDepth;
+	}
+
+	void RtAudit::leaveRealtime()
+	{
+		--t_realtimeDepth;
+	}
+
+	void RtAudit::enterAllow()
+	{
+		++t_allowDepth;
+	}
+
+	void RtAudit::leaveAllow()
+	{
+		--t_allowDepth;
+	}
+
+	bool RtAudit::isAuditing()
+	{
+		return t_realtimeDepth && !t_allowDepth && !t_inHandler && g_active.load(std::memory_order_relaxed);
+	}
+
+	void RtAudit::onViolation(const RtViolation _type, const char* _function)
+	{
+		if(!isAuditing())
+			return;
+
+		// everything we do in here is allowed to allocate and lock
+		t_inHandler = true;
+
+		g_violationCount.fetch_add(1, std::memory_order_relaxed);
+
+		std::array<void*, g_maxFrames> frames{};
+		const auto frameCount = captureStack(frames.data(), frames.size());
+		const auto skip = std::min(frameCount, g_skipFrames);
+
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		auto addHash = [&hash](const uint64_t _v)
+		{
+			hash ^= _v;
+			hash *= 1099511628211ull;
+		};
+
+		addHash(static_cast<uint64_t>(_type));
+		for(size_t i=skip; i<frameCount; ++i)
+			addHash(reinterpret_cast<uintptr_t>(frames[i]));
+
+		{
+			auto& records = getRecords();
+			std::lock_guard lock(records.mutex);
+
+			auto& r = records.records[hash];
+
+			if(!r.count)
+			{
+				r.type = _type;
+				r.function = _function;
+				r.frames.assign(frames.begin() + static_cast<ptrdiff_t>(skip), frames.begin() + static_cast<ptrdiff_t>(frameCount));
+			}
+
+			++r.count;
+		}
+
+		t_inHandler = false;
+	}
+
+	uint64_t RtAudit::getViolationCount()
+	{
+		return g_violationCount.load(std::memory_order_relaxed);
+	}
+
+	void RtAudit::getReports(std::vector<Report>& _reports)
+	{
+		// symbolizing allocates, make sure that we do not report ourselves if called from a real-time scope
+		const auto inHandler = t_inHandler;
+		t_inHandler = true;
+
+		std::vector<Record> records;
+
+		{
+			auto& r = getRecords();
+			std::lock_guard lock(r.mutex);
+
+			for (const auto& it : r.records)
+				records.push_back(it.second);
+		}
+
+		for (const auto& r : records)
+		{
+			Report report;
+			report.type = r.type;
+			report.function = r.function;
+			report.count = r.count;
+			report.stack = symbolize(r.frames);
+			_reports.push_back(std::move(report));
+		}
+
+		t_inHandler = inHandler;
+	}
+
+	void RtAudit::clear()
+	{
+		auto& r = getRecords();
+		std::lock_guard lock(r.mutex);
+		r.records.clear();
+		g_violationCount.store(0, std::memory_order_relaxed);
+	}
+
+	const char* RtAudit::getName(const RtViolation _type)
+	{
+		switch (_type)
+		{
+		case RtViolation::Allocation:	return "allocation";
+		case RtViolation::Deallocation:	return "deallocation";
+		case RtViolation::MutexLock:	return "mutex lock";
+		case RtViolation::Wait:			return "wait";
+		case RtViolation::Sleep:		return "sleep";
+		case RtViolation::FileIO:		return "file io";
+		default:						return "unknown";
+		}
+	}
+
+	size_t RtAudit::writeReports(std::ostream& _out, const std::vector<std::string>& _suppressions)
+	{
+		std::vector<Report> reports;
+		getReports(reports);
+
+		size_t count = 0;
+
+		for (const auto& r : reports)
+		{
+			const auto suppressed = std::any_of(r.stack.begin(), r.stack.end(), [&](const std::string& _frame)
+			{
+				return std::any_of(_suppressions.begin(), _suppressions.end(), [&](const std::string& _s)
+				{
+					return !_s.empty() && _frame.find(_s) != std::string::npos;
+				});
+			});
+
+			if(suppressed)
+				continue;
+
+			++count;
+
+			_out << "Real-time violation: " << getName(r.type) << " (" << (r.function ? r.function : "") << "), " << r.count << " times" << std::endl;
+
+			for(size_t i=0; i<r.stack.size(); ++i)
+				_out << "\t#" << i << ' ' << r.stack[i] << std::endl;
+		}
+		return count;
+	}
+}
+
+#if SYNTHLIB_RT_AUDIT
+
+namespace
+{
+	using synthLib::RtAudit;
+	using synthLib::RtViolation;
+
+	void check(const RtViolation _type, const char* _function)
+	{
+		if(RtAudit::isAuditing())
+			RtAudit::onViolation(_type, _function);
+	}
+
+#ifdef RTAUDIT_INTERCEPT_LIBC
+	// libc-internal calls do not go through the replaced functions, which makes it safe to call dlsym from within
+	template<typename T> T getNext(std::atomic<void*>& _cache, const char* _name)
+	{
+		auto* f = _cache.load(std::memory_order_relaxed);
+		if(!f)
+		{
+			f = dlsym(RTLD_NEXT, _name);
+			_cache.store(f, std::memory_order_relaxed);
+		}
+		return reinterpret_cast<T>(f);
+	}
+
+#define RTAUDIT_NEXT(NAME)	static std::atomic<void*> next_##NAME{nullptr}; const auto real_##NAME = getNext<decltype(&NAME)>(next_##NAME, #NAME)
+#endif
+}
+
+#ifdef RTAUDIT_INTERCEPT_LIBC
+
+extern "C"
+{
+	void* __libc_malloc(size_t);
+	void* __libc_calloc(size_t, size_t);
+	void* __libc_realloc(void*, size_t);
+	void __libc_free(void*);
+
+	void* malloc(const size_t _size)
+	{
+		check(RtViolation::Allocation, "malloc");
+		return __libc_malloc(_size);
+	}
+
+	void* calloc(const size_t _count, const size_t _size)
+	{
+		check(RtViolation::Allocation, "calloc");
+		return __libc_calloc(_count, _size);
+	}
+
+	void* realloc(void* _ptr, const size_t _size)
+	{
+		check(RtViolation::Allocation, "realloc");
+		return __libc_realloc(_ptr, _size);
+	}
+
+	void free(void* _ptr)
+	{
+		if(_ptr)
+			check(RtViolation::Deallocation, "free");
+		__libc_free(_ptr);
+	}
+
+	int pthread_mutex_lock(pthread_mutex_t* _mutex)
+	{
+		RTAUDIT_NEXT(pthread_mutex_lock);
+
+		if(RtAudit::isAuditing())
+		{
+			// locking a mutex that is not held by anyone else does not block
+			if(!RtAudit::isStrictLocking() && pthread_mutex_trylock(_mutex) == 0)
+				return 0;
+
+			RtAudit::onViolation(RtViolation::MutexLock, "pthread_mutex_lock");
+		}
+
+		return real_pthread_mutex_lock(_mutex);
+	}
+
+	int pthread_cond_wait(pthread_cond_t* _cond, pthread_mutex_t* _mutex)
+	{
+		RTAUDIT_NEXT(pthread_cond_wait);
+		check(RtViolation::Wait, "pthread_cond_wait");
+		return real_pthread_cond_wait(_cond, _mutex);
+	}
+
+	int pthread_cond_timedwait(pthread_cond_t* _cond, pthread_mutex_t* _mutex, const timespec* _time)
+	{
+		RTAUDIT_NEXT(pthread_cond_timedwait);
+		check(RtViolation::Wait, "pthread_cond_timedwait");
+		return real_pthread_cond_timedwait(_cond, _mutex, _time);
+	}
+
+	int sem_wait(sem_t* _sem)
+	{
+		RTAUDIT_NEXT(sem_wait);
+		check(RtViolation::Wait, "sem_wait");
+		return real_sem_wait(_sem);
+	}
+
+	int nanosleep(const timespec* _req, timespec* _rem)
+	{
+		RTAUDIT_NEXT(nanosleep);
+		check(RtViolation::Sleep, "nanosleep");
+		return real_nanosleep(_req, _rem);
+	}
+
+	int clock_nanosleep(const clockid_t _clock, const int _flags, const timespec* _req, timespec* _rem)
+	{
+		RTAUDIT_NEXT(clock_nanosleep);
+		check(RtViolation::Sleep, "clock_nanosleep");
+		return real_clock_nanosleep(_clock, _flags, _req, _rem);
+	}
+
+	int usleep(const useconds_t _usec)
+	{
+		RTAUDIT_NEXT(usleep);
+		check(RtViolation::Sleep, "usleep");
+		return real_usleep(_usec);
+	}
+
+	ssize_t read(const int _fd, void* _buf, const size_t _count)
+	{
+		RTAUDIT_NEXT(read);
+		check(RtViolation::FileIO, "read");
+		return real_read(_fd, _buf, _count);
+	}
+
+	ssize_t write(const int _fd, const void* _buf, const size_t _count)
+	{
+		RTAUDIT_NEXT(write);
+		check(RtViolation::FileIO, "write");
+		return real_write(_fd, _buf, _count);
+	}
+}
+
+#else
+
+// Without libc interception, at least catch C++ allocations
+void* operator new(const size_t _size)
+{
+	check(RtViolation::Allocation, "operator new");
+	if(auto* p = std::malloc(_size ? _size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](const size_t _size)
+{
+	check(RtViolation::Allocation, "operator new[]");
+	if(auto* p = std::malloc(_size ? _size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(const size_t _size, const std::nothrow_t&) noexcept
+{
+	check(RtViolation::Allocation, "operator new");
+	return std::malloc(_size ? _size : 1);
+}
+
+void* operator new[](const size_t _size, const std::nothrow_t&) noexcept
+{
+	check(RtViolation::Allocation, "operator new[]");
+	return std::malloc(_size ? _size : 1);
+}
+
+void operator delete(void* _ptr) noexcept
+{
+	if(_ptr)
+		check(RtViolation::Deallocation, "operator delete");
+	std::free(_ptr);
+}
+
+void operator delete[](void* _ptr) noexcept
+{
+	if(_ptr)
+		check(RtViolation::Deallocation, "operator delete[]");
+	std::free(_ptr);
+}
+
+void operator delete(void* _ptr, size_t) noexcept
+{
+	operator delete(_ptr);
+}
+
+void operator delete[](void* _ptr, size_t) noexcept
+{
+	operator delete[](_ptr);
+}
+
+#endif
+
+#endif
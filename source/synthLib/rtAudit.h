@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "buildconfig.h"
+
+namespace synthLib
+{
+	enum class RtViolation : uint8_t
+	{
+		Allocation,		// malloc, calloc, realloc, operator new
+		Deallocation,	// free, operator delete
+		MutexLock,		// locking a mutex that is held by another thread, or any lock if strict locking is enabled
+		Wait,			// condition variables, semaphores
+		Sleep,			// sleep, nanosleep, usleep
+		FileIO,			// read, write
+
+		Count
+	};
+
+	// Debug facility that detects operations that are not real-time safe on threads that are currently processing
+	// audio. Code that needs to be real-time safe is marked with SYNTHLIB_RT_SCOPE(), code that is known to
+	// violate real-time constraints by design can be excluded with SYNTHLIB_RT_ALLOW().
+	// On Linux, allocations, mutex locks, waits, sleeps and file IO are intercepted by replacing the libc functions
+	// in the executable. On other platforms, only operator new/delete are intercepted. As the interceptors replace
+	// global functions, this is only compiled if SYNTHLIB_RT_AUDIT is enabled and should not be used in release builds
+	class RtAudit
+	{
+	public:
+		static constexpr bool Enabled = SYNTHLIB_RT_AUDIT;
+
+		struct Report
+		{
+			RtViolation type = RtViolation::Count;
+			const char* function = nullptr;
+			uint64_t count = 0;
+			std::vector<std::string> stack;		// symbolized call stack, innermost frame first
+		};
+
+		// Violations are only recorded while the audit is active
+		static void setActive(bool _active);
+		static bool isActive();
+
+		// If enabled, every mutex lock on a real-time thread is reported, not only locks that would block
+		static void setStrictLocking(bool _strict);
+		static bool isStrictLocking();
+
+		static void enterRealtime();
+		static void leaveRealtime();
+		static void enterAllow();
+		static void leaveAllow();
+
+		// true if the calling thread is in a real-time scope, is not allowed to violate and the audit is active
+		static bool isAuditing();
+
+		static void onViolation(RtViolation _type, const char* _function);
+
+		static uint64_t getViolationCount();
+		static void getReports(std::vector<Report>& _reports);
+		static void clear();
+
+		static const char* getName(RtViolation _type);
+
+		// Writes all reports that are not suppressed. A report is suppressed if any of its stack frames contains one
+		// of the given strings. Returns the number of reports that have been written
+		static size_t writeReports(std::ostream& _out, const std::vector<std::string>& _suppressions = {});
+	};
+
+	class ScopedRealtime
+	{
+	public:
+		ScopedRealtime() { RtAudit::enterRealtime(); }
+		~ScopedRealtime() { RtAudit::leaveRealtime(); }
+
+		ScopedRealtime(const ScopedRealtime&) = delete;
+		ScopedRealtime& operator = (const ScopedRealtime&) = delete;
+	};
+
+	class ScopedRtAllow
+	{
+	public:
+		explicit ScopedRtAllow(const char* /*_reason*/) { RtAudit::enterAllow(); }
+		~ScopedRtAllow() { RtAudit::leaveAllow(); }
+
+		ScopedRtAllow(const ScopedRtAllow&) = delete;
+		ScopedRtAllow& operator = (const ScopedRtAllow&) = delete;
+	};
+}
+
+#if SYNTHLIB_RT_AUDIT
+#define SYNTHLIB_RT_SCOPE()				const ::synthLib::ScopedRealtime rtAuditScope
+#define SYNTHLIB_RT_ALLOW(REASON)		const ::synthLib::ScopedRtAllow rtAuditAllow(REASON)
+#else
+#define SYNTHLIB_RT_SCOPE()				do{}while(false)
+#define SYNTHLIB_RT_ALLOW(REASON)		do{}while(false)
+#endif
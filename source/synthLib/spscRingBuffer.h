@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace synthLib
+{
+	// Lock-free ring buffer for exactly one producer thread and one consumer thread. Data is accessed in contiguous
+	// regions so that both sides can copy blocks directly from/to the buffer memory without intermediate buffers.
+	// The capacity does not need to be a power of two, which allows to use a multiple of an audio frame size so that
+	// regions never split a frame
+	template<typename T> class SpscRingBuffer
+	{
+	public:
+		explicit SpscRingBuffer(const size_t _capacity) : m_data(_capacity)
+		{
+		}
+
+		size_t capacity() const { return m_data.size(); }
+
+		size_t size() const
+		{
+			return m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_acquire);
+		}
+
+		bool empty() const { return size() == 0; }
+
+		// Producer: returns the number of elements that can be written contiguously to _ptr
+		size_t writeRegion(T*& _ptr)
+		{
+			const auto w = m_writePos.load(std::memory_order_relaxed);
+			const auto r = m_readPos.load(std::memory_order_acquire);
+
+			const auto index = w % capacity();
+			_ptr = &m_data[index];
+
+			return std::min(capacity() - (w - r), capacity() - index);
+		}
+
+		size_t freeSpace() const
+		{
+			return capacity() - (m_writePos.load(std::memory_order_relaxed) - m_readPos.load(std::memory_order_acquire));
+		}
+
+		void commitWrite(const size_t _count)
+		{
+			m_writePos.store(m_writePos.load(std::memory_order_relaxed) + _count, std::memory_order_release);
+		}
+
+		// Producer: writes as many elements as possible, returns the number of elements written
+		size_t write(const T* _src, const size_t _count)
+		{
+			size_t written = 0;
+
+			while(written < _count)
+			{
+				T* dst;
+				const auto n = std::min(writeRegion(dst), _count - written);
+				if(!n)
+					break;
+				std::copy_n(_src + written, n, dst);
+				commitWrite(n);
+				written += n;
+			}
+			return written;
+		}
+
+		// Consumer: returns the number of elements that can be read contiguously from _ptr
+		size_t readRegion(const T*& _ptr) const
+		{
+			const auto r = m_readPos.load(std::memory_order_relaxed);
+			const auto w = m_writePos.load(std::memory_order_acquire);
+
+			const auto index = r % capacity();
+			_ptr = &m_data[index];
+
+			return std::min(w - r, capacity() - index);
+		}
+
+		void commitRead(const size_t _count)
+		{
+			m_readPos.store(m_readPos.load(std::memory_order_relaxed) + _count, std::memory_order_release);
+		}
+
+		// Consumer: reads as many elements as possible, returns the number of elements read
+		size_t read(T* _dst, const size_t _count)
+		{
+			size_t read = 0;
+
+			while(read < _count)
+			{
+				const T* src;
+				const auto n = std::min(readRegion(src), _count - read);
+				if(!n)
+					break;
+				std::copy_n(src, n, _dst + read);
+				commitRead(n);
+				read += n;
+			}
+			return read;
+		}
+
+	private:
+		std::vector<T> m_data;
+
+		// positions increase monotonically, the index into the buffer is position % capacity
+		alignas(64) std::atomic<size_t> m_writePos{0};
+		alignas(64) std::atomic<size_t> m_readPos{0};
+	};
+}
@@ -0,0 +1,237 @@
+#include "tracer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace synthLib
+{
+	namespace
+	{
+		constexpr size_t g_spansPerThread = 32768;
+
+		using Clock = std::chrono::steady_clock;
+
+		const Clock::time_point g_timeBase = Clock::now();
+
+		struct Span
+		{
+			std::atomic<const char*> name{nullptr};
+			std::atomic<uint64_t> begin{0};
+			std::atomic<uint64_t> end{0};
+		};
+
+		struct ThreadBuffer
+		{
+			explicit ThreadBuffer(const uint32_t _id) : id(_id), name("Thread " + std::to_string(_id)) {}
+
+			const uint32_t id;
+			std::string name;	// guarded by the registry mutex
+
+			std::array<Span, g_spansPerThread> spans;
+			std::atomic<uint64_t> writePos{0};		// only written by the owning thread
+			std::atomic<uint64_t> clearPos{0};		// spans before this position have been discarded
+		};
+
+		struct Registry
+		{
+			std::mutex mutex;
+			std::vector<std::shared_ptr<ThreadBuffer>> threads;	// buffers of exited threads are kept until cleared
+			uint32_t nextThreadId = 1;
+		};
+
+		Registry& getRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+		thread_local std::string t_threadName;
+
+		ThreadBuffer& getThreadBuffer()
+		{
+			// the buffer is created on first use only, threads that never record do not pay for it
+			if(!t_buffer)
+			{
+				auto& registry = getRegistry();
+				std::lock_guard lock(registry.mutex);
+				t_buffer = std::make_shared<ThreadBuffer>(registry.nextThreadId++);
+				if(!t_threadName.empty())
+					t_buffer->name = t_threadName;
+				registry.threads.push_back(t_buffer);
+			}
+
+			return *t_buffer;
+		}
+
+		void writeString(std::ostream& _out, const char* _s)
+		{
+			_out << '"';
+			for(; *_s; ++_s)
+			{
+				const auto c = *_s;
+				if(c == '"' || c == '\\')
+					_out << '\\' << c;
+				else if(static_cast<unsigned char>(c) >= 0x20)
+					_out << c;
+			}
+			_out << '"';
+		}
+	}
+
+	std::atomic<bool> Tracer::m_running{false};
+
+	void Tracer::start()
+	{
+		m_running.store(true, std::memory_order_relaxed);
+	}
+
+	void Tracer::stop()
+	{
+		m_running.store(false, std::memory_order_relaxed);
+	}
+
+	void Tracer::clear()
+	{
+		auto& registry = getRegistry();
+
+		std::lock_guard lock(registry.mutex);
+
+		for (const auto& t : registry.threads)
+			t->clearPos.store(t->writePos.load(std::memory_order_acquire), std::memory_order_relaxed);
+
+		// buffers that are only referenced by the registry belong to threads that do not exist anymore
+		registry.threads.erase(std::remove_if(registry.threads.begin(), registry.threads.end(), [](const std::shared_ptr<ThreadBuffer>& _t)
+		{
+			return _t.use_count() == 1;
+		}), registry.threads.end());
+	}
+
+	void Tracer::addSpan(const char* _name, const uint64_t _beginNs, const uint64_t _endNs)
+	{
+		auto& buffer = getThreadBuffer();
+
+		const auto pos = buffer.writePos.load(std::memory_order_relaxed);
+		auto& span = buffer.spans[pos % g_spansPerThread];
+
+		span.name.store(_name, std::memory_order_relaxed);
+		span.begin.store(_beginNs, std::memory_order_relaxed);
+		span.end.store(_endNs, std::memory_order_relaxed);
+
+		buffer.writePos.store(pos + 1, std::memory_order_release);
+	}
+
+	void Tracer::setThreadName(const std::string& _name)
+	{
+		t_threadName = _name;
+
+		if(!t_buffer)
+			return;
+
+		auto& registry = getRegistry();
+		std::lock_guard lock(registry.mutex);
+		t_buffer->name = _name;
+	}
+
+	uint64_t Tracer::getTimeNs()
+	{
+		// zero is used as "not recording" by ScopedTrace
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_timeBase).count()) + 1;
+	}
+
+	void Tracer::writeJson(std::ostream& _out)
+	{
+		auto& registry = getRegistry();
+
+		std::lock_guard lock(registry.mutex);
+
+		struct Entry
+		{
+			const char* name;
+			uint64_t begin;
+			uint64_t end;
+		};
+
+		std::vector<Entry> entries;
+
+		_out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+		bool first = true;
+
+		auto separator = [&]
+		{
+			if(!first)
+				_out << ",\n";
+			first = false;
+		};
+
+		const auto flags = _out.flags();
+		const auto precision = _out.precision();
+
+		_out << std::fixed << std::setprecision(3);
+
+		for (const auto& t : registry.threads)
+		{
+			separator();
+			_out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t->id << ",\"args\":{\"name\":";
+			writeString(_out, t->name.c_str());
+			_out << "}}";
+
+			const auto end = t->writePos.load(std::memory_order_acquire);
+			auto begin = std::max(t->clearPos.load(std::memory_order_relaxed), end > g_spansPerThread ? end - g_spansPerThread : 0);
+
+			entries.clear();
+			entries.reserve(end - begin);
+
+			for(auto pos = begin; pos < end; ++pos)
+			{
+				const auto& span = t->spans[pos % g_spansPerThread];
+				entries.push_back({span.name.load(std::memory_order_relaxed), span.begin.load(std::memory_order_relaxed), span.end.load(std::memory_order_relaxed)});
+			}
+
+			// the thread might have continued writing while we copied, skip everything that could have been overwritten.
+			// This includes the slot at endAfterCopy, the thread might be writing it right now
+			const auto endAfterCopy = t->writePos.load(std::memory_order_acquire);
+			const auto firstValid = endAfterCopy >= g_spansPerThread ? endAfterCopy - g_spansPerThread + 1 : 0;
+			const auto skip = firstValid > begin ? std::min<uint64_t>(firstValid - begin, entries.size()) : 0;
+
+			for(auto i = static_cast<size_t>(skip); i<entries.size(); ++i)
+			{
+				const auto& e = entries[i];
+
+				if(!e.name)
+					continue;
+
+				separator();
+				_out << "{\"name\":";
+				writeString(_out, e.name);
+				_out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << t->id
+					<< ",\"ts\":" << (static_cast<double>(e.begin) / 1000.0)
+					<< ",\"dur\":" << (static_cast<double>(e.end - e.begin) / 1000.0) << '}';
+			}
+		}
+
+		_out << "]}" << std::endl;
+
+		_out.flags(flags);
+		_out.precision(precision);
+	}
+
+	bool Tracer::writeFile(const std::string& _filename)
+	{
+		std::ofstream out(_filename, std::ios::out | std::ios::trunc);
+
+		if(!out.is_open())
+			return false;
+
+		writeJson(out);
+
+		return out.good();
+	}
+}
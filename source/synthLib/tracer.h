@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "buildconfig.h"
+
+namespace synthLib
+{
+	// Records timed spans into per-thread buffers and writes them as Chrome trace_event JSON, which can be opened in
+	// chrome://tracing or Perfetto. Recording is off by default and needs to be started explicitly. Each thread owns a
+	// fixed size ring buffer that only the thread itself writes to, recording a span does not lock or allocate,
+	// except for the first span on a thread, which allocates the buffer. If a buffer is full, the oldest spans are
+	// overwritten
+	class Tracer
+	{
+	public:
+		static constexpr bool Enabled = SYNTHLIB_TRACE;
+
+		static void start();
+		static void stop();
+		static bool isRunning() { return m_running.load(std::memory_order_relaxed); }
+
+		// Discards all recorded spans
+		static void clear();
+
+		// _name needs to be a string literal or otherwise outlive the tracer
+		static void addSpan(const char* _name, uint64_t _beginNs, uint64_t _endNs);
+
+		static void setThreadName(const std::string& _name);
+
+		static uint64_t getTimeNs();
+
+		// Can be called while recording, spans that are overwritten while writing are skipped
+		static void writeJson(std::ostream& _out);
+		static bool writeFile(const std::string& _filename);
+
+	private:
+		static std::atomic<bool> m_running;
+	};
+
+	class ScopedTrace
+	{
+	public:
+		explicit ScopedTrace(const char* _name) : m_name(_name), m_begin(Tracer::isRunning() ? Tracer::getTimeNs() : 0) {}
+
+		~ScopedTrace()
+		{
+			if(m_begin)
+				Tracer::addSpan(m_name, m_begin, Tracer::getTimeNs());
+		}
+
+		ScopedTrace(const ScopedTrace&) = delete;
+		ScopedTrace& operator = (const ScopedTrace&) = delete;
+
+	private:
+		const char* const m_name;
+		const uint64_t m_begin;
+	};
+}
+
+#if SYNTHLIB_TRACE
+#define SYNTHLIB_TRACE_CONCAT2(A, B)		A##B
+#define SYNTHLIB_TRACE_CONCAT(A, B)			SYNTHLIB_TRACE_CONCAT2(A, B)
+#define SYNTHLIB_TRACE_SCOPE(NAME)			const ::synthLib::ScopedTrace SYNTHLIB_TRACE_CONCAT(traceScope, __LINE__)(NAME)
+// Names the calling thread once, subsequent calls on the same thread are ignored
+#define SYNTHLIB_TRACE_THREAD_NAME(NAME)	do { thread_local const bool traceThreadNamed = (::synthLib::Tracer::setThreadName(NAME), true); (void)traceThreadNamed; } while(false)
+#else
+#define SYNTHLIB_TRACE_SCOPE(NAME)			do{}while(false)
+#define SYNTHLIB_TRACE_THREAD_NAME(NAME)	do{}while(false)
+#endif
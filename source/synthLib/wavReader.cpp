@@ -1,5 +1,6 @@
 #include "wavReader.h"
 
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <cassert>
@@ -14,6 +15,9 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 {
 //	const unsigned int totalFileLength = _bufferSize;
 
+	if(_bufferSize < sizeof(SWaveFormatHeader) + sizeof(SWaveFormatChunkInfo))
+		return false;
+
 	size_t bufferPos = 0;
 
 	SWaveFormatHeader& header = *(SWaveFormatHeader*)&_buffer[0];
@@ -22,7 +26,10 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 	if( memcmp( header.str_wave, "WAVE", 4 ) != 0 )
 		return false;
 
-	if( memcmp( header.str_riff, "RIFF", 4 ) != 0 )
+	// RF64 is used for files that exceed 4 GiB, the 64 bit sizes are stored in a ds64 chunk
+	const bool isRF64 = memcmp( header.str_riff, "RF64", 4 ) == 0;
+
+	if( !isRF64 && memcmp( header.str_riff, "RIFF", 4 ) != 0 )
 		return false;
 
 	std::map<uint32_t, SWaveFormatChunkCuePoint> cuePoints;
@@ -31,20 +38,36 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 	size_t dataChunkOffset = 0;
 	size_t dataChunkSize = 0;
 	size_t formatChunkOffset = 0;
+	size_t formatChunkSize = 0;
+	uint64_t ds64DataSize = 0;
 
 	while( bufferPos < (_bufferSize - sizeof(SWaveFormatChunkInfo)) )
 	{
 		SWaveFormatChunkInfo& chunkInfo = *(SWaveFormatChunkInfo*)&_buffer[bufferPos];
 		bufferPos += sizeof(chunkInfo);
 
+		size_t chunkSize = chunkInfo.chunkSize;
+
 		if (memcmp(chunkInfo.chunkName, "fmt ", 4) == 0)
 		{
 			formatChunkOffset = bufferPos;
+			formatChunkSize = chunkSize;
+		}
+		else if (isRF64 && memcmp(chunkInfo.chunkName, "ds64", 4) == 0 && chunkSize >= 3 * sizeof(uint64_t))
+		{
+			// riff size, data size, sample count
+			memcpy(&ds64DataSize, &_buffer[bufferPos + sizeof(uint64_t)], sizeof(ds64DataSize));
 		}
 		else if (memcmp(chunkInfo.chunkName, "data", 4) == 0)
 		{
+			if(isRF64 && chunkInfo.chunkSize == 0xffffffff)
+				chunkSize = static_cast<size_t>(ds64DataSize);
+
+			// a file that is still being written might contain less data than announced
+			chunkSize = std::min(chunkSize, _bufferSize - bufferPos);
+
 			dataChunkOffset = bufferPos;
-			dataChunkSize = chunkInfo.chunkSize;
+			dataChunkSize = chunkSize;
 		}
 		else if (memcmp(chunkInfo.chunkName, "cue ", 4) == 0)
 		{
@@ -105,7 +128,7 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 			}
 		}
 
-		bufferPos += (chunkInfo.chunkSize + 1) & ~1;
+		bufferPos += (chunkSize + 1) & ~static_cast<size_t>(1);
 	}
 
 	if (dataChunkOffset == 0)
@@ -123,15 +146,24 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 	SWaveFormatChunkFormat& fmt = *(SWaveFormatChunkFormat*)&_buffer[formatChunkOffset];
 	bufferPos += sizeof(fmt);
 
-	if( fmt.wave_type != eFormat_PCM && fmt.wave_type != eFormat_IEEE_FLOAT )
+	uint16_t waveType = fmt.wave_type;
+
+	// WAVE_FORMAT_EXTENSIBLE, the actual format is stored in the first two bytes of the sub format GUID
+	if(waveType == eFormat_EXTENSIBLE && formatChunkSize >= 40)
+		memcpy(&waveType, &_buffer[formatChunkOffset + 24], sizeof(waveType));
+
+	if( waveType != eFormat_PCM && waveType != eFormat_IEEE_FLOAT )
 		return false;	// Not PCM or float data
 
+	if( fmt.bits_per_sample == 0 || fmt.num_channels == 0 )
+		return false;
+
 	_data.samplerate = fmt.sample_rate;
 
 	bufferPos = dataChunkOffset;
 
-	const uint32_t numBytes			= static_cast<uint32_t>(dataChunkSize);
-	const uint32_t numSamples		= (numBytes << 3) / fmt.bits_per_sample;
+	const size_t numBytes			= dataChunkSize;
+	const size_t numSamples			= (numBytes << 3) / fmt.bits_per_sample;
 
 	int numChannels = fmt.num_channels;
 
@@ -139,7 +171,7 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 	_data.dataByteSize = numBytes;
 	_data.bitsPerSample = fmt.bits_per_sample;
 	_data.channels = fmt.num_channels;
-	_data.isFloat = fmt.wave_type == eFormat_IEEE_FLOAT;
+	_data.isFloat = waveType == eFormat_IEEE_FLOAT;
 
 	if (_cuePoints && !cuePoints.empty())
 	{
@@ -171,4 +203,143 @@ bool WavReader::load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8
 	return true;
 }
 
+
+ChannelView ChannelView::subView(const size_t _offset, size_t _count) const
+{
+	if(_offset >= m_size)
+		return ChannelView(m_data, 0, m_stride, m_format);
+
+	_count = std::min(_count, m_size - _offset);
+	return ChannelView(getRaw(_offset), _count, m_stride, m_format);
+}
+
+void ChannelView::read(float* _dst, const size_t _offset, const size_t _count) const
+{
+	const auto view = subView(_offset, _count);
+
+	// float data is the common case for renders, it does not need any conversion
+	if(m_format == SampleFormat::Float32)
+	{
+		for(size_t i=0; i<view.size(); ++i)
+			memcpy(&_dst[i], view.getRaw(i), sizeof(float));
+		return;
+	}
+
+	for(size_t i=0; i<view.size(); ++i)
+		_dst[i] = view[i];
+}
+
+WavFile::BlockIterator::BlockIterator(const WavFile& _file, const size_t _blockSize) : m_file(_file), m_blockSize(std::max<size_t>(_blockSize, 1))
+{
+}
+
+bool WavFile::BlockIterator::next()
+{
+	if(m_started)
+		m_offset += m_count;
+
+	m_started = true;
+
+	const auto frameCount = m_file.getFrameCount();
+
+	if(m_offset >= frameCount)
+	{
+		m_count = 0;
+		return false;
+	}
+
+	m_count = std::min(m_blockSize, frameCount - m_offset);
+	return true;
+}
+
+ChannelView WavFile::BlockIterator::getChannel(const uint32_t _channel) const
+{
+	return m_file.getChannel(_channel, m_offset, m_count);
+}
+
+void WavFile::BlockIterator::read(float* const* _channels) const
+{
+	for(uint32_t c=0; c<m_file.getChannelCount(); ++c)
+	{
+		if(_channels[c])
+			getChannel(c).read(_channels[c], 0, m_count);
+	}
+}
+
+bool WavFile::open(const std::string& _filename, std::vector<CuePoint>* _cuePoints/* = nullptr*/)
+{
+	close();
+
+	if(!m_file.open(_filename))
+		return false;
+
+	if(!WavReader::load(m_data, _cuePoints, m_file.data(), m_file.size()))
+	{
+		close();
+		return false;
+	}
+
+	m_format = getSampleFormat(m_data);
+
+	if(m_format == SampleFormat::Invalid)
+	{
+		LOG("Unsupported sample format, " << m_data.bitsPerSample << " bits " << (m_data.isFloat ? "float" : "integer"));
+		close();
+		return false;
+	}
+
+	m_frameSize = (m_data.bitsPerSample >> 3) * m_data.channels;
+	m_frameCount = m_data.dataByteSize / m_frameSize;
+
+	// files are usually processed from start to end
+	m_file.adviseSequential();
+
+	return true;
+}
+
+void WavFile::close()
+{
+	m_file.close();
+	m_data = Data();
+	m_format = SampleFormat::Invalid;
+	m_frameSize = 0;
+	m_frameCount = 0;
+}
+
+ChannelView WavFile::getChannel(const uint32_t _channel) const
+{
+	return getChannel(_channel, 0, m_frameCount);
+}
+
+ChannelView WavFile::getChannel(const uint32_t _channel, const size_t _frameOffset, const size_t _frameCount) const
+{
+	if(_channel >= m_data.channels)
+		return {};
+
+	const auto* data = static_cast<const uint8_t*>(m_data.data) + _channel * (m_data.bitsPerSample >> 3);
+
+	return ChannelView(data, m_frameCount, m_frameSize, m_format).subView(_frameOffset, _frameCount);
+}
+
+SampleFormat WavFile::getSampleFormat(const Data& _data)
+{
+	if(_data.isFloat)
+	{
+		switch (_data.bitsPerSample)
+		{
+		case 32:	return SampleFormat::Float32;
+		case 64:	return SampleFormat::Float64;
+		default:	return SampleFormat::Invalid;
+		}
+	}
+
+	switch (_data.bitsPerSample)
+	{
+	case 16:	return SampleFormat::Int16;
+	case 24:	return SampleFormat::Int24;
+	case 32:	return SampleFormat::Int32;
+	default:	return SampleFormat::Invalid;
+	}
+}
+
 }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <string>
 
+#include "memoryMappedFile.h"
+
 namespace synthLib
 {
 	struct CuePoint
@@ -31,4 +35,128 @@ namespace synthLib
 	public:
 		static bool load(Data& _data, std::vector<CuePoint>* _cuePoints, const uint8_t* _buffer, size_t _bufferSize);
 	};
+
+	enum class SampleFormat : uint8_t
+	{
+		Invalid,
+		Int16,
+		Int24,
+		Int32,
+		Float32,
+		Float64
+	};
+
+	// Read-only view of one channel of interleaved sample data. It does not copy, samples are converted to float on access
+	class ChannelView
+	{
+	public:
+		ChannelView() = default;
+		ChannelView(const uint8_t* _data, const size_t _size, const uint32_t _stride, const SampleFormat _format)
+			: m_data(_data), m_size(_size), m_stride(_stride), m_format(_format)
+		{
+		}
+
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		SampleFormat getFormat() const { return m_format; }
+
+		const uint8_t* getRaw(const size_t _index) const { return m_data + _index * m_stride; }
+
+		float operator[](const size_t _index) const
+		{
+			const auto* p = getRaw(_index);
+
+			switch (m_format)
+			{
+			case SampleFormat::Int16:	return static_cast<float>(read<int16_t>(p)) * (1.0f / 32768.0f);
+			case SampleFormat::Int24:	return static_cast<float>(static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 24) >> 8) * (1.0f / 8388608.0f);
+			case SampleFormat::Int32:	return static_cast<float>(read<int32_t>(p)) * (1.0f / 2147483648.0f);
+			case SampleFormat::Float32:	return read<float>(p);
+			case SampleFormat::Float64:	return static_cast<float>(read<double>(p));
+			default:					return 0.0f;
+			}
+		}
+
+		ChannelView subView(size_t _offset, size_t _count) const;
+
+		// Converts _count samples starting at _offset to float
+		void read(float* _dst, size_t _offset, size_t _count) const;
+
+	private:
+		template<typename T> static T read(const uint8_t* _p)
+		{
+			T v;
+			memcpy(&v, _p, sizeof(T));
+			return v;
+		}
+
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+		uint32_t m_stride = 0;
+		SampleFormat m_format = SampleFormat::Invalid;
+	};
+
+	// Wav file that is memory mapped instead of being loaded, the audio data is accessed in place. Supports RIFF and
+	// RF64 files with 16, 24 or 32 bit integer and 32 or 64 bit float samples
+	class WavFile
+	{
+	public:
+		// Iterates over a file in blocks of a fixed number of frames, the last block might be shorter
+		class BlockIterator
+		{
+		public:
+			BlockIterator(const WavFile& _file, size_t _blockSize);
+
+			// advances to the next block, returns false if the end of the file has been reached
+			bool next();
+
+			size_t getFrameOffset() const { return m_offset; }
+			size_t getFrameCount() const { return m_count; }
+
+			ChannelView getChannel(uint32_t _channel) const;
+
+			// deinterleaves the current block into one float buffer per channel, null pointers are skipped
+			void read(float* const* _channels) const;
+
+		private:
+			const WavFile& m_file;
+			const size_t m_blockSize;
+			size_t m_offset = 0;
+			size_t m_count = 0;
+			bool m_started = false;
+		};
+
+		WavFile() = default;
+		WavFile(const WavFile&) = delete;
+		WavFile(WavFile&&) = default;
+
+		WavFile& operator = (const WavFile&) = delete;
+		WavFile& operator = (WavFile&&) = default;
+
+		bool open(const std::string& _filename, std::vector<CuePoint>* _cuePoints = nullptr);
+		void close();
+
+		bool isValid() const { return m_format != SampleFormat::Invalid; }
+
+		const Data& getData() const { return m_data; }
+		SampleFormat getFormat() const { return m_format; }
+		uint32_t getChannelCount() const { return m_data.channels; }
+		uint32_t getSamplerate() const { return m_data.samplerate; }
+		size_t getFrameCount() const { return m_frameCount; }
+		uint32_t getFrameSize() const { return m_frameSize; }
+
+		ChannelView getChannel(uint32_t _channel) const;
+		ChannelView getChannel(uint32_t _channel, size_t _frameOffset, size_t _frameCount) const;
+
+		BlockIterator getBlocks(const size_t _blockSize) const { return BlockIterator(*this, _blockSize); }
+
+		static SampleFormat getSampleFormat(const Data& _data);
+
+	private:
+		MemoryMappedFile m_file;
+		Data m_data;
+		SampleFormat m_format = SampleFormat::Invalid;
+		uint32_t m_frameSize = 0;
+		size_t m_frameCount = 0;
+	};
 };
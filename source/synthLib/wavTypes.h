@@ -104,6 +104,7 @@ namespace synthLib
 		eFormat_OLIADPCM					= 0x1001,
 		eFormat_OLICELP						= 0x1002,
 		eFormat_OLISBC						= 0x1003,
-		eFormat_OLIOPR						= 0x1004
+		eFormat_OLIOPR						= 0x1004,
+		eFormat_EXTENSIBLE					= 0xfffe
 	};
 }
@@ -2,12 +2,22 @@
 
 #include "../dsp56300/source/dsp56kEmu/logging.h"
 
-#include <map>
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstring>
 #include <mutex>
 #include <thread>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "os.h"
+#include "tracer.h"
+
 #include "dsp56kEmu/threadtools.h"
 #include "dsp56kEmu/types.h"
 
@@ -111,10 +121,188 @@ namespace synthLib
 		_dst.push_back(d[2]);
 	}
 
-	AsyncWriter::AsyncWriter(std::string _filename, uint32_t _samplerate, bool _measureSilence)
+	namespace
+	{
+		constexpr uint32_t g_junkChunkSize = 28;	// size of a ds64 chunk without table
+		constexpr uint32_t g_headerSize = 12 + 8 + g_junkChunkSize + 8 + sizeof(SWaveFormatChunkFormat) + 8;
+		constexpr uint64_t g_maxRiffSize = 0xffffffffull;
+
+		void put16(uint8_t*& _dst, const uint16_t _v)	{ memcpy(_dst, &_v, sizeof(_v)); _dst += sizeof(_v); }
+		void put32(uint8_t*& _dst, const uint32_t _v)	{ memcpy(_dst, &_v, sizeof(_v)); _dst += sizeof(_v); }
+		void put64(uint8_t*& _dst, const uint64_t _v)	{ memcpy(_dst, &_v, sizeof(_v)); _dst += sizeof(_v); }
+		void putId(uint8_t*& _dst, const char* _id)		{ memcpy(_dst, _id, 4); _dst += 4; }
+
+		bool seek(FILE* _file, const uint64_t _pos)
+		{
+#ifdef _WIN32
+			return _fseeki64(_file, static_cast<int64_t>(_pos), SEEK_SET) == 0;
+#else
+			return fseeko(_file, static_cast<off_t>(_pos), SEEK_SET) == 0;
+#endif
+		}
+	}
+
+	WavStreamWriter::~WavStreamWriter()
+	{
+		close();
+	}
+
+	bool WavStreamWriter::open(const std::string& _filename, const int _bitsPerSample, const bool _isFloat, const int _channelCount, const int _samplerate, const uint64_t _preallocateStep/* = 64 * 1024 * 1024*/)
+	{
+		close();
+
+		m_file = openFile(_filename, "wb");
+
+		if(!m_file)
+		{
+			LOG("Failed to open file for writing: " << _filename);
+			return false;
+		}
+
+		m_filename = _filename;
+
+		const auto bytesPerFrame = (_bitsPerSample >> 3) * _channelCount;
+
+		m_format.wave_type = _isFloat ? eFormat_IEEE_FLOAT : eFormat_PCM;
+		m_format.num_channels = static_cast<uint16_t>(_channelCount);
+		m_format.sample_rate = static_cast<uint32_t>(_samplerate);
+		m_format.bytes_per_sec = static_cast<uint32_t>(_samplerate * bytesPerFrame);
+		m_format.block_alignment = static_cast<uint16_t>(bytesPerFrame);
+		m_format.bits_per_sample = static_cast<uint16_t>(_bitsPerSample);
+
+		m_dataSize = 0;
+		m_allocatedSize = 0;
+		m_preallocateStep = _preallocateStep;
+
+		if(!writeHeader())
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	bool WavStreamWriter::write(const void* _data, const size_t _size)
+	{
+		if(!m_file)
+			return false;
+
+		const auto end = g_headerSize + m_dataSize + _size;
+
+		if(m_preallocateStep && end > m_allocatedSize)
+		{
+			const auto allocSize = (end + m_preallocateStep - 1) / m_preallocateStep * m_preallocateStep;
+			if(resize(allocSize))
+				m_allocatedSize = allocSize;
+		}
+
+		if(!seek(m_file, g_headerSize + m_dataSize))
+			return false;
+
+		const auto written = fwrite(_data, 1, _size, m_file);
+		m_dataSize += written;
+
+		return written == _size;
+	}
+
+	bool WavStreamWriter::flush()
+	{
+		if(!m_file)
+			return false;
+
+		// keep the file valid even if the process does not terminate properly
+		const auto res = writeHeader();
+		fflush(m_file);
+		return res;
+	}
+
+	bool WavStreamWriter::close()
+	{
+		if(!m_file)
+			return false;
+
+		bool res = writeHeader();
+
+		// chunks need to have an even size, add a pad byte if required
+		uint64_t fileSize = g_headerSize + m_dataSize;
+
+		if(m_dataSize & 1)
+		{
+			constexpr uint8_t pad = 0;
+			res &= seek(m_file, fileSize) && fwrite(&pad, 1, 1, m_file) == 1;
+			++fileSize;
+		}
+
+		// remove the unused part of the preallocated space
+		if(m_allocatedSize)
+			res &= resize(fileSize);
+
+		fclose(m_file);
+		m_file = nullptr;
+
+		if(!res)
+			LOG("Failed to finalize file " << m_filename);
+
+		return res;
+	}
+
+	bool WavStreamWriter::writeHeader()
+	{
+		const auto riffSize = g_headerSize - 8 + ((m_dataSize + 1) & ~1ull);
+		const bool rf64 = riffSize > g_maxRiffSize;
+
+		uint8_t header[g_headerSize];
+		auto* p = header;
+
+		putId(p, rf64 ? "RF64" : "RIFF");
+		put32(p, rf64 ? 0xffffffff : static_cast<uint32_t>(riffSize));
+		putId(p, "WAVE");
+
+		// RF64 stores the 64 bit sizes in a ds64 chunk. For regular files, a JUNK chunk reserves the space for it
+		putId(p, rf64 ? "ds64" : "JUNK");
+		put32(p, g_junkChunkSize);
+		put64(p, rf64 ? riffSize : 0);
+		put64(p, rf64 ? m_dataSize : 0);
+		put64(p, rf64 && m_format.block_alignment ? m_dataSize / m_format.block_alignment : 0);
+		put32(p, 0);	// table length
+
+		putId(p, "fmt ");
+		put32(p, sizeof(SWaveFormatChunkFormat));
+		put16(p, m_format.wave_type);
+		put16(p, m_format.num_channels);
+		put32(p, m_format.sample_rate);
+		put32(p, m_format.bytes_per_sec);
+		put16(p, m_format.block_alignment);
+		put16(p, m_format.bits_per_sample);
+
+		putId(p, "data");
+		put32(p, rf64 ? 0xffffffff : static_cast<uint32_t>(m_dataSize));
+
+		assert(p == header + g_headerSize);
+
+		return seek(m_file, 0) && fwrite(header, 1, g_headerSize, m_file) == g_headerSize;
+	}
+
+	bool WavStreamWriter::resize(const uint64_t _size) const
+	{
+		fflush(m_file);
+#ifdef _WIN32
+		return _chsize_s(_fileno(m_file), static_cast<int64_t>(_size)) == 0;
+#else
+		return ftruncate(fileno(m_file), static_cast<off_t>(_size)) == 0;
+#endif
+	}
+
+	AsyncWriter::AsyncWriter(std::string _filename, const uint32_t _samplerate, const bool _measureSilence/* = false*/, const uint32_t _channelCount/* = 2*/, const uint32_t _flushIntervalMs/* = 100*/, const bool _dropIfFull/* = false*/)
 	: m_filename(std::move(_filename))
 	, m_samplerate(_samplerate)
 	, m_measureSilence(_measureSilence)
+	, m_channelCount(_channelCount)
+	, m_bytesPerFrame(_channelCount * 3)
+	, m_flushIntervalMs(_flushIntervalMs)
+	, m_dropIfFull(_dropIfFull)
+	// enough for several flush intervals but at least two seconds, always a multiple of the frame size
+	, m_buffer(static_cast<size_t>(std::max(2000u, _flushIntervalMs * 4)) * _samplerate / 1000 * m_bytesPerFrame)
 	{
 		m_thread.reset(new std::thread([&]()
 		{
@@ -124,7 +312,11 @@ namespace synthLib
 
 	AsyncWriter::~AsyncWriter()
 	{
-		m_finished = true;
+		{
+			std::lock_guard lock(m_wakeMutex);
+			m_finished = true;
+		}
+		m_wakeCv.notify_one();
 
 		if(m_thread)
 		{
@@ -133,82 +325,168 @@ namespace synthLib
 		}
 	}
 
-	void AsyncWriter::append(const std::function<void(std::vector<dsp56k::TWord>&)>& _func)
+	bool AsyncWriter::append(const dsp56k::TWord* const* _channels, const uint32_t _sampleCount)
+	{
+		return append(_sampleCount, [&](const uint32_t _frame, const uint32_t _channel)
+		{
+			return _channels[_channel][_frame];
+		});
+	}
+
+	bool AsyncWriter::appendInterleaved(const dsp56k::TWord* _data, const uint32_t _frameCount)
+	{
+		return append(_frameCount, [&](const uint32_t _frame, const uint32_t _channel)
+		{
+			return _data[_frame * m_channelCount + _channel];
+		});
+	}
+
+	template<typename TGetWord> bool AsyncWriter::append(const uint32_t _frameCount, const TGetWord& _getWord)
+	{
+		if(!_frameCount)
+			return true;
+
+		if(m_dropIfFull && m_buffer.freeSpace() < static_cast<size_t>(_frameCount) * m_bytesPerFrame)
+		{
+			m_droppedFrames += _frameCount;
+			return false;
+		}
+
+		bool isSilence = true;
+
+		uint32_t frame = 0;
+
+		// at most two regions as the buffer wraps around, more if we have to wait for the writer. Regions are always a
+		// multiple of the frame size
+		while(frame < _frameCount)
+		{
+			uint8_t* dst;
+			const auto frames = std::min(static_cast<uint32_t>(m_buffer.writeRegion(dst) / m_bytesPerFrame), _frameCount - frame);
+
+			if(!frames)
+			{
+				// only reached in blocking mode, the block is larger than the free space in the buffer
+				if(waitForSpace())
+					continue;
+
+				m_droppedFrames += _frameCount - frame;
+				return false;
+			}
+
+			for(uint32_t f=0; f<frames; ++f, ++frame)
+			{
+				for(uint32_t c=0; c<m_channelCount; ++c)
+				{
+					const dsp56k::TWord w = _getWord(frame, c);
+
+					*dst++ = static_cast<uint8_t>(w);
+					*dst++ = static_cast<uint8_t>(w >> 8);
+					*dst++ = static_cast<uint8_t>(w >> 16);
+
+					constexpr dsp56k::TWord silenceThreshold = 0x1ff;
+					if(w >= silenceThreshold && w < (0xffffff - silenceThreshold))
+						isSilence = false;
+				}
+			}
+
+			m_buffer.commitWrite(static_cast<size_t>(frames) * m_bytesPerFrame);
+		}
+
+		if(m_measureSilence)
+			measureSilence(isSilence, _frameCount);
+
+		// wake the writer early if the producer is faster than the flush interval. Notifying does not lock the mutex
+		if(m_buffer.size() > (m_buffer.capacity() >> 1) && !m_wakeRequested.exchange(true))
+			m_wakeCv.notify_one();
+
+		return true;
+	}
+
+	void AsyncWriter::measureSilence(const bool _isSilence, const uint32_t _frameCount)
 	{
-		std::lock_guard lock(m_writeMutex);
-		_func(m_stereoOutput);
+		if(m_foundNonSilence && _isSilence)
+		{
+			m_silenceDuration += _frameCount;
+		}
+		else if(!_isSilence)
+		{
+			m_silenceDuration = 0;
+			m_foundNonSilence = true;
+		}
+	}
+
+	bool AsyncWriter::waitForSpace()
+	{
+		SYNTHLIB_TRACE_SCOPE("AsyncWriter::waitForSpace");
+
+		std::unique_lock lock(m_wakeMutex);
+
+		m_wakeRequested = true;
+		m_wakeCv.notify_one();
+
+		m_spaceCv.wait(lock, [this] { return m_writerDone || m_buffer.freeSpace() >= m_bytesPerFrame; });
+
+		return !m_writerDone;
 	}
 
 	void AsyncWriter::threadWriteFunc()
 	{
 		dsp56k::ThreadTools::setCurrentThreadName("AsyncWavWriter");
+		SYNTHLIB_TRACE_THREAD_NAME("AsyncWavWriter");
 
-		synthLib::WavWriter writer;
+		WavStreamWriter writer;
 
-		std::vector<dsp56k::TWord> m_wordBuffer;
-		std::vector<uint8_t> m_byteBuffer;
-		m_byteBuffer.reserve(m_wordBuffer.capacity() * 3);
-
-		bool foundNonSilence = false;
+		if(!writer.open(m_filename, 24, false, static_cast<int>(m_channelCount), static_cast<int>(m_samplerate)))
+			LOG("Unable to create file " << m_filename << ", audio will not be written");
 
 		while(true)
 		{
+			// read the flag before writing to not lose anything that has been appended before finishing
+			const bool finished = m_finished;
+
+			writeAvailable(writer);
+
+			// a producer waiting for space checks the buffer while holding the mutex, locking it here ensures that the
+			// notification cannot get lost
 			{
-				std::lock_guard lock(m_writeMutex);
-				std::swap(m_wordBuffer, m_stereoOutput);
+				std::lock_guard lock(m_wakeMutex);
+				m_spaceCv.notify_one();
 			}
 
-			if(m_wordBuffer.empty() && m_byteBuffer.empty() && m_finished)
+			if(finished)
 				break;
 
-			if(!m_wordBuffer.empty())
-			{
-				for (const dsp56k::TWord w : m_wordBuffer)
-					WavWriter::writeWord(m_byteBuffer, w);
+			writer.flush();
 
-				if(m_measureSilence)
-				{
-					bool isSilence = true;
-
-					for (const dsp56k::TWord w : m_wordBuffer)
-					{
-						constexpr dsp56k::TWord silenceThreshold = 0x1ff;
-						const bool silence = w < silenceThreshold || w >= (0xffffff - silenceThreshold);
-						if(!silence)
-						{
-							isSilence = false;
-							break;
-						}
-					}
-
-					if(foundNonSilence && isSilence)
-					{
-						m_silenceDuration += static_cast<uint32_t>(m_wordBuffer.size() >> 1);
-					}
-					else if(!isSilence)
-					{
-						m_silenceDuration = 0;
-						foundNonSilence = true;
-					}
-				}
+			std::unique_lock lock(m_wakeMutex);
+			m_wakeCv.wait_for(lock, std::chrono::milliseconds(m_flushIntervalMs), [this] { return m_finished || m_wakeRequested; });
+			m_wakeRequested = false;
+		}
 
-				m_wordBuffer.clear();
-			}
+		{
+			std::lock_guard lock(m_wakeMutex);
+			m_writerDone = true;
+		}
+		m_spaceCv.notify_all();
 
-			if(!m_byteBuffer.empty())
-			{
-				if(writer.write(m_filename, 24, false, 2, static_cast<int>(m_samplerate), &m_byteBuffer[0], m_byteBuffer.size()))
-				{
-					m_byteBuffer.clear();
-				}
-				else if(m_finished)
-				{
-					LOG("Unable to write data to file " << m_filename << " but termination requested, file is missing data");
-					break;
-				}
-			}
+		writer.close();
+
+		if(m_droppedFrames)
+			LOG("Writer for file " << m_filename << " could not keep up, dropped " << m_droppedFrames << " frames");
+	}
+
+	void AsyncWriter::writeAvailable(WavStreamWriter& _writer)
+	{
+		SYNTHLIB_TRACE_SCOPE("AsyncWriter::write");
+
+		const uint8_t* src;
+
+		while(const auto size = m_buffer.readRegion(src))
+		{
+			if(_writer.isOpen() && !_writer.write(src, size))
+				LOG("Failed to write " << size << " bytes to file " << m_filename);
 
-			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+			m_buffer.commitRead(size);
 		}
 	}
 }
@@ -1,9 +1,12 @@
 #pragma once
 
-#include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
 #include <memory>
 #include <mutex>
 
+#include "spscRingBuffer.h"
 #include "wavTypes.h"
 
 #include <vector>
@@ -31,13 +34,51 @@ namespace synthLib
 		size_t m_existingDataSize = 0;
 	};
 
+	// Writes a wav file incrementally. The header is written when opening and patched whenever the file is flushed or
+	// closed. A JUNK chunk reserves space for a ds64 chunk so that the file can be turned into RF64 if the audio data
+	// exceeds the 4 GiB limit of RIFF. The file is preallocated in large steps to reduce file system fragmentation
+	class WavStreamWriter
+	{
+	public:
+		WavStreamWriter() = default;
+		WavStreamWriter(const WavStreamWriter&) = delete;
+		WavStreamWriter& operator = (const WavStreamWriter&) = delete;
+		~WavStreamWriter();
+
+		bool open(const std::string& _filename, int _bitsPerSample, bool _isFloat, int _channelCount, int _samplerate, uint64_t _preallocateStep = 64 * 1024 * 1024);
+		bool write(const void* _data, size_t _size);
+		bool flush();
+		bool close();
+
+		bool isOpen() const { return m_file != nullptr; }
+		uint64_t getDataSize() const { return m_dataSize; }
+
+	private:
+		bool writeHeader();
+		bool resize(uint64_t _size) const;
+
+		FILE* m_file = nullptr;
+		std::string m_filename;
+		SWaveFormatChunkFormat m_format{};
+		uint64_t m_dataSize = 0;
+		uint64_t m_allocatedSize = 0;
+		uint64_t m_preallocateStep = 0;
+	};
+
+	// Streams audio to a wav file. The producer converts audio to 24 bit and writes it into a lock-free ring buffer,
+	// a background thread writes it to disk in large blocks every flush interval.
+	// By default, the producer waits for the writer if the ring buffer is full so that offline renders never lose audio.
+	// Realtime producers that must never block can opt in to drop audio that does not fit, dropped frames are reported
 	class AsyncWriter
 	{
 	public:
-		AsyncWriter(std::string _filename, uint32_t _samplerate, bool _measureSilence = false);
+		AsyncWriter(std::string _filename, uint32_t _samplerate, bool _measureSilence = false, uint32_t _channelCount = 2, uint32_t _flushIntervalMs = 100, bool _dropIfFull = false);
 		~AsyncWriter();
 
-		void append(const std::function<void(std::vector<dsp56k::TWord>&)>& _func);
+		// one pointer per channel. Returns false if audio has been dropped, either because the ring buffer is full in
+		// drop mode or because the writer has already finished
+		bool append(const dsp56k::TWord* const* _channels, uint32_t _sampleCount);
+		bool appendInterleaved(const dsp56k::TWord* _data, uint32_t _frameCount);
 
 		void setFinished()
 		{
@@ -54,17 +95,40 @@ namespace synthLib
 			return m_silenceDuration;
 		}
 
+		uint64_t getDroppedFrameCount() const
+		{
+			return m_droppedFrames;
+		}
+
 	private:
+		template<typename TGetWord> bool append(uint32_t _frameCount, const TGetWord& _getWord);
+		void measureSilence(bool _isSilence, uint32_t _frameCount);
+		bool waitForSpace();
 		void threadWriteFunc();
+		void writeAvailable(WavStreamWriter& _writer);
 
 		const std::string m_filename;
 		const uint32_t m_samplerate;
 		const bool m_measureSilence;
+		const uint32_t m_channelCount;
+		const uint32_t m_bytesPerFrame;
+		const uint32_t m_flushIntervalMs;
+		const bool m_dropIfFull;
+
+		SpscRingBuffer<uint8_t> m_buffer;
+
+		std::atomic<bool> m_finished{false};
+		std::atomic<uint32_t> m_silenceDuration{0};
+		std::atomic<uint64_t> m_droppedFrames{0};
+		bool m_foundNonSilence = false;
+
+		// the producer only locks the mutex if the buffer runs full and it has to wait for the writer
+		std::atomic<bool> m_wakeRequested{false};
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wakeCv;
+		std::condition_variable m_spaceCv;
+		bool m_writerDone = false;
 
-		bool m_finished = false;
 		std::unique_ptr<std::thread> m_thread;
-		uint32_t m_silenceDuration = 0;
-		std::mutex m_writeMutex;
-		std::vector<dsp56k::TWord> m_stereoOutput;
 	};
 };
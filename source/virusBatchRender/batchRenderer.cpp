@@ -0,0 +1,321 @@
+#include "batchRenderer.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "../gearmulatorBench/jsonWriter.h"
+
+#include "../synthLib/deviceException.h"
+#include "../synthLib/os.h"
+#include "../synthLib/wavWriter.h"
+
+#include "../virusLib/device.h"
+#include "../virusLib/microcontroller.h"
+
+namespace virusBatchRender
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		constexpr uint32_t g_blockSize = 512;
+		constexpr uint32_t g_channelCount = 2;
+
+		constexpr float g_silenceSeconds = 1.0f;		// longer than the gap between two delay repeats
+		constexpr float g_maxSilenceWaitSeconds = 30.0f;
+
+		double seconds(const Clock::time_point& _start)
+		{
+			return std::chrono::duration<double>(Clock::now() - _start).count();
+		}
+
+		synthLib::SMidiEvent createSingleDump(const virusLib::ROMFile::TPreset& _preset)
+		{
+			synthLib::SMidiEvent ev;
+			auto& s = ev.sysex;
+
+			s = {synthLib::M_STARTOFSYSEX, 0x00, 0x20, 0x33, 0x01, virusLib::OMNI_DEVICE_ID, virusLib::DUMP_SINGLE, virusLib::toMidiByte(virusLib::BankNumber::EditBuffer), virusLib::SINGLE};
+			s.insert(s.end(), _preset.begin(), _preset.begin() + virusLib::ROMFile::getSinglePresetSize());
+			s.push_back(virusLib::Microcontroller::calcChecksum(s, 5));
+			s.push_back(synthLib::M_ENDOFSYSEX);
+
+			return ev;
+		}
+	}
+
+	BatchRenderer::BatchRenderer(virusLib::ROMFile _rom, const NoteSpec _spec, std::string _outputFolder)
+		: m_rom(std::move(_rom))
+		, m_spec(_spec)
+		, m_outputFolder(std::move(_outputFolder))
+	{
+	}
+
+	void BatchRenderer::run(const std::vector<Job>& _jobs, uint32_t _workerCount)
+	{
+		_workerCount = std::max(1u, std::min(_workerCount, static_cast<uint32_t>(_jobs.size())));
+
+		m_results.clear();
+		m_results.resize(_jobs.size());
+		m_workers.clear();
+		m_workers.resize(_workerCount);
+		m_nextJob = 0;
+
+		const auto start = Clock::now();
+
+		std::vector<std::thread> threads;
+		threads.reserve(_workerCount);
+
+		for(uint32_t i=0; i<_workerCount; ++i)
+			threads.emplace_back([this, i, &_jobs] { workerThread(i, _jobs); });
+
+		for (auto& t : threads)
+			t.join();
+
+		m_wallSeconds = seconds(start);
+	}
+
+	void BatchRenderer::writeManifest(bench::JsonWriter& _json, const std::vector<Job>& _jobs) const
+	{
+		double audioSeconds = 0.0;
+		double renderSeconds = 0.0;
+		uint32_t failed = 0;
+
+		for (const auto& r : m_results)
+		{
+			if(m_samplerate > 0.0f)
+				audioSeconds += static_cast<double>(r.samples) / m_samplerate;
+			renderSeconds += r.renderSeconds;
+			if(!r.success)
+				++failed;
+		}
+
+		_json.beginObject();
+
+		_json.add("rom", synthLib::getFilenameWithoutPath(m_rom.getFilename()));
+		_json.add("romHash", m_rom.getHash().toString());
+		_json.add("samplerate", static_cast<double>(m_samplerate));
+
+		_json.beginObject("note");
+		_json.add("note", static_cast<uint32_t>(m_spec.note));
+		_json.add("velocity", static_cast<uint32_t>(m_spec.velocity));
+		_json.add("duration", static_cast<double>(m_spec.duration));
+		_json.add("tail", static_cast<double>(m_spec.tail));
+		_json.endObject();
+
+		_json.beginObject("timing");
+		_json.add("wallSeconds", m_wallSeconds);
+		_json.add("audioSeconds", audioSeconds);
+		_json.add("renderSeconds", renderSeconds);
+		_json.add("realtimeFactor", m_wallSeconds > 0.0 ? audioSeconds / m_wallSeconds : 0.0);
+		_json.add("presetsPerSecond", m_wallSeconds > 0.0 ? static_cast<double>(m_results.size()) / m_wallSeconds : 0.0);
+		_json.endObject();
+
+		_json.beginArray("workers");
+		for (const auto& w : m_workers)
+		{
+			_json.beginObject();
+			_json.add("valid", w.valid);
+			_json.add("bootSeconds", w.bootSeconds);
+			_json.add("jobs", w.jobs);
+			_json.endObject();
+		}
+		_json.endArray();
+
+		_json.add("failed", failed);
+
+		_json.beginArray("presets");
+		for(size_t i=0; i<_jobs.size(); ++i)
+		{
+			const auto& j = _jobs[i];
+			const auto& r = m_results[i];
+
+			const auto audio = m_samplerate > 0.0f ? static_cast<double>(r.samples) / m_samplerate : 0.0;
+
+			_json.beginObject();
+			_json.add("bank", j.bank);
+			_json.add("program", j.program);
+			_json.add("name", j.name);
+			_json.add("success", r.success);
+			_json.add("file", r.filename);
+			_json.add("worker", r.worker);
+			_json.add("renderSeconds", r.renderSeconds);
+			_json.add("realtimeFactor", r.renderSeconds > 0.0 ? audio / r.renderSeconds : 0.0);
+			_json.add("peak", static_cast<double>(r.peak));
+			_json.endObject();
+		}
+		_json.endArray();
+
+		_json.endObject();
+	}
+
+	std::string BatchRenderer::createFilename(const Job& _job)
+	{
+		std::string name;
+
+		for (const char c : _job.name)
+			name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+
+		while(!name.empty() && name.back() == '_')
+			name.pop_back();
+
+		char prefix[16];
+		snprintf(prefix, sizeof(prefix), "%c%03u_", static_cast<char>('A' + _job.bank), _job.program);
+
+		return prefix + name + ".wav";
+	}
+
+	void BatchRenderer::workerThread(const uint32_t _index, const std::vector<Job>& _jobs)
+	{
+		auto& stats = m_workers[_index];
+
+		const auto bootStart = Clock::now();
+
+		std::unique_ptr<virusLib::Device> device;
+
+		try
+		{
+			device.reset(new virusLib::Device(m_rom, 0.0f, static_cast<float>(m_rom.getSamplerate())));
+		}
+		catch(const synthLib::DeviceException& _e)
+		{
+			log("Worker " + std::to_string(_index) + " failed to boot device: " + _e.what());
+			return;
+		}
+
+		stats.bootSeconds = seconds(bootStart);
+		stats.valid = true;
+
+		const auto samplerate = device->getSamplerate();
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_samplerate = samplerate;
+		}
+
+		std::vector<float> inputBuffer(g_blockSize, 0.0f);
+		std::array<std::vector<float>, std::tuple_size_v<synthLib::TAudioOutputs>> outputBuffers;
+
+		synthLib::TAudioInputs inputs{};
+		synthLib::TAudioOutputs outputs{};
+
+		for (auto& input : inputs)
+			input = inputBuffer.data();
+
+		for(uint32_t i=0; i<std::min<uint32_t>(device->getChannelCountOut(), static_cast<uint32_t>(outputs.size())); ++i)
+		{
+			outputBuffers[i].resize(g_blockSize);
+			outputs[i] = outputBuffers[i].data();
+		}
+
+		std::vector<float> interleaved(static_cast<size_t>(g_blockSize) * g_channelCount);
+		std::vector<synthLib::SMidiEvent> midiIn;
+		std::vector<synthLib::SMidiEvent> midiOut;
+
+		const auto prerollSamples = static_cast<uint64_t>(m_spec.preroll * samplerate);
+		const auto silenceSamples = static_cast<uint32_t>(g_silenceSeconds * samplerate);
+		const auto maxSilenceWaitSamples = static_cast<uint32_t>(g_maxSilenceWaitSeconds * samplerate);
+		const auto noteOffSample = static_cast<uint64_t>(m_spec.duration * samplerate);
+		const auto totalSamples = noteOffSample + static_cast<uint64_t>(m_spec.tail * samplerate);
+
+		while(true)
+		{
+			const auto jobIndex = m_nextJob.fetch_add(1);
+
+			if(jobIndex >= _jobs.size())
+				break;
+
+			const auto& job = _jobs[jobIndex];
+			auto& result = m_results[jobIndex];
+
+			result.worker = _index;
+			result.filename = createFilename(job);
+
+			synthLib::WavStreamWriter writer;
+
+			if(!writer.open(m_outputFolder + result.filename, 32, true, g_channelCount, static_cast<int>(std::lround(samplerate))))
+			{
+				log("Failed to create " + m_outputFolder + result.filename);
+				continue;
+			}
+
+			const auto start = Clock::now();
+
+			// stop the previous note and load the preset into the edit buffer, the device needs some time to apply it
+			midiIn.clear();
+			midiIn.emplace_back(synthLib::M_CONTROLCHANGE, synthLib::MC_ALLNOTESOFF, 0);
+			midiIn.push_back(createSingleDump(job.preset));
+
+			for(uint64_t pos = 0; pos < prerollSamples; pos += g_blockSize)
+			{
+				midiOut.clear();
+				device->process(inputs, outputs, static_cast<size_t>(std::min<uint64_t>(g_blockSize, prerollSamples - pos)), midiIn, midiOut);
+				midiIn.clear();
+			}
+
+			// let the tail of the previous preset decay so that it does not end up in this file
+			if(!device->processUntilSilent(silenceSamples, maxSilenceWaitSamples))
+				log("Output did not become silent before rendering " + result.filename);
+
+			bool writeError = false;
+
+			for(uint64_t pos = 0; pos < totalSamples; pos += g_blockSize)
+			{
+				const auto count = static_cast<uint32_t>(std::min<uint64_t>(g_blockSize, totalSamples - pos));
+
+				midiIn.clear();
+				midiOut.clear();
+
+				if(pos == 0)
+					midiIn.emplace_back(synthLib::M_NOTEON, m_spec.note, m_spec.velocity, 0);
+
+				if(noteOffSample >= pos && noteOffSample < pos + count)
+					midiIn.emplace_back(synthLib::M_NOTEOFF, m_spec.note, 0, static_cast<uint32_t>(noteOffSample - pos));
+
+				device->process(inputs, outputs, count, midiIn, midiOut);
+
+				auto* dst = interleaved.data();
+
+				for(uint32_t i=0; i<count; ++i)
+				{
+					for(uint32_t c=0; c<g_channelCount; ++c)
+					{
+						const auto v = outputs[c][i];
+						result.peak = std::max(result.peak, std::fabs(v));
+						*dst++ = v;
+					}
+				}
+
+				if(!writer.write(interleaved.data(), static_cast<size_t>(count) * g_channelCount * sizeof(float)))
+				{
+					writeError = true;
+					break;
+				}
+
+				result.samples += count;
+			}
+
+			result.renderSeconds = seconds(start);
+			result.success = writer.close() && !writeError;
+
+			++stats.jobs;
+
+			if(!result.success)
+				log("Failed to write " + m_outputFolder + result.filename);
+			else
+				log("[" + std::to_string(jobIndex + 1) + "/" + std::to_string(_jobs.size()) + "] " + result.filename);
+		}
+	}
+
+	void BatchRenderer::log(const std::string& _message)
+	{
+		std::lock_guard lock(m_mutex);
+		std::cout << _message << std::endl;
+	}
+}
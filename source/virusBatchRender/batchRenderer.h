@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../virusLib/romfile.h"
+
+namespace bench
+{
+	class JsonWriter;
+}
+
+namespace virusBatchRender
+{
+	struct NoteSpec
+	{
+		uint8_t note = 60;
+		uint8_t velocity = 100;
+		float duration = 2.0f;		// seconds until the note off is sent
+		float tail = 2.0f;			// seconds that are rendered after the note off
+		float preroll = 0.25f;		// seconds between sending the preset and the note on, not written
+	};
+
+	struct Job
+	{
+		uint32_t bank = 0;
+		uint32_t program = 0;
+		std::string name;
+		virusLib::ROMFile::TPreset preset{};
+	};
+
+	struct JobResult
+	{
+		std::string filename;
+		uint32_t worker = 0;
+		uint64_t samples = 0;
+		double renderSeconds = 0.0;
+		float peak = 0.0f;
+		bool success = false;
+	};
+
+	// Renders presets on a pool of devices, one per worker thread. Each worker boots its device once and then renders
+	// the presets it takes from a shared queue. After loading a preset, the device renders silence until the tail of
+	// the previous one has decayed, so no audio of another preset ends up in its file. The device is not reset between
+	// presets though, the state that is carried over is limited to free running modulation such as LFOs, which means
+	// that the output depends on the order
+	class BatchRenderer
+	{
+	public:
+		struct WorkerStats
+		{
+			double bootSeconds = 0.0;
+			uint32_t jobs = 0;
+			bool valid = false;
+		};
+
+		BatchRenderer(virusLib::ROMFile _rom, NoteSpec _spec, std::string _outputFolder);
+
+		void run(const std::vector<Job>& _jobs, uint32_t _workerCount);
+
+		const std::vector<JobResult>& getResults() const { return m_results; }
+		const std::vector<WorkerStats>& getWorkerStats() const { return m_workers; }
+		double getWallSeconds() const { return m_wallSeconds; }
+		float getSamplerate() const { return m_samplerate; }
+
+		void writeManifest(bench::JsonWriter& _json, const std::vector<Job>& _jobs) const;
+
+		static std::string createFilename(const Job& _job);
+
+	private:
+		void workerThread(uint32_t _index, const std::vector<Job>& _jobs);
+		void log(const std::string& _message);
+
+		const virusLib::ROMFile m_rom;
+		const NoteSpec m_spec;
+		const std::string m_outputFolder;
+
+		std::vector<JobResult> m_results;
+		std::vector<WorkerStats> m_workers;
+		double m_wallSeconds = 0.0;
+		float m_samplerate = 0.0f;
+
+		std::atomic<size_t> m_nextJob{0};
+		std::mutex m_mutex;
+	};
+}
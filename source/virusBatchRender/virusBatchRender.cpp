@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+#include "batchRenderer.h"
+
+#include "../gearmulatorBench/jsonWriter.h"
+
+#include "../synthLib/os.h"
+
+#include "../virusLib/romloader.h"
+
+#include "../dsp56300/source/disassemble/commandline.h"
+
+namespace
+{
+	void printUsage()
+	{
+		std::cout << "Usage: virusBatchRender [-rom file] [-presets list.txt] [-out folder] [-jobs n] [-note n] [-velocity n] [-duration seconds] [-tail seconds] [-json manifest.json]" << std::endl;
+		std::cout << "Renders one note per preset to one wav file per preset, using one device per job." << std::endl;
+		std::cout << "The preset list contains one preset per line, either by name or by number (bank * 128 + program)." << std::endl;
+		std::cout << "Without a preset list, all singles of the ROM are rendered." << std::endl;
+	}
+
+	std::vector<virusBatchRender::Job> getAllSingles(const virusLib::ROMFile& _rom)
+	{
+		std::vector<virusBatchRender::Job> jobs;
+
+		for(uint32_t b=0; b<26; ++b)
+		{
+			for(uint32_t p=0; p<_rom.getPresetsPerBank(); ++p)
+			{
+				virusBatchRender::Job job;
+
+				if(!_rom.getSingle(static_cast<int>(b), static_cast<int>(p), job.preset))
+					return jobs;
+
+				job.name = virusLib::ROMFile::getSingleName(job.preset);
+
+				if(job.name.empty())
+					return jobs;
+
+				job.bank = b;
+				job.program = p;
+
+				jobs.push_back(job);
+			}
+		}
+		return jobs;
+	}
+
+	bool readPresetList(std::vector<virusBatchRender::Job>& _jobs, const std::string& _filename, const std::vector<virusBatchRender::Job>& _singles, const uint32_t _presetsPerBank)
+	{
+		std::ifstream file(_filename);
+
+		if(!file.is_open())
+		{
+			std::cout << "Failed to open preset list " << _filename << std::endl;
+			return false;
+		}
+
+		std::map<std::string, size_t> byName;
+		for(size_t i=0; i<_singles.size(); ++i)
+			byName.insert({_singles[i].name, i});
+
+		std::string line;
+
+		while(std::getline(file, line))
+		{
+			while(!line.empty() && (line.back() == '\r' || line.back() == ' '))
+				line.pop_back();
+
+			if(line.empty() || line.front() == '#')
+				continue;
+
+			const auto isNumber = line.find_first_not_of("0123456789") == std::string::npos;
+
+			if(isNumber)
+			{
+				const auto index = std::stoul(line);
+				const auto it = std::find_if(_singles.begin(), _singles.end(), [&](const virusBatchRender::Job& _j)
+				{
+					return _j.bank * _presetsPerBank + _j.program == index;
+				});
+
+				if(it != _singles.end())
+				{
+					_jobs.push_back(*it);
+					continue;
+				}
+			}
+			else
+			{
+				const auto it = byName.find(line);
+
+				if(it != byName.end())
+				{
+					_jobs.push_back(_singles[it->second]);
+					continue;
+				}
+			}
+
+			std::cout << "Preset '" << line << "' not found in ROM" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	try
+	{
+		const CommandLine cmd(_argc, _argv);
+
+		if(cmd.contains("help"))
+		{
+			printUsage();
+			return 0;
+		}
+
+		const auto rom = cmd.contains("rom") ? virusLib::ROMLoader::findROM(cmd.get("rom")) : virusLib::ROMLoader::findROM();
+
+		if(!rom.isValid())
+		{
+			std::cout << "Failed to find a valid ROM" << std::endl;
+			return -1;
+		}
+
+		const auto singles = getAllSingles(rom);
+
+		std::vector<virusBatchRender::Job> jobs;
+
+		if(cmd.contains("presets"))
+		{
+			if(!readPresetList(jobs, cmd.get("presets"), singles, rom.getPresetsPerBank()))
+				return -1;
+		}
+		else
+		{
+			jobs = singles;
+		}
+
+		if(jobs.empty())
+		{
+			std::cout << "No presets to render" << std::endl;
+			return -1;
+		}
+
+		virusBatchRender::NoteSpec spec;
+
+		if(cmd.contains("note"))		spec.note = static_cast<uint8_t>(std::clamp(cmd.getInt("note"), 0, 127));
+		if(cmd.contains("velocity"))	spec.velocity = static_cast<uint8_t>(std::clamp(cmd.getInt("velocity"), 1, 127));
+		if(cmd.contains("duration"))	spec.duration = std::max(0.0f, cmd.getFloat("duration"));
+		if(cmd.contains("tail"))		spec.tail = std::max(0.0f, cmd.getFloat("tail"));
+
+		auto outputFolder = cmd.contains("out") ? cmd.get("out") : std::string("batchRender");
+		if(!outputFolder.empty() && outputFolder.back() != '/' && outputFolder.back() != '\\')
+			outputFolder += '/';
+
+		synthLib::createDirectory(outputFolder);
+
+		if(!synthLib::isDirectory(outputFolder))
+		{
+			std::cout << "Failed to create output folder " << outputFolder << std::endl;
+			return -1;
+		}
+
+		const auto hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		const auto workerCount = cmd.contains("jobs") ? static_cast<uint32_t>(std::max(1, cmd.getInt("jobs"))) : hardwareThreads;
+
+		std::cout << "Rendering " << jobs.size() << " presets of ROM " << rom.getFilename() << " with " << std::min<size_t>(workerCount, jobs.size()) << " workers" << std::endl;
+
+		virusBatchRender::BatchRenderer renderer(rom, spec, outputFolder);
+		renderer.run(jobs, workerCount);
+
+		const auto manifestFile = cmd.contains("json") ? cmd.get("json") : outputFolder + "manifest.json";
+
+		std::ofstream manifest(manifestFile);
+		if(!manifest.is_open())
+		{
+			std::cout << "Failed to create manifest " << manifestFile << std::endl;
+			return -1;
+		}
+
+		{
+			bench::JsonWriter json(manifest);
+			renderer.writeManifest(json, jobs);
+		}
+
+		manifest << std::endl;
+
+		uint32_t failed = 0;
+		for (const auto& r : renderer.getResults())
+		{
+			if(!r.success)
+				++failed;
+		}
+
+		std::cout << "Rendered " << (jobs.size() - failed) << " presets in " << renderer.getWallSeconds() << " seconds, manifest written to " << manifestFile << std::endl;
+
+		if(failed)
+		{
+			std::cout << failed << " presets failed to render" << std::endl;
+			return -1;
+		}
+
+		return 0;
+	}
+	catch(const std::exception& _e)
+	{
+		std::cout << _e.what() << std::endl;
+		return -1;
+	}
+}
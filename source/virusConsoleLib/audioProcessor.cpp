@@ -1,58 +1,149 @@
 #include "audioProcessor.h"
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "esaiListenerToFile.h"
+#include "dsp56kEmu/logging.h"
 #include "dsp56kEmu/types.h"
 
 #include "../synthLib/wavWriter.h"
 
 #include "../virusLib/dspSingle.h"
 
-AudioProcessor::AudioProcessor(uint32_t _samplerate, std::string _outputFilename, bool _terminateOnSilence, uint32_t _maxSamplecount, virusLib::DspSingle* _dsp1, virusLib::DspSingle* _dsp2)
+AudioProcessor::AudioProcessor(uint32_t _samplerate, std::string _outputFilename, bool _terminateOnSilence, uint32_t _maxSamplecount, virusLib::DspSingle* _dsp1, virusLib::DspSingle* _dsp2, const AudioCaptureConfig& _captureConfig/* = {}*/)
 : m_samplerate(_samplerate)
 , m_outputFilname(std::move(_outputFilename))
 , m_terminateOnSilence(_terminateOnSilence)
 , m_maxSampleCount(_maxSamplecount)
 , m_dsp1(_dsp1)
 , m_dsp2(_dsp2)
-, m_writer(m_outputFilname, _samplerate, _terminateOnSilence)
 {
-	m_outputBuffers.resize(2);
+	m_outputBuffers.resize(OutputCount);
 	m_inputBuffers.resize(2);
+
+	createWriters(_captureConfig);
 }
 
 AudioProcessor::~AudioProcessor() = default;
 
+std::string AudioProcessor::getStemFilename(const std::string& _filename, const uint32_t _stereoPair)
+{
+	const auto suffix = "_out" + std::to_string(_stereoPair + 1);
+
+	const auto pos = _filename.find_last_of('.');
+	const auto slash = _filename.find_last_of("/\\");
+
+	if(pos == std::string::npos || (slash != std::string::npos && pos < slash))
+		return _filename + suffix;
+
+	return _filename.substr(0, pos) + suffix + _filename.substr(pos);
+}
+
+void AudioProcessor::createWriters(const AudioCaptureConfig& _config)
+{
+	// group outputs either into one file or into one file per stereo pair
+	std::vector<std::vector<uint32_t>> groups;
+
+	for(uint32_t i=0; i<OutputCount; ++i)
+	{
+		if(!(_config.outputMask & (1<<i)))
+			continue;
+
+		const auto group = _config.multichannel ? 0 : i>>1;
+
+		if(groups.size() <= group)
+			groups.resize(group + 1);
+
+		groups[group].push_back(i);
+	}
+
+	size_t groupCount = 0;
+	for (const auto& group : groups)
+		groupCount += group.empty() ? 0 : 1;
+
+	for(size_t g=0; g<groups.size(); ++g)
+	{
+		if(groups[g].empty())
+			continue;
+
+		// the regular stereo output keeps the plain file name
+		const auto filename = groupCount == 1 ? m_outputFilname : getStemFilename(m_outputFilname, static_cast<uint32_t>(g));
+
+		auto& w = m_writers.emplace_back();
+		w.outputs = groups[g];
+		w.channels.resize(w.outputs.size(), nullptr);
+		w.writer.reset(new synthLib::AsyncWriter(filename, m_samplerate, m_terminateOnSilence, static_cast<uint32_t>(w.outputs.size())));
+
+		m_outputFilenames.push_back(filename);
+	}
+}
+
+uint32_t AudioProcessor::getSilenceDuration() const
+{
+	// audio is only considered silent if all outputs are silent
+	uint32_t duration = std::numeric_limits<uint32_t>::max();
+
+	for (const auto& w : m_writers)
+		duration = std::min(duration, w.writer->getSilenceDuration());
+
+	return m_writers.empty() ? 0 : duration;
+}
+
+void AudioProcessor::setFinished()
+{
+	m_finished = true;
+
+	for (const auto& w : m_writers)
+		w.writer->setFinished();
+}
+
 void AudioProcessor::processBlock(const uint32_t _blockSize)
 {
-	if(m_outputBuffers[0].size() < _blockSize)
+	if(m_inputBuffers[0].size() < _blockSize)
 	{
-		for(size_t i=0; i<m_outputBuffers.size(); ++i)
+		for(size_t i=0; i<m_inputBuffers.size(); ++i)
 		{
-			m_outputBuffers[i].resize(_blockSize);
 			m_inputBuffers[i].resize(_blockSize);
-
 			m_inputs[i] = m_inputBuffers[i].data();
-			m_outputs[i] = m_outputBuffers[i].data();
 		}
 
-		m_stereoOutput.reserve(m_outputBuffers.size() * 2);
+		// Outputs that are not captured are left as nullptr, the DSP writes them to a dummy buffer
+		for (auto& w : m_writers)
+		{
+			for(size_t c=0; c<w.outputs.size(); ++c)
+			{
+				const auto o = w.outputs[c];
+				m_outputBuffers[o].resize(_blockSize);
+				m_outputs[o] = m_outputBuffers[o].data();
+				w.channels[c] = m_outputs[o];
+			}
+		}
+	}
+
+	if(m_fastForwardSampleCount)
+	{
+		// all outputs are null, the DSP writes them to a dummy buffer
+		const auto count = std::min(m_fastForwardSampleCount, static_cast<uint32_t>(m_inputBuffers[0].size()));
+		m_dsp1->processAudio(m_inputs, synthLib::TAudioOutputsInt{}, count, _blockSize);
+		m_fastForwardSampleCount -= count;
+		return;
 	}
 
 	const bool terminateOnSilence = m_terminateOnSilence;
 
 	auto sampleCount = static_cast<uint32_t>(m_inputBuffers[0].size());
 
-	if(terminateOnSilence && m_writer.getSilenceDuration() >= m_samplerate * 5)
+	if(terminateOnSilence && getSilenceDuration() >= m_samplerate * 5)
 	{
-		m_writer.setFinished();
+		setFinished();
 		return;
 	}
 
 	if(m_maxSampleCount && m_processedSampleCount >= m_maxSampleCount)
 	{
-		m_writer.setFinished();
+		setFinished();
 		return;
 	}
 
@@ -73,19 +164,17 @@ void AudioProcessor::processBlock(const uint32_t _blockSize)
 
 	m_processedSampleCount += sampleCount;
 
+	for(size_t i=0; i<m_writers.size(); ++i)
 	{
-		m_writer.append([&](std::vector<dsp56k::TWord>& _dst)
+		// writers block until there is space, append only fails if audio has been lost
+		if(!m_writers[i].writer->append(m_writers[i].channels.data(), sampleCount))
 		{
-			_dst.reserve(m_stereoOutput.size() + sampleCount * 2);
-
-			for(size_t iSrc=0; iSrc<sampleCount; ++iSrc)
-			{
-				_dst.push_back(m_outputs[0][iSrc]);
-				_dst.push_back(m_outputs[1][iSrc]);
-			}
-		});
+			LOG("Failed to write audio to file " << m_outputFilenames[i] << ", stopping");
+			setFinished();
+			return;
+		}
 	}
 
 	if(m_maxSampleCount && m_processedSampleCount >= m_maxSampleCount)
-		m_writer.setFinished();
+		setFinished();
 }
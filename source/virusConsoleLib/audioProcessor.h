@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,17 +15,45 @@ namespace virusLib
 	class DspSingle;
 }
 
+// Selects which DSP outputs are captured. The DSP always computes all outputs, capturing more of them has no DSP cost
+struct AudioCaptureConfig
+{
+	uint8_t outputMask = 0x03;	// one bit per output, outputs 0/1 are the main stereo output
+	bool multichannel = false;	// true: all captured outputs go to one file, false: one stem file per stereo pair
+};
+
 class AudioProcessor
 {
 public:
-	AudioProcessor(uint32_t _samplerate, std::string _outputFilename, bool _terminateOnSilence, uint32_t _maxSamplecount, virusLib::DspSingle* _dsp1, virusLib::DspSingle* _dsp2);
+	static constexpr uint32_t OutputCount = 6;
+
+	AudioProcessor(uint32_t _samplerate, std::string _outputFilename, bool _terminateOnSilence, uint32_t _maxSamplecount, virusLib::DspSingle* _dsp1, virusLib::DspSingle* _dsp2, const AudioCaptureConfig& _captureConfig = {});
 	~AudioProcessor();
 
 	void processBlock(uint32_t _blockSize);
 
-	bool finished() const { return m_writer.isFinished(); }
+	// The given number of samples is processed by the DSP before any output is captured. These samples are neither
+	// converted nor written and do not count towards the max sample count
+	void setFastForward(const uint32_t _sampleCount) { m_fastForwardSampleCount = _sampleCount; }
+
+	bool finished() const { return m_finished; }
+
+	const std::vector<std::string>& getOutputFilenames() const { return m_outputFilenames; }
+
+	static std::string getStemFilename(const std::string& _filename, uint32_t _stereoPair);
 
 private:
+	struct Writer
+	{
+		std::unique_ptr<synthLib::AsyncWriter> writer;
+		std::vector<uint32_t> outputs;
+		std::vector<const dsp56k::TWord*> channels;
+	};
+
+	void createWriters(const AudioCaptureConfig& _config);
+	uint32_t getSilenceDuration() const;
+	void setFinished();
+
 	// constant data
 	const uint32_t m_samplerate;
 	const std::string m_outputFilname;
@@ -39,9 +68,11 @@ private:
 
 	std::vector<std::vector<dsp56k::TWord>> m_outputBuffers;
 	std::vector<std::vector<dsp56k::TWord>> m_inputBuffers;
-	std::vector<dsp56k::TWord> m_stereoOutput;
 
 	uint32_t m_processedSampleCount = 0;
+	uint32_t m_fastForwardSampleCount = 0;
+	bool m_finished = false;
 
-	synthLib::AsyncWriter m_writer;
+	std::vector<Writer> m_writers;
+	std::vector<std::string> m_outputFilenames;
 };
@@ -1,5 +1,6 @@
 #include "consoleApp.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "audioProcessor.h"
@@ -8,6 +9,11 @@
 #include "../virusLib/device.h"
 #include "../virusLib/romloader.h"
 
+#include "../synthLib/deviceException.h"
+#include "../synthLib/midiFileRenderer.h"
+#include "../synthLib/perfCounters.h"
+#include "../synthLib/renderCache.h"
+
 #include "dsp56kEmu/dsp.h"
 
 namespace virusLib
@@ -20,6 +26,12 @@ using namespace synthLib;
 
 class EsaiListener;
 
+namespace
+{
+	// the ESAI callback is invoked once per sample, audioCallback() and with it the demo playback every fourth time
+	constexpr uint32_t g_samplesPerAudioCallback = 4;
+}
+
 ConsoleApp::ConsoleApp(const std::string& _romFile)
 : m_romName(_romFile)
 , m_rom(ROMLoader::findROM(_romFile))
@@ -185,6 +197,10 @@ void ConsoleApp::audioCallback(const uint32_t _audioCallbackCount)
 			LOG("Sending Preset");
 			m_uc->writeSingle(BankNumber::EditBuffer, virusLib::SINGLE, m_preset);
 		}
+		else if(m_demoSeekTicks)
+		{
+			m_demo->seek(m_demoSeekTicks);
+		}
 		break;
 	case 512:
 		if(!m_demo)
@@ -200,6 +216,21 @@ void ConsoleApp::audioCallback(const uint32_t _audioCallbackCount)
 		m_demo->process(1);
 }
 
+void ConsoleApp::setOutputCapture(const uint8_t _outputMask, const bool _multichannel)
+{
+	m_captureConfig.outputMask = _outputMask;
+	m_captureConfig.multichannel = _multichannel;
+}
+
+void ConsoleApp::setDemoStart(const float _seekSeconds, const float _fastForwardSeconds)
+{
+	const auto samplerate = static_cast<float>(m_rom.getSamplerate());
+
+	// the demo advances by one tick per audioCallback(), not per sample
+	m_demoSeekTicks = static_cast<uint32_t>(std::max(0.0f, _seekSeconds) * samplerate / static_cast<float>(g_samplesPerAudioCallback));
+	m_fastForwardSamples = static_cast<uint32_t>(std::max(0.0f, _fastForwardSeconds) * samplerate);
+}
+
 void ConsoleApp::run(const std::string& _audioOutputFilename, uint32_t _maxSampleCount/* = 0*/, bool _createDebugger/* = false*/, bool _dumpAssembler/* = false*/)
 {
 	assert(!_audioOutputFilename.empty());
@@ -234,8 +265,8 @@ void ConsoleApp::run(const std::string& _audioOutputFilename, uint32_t _maxSampl
 		}
 
 		callbackCount++;
-		if((callbackCount & 0x3) == 0)
-			audioCallback(callbackCount>>2);
+		if((callbackCount % g_samplesPerAudioCallback) == 0)
+			audioCallback(callbackCount / g_samplesPerAudioCallback);
 	}, 0);
 
 	bootDSP(_createDebugger);
@@ -253,7 +284,8 @@ void ConsoleApp::run(const std::string& _audioOutputFilename, uint32_t _maxSampl
 
 	std::vector<synthLib::SMidiEvent> midiEvents;
 
-	AudioProcessor proc(m_rom.getSamplerate(), _audioOutputFilename, m_demo != nullptr, _maxSampleCount, m_dsp1.get(), m_dsp2);
+	AudioProcessor proc(m_rom.getSamplerate(), _audioOutputFilename, m_demo != nullptr, _maxSampleCount, m_dsp1.get(), m_dsp2, m_captureConfig);
+	proc.setFastForward(m_fastForwardSamples);
 
 	while(!proc.finished())
 	{
@@ -264,4 +296,70 @@ void ConsoleApp::run(const std::string& _audioOutputFilename, uint32_t _maxSampl
 	}
 
 	esai.setCallback(nullptr,0);
+
+	if constexpr (synthLib::PerfCounters::Enabled)
+	{
+		synthLib::PerfCounterSnapshot perf;
+		synthLib::PerfCounters::getSnapshot(perf);
+		std::cout << "Performance counters:" << std::endl << perf.toString();
+	}
+}
+
+bool ConsoleApp::renderMidiFile(const std::string& _midiFilename, const std::string& _audioOutputFilename, const synthLib::RenderCache* _cache/* = nullptr*/) const
+{
+	MidiFileRenderer renderer;
+
+	if(!renderer.load(_midiFilename))
+		return false;
+
+	std::unique_ptr<virusLib::Device> device;
+
+	try
+	{
+		device.reset(new virusLib::Device(m_rom, 0.0f, m_rom.getSamplerate()));
+	}
+	catch(const DeviceException& e)
+	{
+		std::cout << "Failed to create device: " << e.what() << std::endl;
+		return false;
+	}
+
+	MidiFileRenderer::Config config;
+
+	if(renderer.getChannelMask() & ~1u)
+	{
+		std::cout << "MIDI file uses multiple channels, switching to Multi mode" << std::endl;
+
+		SMidiEvent& ev = config.setupEvents.emplace_back();
+		ev.sysex = {M_STARTOFSYSEX, 0x00, 0x20, 0x33, 0x01, OMNI_DEVICE_ID, PAGE_C, 0x00, PLAY_MODE, PlayModeMulti, M_ENDOFSYSEX};
+	}
+
+	if(_cache)
+	{
+		const auto hash = m_rom.getHash().toString();
+		config.cache = _cache;
+		config.cacheKey.assign(hash.begin(), hash.end());
+	}
+
+	std::cout << "Rendering " << renderer.getDuration() << " seconds of MIDI file " << _midiFilename << " to " << _audioOutputFilename << std::endl;
+
+	MidiFileRenderer::Stats stats;
+
+	if(!renderer.render(*device, _audioOutputFilename, config, &stats))
+		return false;
+
+	const auto seconds = static_cast<double>(stats.samples) / device->getSamplerate();
+
+	if(stats.cached)
+	{
+		std::cout << "Served " << seconds << " seconds from render cache " << _cache->getFolder() << std::endl;
+		return true;
+	}
+
+	std::cout << "Rendered " << seconds << " seconds in " << stats.renderSeconds << " seconds";
+	if(stats.renderSeconds > 0.0)
+		std::cout << ", " << (seconds / stats.renderSeconds) << "x realtime";
+	std::cout << std::endl;
+
+	return true;
 }
@@ -6,6 +6,13 @@
 #include "../virusLib/demoplayback.h"
 #include "../virusLib/dspSingle.h"
 
+#include "audioProcessor.h"
+
+namespace synthLib
+{
+	class RenderCache;
+}
+
 class ConsoleApp
 {
 public:
@@ -25,8 +32,21 @@ public:
 
 	static void waitReturn();
 
+	// Selects the DSP outputs that are written by run(), see AudioCaptureConfig
+	void setOutputCapture(uint8_t _outputMask, bool _multichannel);
+
+	// Starts demo playback at the given position instead of its beginning, see DemoPlayback::seek. The first
+	// _fastForwardSeconds of the output are rendered but not written to give the DSP time to process the presets
+	// that are replayed by the seek
+	void setDemoStart(float _seekSeconds, float _fastForwardSeconds);
+
 	void run(const std::string& _audioOutputFilename, uint32_t _maxSampleCount = 0, bool _createDebugger = false, bool _dumpAssembler = false);
 
+	// Renders a Standard MIDI File faster than realtime via a Device. Multi mode is selected if the file uses more than
+	// one MIDI channel, sysex in the file can be used to set up the device
+	// If a render cache is given, a file that has been rendered before with the same ROM is served from the cache
+	bool renderMidiFile(const std::string& _midiFilename, const std::string& _audioOutputFilename, const synthLib::RenderCache* _cache = nullptr) const;
+
 	const virusLib::ROMFile& getRom() const { return m_rom; }
 
 private:
@@ -43,4 +63,9 @@ private:
 	std::unique_ptr<virusLib::DemoPlayback> m_demo;
 
 	virusLib::Microcontroller::TPreset m_preset;
+
+	AudioCaptureConfig m_captureConfig;
+
+	uint32_t m_demoSeekTicks = 0;
+	uint32_t m_fastForwardSamples = 0;
 };
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <vector>
+
+#include "../virusLib/demoplayback.h"
+#include "../virusLib/dspSingle.h"
+#include "../virusLib/microcontroller.h"
+#include "../virusLib/romfile.h"
+
+namespace
+{
+	struct TestEvent
+	{
+		uint8_t delay;		// until the next event, scaled by the time scale
+		bool isState;
+		uint64_t key;
+	};
+
+	// Replaces the events of a song by synthetic ones and records which of them are sent to the device. The
+	// microcontroller is not backed by a ROM, switching to multi mode when playback starts does nothing
+	class TestPlayback : public virusLib::DemoPlayback
+	{
+	public:
+		TestPlayback(virusLib::Microcontroller& _mc, std::vector<TestEvent> _events) : DemoPlayback(_mc), m_events(std::move(_events))
+		{
+		}
+
+		const std::vector<size_t>& getProcessed() const { return m_processed; }
+
+	private:
+		size_t getEventCount() const override								{ return m_events.size(); }
+		uint32_t getEventDelay(const size_t _index) const override			{ return m_events[_index].delay; }
+		bool processEvent(const size_t _index) override						{ m_processed.push_back(_index); return true; }
+
+		bool isStateEvent(const size_t _index, uint64_t& _key) const override
+		{
+			_key = m_events[_index].key;
+			return m_events[_index].isState;
+		}
+
+		const std::vector<TestEvent> m_events;
+		std::vector<size_t> m_processed;
+	};
+
+	bool check(const bool _condition, const std::string& _what)
+	{
+		if(!_condition)
+			std::cout << "FAILED: " << _what << std::endl;
+		return _condition;
+	}
+
+	bool testSeekToHalf()
+	{
+		const auto rom = virusLib::ROMFile::invalid();
+
+		virusLib::DspSingle dsp(0x040000, false);
+		virusLib::Microcontroller mc(dsp, rom, false);
+
+		// with the default time scale of 54, the events are at ticks 0, 162, 216, 324 and 540
+		TestPlayback playback(mc, {
+			{3, true, 1},		// preset, superseded by event 2
+			{1, false, 0},		// note, skipped
+			{2, true, 1},		// preset
+			{4, true, 2},		// first event after the seek target
+			{0, true, 3}
+		});
+
+		const auto length = playback.getLength();
+		const auto target = length / 2;
+
+		bool ok = check(length == 540, "song length is " + std::to_string(length) + " ticks, expected 540");
+
+		ok &= check(playback.seek(target), "seek to tick " + std::to_string(target) + " failed");
+		ok &= check(playback.getPosition() == target, "position after seek is " + std::to_string(playback.getPosition()));
+		ok &= check(playback.getProcessed() == std::vector<size_t>{2}, "seek should replay event 2 only");
+
+		// event 3 is due at tick 324, 54 ticks after the target
+		playback.process(53);
+		ok &= check(playback.getProcessed().size() == 1, "event 3 was processed too early");
+
+		playback.process(1);
+		ok &= check(playback.getProcessed() == std::vector<size_t>{2, 3}, "event 3 was not processed at tick 324");
+
+		return ok;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	if(!testSeekToHalf())
+		return -1;
+
+	std::cout << "Demo playback tests passed" << std::endl;
+	return 0;
+}
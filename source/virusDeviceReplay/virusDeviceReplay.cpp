@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+#include "../synthLib/deviceException.h"
+#include "../synthLib/deviceReplay.h"
+#include "../synthLib/plugin.h"
+#include "../synthLib/wavWriter.h"
+
+#include "../virusLib/device.h"
+#include "../virusLib/romloader.h"
+
+#include "../dsp56300/source/disassemble/commandline.h"
+
+namespace
+{
+	void printUsage()
+	{
+		std::cout << "Usage: virusDeviceReplay -file session.drec [-rom file] [-repeat n] [-wav output.wav]" << std::endl;
+		std::cout << "Replays a recorded device session and verifies that the output is bit-identical to the recording." << std::endl;
+		std::cout << "With -repeat, the session is replayed multiple times on fresh devices, for profiling." << std::endl;
+		std::cout << "Usage: virusDeviceReplay -selftest [-rom file]" << std::endl;
+		std::cout << "Records a session that starts while a note is playing, replays it and verifies that the output is bit-identical." << std::endl;
+	}
+
+	void processPlugin(synthLib::Plugin& _plugin, const uint32_t _samples)
+	{
+		constexpr uint32_t blockSize = 256;
+
+		std::vector<float> buffer(blockSize * 8, 0.0f);
+
+		synthLib::TAudioInputs inputs{};
+		synthLib::TAudioOutputs outputs{};
+
+		inputs[0] = inputs[1] = buffer.data();
+
+		for(size_t i=0; i<6; ++i)
+			outputs[i] = &buffer[(i + 2) * blockSize];
+
+		for(uint32_t pos=0; pos<_samples; pos += blockSize)
+			_plugin.process(inputs, outputs, blockSize, 120.0f, 0.0f, false);
+	}
+
+	int runSelfTest(const virusLib::ROMFile& _rom)
+	{
+		const char* filename = "virusDeviceReplaySelfTest.drec";
+
+		const auto samplerate = static_cast<float>(_rom.getSamplerate());
+		const auto seconds = [&](const float _seconds) { return static_cast<uint32_t>(_seconds * samplerate); };
+
+		try
+		{
+			// the plugin takes ownership of the device that is booted for the recording and deletes the first one
+			synthLib::Plugin plugin(new virusLib::Device(_rom, samplerate, samplerate));
+			plugin.setHostSamplerate(samplerate, samplerate);
+			plugin.setBlockSize(256);
+
+			// the session is already running with a held note and ringing effects when the recording starts
+			plugin.addMidiEvent(synthLib::SMidiEvent(synthLib::M_NOTEON, 60, 100));
+			processPlugin(plugin, seconds(1.0f));
+
+			if(!plugin.startRecording(filename, new virusLib::Device(_rom, samplerate, samplerate)))
+			{
+				std::cout << "Failed to start recording to " << filename << std::endl;
+				delete plugin.getDevice();
+				return -1;
+			}
+
+			plugin.addMidiEvent(synthLib::SMidiEvent(synthLib::M_NOTEON, 64, 100));
+			processPlugin(plugin, seconds(0.5f));
+			plugin.addMidiEvent(synthLib::SMidiEvent(synthLib::M_PROGRAMCHANGE, 3, 0));
+			plugin.addMidiEvent(synthLib::SMidiEvent(synthLib::M_NOTEON, 67, 80));
+			processPlugin(plugin, seconds(1.0f));
+			plugin.addMidiEvent(synthLib::SMidiEvent(synthLib::M_NOTEOFF, 64, 0));
+			plugin.addMidiEvent(synthLib::SMidiEvent(synthLib::M_NOTEOFF, 67, 0));
+			processPlugin(plugin, seconds(1.0f));
+
+			plugin.stopRecording();
+			delete plugin.getDevice();
+		}
+		catch(const synthLib::DeviceException& _e)
+		{
+			std::cout << "Failed to boot device: " << _e.what() << std::endl;
+			return -1;
+		}
+
+		synthLib::DeviceReplay replay;
+		synthLib::DeviceReplay::Result result;
+
+		const auto loaded = replay.load(filename);
+		std::remove(filename);
+
+		if(!loaded)
+		{
+			std::cout << replay.getError() << std::endl;
+			return -1;
+		}
+
+		try
+		{
+			virusLib::Device device(_rom, replay.getSamplerate(), replay.getSamplerate());
+
+			if(!replay.run(device, result))
+			{
+				std::cout << replay.getError() << std::endl;
+				return -1;
+			}
+		}
+		catch(const synthLib::DeviceException& _e)
+		{
+			std::cout << "Failed to boot device: " << _e.what() << std::endl;
+			return -1;
+		}
+
+		std::cout << "Replayed " << result.blocks << " blocks, " << result.stateChanges << " state changes" << std::endl;
+
+		if(!result.complete || !result.blocks)
+		{
+			std::cout << "FAILED: recording is incomplete" << std::endl;
+			return -1;
+		}
+
+		if(result.outputMismatches)
+		{
+			std::cout << "FAILED: output differs from recording in " << result.outputMismatches << " blocks, first mismatch at block " << result.firstOutputMismatch << std::endl;
+			return -1;
+		}
+
+		std::cout << "Output is bit-identical to the recording" << std::endl;
+		return 0;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	try
+	{
+		const CommandLine cmd(_argc, _argv);
+
+		if(cmd.contains("help") || (!cmd.contains("file") && !cmd.contains("selftest")))
+		{
+			printUsage();
+			return cmd.contains("help") ? 0 : -1;
+		}
+
+		const auto rom = cmd.contains("rom") ? virusLib::ROMLoader::findROM(cmd.get("rom")) : virusLib::ROMLoader::findROM();
+
+		if(!rom.isValid())
+		{
+			std::cout << "Failed to find a valid ROM" << std::endl;
+			return -1;
+		}
+
+		if(cmd.contains("selftest"))
+			return runSelfTest(rom);
+
+		synthLib::DeviceReplay replay;
+
+		if(!replay.load(cmd.get("file")))
+		{
+			std::cout << replay.getError() << std::endl;
+			return -1;
+		}
+
+		const auto repeat = cmd.contains("repeat") ? std::max(1, cmd.getInt("repeat")) : 1;
+
+		std::unique_ptr<synthLib::WavStreamWriter> wav;
+
+		if(cmd.contains("wav"))
+		{
+			wav.reset(new synthLib::WavStreamWriter());
+
+			if(!wav->open(cmd.get("wav"), 32, true, static_cast<int>(replay.getChannelCountOut()), static_cast<int>(replay.getSamplerate())))
+			{
+				std::cout << "Failed to create " << cmd.get("wav") << std::endl;
+				return -1;
+			}
+		}
+
+		std::vector<float> interleaved;
+
+		auto writeOutput = [&](const synthLib::TAudioOutputs& _outputs, const uint32_t _channels, const size_t _samples)
+		{
+			interleaved.resize(_samples * _channels);
+
+			for(size_t i=0; i<_samples; ++i)
+			{
+				for(uint32_t c=0; c<_channels; ++c)
+					interleaved[i * _channels + c] = _outputs[c][i];
+			}
+
+			wav->write(interleaved.data(), interleaved.size() * sizeof(float));
+		};
+
+		bool identical = true;
+
+		for(int i=0; i<repeat; ++i)
+		{
+			// a fresh device per run, replays start from the state that the device had when recording started
+			std::unique_ptr<virusLib::Device> device;
+
+			try
+			{
+				device.reset(new virusLib::Device(rom, replay.getSamplerate(), replay.getSamplerate()));
+			}
+			catch(const synthLib::DeviceException& _e)
+			{
+				std::cout << "Failed to boot device: " << _e.what() << std::endl;
+				return -1;
+			}
+
+			synthLib::DeviceReplay::Result result;
+
+			const auto callback = wav && i == 0 ? synthLib::DeviceReplay::OutputCallback(writeOutput) : synthLib::DeviceReplay::OutputCallback();
+
+			if(!replay.run(*device, result, callback))
+			{
+				std::cout << replay.getError() << std::endl;
+				return -1;
+			}
+
+			const auto renderedSeconds = static_cast<double>(result.samples) / static_cast<double>(replay.getSamplerate());
+
+			std::cout << "Run " << (i+1) << ": " << result.blocks << " blocks, " << renderedSeconds << " seconds of audio, " << result.stateChanges << " state changes, " <<
+				"processed in " << result.processSeconds << " seconds (realtime factor " << (result.processSeconds > 0.0 ? renderedSeconds / result.processSeconds : 0.0) << ")" << std::endl;
+
+			if(!result.complete)
+				std::cout << "Recording is incomplete, it ends without end marker" << std::endl;
+
+			if(result.inputMismatches)
+				std::cout << result.inputMismatches << " blocks with input audio that does not match its hash" << std::endl;
+
+			if(result.outputMismatches)
+			{
+				std::cout << "Output differs from recording in " << result.outputMismatches << " blocks, first mismatch at block " << result.firstOutputMismatch << std::endl;
+				identical = false;
+			}
+		}
+
+		if(wav)
+			wav->close();
+
+		if(!identical)
+			return -1;
+
+		std::cout << "Output is bit-identical to the recording" << std::endl;
+		return 0;
+	}
+	catch(const std::exception& _e)
+	{
+		std::cout << _e.what() << std::endl;
+		return -1;
+	}
+}
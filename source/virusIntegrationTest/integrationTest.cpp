@@ -2,6 +2,7 @@
 
 #include "integrationTest.h"
 
+#include <cstdlib>
 #include <fstream>
 #include <utility>
 
@@ -10,14 +11,124 @@
 #include "../dsp56300/source/dsp56kEmu/jitunittests.h"
 #include "../dsp56300/source/disassemble/commandline.h"
 
+#include "../synthLib/audioDiff.h"
 #include "../synthLib/wavReader.h"
 #include "../synthLib/os.h"
 
+#include "testRunner.h"
+
 namespace synthLib
 {
 	class WavReader;
 }
 
+static bool collectTests(std::vector<TestCase>& _tests, const std::string& _folder)
+{
+	std::vector<std::string> subfolders;
+	synthLib::getDirectoryEntries(subfolders, _folder);
+
+	if(subfolders.empty())
+	{
+		std::cout << "Nothing found for testing in folder " << _folder << std::endl;
+		return false;
+	}
+
+	for (auto& subfolder : subfolders)
+	{
+		if(subfolder.find("/.") != std::string::npos)
+			continue;
+
+		std::vector<std::string> files;
+		synthLib::getDirectoryEntries(files, subfolder);
+
+		std::string romFile;
+		std::string presetsFile;
+
+		if(files.empty())
+		{
+			std::cout << "Directory " << subfolder << " doesn't contain any files" << std::endl;
+			return false;
+		}
+
+		for (auto& file : files)
+		{
+			if(synthLib::hasExtension(file, ".txt"))
+				presetsFile = file;
+			if(synthLib::hasExtension(file, ".bin"))
+				romFile = file;
+		}
+
+		if(romFile.empty())
+		{
+			std::cout << "Failed to find ROM in folder " << subfolder << std::endl;
+			return false;
+		}
+		if(presetsFile.empty())
+		{
+			std::cout << "Failed to find presets file in folder " << subfolder << std::endl;
+			return false;
+		}
+
+		if(romFile.find("firmware") != std::string::npos)
+		{
+			auto* hFile = fopen(romFile.c_str(), "rb");
+			size_t size = 0;
+			if(hFile)
+			{
+				fseek(hFile, 0, SEEK_END);
+				size = ftell(hFile);
+				fclose(hFile);
+			}
+			if(size > virusLib::ROMFile::getRomSizeModelABC())
+			{
+				std::cout << "Ignoring TI verification tests, TI is not supported" << std::endl;
+				continue;
+			}
+		}
+
+		std::vector<std::string> presets;
+
+		std::ifstream ss;
+		ss.open(presetsFile.c_str(), std::ios::in);
+
+		if(!ss.is_open())
+		{
+			std::cout << "Failed to open presets file " << presetsFile << std::endl;
+			return false;
+		}
+
+		std::string line;
+
+		while(std::getline(ss, line))
+		{
+			while(!line.empty() && line.find_last_of("\r\n") != std::string::npos)
+				line = line.substr(0, line.size()-1);
+			if(!line.empty())
+				presets.push_back(line);
+		}
+
+		ss.close();
+
+		if(presets.empty())
+		{
+			std::cout << "Presets file " << presetsFile << "  is empty" << std::endl;
+			return false;
+		}
+
+		const auto suite = synthLib::getFilenameWithoutPath(subfolder);
+
+		for (auto& preset : presets)
+			_tests.push_back({suite.empty() ? subfolder : suite, romFile, preset, subfolder + '/'});
+	}
+
+	if(_tests.empty())
+	{
+		std::cout << "No tests found in folder " << _folder << std::endl;
+		return false;
+	}
+	return true;
+}
+
 int main(int _argc, char* _argv[])
 {
 	if constexpr (true)
@@ -51,110 +162,35 @@ int main(int _argc, char* _argv[])
 				const auto romFile = cmd.get("rom");
 				const auto preset = cmd.get("preset");
 
-				IntegrationTest test(cmd, romFile, preset, std::string());
+				IntegrationTest test(cmd, romFile, preset, std::string(), std::cout);
 				return test.run();
 			}
 			if(cmd.contains("folder"))
 			{
-				std::vector<std::string> subfolders;
-				synthLib::getDirectoryEntries(subfolders, cmd.get("folder"));
-
-				if(subfolders.empty())
-				{
-					std::cout << "Nothing found for testing in folder " << cmd.get("folder") << std::endl;
+				std::vector<TestCase> tests;
+				if(!collectTests(tests, cmd.get("folder")))
 					return -1;
-				}
 
-				for (auto& subfolder : subfolders)
+				const auto jobs = cmd.contains("jobs") ? static_cast<uint32_t>(cmd.getInt("jobs")) : TestRunner::getDefaultJobCount();
+				const auto timeout = cmd.contains("timeout") ? static_cast<uint32_t>(cmd.getInt("timeout")) : 0;
+
+				TestRunner runner(cmd, jobs, timeout);
+
+				const auto success = runner.run(tests);
+
+				if(cmd.contains("junit"))
+					runner.writeJUnitReport(cmd.get("junit"));
+
+				// threads that are stuck in a test cannot be joined, terminate without unwinding
+				if(runner.hasAbandonedWorkers())
 				{
-					if(subfolder.find("/.") != std::string::npos)
-						continue;
-
-					std::vector<std::string> files;
-					synthLib::getDirectoryEntries(files, subfolder);
-
-					std::string romFile;
-					std::string presetsFile;
-
-					if(files.empty())
-					{
-						std::cout << "Directory " << subfolder << " doesn't contain any files" << std::endl;
-						return -1;
-					}
-
-					for (auto& file : files)
-					{
-						if(synthLib::hasExtension(file, ".txt"))
-							presetsFile = file;
-						if(synthLib::hasExtension(file, ".bin"))
-							romFile = file;
-					}
-
-					if(romFile.empty())
-					{
-						std::cout << "Failed to find ROM in folder " << subfolder << std::endl;
-						return -1;
-					}
-					if(presetsFile.empty())
-					{
-						std::cout << "Failed to find presets file in folder " << subfolder << std::endl;
-						return -1;
-					}
-
-					if(romFile.find("firmware") != std::string::npos)
-					{
-						auto* hFile = fopen(romFile.c_str(), "rb");
-						size_t size = 0;
-						if(hFile)
-						{
-							fseek(hFile, 0, SEEK_END);
-							size = ftell(hFile);
-							fclose(hFile);
-						}
-						if(size > virusLib::ROMFile::getRomSizeModelABC())
-						{
-							std::cout << "Ignoring TI verification tests, TI is not supported" << std::endl;
-							continue;
-						}
-					}
-
-					std::vector<std::string> presets;
-
-					std::ifstream ss;
-					ss.open(presetsFile.c_str(), std::ios::in);
-
-					if(!ss.is_open())
-					{
-						std::cout << "Failed to open presets file " << presetsFile << std::endl;
-						return -1;
-					}
-
-					std::string line;
-
-					while(std::getline(ss, line))
-					{
-						while(!line.empty() && line.find_last_of("\r\n") != std::string::npos)
-							line = line.substr(0, line.size()-1);
-						if(!line.empty())
-							presets.push_back(line);
-					}
-
-					ss.close();
-
-					if(presets.empty())
-					{
-						std::cout << "Presets file " << presetsFile << "  is empty" << std::endl;
-						return -1;
-					}
-
-					for (auto& preset : presets)
-					{
-						IntegrationTest test(cmd, romFile, preset, subfolder + '/');
-						if(test.run() != 0)
-							return -1;
-					}
+					std::cout.flush();
+					std::_Exit(-1);
 				}
 
+				if(!success)
+					return -1;
+
 				if(!forever)
 					return 0;
 			}
@@ -169,11 +205,12 @@ int main(int _argc, char* _argv[])
 	}
 }
 
-IntegrationTest::IntegrationTest(const CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder)
+IntegrationTest::IntegrationTest(const CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder, std::ostream& _out)
 	: m_cmd(_commandLine)
 	, m_romFile(std::move(_romFile))
 	, m_presetName(std::move(_presetName))
 	, m_outputFolder(std::move(_outputFolder))
+	, m_out(_out)
 	, m_app(m_romFile)
 {
 }
@@ -182,13 +219,13 @@ int IntegrationTest::run()
 {
 	if (!m_app.isValid())
 	{
-		std::cout << "Failed to load ROM " << m_romFile << ", make sure that the ROM file is valid" << std::endl;
+		m_out << "Failed to load ROM " << m_romFile << ", make sure that the ROM file is valid" << std::endl;
 		return -1;
 	}
 
 	if (!m_app.loadSingle(m_presetName))
 	{
-		std::cout << "Failed to find preset '" << m_presetName << "', make sure to use a ROM that contains it" << std::endl;
+		m_out << "Failed to find preset '" << m_presetName << "', make sure to use a ROM that contains it" << std::endl;
 		return -1;
 	}
 
@@ -207,43 +244,23 @@ int IntegrationTest::run()
 	return runCompare();
 }
 
-bool IntegrationTest::loadAudioFile(File& _dst, const std::string& _filename) const
+bool IntegrationTest::loadAudioFile(synthLib::WavFile& _dst, const std::string& _filename) const
 {
-	const auto hFile = fopen(_filename.c_str(), "rb");
-	if (!hFile)
-	{
-		std::cout << "Failed to load wav file " << _filename << " for comparison" << std::endl;
-		return false;
-	}
-	fseek(hFile, 0, SEEK_END);
-	const size_t size = ftell(hFile);
-	_dst.file.resize(size);
-	fseek(hFile, 0, SEEK_SET);
-	if (fread(&_dst.file.front(), 1, size, hFile) != size)
+	if (!_dst.open(_filename))
 	{
-		std::cout << "Failed to read data from file " << _filename << std::endl;
-		fclose(hFile);
+		m_out << "Failed to load file " << _filename << " as wave data, make sure that the file is a valid 24 bit stereo wav file" << std::endl;
 		return false;
 	}
-	fclose(hFile);
-
-	_dst.data.data = nullptr;
 
-	if (!synthLib::WavReader::load(_dst.data, nullptr, &_dst.file.front(), _dst.file.size()))
+	if(_dst.getSamplerate() != m_app.getRom().getSamplerate())
 	{
-		std::cout << "Failed to interpret file " << _filename << " as wave data, make sure that the file is a valid 24 bit stereo wav file" << std::endl;
+		m_out << "Wave file " << _filename << " does not have the correct samplerate, expected " << m_app.getRom().getSamplerate() << " but got " << _dst.getSamplerate() << " instead" << std::endl;
 		return false;
 	}
 
-	if(_dst.data.samplerate != m_app.getRom().getSamplerate())
+	if (_dst.getFormat() != synthLib::SampleFormat::Int24 || _dst.getChannelCount() != 2)
 	{
-		std::cout << "Wave file " << _filename << " does not have the correct samplerate, expected " << m_app.getRom().getSamplerate() << " but got " << _dst.data.samplerate << " instead" << std::endl;
-		return false;
-	}
-
-	if (_dst.data.bitsPerSample != 24 || _dst.data.channels != 2 || _dst.data.isFloat)
-	{
-		std::cout << "Wave file " << _filename << " has an invalid format, expected 24 bit / 2 channels but got " << _dst.data.bitsPerSample << " bit / " << _dst.data.channels << " channels" << std::endl;
+		m_out << "Wave file " << _filename << " has an invalid format, expected 24 bit / 2 channels but got " << _dst.getData().bitsPerSample << " bit / " << _dst.getChannelCount() << " channels" << std::endl;
 		return false;
 	}
 	return true;
@@ -251,35 +268,35 @@ bool IntegrationTest::loadAudioFile(File& _dst, const std::string& _filename) co
 
 int IntegrationTest::runCompare()
 {
-	const auto sampleCount = m_referenceFile.data.dataByteSize * 8 / m_referenceFile.data.bitsPerSample;
-	const auto frameCount = sampleCount >> 1;
-
-	std::vector<uint8_t> temp;
+	const auto frameCount = m_referenceFile.getFrameCount();
 
-	File compareFile;
+	synthLib::WavFile compareFile;
 	const auto res = createAudioFile(compareFile, "compare_", static_cast<uint32_t>(frameCount));
 	if(res)
 		return res;
 
-	auto* ptrA = static_cast<const uint8_t*>(compareFile.data.data);
-	auto* ptrB = static_cast<const uint8_t*>(m_referenceFile.data.data);
+	synthLib::AudioDiff::Config config;
+	if(m_cmd.contains("tolerance"))
+		config.tolerance = m_cmd.getFloat("tolerance");
 
-	for(uint32_t i=0; i<sampleCount; ++i)
+	synthLib::AudioDiff::Result diff;
+	if(!synthLib::AudioDiff::compare(diff, compareFile, m_referenceFile, config))
 	{
-		const uint32_t a = (static_cast<uint32_t>(ptrA[0]) << 24) | (static_cast<uint32_t>(ptrA[1]) << 16) | ptrA[2];
-		const uint32_t b = (static_cast<uint32_t>(ptrB[0]) << 24) | (static_cast<uint32_t>(ptrB[1]) << 16) | ptrB[2];
-
-		if(b != a)
-		{
-			std::cout << "Test failed, audio output is not identical to reference file, difference starting at frame " << (i>>1) << ", ROM " << m_romFile << ", preset " << m_presetName << std::endl;
-			return -2;
-		}
+		m_out << "Failed to compare audio output with reference file, ROM " << m_romFile << ", preset " << m_presetName << std::endl;
+		return -1;
+	}
 
-		ptrA += 3;
-		ptrB += 3;
+	if(!diff.isMatch())
+	{
+		m_out << diff.toString(static_cast<float>(m_referenceFile.getSamplerate()));
+		m_out << "Test failed, audio output is not identical to reference file, difference starting at frame " << diff.firstFrame << ", ROM " << m_romFile << ", preset " << m_presetName << std::endl;
+		return -2;
 	}
 
-	std::cout << "Test succeeded, compared " << sampleCount << " samples, ROM " << m_romFile << ", preset " << m_presetName << std::endl;
+	m_out << "Test succeeded, compared " << (frameCount << 1) << " samples";
+	if(diff.maxError > 0.0f)
+		m_out << ", max error " << diff.maxError << " within tolerance " << config.tolerance;
+	m_out << ", ROM " << m_romFile << ", preset " << m_presetName << std::endl;
 	return 0;
 }
 
@@ -287,11 +304,11 @@ int IntegrationTest::runCreate(const int _lengthSeconds)
 {
 	const auto sampleCount = m_app.getRom().getSamplerate() * _lengthSeconds * 2;
 
-	File file;
+	synthLib::WavFile file;
 	return createAudioFile(file, "", sampleCount);
 }
 
-int IntegrationTest::createAudioFile(File& _dst, const std::string& _prefix, const uint32_t _sampleCount)
+int IntegrationTest::createAudioFile(synthLib::WavFile& _dst, const std::string& _prefix, const uint32_t _sampleCount)
 {
 	const auto filename = m_outputFolder + _prefix + m_app.getSingleNameAsFilename();
 
@@ -299,7 +316,7 @@ int IntegrationTest::createAudioFile(File& _dst, const std::string& _prefix, con
 
 	if(!hFile)
 	{
-		std::cout << "Failed to create output file " << filename << std::endl;
+		m_out << "Failed to create output file " << filename << std::endl;
 		return -1;
 	}
 
@@ -309,15 +326,15 @@ int IntegrationTest::createAudioFile(File& _dst, const std::string& _prefix, con
 
 	if(!loadAudioFile(_dst, filename))
 	{
-		std::cout << "Failed to open written file " << filename << " for verification" << std::endl;
+		m_out << "Failed to open written file " << filename << " for verification" << std::endl;
 		return -1;
 	}
 
-	const auto sampleCount = _dst.data.dataByteSize * 8 / _dst.data.bitsPerSample / 2;
+	const auto sampleCount = _dst.getFrameCount();
 
 	if(sampleCount != _sampleCount)
 	{
-		std::cout << "Verification of written file failed, expected " << _sampleCount << " samples but file only has " << sampleCount << " samples" << std::endl;
+		m_out << "Verification of written file failed, expected " << _sampleCount << " samples but file only has " << sampleCount << " samples" << std::endl;
 		return -1;
 	}
 	return 0;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ostream>
+
 #include "../virusConsoleLib/consoleApp.h"
 
 #include "../synthLib/wavReader.h"
@@ -9,27 +11,22 @@ class CommandLine;
 class IntegrationTest
 {
 public:
-	explicit IntegrationTest(const CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder);
+	explicit IntegrationTest(const CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder, std::ostream& _out);
 
 	int run();
 
 private:
-	struct File
-	{
-		std::vector<uint8_t> file;
-		synthLib::Data data;
-	};
-
-	bool loadAudioFile(File& _dst, const std::string& _filename) const;
+	bool loadAudioFile(synthLib::WavFile& _dst, const std::string& _filename) const;
 	int runCompare();
 	int runCreate(int _lengthSeconds);
-	int createAudioFile(File& _dst, const std::string& _prefix, uint32_t _sampleCount);
+	int createAudioFile(synthLib::WavFile& _dst, const std::string& _prefix, uint32_t _sampleCount);
 
 	const CommandLine& m_cmd;
 	const std::string m_romFile;
 	const std::string m_presetName;
 	const std::string m_outputFolder;
+	std::ostream& m_out;
 	ConsoleApp m_app;
 
-	File m_referenceFile;
+	synthLib::WavFile m_referenceFile;
 };
@@ -5,7 +5,7 @@ set(TEST_DATA_DIR integrationTestsData)
 if(EXISTS ${RCLONE_CONF})
 	copyDataFrom("integrationtests" ${TEST_DATA_DIR})
 
-	execute_process(COMMAND ${TEST_RUNNER} -folder ${TEST_DATA_DIR} COMMAND_ECHO STDOUT RESULT_VARIABLE TEST_RESULT)
+	execute_process(COMMAND ${TEST_RUNNER} -folder ${TEST_DATA_DIR} -timeout 1800 -junit ${ROOT_DIR}/virusIntegrationTests.xml COMMAND_ECHO STDOUT RESULT_VARIABLE TEST_RESULT)
 	if(TEST_RESULT)
 		message(FATAL_ERROR "Failed to execute ${TEST_RUNNER}: " ${CMD_RESULT})
 	endif()
@@ -0,0 +1,354 @@
+#include "testRunner.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "integrationTest.h"
+
+namespace
+{
+	std::string escapeXml(const std::string& _s)
+	{
+		std::string res;
+		res.reserve(_s.size());
+
+		for (const char c : _s)
+		{
+			switch (c)
+			{
+			case '&':	res += "&amp;";		break;
+			case '<':	res += "&lt;";		break;
+			case '>':	res += "&gt;";		break;
+			case '"':	res += "&quot;";	break;
+			case '\'':	res += "&apos;";	break;
+			default:
+				// control characters other than tab and newlines are not allowed in XML 1.0
+				if(static_cast<unsigned char>(c) < 0x20 && c != '\t' && c != '\n' && c != '\r')
+					continue;
+				res += c;
+			}
+		}
+		return res;
+	}
+
+	std::string lastLine(const std::string& _s)
+	{
+		const auto end = _s.find_last_not_of("\r\n");
+		if(end == std::string::npos)
+			return {};
+
+		const auto newline = _s.find_last_of('\n', end);
+		const auto start = newline == std::string::npos ? 0 : newline + 1;
+
+		return _s.substr(start, end + 1 - start);
+	}
+}
+
+TestRunner::TestRunner(const CommandLine& _commandLine, const uint32_t _jobCount, const uint32_t _timeoutSeconds)
+	: m_cmd(_commandLine)
+	, m_jobCount(std::max(1u, _jobCount))
+	, m_timeout(_timeoutSeconds)
+{
+}
+
+TestRunner::~TestRunner()
+{
+	for(size_t i=0; i<m_threads.size(); ++i)
+	{
+		if(!m_threads[i].joinable())
+			continue;
+
+		if(m_slots[i].abandoned)
+			m_threads[i].detach();
+		else
+			m_threads[i].join();
+	}
+}
+
+bool TestRunner::run(const std::vector<TestCase>& _tests)
+{
+	const auto start = Clock::now();
+
+	std::unique_lock lock(m_mutex);
+
+	m_tests = _tests;
+	m_results.assign(m_tests.size(), TestResult());
+	m_nextTest = 0;
+	m_finishedCount = 0;
+
+	std::cout << "Running " << m_tests.size() << " tests using " << std::min<size_t>(m_jobCount, m_tests.size()) << " jobs";
+	if(m_timeout.count() > 0)
+		std::cout << ", timeout " << m_timeout.count() << " seconds per test";
+	std::cout << std::endl;
+
+	for(size_t i=0; i<std::min<size_t>(m_jobCount, m_tests.size()); ++i)
+		startWorker();
+
+	while(m_finishedCount < m_tests.size())
+	{
+		m_cv.wait_for(lock, std::chrono::seconds(1));
+
+		if(m_timeout.count() > 0)
+			checkTimeouts();
+	}
+
+	lock.unlock();
+
+	for(size_t i=0; i<m_threads.size(); ++i)
+	{
+		if(!m_slots[i].abandoned && m_threads[i].joinable())
+			m_threads[i].join();
+	}
+
+	m_wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	size_t passed = 0;
+	for (const auto& r : m_results)
+	{
+		if(r.status == TestResult::Status::Passed)
+			++passed;
+	}
+
+	std::cout << passed << " of " << m_results.size() << " tests passed in " << std::fixed << std::setprecision(1) << m_wallSeconds << " seconds" << std::defaultfloat << std::endl;
+
+	return passed == m_results.size();
+}
+
+bool TestRunner::writeJUnitReport(const std::string& _filename) const
+{
+	// tests are grouped into one test suite per folder, in the order of their first appearance
+
+	std::vector<std::string> suiteNames;
+	std::map<std::string, std::vector<size_t>> suites;
+
+	for(size_t i=0; i<m_tests.size(); ++i)
+	{
+		auto& suite = suites[m_tests[i].suite];
+		if(suite.empty())
+			suiteNames.push_back(m_tests[i].suite);
+		suite.push_back(i);
+	}
+
+	auto countStatus = [&](const std::vector<size_t>& _indices, const std::initializer_list<TestResult::Status> _status)
+	{
+		size_t count = 0;
+		for (const auto i : _indices)
+		{
+			if(std::find(_status.begin(), _status.end(), m_results[i].status) != _status.end())
+				++count;
+		}
+		return count;
+	};
+
+	std::vector<size_t> all(m_tests.size());
+	for(size_t i=0; i<all.size(); ++i)
+		all[i] = i;
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3);
+
+	ss << R"(<?xml version="1.0" encoding="UTF-8"?>)" << '\n';
+	ss << R"(<testsuites name="virusIntegrationTest" tests=")" << m_tests.size()
+		<< R"(" failures=")" << countStatus(all, {TestResult::Status::Failed, TestResult::Status::Timeout})
+		<< R"(" errors=")" << countStatus(all, {TestResult::Status::Error})
+		<< R"(" time=")" << m_wallSeconds << R"(">)" << '\n';
+
+	for (const auto& suiteName : suiteNames)
+	{
+		const auto& indices = suites[suiteName];
+
+		double time = 0.0;
+		for (const auto i : indices)
+			time += m_results[i].seconds;
+
+		ss << '\t' << R"(<testsuite name=")" << escapeXml(suiteName) << R"(" tests=")" << indices.size()
+			<< R"(" failures=")" << countStatus(indices, {TestResult::Status::Failed, TestResult::Status::Timeout})
+			<< R"(" errors=")" << countStatus(indices, {TestResult::Status::Error})
+			<< R"(" time=")" << time << R"(">)" << '\n';
+
+		for (const auto i : indices)
+		{
+			const auto& t = m_tests[i];
+			const auto& r = m_results[i];
+
+			ss << "\t\t" << R"(<testcase classname=")" << escapeXml(suiteName) << R"(" name=")" << escapeXml(t.preset) << R"(" time=")" << r.seconds << R"(">)" << '\n';
+
+			switch (r.status)
+			{
+			case TestResult::Status::Passed:
+				break;
+			case TestResult::Status::Failed:
+			case TestResult::Status::Timeout:
+				ss << "\t\t\t" << R"(<failure type=")" << toString(r.status) << R"(" message=")" << escapeXml(lastLine(r.output)) << R"("/>)" << '\n';
+				break;
+			default:
+				ss << "\t\t\t" << R"(<error type=")" << toString(r.status) << R"(" message=")" << escapeXml(lastLine(r.output)) << R"("/>)" << '\n';
+				break;
+			}
+
+			if(!r.output.empty())
+				ss << "\t\t\t" << "<system-out>" << escapeXml(r.output) << "</system-out>" << '\n';
+
+			ss << "\t\t" << "</testcase>" << '\n';
+		}
+
+		ss << '\t' << "</testsuite>" << '\n';
+	}
+
+	ss << "</testsuites>" << '\n';
+
+	std::ofstream file(_filename, std::ios::out | std::ios::trunc);
+	if(!file.is_open())
+	{
+		std::cout << "Failed to create JUnit report " << _filename << std::endl;
+		return false;
+	}
+
+	file << ss.str();
+	return file.good();
+}
+
+uint32_t TestRunner::getDefaultJobCount()
+{
+	// every device runs the DSP emulation in a separate thread next to the thread that drives it
+	return std::max(1u, std::thread::hardware_concurrency() / 2);
+}
+
+void TestRunner::startWorker()
+{
+	const auto index = m_slots.size();
+	m_slots.emplace_back();
+	m_threads.emplace_back([this, index] { workerThread(index); });
+}
+
+void TestRunner::workerThread(const size_t _slot)
+{
+	while(true)
+	{
+		size_t index;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			if(m_nextTest >= m_tests.size())
+				return;
+
+			index = m_nextTest++;
+
+			auto& slot = m_slots[_slot];
+			slot.test = index;
+			slot.start = Clock::now();
+			slot.busy = true;
+		}
+
+		auto result = runTest(m_cmd, m_tests[index]);
+
+		std::lock_guard lock(m_mutex);
+
+		auto& slot = m_slots[_slot];
+		slot.busy = false;
+
+		// a replacement worker has been started if the test timed out, the result is discarded
+		if(slot.abandoned)
+		{
+			--m_abandonedWorkers;
+			return;
+		}
+
+		finishTest(index, std::move(result));
+	}
+}
+
+void TestRunner::checkTimeouts()
+{
+	const auto now = Clock::now();
+
+	for(size_t i=0; i<m_slots.size(); ++i)
+	{
+		auto& slot = m_slots[i];
+
+		if(!slot.busy || slot.abandoned || now - slot.start < m_timeout)
+			continue;
+
+		slot.abandoned = true;
+		++m_abandonedWorkers;
+
+		TestResult r;
+		r.status = TestResult::Status::Timeout;
+		r.exitCode = -1;
+		r.seconds = std::chrono::duration<double>(now - slot.start).count();
+		r.output = "Test timed out after " + std::to_string(m_timeout.count()) + " seconds\n";
+
+		finishTest(slot.test, std::move(r));
+
+		if(m_nextTest < m_tests.size())
+			startWorker();
+	}
+}
+
+void TestRunner::finishTest(const size_t _test, TestResult&& _result)
+{
+	auto& r = m_results[_test];
+	r = std::move(_result);
+
+	++m_finishedCount;
+
+	const auto& t = m_tests[_test];
+
+	std::cout << '[' << m_finishedCount << '/' << m_tests.size() << "] " << toString(r.status) << ' ' << t.suite << '/' << t.preset
+		<< " (" << std::fixed << std::setprecision(1) << r.seconds << "s)" << std::defaultfloat << std::endl;
+
+	if(r.status != TestResult::Status::Passed)
+		std::cout << r.output;
+
+	m_cv.notify_one();
+}
+
+TestResult TestRunner::runTest(const CommandLine& _commandLine, const TestCase& _test)
+{
+	TestResult r;
+	std::stringstream out;
+
+	const auto start = Clock::now();
+
+	try
+	{
+		IntegrationTest test(_commandLine, _test.romFile, _test.preset, _test.outputFolder, out);
+		r.exitCode = test.run();
+	}
+	catch(const std::runtime_error& _err)
+	{
+		out << _err.what() << std::endl;
+		r.exitCode = -1;
+	}
+
+	r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	r.output = out.str();
+
+	switch (r.exitCode)
+	{
+	case 0:		r.status = TestResult::Status::Passed;	break;
+	case -2:	r.status = TestResult::Status::Failed;	break;
+	default:	r.status = TestResult::Status::Error;	break;
+	}
+
+	return r;
+}
+
+const char* TestRunner::toString(const TestResult::Status _status)
+{
+	switch (_status)
+	{
+	case TestResult::Status::Pending:	return "PENDING";
+	case TestResult::Status::Passed:	return "PASS";
+	case TestResult::Status::Failed:	return "FAIL";
+	case TestResult::Status::Error:		return "ERROR";
+	case TestResult::Status::Timeout:	return "TIMEOUT";
+	}
+	return "";
+}
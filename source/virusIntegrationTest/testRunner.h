@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CommandLine;
+
+struct TestCase
+{
+	std::string suite;			// name of the folder that contains the ROM and the presets file
+	std::string romFile;
+	std::string preset;
+	std::string outputFolder;
+};
+
+struct TestResult
+{
+	enum class Status
+	{
+		Pending,
+		Passed,
+		Failed,		// audio output differs from the reference
+		Error,		// test could not be executed, for example because of a missing file
+		Timeout
+	};
+
+	Status status = Status::Pending;
+	int exitCode = 0;
+	double seconds = 0.0;
+	std::string output;
+};
+
+// Runs integration tests concurrently, every worker thread creates its own device per test. A test that exceeds the
+// timeout is reported as failed and its worker is abandoned, a new worker is started in its place as the emulation
+// cannot be interrupted
+class TestRunner
+{
+public:
+	TestRunner(const CommandLine& _commandLine, uint32_t _jobCount, uint32_t _timeoutSeconds);
+	~TestRunner();
+
+	// returns true if all tests passed
+	bool run(const std::vector<TestCase>& _tests);
+
+	bool writeJUnitReport(const std::string& _filename) const;
+
+	// workers that are still stuck in a test that timed out. The process has to be terminated without returning from
+	// main if there are any, these threads cannot be joined
+	bool hasAbandonedWorkers() const { return m_abandonedWorkers > 0; }
+
+	static uint32_t getDefaultJobCount();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Slot
+	{
+		size_t test = 0;
+		Clock::time_point start;
+		bool busy = false;
+		bool abandoned = false;
+	};
+
+	void startWorker();
+	void workerThread(size_t _slot);
+	void checkTimeouts();
+	void finishTest(size_t _test, TestResult&& _result);
+
+	static TestResult runTest(const CommandLine& _commandLine, const TestCase& _test);
+	static const char* toString(TestResult::Status _status);
+
+	const CommandLine& m_cmd;
+	const uint32_t m_jobCount;
+	const std::chrono::seconds m_timeout;
+
+	std::vector<TestCase> m_tests;
+	std::vector<TestResult> m_results;
+	double m_wallSeconds = 0.0;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	size_t m_nextTest = 0;
+	size_t m_finishedCount = 0;
+	uint32_t m_abandonedWorkers = 0;
+	std::vector<Slot> m_slots;
+	std::vector<std::thread> m_threads;
+};
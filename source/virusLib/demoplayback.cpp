@@ -1,10 +1,14 @@
 #include "demoplayback.h"
 
+#include <algorithm>
 #include <cassert>
+#include <set>
 #include <vector>
 
 #include "microcontroller.h"
+#include "microcontrollerTypes.h"
 
+#include "../synthLib/asyncLog.h"
 #include "../synthLib/midiToSysex.h"
 #include "../synthLib/midiTypes.h"
 #include "../synthLib/os.h"
@@ -28,7 +32,7 @@ namespace virusLib
 			auto* hFile = fopen(_filename.c_str(), "rb");
 			if(!hFile)
 			{
-				LOG("Failed to open demo file " << _filename);
+				SYNTHLIB_LOG_ERROR("Failed to open demo file " << _filename);
 				return false;
 			}
 			fseek(hFile, 0, SEEK_END);
@@ -42,7 +46,7 @@ namespace virusLib
 		MidiFileToRomData romReader;
 		if(!romReader.load(_filename) || romReader.getData().empty())
 		{
-			LOG("Failed to load demo midi file " << _filename << ", no valid data found in file");
+			SYNTHLIB_LOG_ERROR("Failed to load demo midi file " << _filename << ", no valid data found in file");
 			return false;
 		}
 
@@ -236,19 +240,16 @@ namespace virusLib
 		if(m_stop)
 			return;
 
-		if(m_currentEvent == 0 && m_remainingDelay == 0)
+		if(!m_started)
 		{
-			// switch to multi mode when playback starts
-			Microcontroller::TPreset data;
-			m_mc.requestMulti(BankNumber::A, 0, data);
-			m_mc.writeMulti(BankNumber::EditBuffer, 0, data);
-			--m_remainingDelay;
+			start();
 			return;
 		}
 
 		if(m_currentEvent >= getEventCount())
 			return;
 
+		m_position += _samples;
 		m_remainingDelay -= static_cast<int32_t>(_samples);
 
 		while(m_remainingDelay <= 0)
@@ -256,7 +257,7 @@ namespace virusLib
 			if(!processEvent(m_currentEvent))
 				return;
 
-			m_remainingDelay = static_cast<int32_t>(static_cast<float>(getEventDelay(m_currentEvent)) * m_timeScale);
+			m_remainingDelay = getScaledDelay(m_currentEvent);
 
 			++m_currentEvent;
 
@@ -268,6 +269,92 @@ namespace virusLib
 		}
 	}
 
+	bool DemoPlayback::seek(const uint64_t _ticks)
+	{
+		if(m_stop || _ticks < m_position)
+			return false;
+
+		if(!m_started)
+			start();
+
+		// collect all events up to the target, the time of the current event is given by the remaining delay
+		const auto eventCount = getEventCount();
+
+		std::vector<size_t> events;
+
+		auto index = static_cast<size_t>(m_currentEvent);
+		auto time = m_position + static_cast<uint64_t>(std::max(m_remainingDelay, 0));
+
+		while(index < eventCount && time <= _ticks)
+		{
+			events.push_back(index);
+			time += static_cast<uint64_t>(std::max(getScaledDelay(index), 0));
+			++index;
+		}
+
+		// walk backwards to find the events that are not overwritten by later ones
+		std::vector<size_t> apply;
+		std::set<uint64_t> keys;
+
+		for(auto it = events.rbegin(); it != events.rend(); ++it)
+		{
+			uint64_t key = 0;
+
+			if(!isStateEvent(*it, key))
+				continue;
+
+			if(key && !keys.insert(key).second)
+				continue;
+
+			apply.push_back(*it);
+		}
+
+		for(auto it = apply.rbegin(); it != apply.rend(); ++it)
+			processEvent(*it);
+
+		SYNTHLIB_LOG_INFO("Demo playback seek to tick " << _ticks << ", replayed " << apply.size() << " of " << events.size() << " events");
+
+		m_currentEvent = static_cast<uint32_t>(index);
+		m_position = _ticks;
+
+		if(index >= eventCount)
+		{
+			stop();
+			return false;
+		}
+
+		m_remainingDelay = static_cast<int32_t>(time - _ticks);
+		return true;
+	}
+
+	uint64_t DemoPlayback::getLength() const
+	{
+		// playback stops when the last event has been processed
+		uint64_t length = 0;
+
+		for(size_t i=0; i+1<getEventCount(); ++i)
+			length += static_cast<uint64_t>(std::max(getScaledDelay(i), 0));
+
+		return length;
+	}
+
+	void DemoPlayback::start()
+	{
+		// switch to multi mode when playback starts
+		Microcontroller::TPreset data;
+		m_mc.requestMulti(BankNumber::A, 0, data);
+		m_mc.writeMulti(BankNumber::EditBuffer, 0, data);
+
+		// the first event is processed with the next call to process()
+		m_remainingDelay = -1;
+		m_started = true;
+	}
+
+	int32_t DemoPlayback::getScaledDelay(const size_t _index) const
+	{
+		return static_cast<int32_t>(static_cast<float>(getEventDelay(_index)) * m_timeScale);
+	}
+
 	void DemoPlayback::writeRawData(const std::vector<uint8_t>& _data) const
 	{
 		std::vector<dsp56k::TWord> dspWords;
@@ -289,10 +376,83 @@ namespace virusLib
 	void DemoPlayback::stop()
 	{
 		m_stop = true;
-		LOG("Demo Playback end reached");
+		SYNTHLIB_LOG_INFO("Demo Playback end reached");
 		std::cout << "Demo song has ended." << std::endl;
 	}
 
+	bool DemoPlayback::isStateEvent(const Event& _event, uint64_t& _key)
+	{
+		const auto& d = _event.data;
+
+		_key = 0;
+
+		switch (_event.type)
+		{
+		case EventType::RawSerial:
+			// header f0 75 55, followed by the preset type (single or multi) and the program number
+			if(d.size() > 4)
+				_key = 1ull << 56 | static_cast<uint64_t>(d[3]) << 8 | d[4];
+			return true;
+		case EventType::MidiSysex:
+			if(d.size() > 9 && d[1] == 0x00 && d[2] == 0x20 && d[3] == 0x33)
+			{
+				const auto cmd = static_cast<uint64_t>(d[6]);
+
+				switch (d[6])
+				{
+				case DUMP_SINGLE:
+				case DUMP_MULTI:
+					_key = 2ull << 56 | cmd << 16 | static_cast<uint64_t>(d[7]) << 8 | d[8];	// bank, program
+					break;
+				case PARAM_CHANGE_A:
+				case PARAM_CHANGE_B:
+				case PARAM_CHANGE_C:
+				case PARAM_CHANGE_D:
+					_key = 3ull << 56 | cmd << 16 | static_cast<uint64_t>(d[7]) << 8 | d[8];	// part, parameter
+					break;
+				default:
+					break;
+				}
+			}
+			return true;
+		case EventType::Midi:
+			{
+				if(d[0] >= 0xf0)
+					return false;
+
+				const auto channel = static_cast<uint64_t>(d[0] & 0x0f);
+
+				switch (d[0] & 0xf0)
+				{
+				case synthLib::M_NOTEON:
+				case synthLib::M_NOTEOFF:
+					return false;
+				case synthLib::M_POLYPRESSURE:
+					// edits parameters of page B if enabled
+					_key = 4ull << 56 | channel << 8 | d[1];
+					return true;
+				case synthLib::M_CONTROLCHANGE:
+					// bank selects are evaluated by the next program change, channel mode messages are not a state
+					if(d[1] != synthLib::MC_BANKSELECTMSB && d[1] != synthLib::MC_BANKSELECTLSB && d[1] < synthLib::MC_ALLSOUNDOFF)
+						_key = 5ull << 56 | channel << 8 | d[1];
+					return true;
+				case synthLib::M_PROGRAMCHANGE:
+					_key = 6ull << 56 | channel;
+					return true;
+				case synthLib::M_AFTERTOUCH:
+					_key = 7ull << 56 | channel;
+					return true;
+				case synthLib::M_PITCHBEND:
+					_key = 8ull << 56 | channel;
+					return true;
+				default:
+					return false;
+				}
+			}
+		}
+		return false;
+	}
+
 	bool DemoPlayback::processEvent(const Event& _event) const
 	{
 		switch (_event.type)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -16,8 +17,20 @@ namespace virusLib
 		virtual bool loadFile(const std::string& _filename);
 		virtual bool loadBinData(const std::vector<uint8_t>& _data);
 
+		// Advances playback by the given number of ticks. The delays of the song are scaled by the time scale of the ROM,
+		// which expects one tick per four samples of the device
 		virtual void process(uint32_t _samples);
 
+		// Moves playback to the given number of ticks after its start without rendering, see process(). Events that
+		// change the state of the device, such as presets, program changes and controllers, are replayed up to the
+		// target, notes are skipped. Events that are superseded by later ones are dropped. Has to be called from the
+		// thread that calls process(). Returns false if the target is beyond the end of the song
+		bool seek(uint64_t _ticks);
+
+		// length of the song and current playback position in ticks, see process()
+		uint64_t getLength() const;
+		uint64_t getPosition() const { return m_position; }
+
 	protected:
 		void writeRawData(const std::vector<uint8_t>& _data) const;
 		void setTimeScale(const float _timeScale) { m_timeScale = _timeScale; }
@@ -45,9 +58,17 @@ namespace virusLib
 
 		bool processEvent(const Event& _event) const;
 
-		virtual size_t getEventCount() const						{ return m_events.size(); }
-		virtual uint32_t getEventDelay(const size_t _index) const	{ return m_events[_index].delay; }
-		virtual bool processEvent(const size_t _index)				{ return processEvent(m_events[_index]); }
+		// returns false if the event does not change the state of the device. _key identifies what is changed, a later
+		// event with the same key makes this one obsolete. A key of zero is never considered to be obsolete
+		static bool isStateEvent(const Event& _event, uint64_t& _key);
+
+		void start();
+		int32_t getScaledDelay(size_t _index) const;
+
+		virtual size_t getEventCount() const									{ return m_events.size(); }
+		virtual uint32_t getEventDelay(const size_t _index) const				{ return m_events[_index].delay; }
+		virtual bool processEvent(const size_t _index)							{ return processEvent(m_events[_index]); }
+		virtual bool isStateEvent(const size_t _index, uint64_t& _key) const	{ return isStateEvent(m_events[_index], _key); }
 
 	protected:
 		Microcontroller& m_mc;
@@ -56,6 +77,8 @@ namespace virusLib
 		std::vector<Event> m_events;
 		int32_t m_remainingDelay = 0;
 		uint32_t m_currentEvent = 0;
+		uint64_t m_position = 0;
+		bool m_started = false;
 
 		float m_timeScale = 54.0f;
 		bool m_stop = false;
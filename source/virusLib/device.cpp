@@ -6,18 +6,28 @@
 #include "dsp56kEmu/jit.h"
 
 #include "../synthLib/deviceException.h"
+#include "../synthLib/perfCounters.h"
+#include "../synthLib/rtAudit.h"
+#include "../synthLib/tracer.h"
 
 #include <cstring>
 
 #include "dspMemoryPatches.h"
+#include "latencyCalibration.h"
 
 namespace virusLib
 {
+	// Used if no calibration is available. The MIDI latency is an average value, it drifts in a range of roughly +/- 61
+	// samples. The input latency has been measured by using an input init patch. Sent a click to the input and recorded
+	// both the input as direct signal plus the Virus output and checking the resulting latency in a wave editor
+	static constexpr uint32_t g_defaultLatencyMidiToOutput = 324;
+	static constexpr uint32_t g_defaultLatencyInputToOutput = 384;
+
 	Device::Device(ROMFile _rom, const float _preferredDeviceSamplerate, const float _hostSamplerate, const bool _createDebugger/* = false*/)
 		: m_rom(std::move(_rom))
 		, m_samplerate(getDeviceSamplerate(_preferredDeviceSamplerate, _hostSamplerate))
 	{
-		if(!m_rom.isValid())
+		if(!m_rom.load())
 			throw synthLib::DeviceException(synthLib::DeviceError::FirmwareMissing, "Either a ROM file (.bin) or an OS update file (.mid) is required, but neither was found.");
 
 		DspSingle* dsp1;
@@ -291,15 +301,45 @@ namespace virusLib
 
 	uint32_t Device::getInternalLatencyMidiToOutput() const
 	{
-		// Note that this is an average value, midi latency drifts in a range of roughly +/- 61 samples
-		return 324;
+		LatencyCalibration::Result result;
+
+		if(LatencyCalibration::instance().find(result, m_rom.getHash(), m_samplerate))
+			return result.midiToOutput;
+
+		return g_defaultLatencyMidiToOutput;
 	}
 
 	uint32_t Device::getInternalLatencyInputToOutput() const
 	{
-		// Measured by using an input init patch. Sent a click to the input and recorded both the input
-		// as direct signal plus the Virus output and checking the resulting latency in a wave editor
-		return 384;
+		LatencyCalibration::Result result;
+
+		if(LatencyCalibration::instance().find(result, m_rom.getHash(), m_samplerate))
+			return result.inputToOutput;
+
+		return g_defaultLatencyInputToOutput;
+	}
+
+	bool Device::hasLatencyCalibration() const
+	{
+		LatencyCalibration::Result result;
+		return LatencyCalibration::instance().find(result, m_rom.getHash(), m_samplerate);
+	}
+
+	bool Device::calibrateLatency(const bool _force/* = false*/, const std::atomic<bool>* _cancel/* = nullptr*/)
+	{
+		if(!_force && hasLatencyCalibration())
+			return true;
+
+		LatencyCalibration::Result result;
+
+		if(!LatencyCalibration::measure(result, *this, m_rom, _cancel))
+			return false;
+
+		auto& calibration = LatencyCalibration::instance();
+
+		calibration.set(m_rom.getHash(), m_samplerate, result);
+		calibration.save();
+		return true;
 	}
 
 	uint32_t Device::getChannelCountIn()
@@ -350,6 +390,8 @@ namespace virusLib
 
 	void Device::processAudio(const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, size_t _samples)
 	{
+		SYNTHLIB_PERF_SCOPE(DeviceProcessAudio);
+
 		constexpr auto maxBlockSize = dsp56k::Audio::RingBufferSize>>2;
 
 		auto inputs(_inputs);
@@ -379,6 +421,11 @@ namespace virusLib
 
 	void Device::onAudioWritten()
 	{
+		// called by the DSP thread
+		SYNTHLIB_TRACE_THREAD_NAME("DSP");
+		SYNTHLIB_TRACE_SCOPE("Device::onAudioWritten");
+		SYNTHLIB_RT_SCOPE();
+
 		m_mc->getMidiQueue(0).onAudioWritten();
 		m_mc->process();
 	}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "dspSingle.h"
 #include "frontpanelState.h"
 #include "../synthLib/midiTypes.h"
@@ -42,6 +44,16 @@ namespace virusLib
 		uint32_t getInternalLatencyMidiToOutput() const override;
 		uint32_t getInternalLatencyInputToOutput() const override;
 
+		// True if the latencies have been measured for the ROM and the current samplerate, default values are reported
+		// until then
+		bool hasLatencyCalibration() const;
+
+		// Measures the latencies on this device if they are not known yet for the ROM and the current samplerate. The
+		// device needs to be idle, the global state is restored afterwards but notes that are playing are stopped and
+		// the edit buffer is replaced. Any other device that uses the same ROM and samplerate reports the measured
+		// latencies afterwards. The measurement stops early if _cancel is set
+		bool calibrateLatency(bool _force = false, const std::atomic<bool>* _cancel = nullptr);
+
 		uint32_t getChannelCountIn() override;
 		uint32_t getChannelCountOut() override;
 
@@ -2,6 +2,11 @@
 
 #include "dsp56kEmu/dsp.h"
 
+#include "../synthLib/deadlineMonitor.h"
+#include "../synthLib/perfCounters.h"
+#include "../synthLib/rtAudit.h"
+#include "../synthLib/tracer.h"
+
 #if DSP56300_DEBUGGER
 #include "dsp56kDebugger/debugger.h"
 #endif
@@ -95,6 +100,13 @@ namespace virusLib
 			, _outputs[5] ? _outputs[5] : dOut
 			, dOut, dOut, dOut, dOut, dOut, dOut};
 
+		SYNTHLIB_PERF_SCOPE(DspAudioWait);
+		const synthLib::ScopedDspWait dspWait;
+		SYNTHLIB_TRACE_SCOPE("Audio::processAudioInterleaved");
+
+		// by design, the audio thread waits until the DSP thread has produced enough output
+		SYNTHLIB_RT_ALLOW("waiting for DSP output");
+
 		_dsp.getAudio().processAudioInterleaved(inputs, outputs, static_cast<uint32_t>(_samples), _latency);
 	}
 	void DspSingle::processAudio(const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, const size_t _samples, const uint32_t _latency)
@@ -2,6 +2,8 @@
 
 #include "dsp56kEmu/hdi08.h"
 
+#include "../synthLib/perfCounters.h"
+
 namespace virusLib
 {
 	Hdi08Queue::Hdi08Queue(dsp56k::HDI08& _hdi08) : m_hdi08(_hdi08)
@@ -99,5 +101,7 @@ namespace virusLib
 
 			m_dataRX.pop_front();
 		}
+
+		SYNTHLIB_PERF_VALUE(Hdi08QueueDepth, m_dataRX.size());
 	}
 }
@@ -4,9 +4,10 @@
 #include <sstream>
 #include <thread>
 
-#include "microcontroller.h"
 #include "romfile.h"
 
+#include "../synthLib/asyncLog.h"
+
 #include "../dsp56300/source/dsp56kEmu/logging.h"
 
 namespace virusLib
@@ -29,29 +30,29 @@ namespace virusLib
 			{
 				m_remainingPresetBytes = 0;
 				m_state = State::Default;
-				LOG("Finished receiving preset, no upgrade needed");
+				SYNTHLIB_LOG_INFO("Finished receiving preset, no upgrade needed");
 			}
 			else if(_data == 0xf50000)
 			{
 				m_state = State::StatusReport;
-				m_remainingStatusBytes = isABCFamily(m_mc.getROM().getModel()) ? 1 : 2;
+				m_remainingStatusBytes = isABCFamily(m_rom.getModel()) ? 1 : 2;
 			}
 			else if(_data == 0xf400f4)
 			{
 				m_state = State::Preset;
-				LOG("Begin receiving upgraded preset");
+				SYNTHLIB_LOG_INFO("Begin receiving upgraded preset");
 
 				m_presetData.clear();
 
 				if(m_remainingPresetBytes == 0)
 				{
 					m_remainingPresetBytes = std::numeric_limits<uint32_t>::max();
-					LOG("No one requested a preset upgrade, assuming preset size based on first word (version number)");
+					SYNTHLIB_LOG_INFO("No one requested a preset upgrade, assuming preset size based on first word (version number)");
 				}
 			}
 			else if((_data & 0xff0000) == 0xf00000)
 			{
-				LOG("Begin reading sysex");
+				SYNTHLIB_LOG_DEBUG("Begin reading sysex");
 				m_state = State::Sysex;
 				m_sysexData.push_back(byte);
 			}
@@ -80,7 +81,7 @@ namespace virusLib
 							{
 							case PatternType::DspBoot:
 								m_dspHasBooted = true;
-								LOG("DSP boot completed");
+								SYNTHLIB_LOG_INFO("DSP boot completed");
 								break;
 							default:
 								m_matchedPatterns.push_back(p);
@@ -104,7 +105,7 @@ namespace virusLib
 /*					std::stringstream s;
 					for (const auto& w : m_nonPatternWords)
 						s << HEX(w) << ' ';
-					LOG("Unknown DSP words: " << s.str());
+					SYNTHLIB_LOG_WARNING("Unknown DSP words: " << s.str());
 */
 					m_nonPatternWords.clear();
 				}
@@ -114,7 +115,7 @@ namespace virusLib
 			{
 				if(_data & 0xffff)
 				{
-					LOG("Abort reading sysex, received invalid midi byte " << HEX(_data));
+					SYNTHLIB_LOG_WARNING("Abort reading sysex, received invalid midi byte " << HEX(_data));
 					m_state = State::Default;
 					m_midiData.clear();
 					return append(_data);
@@ -124,15 +125,18 @@ namespace virusLib
 
 				if(byte == 0xf7)
 				{
-					LOG("End reading sysex");
+					SYNTHLIB_LOG_DEBUG("End reading sysex");
 
 					m_state = State::Default;
 
+#if SYNTHLIB_LOG_LEVEL <= 0
+					// the hex dump allocates, it is only built if debug messages are compiled in
 					std::stringstream s;
 					for (const auto b : m_sysexData)
 						s << HEXN(b, 2);
 
-					LOG("Received sysex: " << s.str());
+					SYNTHLIB_LOG_DEBUG("Received sysex: " << s.str());
+#endif
 
 					synthLib::SMidiEvent ev;
 					std::swap(ev.sysex, m_sysexData);
@@ -152,13 +156,13 @@ namespace virusLib
 					{
 					case 1:
 					case 2:
-						m_remainingPresetBytes = m_mc.getROM().getMultiPresetSize();
+						m_remainingPresetBytes = m_rom.getMultiPresetSize();
 						break;
 					default:
-						m_remainingPresetBytes = m_mc.getROM().getSinglePresetSize();
+						m_remainingPresetBytes = m_rom.getSinglePresetSize();
 						break;
 					}
-					LOG("Preset size for version code " << static_cast<int>(version) << " is " << m_remainingPresetBytes);
+					SYNTHLIB_LOG_INFO("Preset size for version code " << static_cast<int>(version) << " is " << m_remainingPresetBytes);
 				}
 
 				uint32_t shift = 16;
@@ -173,7 +177,7 @@ namespace virusLib
 
 				if(m_remainingPresetBytes == 0)
 				{
-					LOG("Succesfully received preset");
+					SYNTHLIB_LOG_INFO("Succesfully received preset");
 					m_state = State::Default;
 				}
 			}
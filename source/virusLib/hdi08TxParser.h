@@ -8,7 +8,7 @@
 
 namespace virusLib
 {
-	class Microcontroller;
+	class ROMFile;
 
 	class Hdi08TxParser
 	{
@@ -28,7 +28,7 @@ namespace virusLib
 			Count
 		};
 
-		Hdi08TxParser(Microcontroller& _mc) : m_mc(_mc)
+		explicit Hdi08TxParser(const ROMFile& _rom) : m_rom(_rom)
 		{
 			m_patternPositions.fill(0);
 		}
@@ -51,7 +51,7 @@ namespace virusLib
 		void getPresetData(std::vector<uint8_t>& _data);
 
 	private:
-		Microcontroller& m_mc;
+		const ROMFile& m_rom;
 
 		std::vector<synthLib::SMidiEvent> m_midiData;
 		std::vector<uint8_t> m_sysexData;
@@ -0,0 +1,409 @@
+#include "latencyCalibration.h"
+
+#include <array>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "microcontroller.h"
+#include "microcontrollerTypes.h"
+#include "romfile.h"
+
+#include "../synthLib/asyncLog.h"
+#include "../synthLib/device.h"
+#include "../synthLib/os.h"
+
+namespace virusLib
+{
+	static constexpr const char* g_cacheHeader = "virusLatency 1";
+
+	namespace
+	{
+		constexpr uint32_t g_blockSize = 64;
+		constexpr uint32_t g_trialCount = 8;
+		constexpr uint32_t g_trialOffsetStep = 23;			// varies the event position within a block to average the drift of the MIDI timing
+		constexpr uint32_t g_maxLatency = 8192;				// samples until a measurement is considered to be failed
+		constexpr uint32_t g_maxSilenceWait = 262144;		// samples to wait for the output to decay before a measurement
+		constexpr float g_threshold = 1.0f / 1024.0f;		// roughly -60 dB
+		constexpr uint8_t g_note = 60;
+
+		// Parameters of the init single that is played during the measurement. Anything that delays the onset of a
+		// note, such as envelope attacks, portamento or the arpeggiator, is switched off. Page A indices are 0-127,
+		// page B indices 128-255
+		constexpr std::pair<uint8_t, uint8_t> g_initSingle[] =
+		{
+			{5, 0},				// Portamento Time
+			{17, 64},			// Osc1 Shape: Saw
+			{27, 0},			// Osc2 FM Amount
+			{33, 0},			// Osc Balance: Osc1 only
+			{34, 0},			// Sub Osc Volume
+			{36, 127},			// Osc Mainvolume
+			{37, 0},			// Noise Volume
+			{38, 0},			// Ring Mod Volume
+			{40, 127},			// Cutoff
+			{41, 127},			// Cutoff2
+			{42, 0},			// Filter1 Resonance
+			{43, 0},			// Filter2 Resonance
+			{44, 0},			// Filter1 Env Amount
+			{45, 0},			// Filter2 Env Amount
+			{49, 0},			// Saturation: Off
+			{51, 0},			// Filter1 Mode: Lowpass
+			{54, 0},			// Filter Env Attack
+			{59, 0},			// Amp Env Attack
+			{60, 127},			// Amp Env Decay
+			{61, 127},			// Amp Env Sustain
+			{62, 64},			// Amp Env Sustain Time: flat
+			{63, 0},			// Amp Env Release
+			{91, 100},			// Patch Volume
+			{93, 64},			// Transpose
+			{94, 0},			// Key Mode: Poly
+			{97, 0},			// Unison Mode: Off
+			{105, 0},			// Chorus Mix
+			{112, 0},			// Delay/Reverb Mode: Off
+			{128 + 1, 0},		// Arp Mode: Off
+			{128 + 36, 0},		// Punch Intensity
+			{128 + 60, 64},		// Amp Velocity: none
+			{128 + 64, 0},		// Assign1 Source: Off
+			{128 + 67, 0},		// Assign2 Source: Off
+			{128 + 72, 0},		// Assign3 Source: Off
+			{128 + 84, 0},		// Phaser Mode: Off
+			{128 + 85, 0},		// Phaser Mix
+			{128 + 100, 0},		// Distortion Curve: Off
+			{128 + 103, 0},		// Assign4 Source: Off
+			{128 + 106, 0},		// Assign5 Source: Off
+			{128 + 109, 0},		// Assign6 Source: Off
+		};
+
+		// Starts from the first single of the ROM so that name and all parameters that are not overridden are valid
+		bool createInitSingle(synthLib::SMidiEvent& _ev, const ROMFile& _rom)
+		{
+			ROMFile::TPreset preset;
+			if(!_rom.getSingle(0, 0, preset))
+				return false;
+
+			for (const auto& [index, value] : g_initSingle)
+				preset[index] = value;
+
+			auto& s = _ev.sysex;
+
+			s = {synthLib::M_STARTOFSYSEX, 0x00, 0x20, 0x33, 0x01, OMNI_DEVICE_ID, DUMP_SINGLE, toMidiByte(BankNumber::EditBuffer), SINGLE};
+			s.insert(s.end(), preset.begin(), preset.begin() + ROMFile::getSinglePresetSize());
+			s.push_back(Microcontroller::calcChecksum(s, 5));
+			s.push_back(synthLib::M_ENDOFSYSEX);
+
+			return true;
+		}
+
+		class Measurement
+		{
+		public:
+			Measurement(synthLib::Device& _device, const std::atomic<bool>* _cancel) : m_device(_device), m_cancel(_cancel)
+			{
+				for(size_t i=0; i<m_in.size(); ++i)
+				{
+					m_in[i].resize(g_blockSize, 0.0f);
+					m_inputs[i] = m_in[i].data();
+				}
+
+				m_discard.resize(g_blockSize);
+
+				for (auto& output : m_outputs)
+					output = m_discard.data();
+
+				for(size_t i=0; i<m_out.size(); ++i)
+				{
+					m_out[i].resize(g_blockSize);
+					m_outputs[i] = m_out[i].data();
+				}
+			}
+
+			// returns the position of the first sample of the main output that exceeds the threshold, -1 if there is none
+			int process(const std::vector<synthLib::SMidiEvent>& _midi, const int _clickOffset = -1)
+			{
+				if(_clickOffset >= 0)
+				{
+					for (auto& in : m_in)
+						in[_clickOffset] = 1.0f;
+				}
+
+				m_midiOut.clear();
+				m_device.process(m_inputs, m_outputs, g_blockSize, _midi, m_midiOut);
+
+				if(_clickOffset >= 0)
+				{
+					for (auto& in : m_in)
+						in[_clickOffset] = 0.0f;
+				}
+
+				for(uint32_t i=0; i<g_blockSize; ++i)
+				{
+					for (const auto& out : m_out)
+					{
+						if(std::fabs(out[i]) > g_threshold)
+							return static_cast<int>(i);
+					}
+				}
+				return -1;
+			}
+
+			bool isCancelled() const
+			{
+				return m_cancel && *m_cancel;
+			}
+
+			bool waitForSilence()
+			{
+				const std::vector<synthLib::SMidiEvent> noMidi;
+
+				for(uint32_t i=0; i<g_maxSilenceWait && !isCancelled(); i += g_blockSize)
+				{
+					if(process(noMidi) < 0)
+						return true;
+				}
+				return false;
+			}
+
+			// processes blocks until the output exceeds the threshold, the returned latency is relative to the start
+			// of the first block that is processed
+			bool measureOnset(uint32_t& _latency, const std::vector<synthLib::SMidiEvent>& _midi, const int _clickOffset)
+			{
+				const std::vector<synthLib::SMidiEvent> noMidi;
+
+				for(uint32_t pos=0; pos<g_maxLatency && !isCancelled(); pos += g_blockSize)
+				{
+					const auto onset = pos ? process(noMidi) : process(_midi, _clickOffset);
+
+					if(onset >= 0)
+					{
+						_latency = pos + static_cast<uint32_t>(onset);
+						return true;
+					}
+				}
+				return false;
+			}
+
+		private:
+			synthLib::Device& m_device;
+			const std::atomic<bool>* const m_cancel;
+
+			std::array<std::vector<float>, 2> m_in;
+			std::array<std::vector<float>, 2> m_out;	// main output, left and right
+			std::vector<float> m_discard;
+
+			synthLib::TAudioInputs m_inputs{};
+			synthLib::TAudioOutputs m_outputs{};
+
+			std::vector<synthLib::SMidiEvent> m_midiOut;
+		};
+
+		bool measureMidiToOutput(uint32_t& _latency, Measurement& _m)
+		{
+			uint32_t sum = 0;
+
+			for(uint32_t t=0; t<g_trialCount; ++t)
+			{
+				if(!_m.waitForSilence())
+					return false;
+
+				const auto offset = (t * g_trialOffsetStep) % g_blockSize;
+
+				uint32_t onset;
+				if(!_m.measureOnset(onset, {synthLib::SMidiEvent(synthLib::M_NOTEON, g_note, 127, offset)}, -1) || onset < offset)
+					return false;
+
+				sum += onset - offset;
+
+				_m.process({synthLib::SMidiEvent(synthLib::M_NOTEOFF, g_note, 0)});
+			}
+
+			_latency = (sum + g_trialCount / 2) / g_trialCount;
+			return true;
+		}
+
+		bool measureInputToOutput(uint32_t& _latency, Measurement& _m)
+		{
+			// the input thru level routes the inputs straight to the main output, regardless of the patch
+
+			const std::vector<uint8_t> inputThru{synthLib::M_STARTOFSYSEX, 0x00, 0x20, 0x33, 0x01, OMNI_DEVICE_ID, PAGE_C, 0x00, INPUT_THRU_LEVEL, 0x7f, synthLib::M_ENDOFSYSEX};
+
+			synthLib::SMidiEvent ev;
+			ev.sysex = inputThru;
+
+			_m.process({ev});
+
+			uint32_t sum = 0;
+
+			for(uint32_t t=0; t<g_trialCount; ++t)
+			{
+				if(!_m.waitForSilence())
+					return false;
+
+				const auto offset = (t * g_trialOffsetStep) % g_blockSize;
+
+				uint32_t onset;
+				if(!_m.measureOnset(onset, {}, static_cast<int>(offset)) || onset < offset)
+					return false;
+
+				sum += onset - offset;
+			}
+
+			_latency = (sum + g_trialCount / 2) / g_trialCount;
+			return true;
+		}
+	}
+
+	LatencyCalibration::LatencyCalibration(std::string _filename) : m_filename(std::move(_filename))
+	{
+		load();
+	}
+
+	bool LatencyCalibration::find(Result& _result, const synthLib::MD5& _romHash, const float _samplerate)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_entries.find(createKey(_romHash, _samplerate));
+		if(it == m_entries.end())
+			return false;
+
+		_result = it->second;
+		return true;
+	}
+
+	void LatencyCalibration::set(const synthLib::MD5& _romHash, const float _samplerate, const Result& _result)
+	{
+		std::lock_guard lock(m_mutex);
+		m_entries[createKey(_romHash, _samplerate)] = _result;
+		m_dirty = true;
+	}
+
+	bool LatencyCalibration::save()
+	{
+		std::lock_guard lock(m_mutex);
+
+		if(!m_dirty)
+			return true;
+
+		std::stringstream file;
+
+		file << g_cacheHeader << '\n';
+
+		for (const auto& it : m_entries)
+		{
+			const auto& r = it.second;
+			file << it.first.first.toString() << '\t' << it.first.second << '\t' << r.midiToOutput << '\t' << r.inputToOutput << '\n';
+		}
+
+		const auto str = file.str();
+
+		if(!synthLib::writeFile(m_filename, reinterpret_cast<const uint8_t*>(str.c_str()), str.size()))
+			return false;
+
+		m_dirty = false;
+		return true;
+	}
+
+	LatencyCalibration& LatencyCalibration::instance()
+	{
+		static LatencyCalibration cache(synthLib::getCacheDirectory() + "virusLatency.txt");
+		return cache;
+	}
+
+	bool LatencyCalibration::measure(Result& _result, synthLib::Device& _device, const ROMFile& _rom, const std::atomic<bool>* _cancel/* = nullptr*/)
+	{
+#if SYNTHLIB_DEMO_MODE
+		return false;
+#else
+		std::vector<uint8_t> globalState;
+		if(!_device.getState(globalState, synthLib::StateTypeGlobal))
+			return false;
+
+		const auto extraLatency = _device.getExtraLatencySamples();
+		_device.setExtraLatencySamples(0);
+
+		synthLib::SMidiEvent initSingle;
+		if(!createInitSingle(initSingle, _rom))
+			return false;
+
+		Measurement m(_device, _cancel);
+
+		// the patch that the device booted with may have a slow attack or an arpeggiator, which would end up in the
+		// measured latency
+		m.process({initSingle});
+
+		Result r;
+		const auto success = measureMidiToOutput(r.midiToOutput, m) && measureInputToOutput(r.inputToOutput, m);
+
+		m.process({synthLib::SMidiEvent(synthLib::M_CONTROLCHANGE, synthLib::MC_ALLNOTESOFF, 0)});
+
+		_device.setState(globalState, synthLib::StateTypeGlobal);
+		_device.setExtraLatencySamples(extraLatency);
+
+		if(m.isCancelled())
+		{
+			SYNTHLIB_LOG_INFO("Latency calibration at " << _device.getSamplerate() << " Hz cancelled");
+			return false;
+		}
+
+		if(!success)
+		{
+			SYNTHLIB_LOG_WARNING("Latency calibration failed at " << _device.getSamplerate() << " Hz");
+			return false;
+		}
+
+		SYNTHLIB_LOG_INFO("Latency calibration at " << _device.getSamplerate() << " Hz: MIDI to output " << r.midiToOutput << " samples, input to output " << r.inputToOutput << " samples");
+
+		_result = r;
+		return true;
+#endif
+	}
+
+	bool LatencyCalibration::load()
+	{
+		std::vector<uint8_t> data;
+		if(!synthLib::readFile(data, m_filename))
+			return false;
+
+		std::stringstream file(std::string(data.begin(), data.end()));
+
+		std::string line;
+
+		if(!std::getline(file, line) || line != g_cacheHeader)
+			return false;
+
+		while(std::getline(file, line))
+		{
+			std::stringstream ss(line);
+
+			std::string hash, samplerate, midiToOutput, inputToOutput;
+
+			if(!std::getline(ss, hash, '\t') || !std::getline(ss, samplerate, '\t') || !std::getline(ss, midiToOutput, '\t') || !std::getline(ss, inputToOutput, '\t'))
+				continue;
+
+			Key key;
+			Result r;
+
+			try
+			{
+				key.second = static_cast<uint32_t>(std::stoul(samplerate));
+				r.midiToOutput = static_cast<uint32_t>(std::stoul(midiToOutput));
+				r.inputToOutput = static_cast<uint32_t>(std::stoul(inputToOutput));
+			}
+			catch(const std::exception&)
+			{
+				continue;
+			}
+
+			if(!key.first.fromString(hash))
+				continue;
+
+			m_entries.insert({key, r});
+		}
+
+		return true;
+	}
+
+	LatencyCalibration::Key LatencyCalibration::createKey(const synthLib::MD5& _romHash, const float _samplerate)
+	{
+		return {_romHash, static_cast<uint32_t>(std::lround(_samplerate))};
+	}
+}
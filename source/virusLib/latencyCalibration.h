@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "../synthLib/md5.h"
+
+namespace synthLib
+{
+	class Device;
+}
+
+namespace virusLib
+{
+	class ROMFile;
+
+	// Measures the MIDI to output and input to output latency of a booted device and caches the results per ROM and
+	// device samplerate. The latencies are internal to the device, they do not depend on the resampling that is done by
+	// the plugin, the resampler reports its own latency
+	class LatencyCalibration
+	{
+	public:
+		struct Result
+		{
+			uint32_t midiToOutput = 0;
+			uint32_t inputToOutput = 0;
+		};
+
+		explicit LatencyCalibration(std::string _filename);
+
+		bool find(Result& _result, const synthLib::MD5& _romHash, float _samplerate);
+		void set(const synthLib::MD5& _romHash, float _samplerate, const Result& _result);
+
+		bool save();
+
+		static LatencyCalibration& instance();
+
+		// Loads an init single from the ROM, plays notes and sends clicks through the input, measuring the time until
+		// they appear at the output. Modifies the global state of the device and restores it afterwards, the edit buffer
+		// keeps the init single. Returns false if any of the measurements failed or _cancel has been set
+		static bool measure(Result& _result, synthLib::Device& _device, const ROMFile& _rom, const std::atomic<bool>* _cancel = nullptr);
+
+	private:
+		using Key = std::pair<synthLib::MD5, uint32_t>;
+
+		bool load();
+
+		static Key createKey(const synthLib::MD5& _romHash, float _samplerate);
+
+		const std::string m_filename;
+
+		std::mutex m_mutex;
+		std::map<Key, Result> m_entries;
+		bool m_dirty = false;
+	};
+}
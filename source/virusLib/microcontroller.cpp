@@ -7,7 +7,10 @@
 
 #include "dspSingle.h"
 #include "frontpanelState.h"
+#include "../synthLib/asyncLog.h"
 #include "../synthLib/midiTypes.h"
+#include "../synthLib/perfCounters.h"
+#include "../synthLib/tracer.h"
 
 using namespace dsp56k;
 using namespace synthLib;
@@ -106,7 +109,7 @@ void Microcontroller::sendInitControlCommands(uint8_t _masterVolume)
 {
 	writeHostBitsWithWait(0, 1);
 
-	LOG("Sending Init Control Commands");
+	SYNTHLIB_LOG_INFO("Sending Init Control Commands");
 
 	sendControlCommand(MIDI_CLOCK_RX, 0x1);											// Enable MIDI clock receive
 	sendControlCommand(GLOBAL_CHANNEL, 0x0);										// Set global midi channel to 0
@@ -200,7 +203,7 @@ bool Microcontroller::sendPreset(const uint8_t program, const TPreset& preset, c
 
 	m_hdi08.writeRX(presetToDSPWords(preset, isMulti));
 
-	LOG("Send to DSP: " << (isMulti ? "Multi" : "Single") << " to program " << static_cast<int>(program));
+	SYNTHLIB_LOG_INFO("Send to DSP: " << (isMulti ? "Multi" : "Single") << " to program " << static_cast<int>(program));
 
 	for (auto& parser : m_hdi08TxParsers)
 		parser.waitForPreset(isMulti ? m_rom.getMultiPresetSize() : m_rom.getSinglePresetSize());
@@ -504,7 +507,7 @@ bool Microcontroller::sendSysex(const std::vector<uint8_t>& _data, std::vector<S
 			{
 				const auto bank = fromMidiByte(_data[7]);
 				const uint8_t program = _data[8];
-				LOG("Received Single dump, Bank " << (int)toMidiByte(bank) << ", program " << (int)program);
+				SYNTHLIB_LOG_INFO("Received Single dump, Bank " << (int)toMidiByte(bank) << ", program " << (int)program);
 				TPreset preset;
 				preset.fill(0);
 				std::copy_n(_data.data() + g_sysexPresetHeaderSize, std::min(preset.size(), _data.size() - g_sysexPresetHeaderSize - g_sysexPresetFooterSize), preset.begin());
@@ -514,7 +517,7 @@ bool Microcontroller::sendSysex(const std::vector<uint8_t>& _data, std::vector<S
 			{
 				const auto bank = fromMidiByte(_data[7]);
 				const uint8_t program = _data[8];
-				LOG("Received Multi dump, Bank " << (int)toMidiByte(bank) << ", program " << (int)program);
+				SYNTHLIB_LOG_INFO("Received Multi dump, Bank " << (int)toMidiByte(bank) << ", program " << (int)program);
 				TPreset preset;
 				std::copy_n(_data.data() + g_sysexPresetHeaderSize, std::min(preset.size(), _data.size() - g_sysexPresetHeaderSize - g_sysexPresetFooterSize), preset.begin());
 				return writeMulti(bank, program, preset);
@@ -525,7 +528,7 @@ bool Microcontroller::sendSysex(const std::vector<uint8_t>& _data, std::vector<S
 				if(!m_pendingPresetWrites.empty() || bank == BankNumber::EditBuffer && waitingForPresetReceiveConfirmation())
 					return enqueue();
 				const uint8_t program = _data[8];
-				LOG("Request Single, Bank " << (int)toMidiByte(bank) << ", program " << (int)program);
+				SYNTHLIB_LOG_INFO("Request Single, Bank " << (int)toMidiByte(bank) << ", program " << (int)program);
 				buildSingleResponse(bank, program);
 				break;
 			}
@@ -535,7 +538,7 @@ bool Microcontroller::sendSysex(const std::vector<uint8_t>& _data, std::vector<S
 				if(!m_pendingPresetWrites.empty() || bank == BankNumber::EditBuffer && waitingForPresetReceiveConfirmation())
 					return enqueue();
 				const uint8_t program = _data[8];
-				LOG("Request Multi, Bank " << (int)bank << ", program " << (int)program);
+				SYNTHLIB_LOG_INFO("Request Multi, Bank " << (int)bank << ", program " << (int)program);
 				buildMultiResponse(bank, program);
 				break;
 			}
@@ -594,7 +597,7 @@ bool Microcontroller::sendSysex(const std::vector<uint8_t>& _data, std::vector<S
 					{
 					case PlayModeSingle:
 						{
-							LOG("Switch to Single mode");
+							SYNTHLIB_LOG_INFO("Switch to Single mode");
 							return writeSingle(BankNumber::EditBuffer, SINGLE, m_singleEditBuffer);
 						}
 					case PlayModeMultiSingle:
@@ -658,7 +661,7 @@ bool Microcontroller::sendSysex(const std::vector<uint8_t>& _data, std::vector<S
 				return send(page, part, param, value);
 			}
 		default:
-			LOG("Unknown sysex command " << HEXN(cmd, 2));
+			SYNTHLIB_LOG_WARNING("Unknown sysex command " << HEXN(cmd, 2));
 	}
 
 	return true;
@@ -779,7 +782,7 @@ bool Microcontroller::writeSingle(BankNumber _bank, uint8_t _program, const TPre
 	if(_program >= m_singleEditBuffers.size() && _program != SINGLE)
 		return false;
 
-	LOG("Loading Single " << ROMFile::getSingleName(_data) << " to part " << static_cast<int>(_program));
+	SYNTHLIB_LOG_INFO("Loading Single " << ROMFile::getSingleName(_data) << " to part " << static_cast<int>(_program));
 
 	// Send to DSP
 	return sendPreset(_program, _data, false);
@@ -795,11 +798,11 @@ bool Microcontroller::writeMulti(BankNumber _bank, uint8_t _program, const TPres
 
 	if (_bank != BankNumber::EditBuffer) 
 	{
-		LOG("We do not support writing to RAM or ROM, attempt to write multi to bank " << static_cast<int>(toMidiByte(_bank)) << ", program " << static_cast<int>(_program));
+		SYNTHLIB_LOG_WARNING("We do not support writing to RAM or ROM, attempt to write multi to bank " << static_cast<int>(toMidiByte(_bank)) << ", program " << static_cast<int>(_program));
 		return true;
 	}
 
-	LOG("Loading Multi " << ROMFile::getMultiName(_data));
+	SYNTHLIB_LOG_INFO("Loading Multi " << ROMFile::getMultiName(_data));
 
 	// Convert array of uint8_t to vector of 24bit TWord
 	return sendPreset(_program, _data, true);
@@ -882,6 +885,9 @@ bool Microcontroller::loadMultiSingle(uint8_t _part, const TPreset& _multi)
 
 void Microcontroller::process()
 {
+	SYNTHLIB_PERF_SCOPE(MicrocontrollerProcess);
+	SYNTHLIB_TRACE_SCOPE("Microcontroller::process");
+
 	m_hdi08.exec();
 
 	std::lock_guard lock(m_mutex);
@@ -978,7 +984,7 @@ bool Microcontroller::setState(const std::vector<synthLib::SMidiEvent>& _events)
 void Microcontroller::addDSP(DspSingle& _dsp, bool _useEsaiBasedMidiTiming)
 {
 	m_hdi08.addHDI08(_dsp.getHDI08());
-	m_hdi08TxParsers.emplace_back(*this);
+	m_hdi08TxParsers.emplace_back(m_rom);
 	m_midiQueues.emplace_back(_dsp, m_hdi08.getQueue(m_hdi08.size()-1), _useEsaiBasedMidiTiming);
 }
 
@@ -1149,7 +1155,7 @@ void Microcontroller::receiveUpgradedPreset()
 	if(upgradedPreset.empty())
 		return;
 
-	LOG("Replacing edit buffer for " << (m_sentPresetIsMulti ? "multi" : "single") << " program " << static_cast<int>(m_sentPresetProgram) << " with upgraded preset");
+	SYNTHLIB_LOG_INFO("Replacing edit buffer for " << (m_sentPresetIsMulti ? "multi" : "single") << " program " << static_cast<int>(m_sentPresetProgram) << " with upgraded preset");
 
 	auto copyTo = [&upgradedPreset, this](TPreset& _preset)
 	{
@@ -2,28 +2,50 @@
 
 #include "dsp56kEmu/logging.h"
 
-#include "../synthLib/os.h"
 #include "../synthLib/midiToSysex.h"
 
 namespace virusLib
 {
 	bool MidiFileToRomData::load(const std::string& _filename)
 	{
-		std::vector<uint8_t> sysex;
+		synthLib::MidiFileParser parser;
 
-		if(!synthLib::MidiToSysex::readFile(sysex, _filename.c_str()))
+		bool res = false;
+
+		// stream the file, packets are processed directly from the mapped file without copying them
+		if(!parser.parseFile(_filename, [&](const synthLib::MidiFileParser::Event& _e)
+		{
+			if(!_e.isSysex())
+				return true;
+
+			if(!add(_e.getSysex()))
+				return false;
+
+			res = isComplete();
+			return !res;
+		}))
+		{
+			LOG("Failed to read MIDI file " << _filename);
 			return false;
+		}
 
-		return load(sysex);
+		return res;
 	}
 
 	bool MidiFileToRomData::load(const std::vector<uint8_t>& _fileData, bool _isMidiFileData/* = false*/)
 	{
-		std::vector<std::vector<uint8_t>> packets;
+		std::vector<synthLib::SysexSpan> packets;
 
-		synthLib::MidiToSysex::splitMultipleSysex(packets, _fileData, _isMidiFileData);
+		synthLib::MidiToSysex::splitMultipleSysex(packets, _fileData.data(), _fileData.size(), _isMidiFileData);
 
-		return add(packets);
+		for (const auto& packet : packets)
+		{
+			if(!add(packet))
+				return false;
+			if(isComplete())
+				return true;
+		}
+		return false;
 	}
 
 	bool MidiFileToRomData::add(const std::vector<Packet>& _packets)
@@ -39,6 +61,11 @@ namespace virusLib
 	}
 
 	bool MidiFileToRomData::add(const Packet& _packet)
+	{
+		return add(synthLib::SysexSpan::fromMessage(_packet.data(), _packet.size()));
+	}
+
+	bool MidiFileToRomData::add(const synthLib::SysexSpan& _packet)
 	{
 		if(isComplete())
 			return isValid();
@@ -86,36 +113,38 @@ namespace virusLib
 	bool MidiFileToRomData::setCompleted()
 	{
 		m_complete = true;
-		if(!toBinary(m_data))
+		if(!m_binaryValid)
 			m_valid = false;
+		else
+			m_data = std::move(m_binary);
 		return isComplete();
 	}
 
-	bool MidiFileToRomData::toBinary(std::vector<uint8_t>& _binary) const
+	void MidiFileToRomData::addPacket(const synthLib::SysexSpan& _packet)
 	{
-		if(!isComplete())
-			return false;
+		++m_packetCount;
 
-		for (const auto& p : m_packets)
+		if(!m_binaryValid)
+			return;
+
+		// midi bytes in a sysex frame can only carry 7 bit, not 8. They've chosen the easy way that costs more storage
+		// They transfer only one nibble of a ROM byte in one midi byte to ensure that the most significant nibble is
+		// always zero. By concating two nibbles together we get one ROM byte
+		for(size_t s=8; s<_packet.size()-2; s += 2)
 		{
-			// midi bytes in a sysex frame can only carry 7 bit, not 8. They've chosen the easy way that costs more storage
-			// They transfer only one nibble of a ROM byte in one midi byte to ensure that the most significant nibble is
-			// always zero. By concating two nibbles together we get one ROM byte
-			for(size_t s=8; s<p.size()-2; s += 2)
+			const uint8_t a = _packet[s];
+			const uint8_t b = _packet[s+1];
+			if(a > 0xf || b > 0xf)
 			{
-				const uint8_t a = p[s];
-				const uint8_t b = p[s+1];
-				if(a > 0xf || b > 0xf)
-				{
-					LOG("Invalid data, high nibble must be 0");
-					return false;
-				}
-				_binary.push_back(static_cast<uint8_t>(b << 4) | a);
+				LOG("Invalid data, high nibble must be 0");
+				m_binaryValid = false;
+				return;
 			}
+			m_binary.push_back(static_cast<uint8_t>(b << 4) | a);
 		}
-		return true;
 	}
-	bool MidiFileToRomData::processPacket(const Packet& _packet, uint8_t msb, uint8_t lsb)
+
+	bool MidiFileToRomData::processPacket(const synthLib::SysexSpan& _packet, uint8_t msb, uint8_t lsb)
 	{
 //		LOG("Got Packet " << static_cast<int>(msb) << " " << static_cast<int>(lsb) << ", size " << _packet.size());
 
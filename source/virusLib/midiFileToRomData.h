@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "../synthLib/midiFileParser.h"
+
 namespace virusLib
 {
 	class MidiFileToRomData
@@ -20,28 +22,26 @@ namespace virusLib
 
 		bool add(const std::vector<Packet>& _packets);
 		bool add(const Packet& _packet);
+		bool add(const synthLib::SysexSpan& _packet);
 
 		bool isValid() const { return m_valid; }
 		bool isComplete() const { return isValid() && m_complete; }
 
 		const std::vector<uint8_t>& getData() const { return m_data; }
 
-		size_t getPacketCount() const { return m_packets.size(); }
+		size_t getPacketCount() const { return m_packetCount; }
 
 		uint8_t getFirstSector() const { return m_firstSector; }
 		
 	private:
-		void addPacket(const Packet& _packet)
-		{
-			m_packets.push_back(_packet);
-		}
+		void addPacket(const synthLib::SysexSpan& _packet);
 		bool setCompleted();
 
-		bool processPacket(const Packet& _packet, uint8_t _msb, uint8_t _lsb);
-
-		bool toBinary(std::vector<uint8_t>& _binary) const;
+		bool processPacket(const synthLib::SysexSpan& _packet, uint8_t _msb, uint8_t _lsb);
 
-		std::vector<Packet> m_packets;
+		size_t m_packetCount = 0;
+		std::vector<uint8_t> m_binary;	// data of packets received so far, becomes m_data once complete
+		bool m_binaryValid = true;
 		std::vector<uint8_t> m_data;
 
 		bool m_valid = true;
@@ -0,0 +1,94 @@
+#include "romcache.h"
+
+#include <algorithm>
+
+#include "../synthLib/os.h"
+
+namespace virusLib
+{
+	std::mutex ROMCache::m_mutex;
+	std::map<std::string, std::vector<ROMCache::Entry>> ROMCache::m_entries;
+
+	std::vector<ROMFile> ROMCache::get(const std::vector<std::string>& _files, const DeviceModel _model, const TLoadFunc& _load)
+	{
+		std::string key;
+
+		if(!createKey(key, _files, _model))
+			return _load();
+
+		std::lock_guard lock(m_mutex);
+
+		prune();
+
+		const auto it = m_entries.find(key);
+
+		if(it != m_entries.end())
+		{
+			std::vector<ROMFile> roms;
+			roms.reserve(it->second.size());
+
+			for (const auto& e : it->second)
+			{
+				auto image = e.image.lock();
+				if(!image)
+					break;
+				roms.emplace_back(e.filename, e.model, e.hash, std::move(image));
+			}
+
+			if(roms.size() == it->second.size())
+				return roms;
+
+			// an image has been released after pruning, reload all of them
+			m_entries.erase(it);
+		}
+
+		auto roms = _load();
+
+		auto& entry = m_entries[key];
+		entry.reserve(roms.size());
+
+		for (const auto& rom : roms)
+			entry.push_back({rom.getFilename(), rom.getModel(), rom.getHash(), rom.getLazyImage()});
+
+		return roms;
+	}
+
+	void ROMCache::prune()
+	{
+		// Entries are removed as soon as one of their images has been released. This includes entries of files that
+		// have changed on disk, their key is never looked up again
+		for(auto it = m_entries.begin(); it != m_entries.end();)
+		{
+			const auto& entries = it->second;
+
+			const bool expired = entries.empty() || std::any_of(entries.begin(), entries.end(), [](const Entry& _e)
+			{
+				return _e.image.expired();
+			});
+
+			if(expired)
+				it = m_entries.erase(it);
+			else
+				++it;
+		}
+	}
+
+	bool ROMCache::createKey(std::string& _key, const std::vector<std::string>& _files, const DeviceModel _model)
+	{
+		_key = std::to_string(static_cast<int>(_model));
+
+		for (const auto& file : _files)
+		{
+			size_t size = 0;
+			uint64_t lastModified = 0;
+
+			if(!synthLib::getFileInfo(file, size, lastModified))
+				return false;
+
+			_key += '\n';
+			_key += file;
+			_key += '|' + std::to_string(size) + '|' + std::to_string(lastModified);
+		}
+		return true;
+	}
+}
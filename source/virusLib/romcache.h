@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "romfile.h"
+
+namespace virusLib
+{
+	// Process-wide registry of parsed ROM images. A lookup is identified by the set of candidate files, including their
+	// size and modification time, so any change on disk causes the files to be loaded again.
+	// Images are refcounted, the registry does not keep them alive once the last ROMFile referencing them is gone
+	class ROMCache
+	{
+		struct Entry
+		{
+			std::string filename;
+			DeviceModel model;
+			synthLib::MD5 hash;
+			std::weak_ptr<ROMFile::LazyImage> image;
+		};
+
+	public:
+		using TLoadFunc = std::function<std::vector<ROMFile>()>;
+
+		static std::vector<ROMFile> get(const std::vector<std::string>& _files, DeviceModel _model, const TLoadFunc& _load);
+
+	private:
+		static void prune();
+		static bool createKey(std::string& _key, const std::vector<std::string>& _files, DeviceModel _model);
+
+		static std::mutex m_mutex;
+		static std::map<std::string, std::vector<Entry>> m_entries;
+	};
+}
@@ -1,8 +1,6 @@
-#include <fstream>
 #include <algorithm>
 
 #include "romfile.h"
-#include "utils.h"
 
 #include "../dsp56300/source/dsp56kEmu/dsp.h"
 #include "../dsp56300/source/dsp56kEmu/logging.h"
@@ -16,30 +14,102 @@
 namespace virusLib
 {
 
-ROMFile::ROMFile(std::vector<uint8_t> _data, std::string _name, const DeviceModel _model/* = DeviceModel::ABC*/) : m_model(_model), m_romFileName(std::move(_name)), m_romFileData(std::move(_data))
+const std::shared_ptr<const ROMFile::Image>& ROMFile::LazyImage::get() const
 {
-	if(initialize())
+	std::call_once(m_once, [this]
+	{
+		if(m_load)
+			m_image = m_load();
+	});
+	return m_image;
+}
+
+ROMFile::ROMFile(std::vector<uint8_t> _data, std::string _name, const DeviceModel _model/* = DeviceModel::ABC*/)
+	: ROMFile(createImage(std::move(_data), std::move(_name), _model))
+{
+}
+
+ROMFile::ROMFile(std::shared_ptr<const synthLib::MemoryMappedFile> _mappedFile, std::string _name, const DeviceModel _model/* = DeviceModel::ABC*/)
+	: ROMFile(createImage(std::move(_mappedFile), std::move(_name), _model))
+{
+}
+
+ROMFile::ROMFile(std::shared_ptr<const Image> _image)
+{
+	if(!isValid(_image.get()))
 		return;
-	m_romFileData.clear();
-	bootRom.size = 0;
+
+	m_filename = _image->filename;
+	m_model = _image->model;
+	m_hash = _image->hash;
+	m_image = std::make_shared<LazyImage>(std::move(_image));
+}
+
+ROMFile::ROMFile(std::string _name, const DeviceModel _model, const synthLib::MD5& _hash, std::shared_ptr<LazyImage> _image)
+	: m_filename(std::move(_name))
+	, m_model(_model)
+	, m_hash(_hash)
+	, m_image(std::move(_image))
+{
+}
+
+std::shared_ptr<const ROMFile::Image> ROMFile::createImage(std::vector<uint8_t> _data, std::string _name, const DeviceModel _model)
+{
+	auto image = std::make_shared<Image>();
+
+	image->filename = std::move(_name);
+	image->model = _model;
+	image->ownedData = std::move(_data);
+
+	if(!initialize(*image))
+	{
+		image->ownedData.clear();
+		image->bootRom.size = 0;
+	}
+
+	return image;
+}
+
+std::shared_ptr<const ROMFile::Image> ROMFile::createImage(std::shared_ptr<const synthLib::MemoryMappedFile> _mappedFile, std::string _name, const DeviceModel _model)
+{
+	auto image = std::make_shared<Image>();
+
+	image->filename = std::move(_name);
+	image->model = _model;
+	image->mappedFile = std::move(_mappedFile);
+
+	if(!initialize(*image))
+	{
+		image->mappedFile.reset();
+		image->bootRom.size = 0;
+	}
+
+	return image;
 }
 
 ROMFile ROMFile::invalid()
 {
-	return ROMFile({}, {}, DeviceModel::Invalid);
+	return ROMFile(std::shared_ptr<const Image>());
 }
 
-bool ROMFile::initialize()
+bool ROMFile::initialize(Image& _image)
 {
-	const std::unique_ptr<std::istream> dsp(new imemstream(reinterpret_cast<std::vector<char>&>(m_romFileData)));
-	
-	const auto chunks = readChunks(*dsp);
+	const auto chunks = readChunks(_image);
 
 	if (chunks.empty())
 		return false;
 
+	if(chunks[0].items.size() < 2)
+		return false;
+
+	auto& bootRom = _image.bootRom;
+
 	bootRom.size = chunks[0].items[0];
 	bootRom.offset = chunks[0].items[1];
+
+	if(bootRom.size + 2 > chunks[0].items.size())
+		return false;
+
 	bootRom.data = std::vector<uint32_t>(bootRom.size);
 
 	// The first chunk contains the bootrom
@@ -53,21 +123,23 @@ bool ROMFile::initialize()
 	for (size_t j = 0; j < chunks.size(); j++)
 	{
 		for (; i < chunks[j].items.size(); i++)
-			m_commandStream.emplace_back(chunks[j].items[i]);
+			_image.commandStream.emplace_back(chunks[j].items[i]);
 		i = 0;
 	}
 
+	_image.hash = synthLib::MD5(_image.data(), _image.size());
+
 	printf("Program BootROM size = 0x%x\n", bootRom.size);
 	printf("Program BootROM offset = 0x%x\n", bootRom.offset);
-	printf("Program CommandStream size = 0x%x\n", static_cast<uint32_t>(m_commandStream.size()));
+	printf("Program CommandStream size = 0x%x\n", static_cast<uint32_t>(_image.commandStream.size()));
 
 	return true;
 }
 
-std::vector<ROMFile::Chunk> ROMFile::readChunks(std::istream& _file)
+std::vector<ROMFile::Chunk> ROMFile::readChunks(Image& _image)
 {
-	_file.seekg(0, std::ios_base::end);
-	const auto fileSize = _file.tellg();
+	const auto* data = _image.data();
+	const auto fileSize = _image.size();
 
 	uint32_t offset = 0x18000;
 	int lastChunkId = 4;
@@ -75,7 +147,7 @@ std::vector<ROMFile::Chunk> ROMFile::readChunks(std::istream& _file)
 	if (fileSize == getRomSizeModelABC() || fileSize == getRomSizeModelABC()/2)	// the latter is a ROM without presets
 	{
 		// ABC
-		m_model = DeviceModel::C;
+		_image.model = DeviceModel::C;
 	}
 	else 
 	{
@@ -89,18 +161,18 @@ std::vector<ROMFile::Chunk> ROMFile::readChunks(std::istream& _file)
 	// Read all the chunks
 	for (int i = 0; i <= lastChunkId; i++)
 	{
-		_file.seekg(offset);
+		if(offset + 3 > fileSize)
+			return {};
 
 		// Read buffer
 		Chunk chunk;
-		//file.read(reinterpret_cast<char *>(&chunk->chunk_id), 1);
-		_file.read(reinterpret_cast<char*>(&chunk.chunk_id), 1);
-		_file.read(reinterpret_cast<char*>(&chunk.size1), 1);
-		_file.read(reinterpret_cast<char*>(&chunk.size2), 1);
+		chunk.chunk_id = data[offset];
+		chunk.size1 = data[offset + 1];
+		chunk.size2 = data[offset + 2];
 
 		if(i == 0 && chunk.chunk_id == 3 && lastChunkId == 4)	// Virus A has one chunk less
 		{
-			m_model = DeviceModel::A;
+			_image.model = DeviceModel::A;
 			lastChunkId = 3;
 		}
 
@@ -110,14 +182,17 @@ std::vector<ROMFile::Chunk> ROMFile::readChunks(std::istream& _file)
 		// Format uses a special kind of size where the first byte should be decreased by 1
 		const uint16_t len = ((chunk.size1 - 1) << 8) | chunk.size2;
 
-		for (uint32_t j = 0; j < len; j++)
-		{
-			uint8_t buf[3];
-			_file.read(reinterpret_cast<char*>(buf), 3);
+		if(offset + 3 + len * 3 > fileSize)
+			return {};
+
+		chunk.items.reserve(len);
+
+		const auto* buf = &data[offset + 3];
+
+		for (uint32_t j = 0; j < len; j++, buf += 3)
 			chunk.items.emplace_back((buf[0] << 16) | (buf[1] << 8) | buf[2]);
-		}
 
-		chunks.emplace_back(chunk);
+		chunks.emplace_back(std::move(chunk));
 
 		offset += 0x8000;
 	}
@@ -125,8 +200,25 @@ std::vector<ROMFile::Chunk> ROMFile::readChunks(std::istream& _file)
 	return chunks;
 }
 
+bool ROMFile::load() const
+{
+	return isValid() && isValid(m_image->get().get());
+}
+
+std::shared_ptr<const ROMFile::Image> ROMFile::getImage() const
+{
+	return m_image ? m_image->get() : nullptr;
+}
+
 std::thread ROMFile::bootDSP(dsp56k::DSP& dsp, dsp56k::HDI08& _hdi08) const
 {
+	auto image = getImage();
+
+	if(!isValid(image.get()))
+		return {};
+
+	const auto& bootRom = image->bootRom;
+
 	// Load BootROM in DSP memory
 	for (uint32_t i=0; i<bootRom.data.size(); i++)
 	{
@@ -138,9 +230,9 @@ std::thread ROMFile::bootDSP(dsp56k::DSP& dsp, dsp56k::HDI08& _hdi08) const
 //	dsp.memory().saveAssembly((m_file + "_BootROM.asm").c_str(), bootRom.offset, bootRom.size, false, false, &periph);
 
 	// Attach command stream
-	std::thread feedCommandStream([&]()
+	std::thread feedCommandStream([image = std::move(image), &_hdi08]()
 	{
-		_hdi08.writeRX(m_commandStream);
+		_hdi08.writeRX(image->commandStream);
 	});
 
 	// Initialize the DSP
@@ -167,13 +259,22 @@ bool ROMFile::getMulti(const int _presetNumber, TPreset& _out) const
 
 bool ROMFile::getPreset(const uint32_t _offset, TPreset& _out) const
 {
-	if(_offset + getSinglePresetSize() > m_romFileData.size())
+	const auto image = getImage();
+
+	if(!image || _offset + getSinglePresetSize() > image->size())
 		return false;
 
-	memcpy(_out.data(), &m_romFileData[_offset], getSinglePresetSize());
+	memcpy(_out.data(), &image->data()[_offset], getSinglePresetSize());
 	return true;
 }
 
+const std::vector<uint8_t>& ROMFile::getDemoData() const
+{
+	static const std::vector<uint8_t> g_empty;
+	const auto* image = m_image ? m_image->get().get() : nullptr;
+	return image ? image->demoData : g_empty;
+}
+
 std::string ROMFile::getSingleName(const TPreset& _preset)
 {
 	return getPresetName(_preset, 240, 249);
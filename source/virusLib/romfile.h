@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <string>
@@ -7,6 +10,7 @@
 #include "dsp56kEmu/types.h"
 
 #include "../synthLib/md5.h"
+#include "../synthLib/memoryMappedFile.h"
 
 #include "deviceModel.h"
 
@@ -38,7 +42,51 @@ public:
 
 	using TPreset = std::array<uint8_t, 512>;
 
+	// Parsed content of a ROM. Never modified after creation and shared between all ROMFile instances that refer to the same file(s)
+	struct Image
+	{
+		std::string filename;
+		DeviceModel model = DeviceModel::Invalid;
+
+		BootRom bootRom;
+		std::vector<uint32_t> commandStream;
+		std::vector<uint8_t> demoData;
+
+		synthLib::MD5 hash;
+
+		// ROM data is either mapped from disk or owned if it has been decoded, for example from a MIDI OS update
+		std::shared_ptr<const synthLib::MemoryMappedFile> mappedFile;
+		std::vector<uint8_t> ownedData;
+
+		const uint8_t* data() const { return mappedFile ? mappedFile->data() : ownedData.data(); }
+		size_t size() const { return mappedFile ? mappedFile->size() : ownedData.size(); }
+	};
+
+	// Provides the image of a ROM. The image is either available immediately or created on first access, which allows
+	// to enumerate ROMs that are known from the ROM index without loading them
+	class LazyImage
+	{
+	public:
+		using TLoadFunc = std::function<std::shared_ptr<const Image>()>;
+
+		explicit LazyImage(std::shared_ptr<const Image> _image) : m_image(std::move(_image)) {}
+		explicit LazyImage(TLoadFunc _load) : m_load(std::move(_load)) {}
+
+		const std::shared_ptr<const Image>& get() const;
+
+	private:
+		mutable std::once_flag m_once;
+		TLoadFunc m_load;
+		mutable std::shared_ptr<const Image> m_image;
+	};
+
 	explicit ROMFile(std::vector<uint8_t> _data, std::string _name, DeviceModel _model = DeviceModel::ABC);
+	explicit ROMFile(std::shared_ptr<const synthLib::MemoryMappedFile> _mappedFile, std::string _name, DeviceModel _model = DeviceModel::ABC);
+	explicit ROMFile(std::shared_ptr<const Image> _image);
+	ROMFile(std::string _name, DeviceModel _model, const synthLib::MD5& _hash, std::shared_ptr<LazyImage> _image);
+
+	static std::shared_ptr<const Image> createImage(std::vector<uint8_t> _data, std::string _name, DeviceModel _model);
+	static std::shared_ptr<const Image> createImage(std::shared_ptr<const synthLib::MemoryMappedFile> _mappedFile, std::string _name, DeviceModel _model);
 
 	static ROMFile invalid();
 
@@ -52,13 +100,16 @@ public:
 
 	std::thread bootDSP(dsp56k::DSP& dsp, dsp56k::HDI08& _hdi08) const;
 
-	bool isValid() const { return bootRom.size > 0; }
+	bool isValid() const { return m_image && m_model != DeviceModel::Invalid; }
+
+	// Ensures that the ROM image is loaded, returns false if it cannot be loaded
+	bool load() const;
 
 	DeviceModel getModel() const { return m_model; }
 
 	std::string getModelName() const;
 
-	bool isTIFamily() const { return virusLib::isTIFamily(m_model); }
+	bool isTIFamily() const { return virusLib::isTIFamily(getModel()); }
 
 	uint32_t getSamplerate() const
 	{
@@ -90,28 +141,25 @@ public:
 		return 128;
 	}
 
-	const std::vector<uint8_t>& getDemoData() const { return m_demoData; }
+	const std::vector<uint8_t>& getDemoData() const;
+
+	std::string getFilename() const { return isValid() ? m_filename : std::string(); }
 
-	std::string getFilename() const { return isValid() ? m_romFileName : std::string(); }
+	const synthLib::MD5& getHash() const { return m_hash; }
 
-	const auto& getHash() const { return m_romDataHash; }
+	std::shared_ptr<const Image> getImage() const;
+	const std::shared_ptr<LazyImage>& getLazyImage() const { return m_image; }
 
 private:
-	bool initialize();
-	std::vector<Chunk> readChunks(std::istream& _file);
+	static bool initialize(Image& _image);
+	static std::vector<Chunk> readChunks(Image& _image);
 
-	BootRom bootRom;
-	std::vector<uint32_t> m_commandStream;
+	static bool isValid(const Image* _image) { return _image && _image->bootRom.size > 0; }
 
+	std::string m_filename;
 	DeviceModel m_model = DeviceModel::Invalid;
-
-	std::vector<TPreset> m_singles;
-	std::vector<TPreset> m_multis;
-	std::vector<uint8_t> m_demoData;
-
-	std::string m_romFileName;
-	std::vector<uint8_t> m_romFileData;
-	synthLib::MD5 m_romDataHash;
+	synthLib::MD5 m_hash;
+	std::shared_ptr<LazyImage> m_image;
 };
 
 }
@@ -0,0 +1,140 @@
+#include "romindex.h"
+
+#include <sstream>
+
+#include "../synthLib/os.h"
+
+namespace virusLib
+{
+	static constexpr const char* g_indexHeader = "virusRomIndex 1";
+
+	ROMIndex::ROMIndex(std::string _filename) : m_filename(std::move(_filename))
+	{
+		load();
+	}
+
+	bool ROMIndex::find(Entry& _entry, const std::string& _filename)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_entries.find(_filename);
+		if(it == m_entries.end())
+			return false;
+
+		if(!isUpToDate(it->second))
+		{
+			m_entries.erase(it);
+			m_dirty = true;
+			return false;
+		}
+
+		_entry = it->second;
+		return true;
+	}
+
+	void ROMIndex::set(const Entry& _entry)
+	{
+		std::lock_guard lock(m_mutex);
+
+		auto& e = m_entries[_entry.filename];
+
+		// files are examined again if any of them is not indexed, most entries stay the same
+		if(e == _entry)
+			return;
+
+		e = _entry;
+		m_dirty = true;
+	}
+
+	bool ROMIndex::save()
+	{
+		std::lock_guard lock(m_mutex);
+
+		if(!m_dirty)
+			return true;
+
+		std::stringstream file;
+
+		file << g_indexHeader << '\n';
+
+		for (const auto& it : m_entries)
+		{
+			const auto& e = it.second;
+
+			file << e.filename << '\t' << e.size << '\t' << e.lastModified << '\t' << static_cast<int>(e.type) << '\t'
+				<< static_cast<int>(e.model) << '\t' << e.hash.toString() << '\t' << e.presetsFile << '\n';
+		}
+
+		const auto str = file.str();
+
+		if(!synthLib::writeFile(m_filename, reinterpret_cast<const uint8_t*>(str.c_str()), str.size()))
+			return false;
+
+		m_dirty = false;
+		return true;
+	}
+
+	ROMIndex& ROMIndex::instance()
+	{
+		static ROMIndex index(synthLib::getCacheDirectory() + "virusRomIndex.txt");
+		return index;
+	}
+
+	bool ROMIndex::load()
+	{
+		std::vector<uint8_t> data;
+		if(!synthLib::readFile(data, m_filename))
+			return false;
+
+		std::stringstream file(std::string(data.begin(), data.end()));
+
+		std::string line;
+
+		if(!std::getline(file, line) || line != g_indexHeader)
+			return false;
+
+		while(std::getline(file, line))
+		{
+			std::stringstream ss(line);
+
+			Entry e;
+			std::string size, lastModified, type, model, hash;
+
+			if(!std::getline(ss, e.filename, '\t') || !std::getline(ss, size, '\t') || !std::getline(ss, lastModified, '\t') ||
+				!std::getline(ss, type, '\t') || !std::getline(ss, model, '\t') || !std::getline(ss, hash, '\t'))
+				continue;
+
+			std::getline(ss, e.presetsFile, '\t');
+
+			try
+			{
+				e.size = std::stoull(size);
+				e.lastModified = std::stoull(lastModified);
+				e.type = static_cast<ROMLoader::FileType>(std::stoi(type));
+				e.model = static_cast<DeviceModel>(std::stoi(model));
+			}
+			catch(const std::exception&)
+			{
+				continue;
+			}
+
+			if(!e.hash.fromString(hash))
+				continue;
+
+			m_entries.insert({e.filename, e});
+		}
+
+		return true;
+	}
+
+	bool ROMIndex::isUpToDate(const Entry& _entry)
+	{
+		size_t size;
+		uint64_t lastModified;
+
+		if(!synthLib::getFileInfo(_entry.filename, size, lastModified))
+			return false;
+
+		return size == _entry.size && lastModified == _entry.lastModified;
+	}
+}
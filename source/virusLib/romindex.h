@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "romloader.h"
+
+namespace virusLib
+{
+	// Persistent index of all files that have been examined while searching for ROMs. It allows to enumerate ROMs
+	// without loading and decoding them. Entries are validated lazily via file size and modification time. The index
+	// is stored in the per-user cache directory and only written if an entry changed
+	class ROMIndex
+	{
+	public:
+		struct Entry
+		{
+			std::string filename;
+			size_t size = 0;
+			uint64_t lastModified = 0;
+			ROMLoader::FileType type = ROMLoader::Invalid;
+			DeviceModel model = DeviceModel::Invalid;
+			synthLib::MD5 hash;			// hash of the resulting ROM
+			std::string presetsFile;	// MIDI OS updates only: presets file that has been combined with it
+
+			bool operator == (const Entry& _e) const
+			{
+				return filename == _e.filename && size == _e.size && lastModified == _e.lastModified && type == _e.type &&
+					model == _e.model && hash == _e.hash && presetsFile == _e.presetsFile;
+			}
+		};
+
+		explicit ROMIndex(std::string _filename);
+
+		// returns false if the file is not known or if it changed since it has been added
+		bool find(Entry& _entry, const std::string& _filename);
+		void set(const Entry& _entry);
+
+		bool save();
+
+		static ROMIndex& instance();
+
+	private:
+		bool load();
+
+		static bool isUpToDate(const Entry& _entry);
+
+		const std::string m_filename;
+
+		std::mutex m_mutex;
+		std::map<std::string, Entry> m_entries;
+		bool m_dirty = false;
+	};
+}
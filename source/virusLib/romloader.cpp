@@ -1,6 +1,8 @@
 #include "romloader.h"
 
 #include "midiFileToRomData.h"
+#include "romcache.h"
+#include "romindex.h"
 
 #include "../synthLib/os.h"
 
@@ -44,7 +46,10 @@ namespace virusLib
 			files = findFiles(_path, ".bin", g_binSizeTImin, g_binSizeTImax);
 		}
 
-		return initializeRoms(files, _model);
+		return ROMCache::get(files, _model, [&files, _model]
+		{
+			return initializeRoms(files, _model);
+		});
 	}
 
 	ROMFile ROMLoader::findROM(const DeviceModel _model/* = DeviceModel::ABC*/)
@@ -93,7 +98,7 @@ namespace virusLib
 		{
             const auto path3 = synthLib::getCurrentDirectory();
 			if(path3 != path2 && path3 != path)
-				synthLib::findFiles(results, path, _extension, _minSize, _maxSize);
+				synthLib::findFiles(results, path3, _extension, _minSize, _maxSize);
 		}
 
 		return results;
@@ -114,11 +119,13 @@ namespace virusLib
 		FileData data;
 		data.filename = _name;
 
-		if(!synthLib::readFile(data.data, _name))
-			return {};
-
 		if(synthLib::hasExtension(_name, ".bin"))
 		{
+			auto mappedFile = std::make_shared<synthLib::MemoryMappedFile>();
+			if(!mappedFile->open(_name))
+				return {};
+
+			data.mappedFile = std::move(mappedFile);
 			data.type = BinaryRom;
 			return data;
 		}
@@ -126,6 +133,9 @@ namespace virusLib
 		if(!synthLib::hasExtension(_name, ".mid"))
 			return {};
 
+		if(!synthLib::readFile(data.data, _name))
+			return {};
+
 		MidiFileToRomData midiLoader;
 		if(!midiLoader.load(data.data, true))
 			return {};
@@ -149,16 +159,49 @@ namespace virusLib
 		if(_files.empty())
 			return {};
 
+		auto& index = ROMIndex::instance();
+
+		std::vector<ROMFile> roms;
+
+		if(initializeRomsFromIndex(roms, index, _files, _model))
+			return roms;
+
+		roms = loadRoms(index, _files, _model);
+
+		index.save();
+
+		return roms;
+	}
+
+	std::vector<ROMFile> ROMLoader::loadRoms(ROMIndex& _index, const std::vector<std::string>& _files, const DeviceModel _model)
+	{
 		std::vector<FileData> fileDatas;
 		fileDatas.reserve(_files.size());
 
+		std::vector<ROMIndex::Entry> indexEntries;
+		indexEntries.reserve(_files.size());
+
 		for (const auto& file : _files)
 		{
+			ROMIndex::Entry entry;
+			entry.filename = file;
+
+			if(!synthLib::getFileInfo(file, entry.size, entry.lastModified))
+				continue;
+
 			auto data = loadFile(file);
+
 			if(!data.isValid())
+			{
+				// remember invalid files too to skip them next time
+				_index.set(entry);
 				continue;
+			}
+
+			entry.type = data.type;
 
 			fileDatas.emplace_back(std::move(data));
+			indexEntries.emplace_back(std::move(entry));
 		}
 
 		if(fileDatas.empty())
@@ -175,15 +218,20 @@ namespace virusLib
 				presets.push_back(&fd);
 		}
 
-		for (const auto& fd : fileDatas)
+		for(size_t i=0; i<fileDatas.size(); ++i)
 		{
+			auto& fd = fileDatas[i];
+			auto& entry = indexEntries[i];
+
 			if(fd.type == MidiPresets)
 				continue;
 
+			const auto romCount = roms.size();
+
 			if(fd.type == BinaryRom)
 			{
 				// load as-is
-				auto& rom = roms.emplace_back(fd.data, fd.filename, _model);
+				auto& rom = roms.emplace_back(fd.mappedFile, fd.filename, _model);
 				if(!rom.isValid())
 					roms.pop_back();
 			}
@@ -193,7 +241,7 @@ namespace virusLib
 				if(presets.empty())
 				{
 					// none available, use without presets
-					auto& rom = roms.emplace_back(fd.data, fd.filename, _model);
+					auto& rom = roms.emplace_back(std::move(fd.data), fd.filename, _model);
 					if(!rom.isValid())
 						roms.pop_back();
 				}
@@ -206,13 +254,111 @@ namespace virusLib
 
 					auto& rom = roms.emplace_back(data, fd.filename, _model);
 					if(!rom.isValid())
+					{
 						roms.pop_back();
-					else if(presets.size() > 1)
-						presets.erase(presets.begin());	// do not use preset file more than once if we have multiple
+					}
+					else
+					{
+						entry.presetsFile = p.filename;
+
+						if(presets.size() > 1)
+							presets.erase(presets.begin());	// do not use preset file more than once if we have multiple
+					}
 				}
 			}
+
+			if(roms.size() > romCount)
+			{
+				entry.model = roms.back().getModel();
+				entry.hash = roms.back().getHash();
+			}
+			else
+			{
+				entry.type = Invalid;
+			}
 		}
 
+		for (const auto& entry : indexEntries)
+			_index.set(entry);
+
 		return roms;
 	}
+
+	bool ROMLoader::initializeRomsFromIndex(std::vector<ROMFile>& _roms, ROMIndex& _index, const std::vector<std::string>& _files, const DeviceModel _model)
+	{
+		std::vector<ROMIndex::Entry> entries;
+		entries.reserve(_files.size());
+
+		for (const auto& file : _files)
+		{
+			if(!_index.find(entries.emplace_back(), file))
+				return false;
+		}
+
+		std::vector<const ROMIndex::Entry*> presets;
+
+		for (const auto& e : entries)
+		{
+			if(e.type == MidiPresets)
+				presets.push_back(&e);
+		}
+
+		std::vector<ROMFile> roms;
+		roms.reserve(entries.size());
+
+		for (const auto& e : entries)
+		{
+			if(e.type != BinaryRom && e.type != MidiRom)
+				continue;
+
+			if(e.type == MidiRom)
+			{
+				// the presets that are combined with an OS update depend on the other files that have been found
+				const auto presetsFile = presets.empty() ? std::string() : presets.front()->filename;
+
+				if(presetsFile != e.presetsFile)
+					return false;
+
+				if(presets.size() > 1)
+					presets.erase(presets.begin());
+			}
+
+			// the ROM is loaded once it is used
+			auto image = std::make_shared<ROMFile::LazyImage>([e, _model]() -> std::shared_ptr<const ROMFile::Image>
+			{
+				auto fd = loadFile(e.filename);
+				if(fd.type != e.type)
+					return {};
+
+				std::shared_ptr<const ROMFile::Image> res;
+
+				if(fd.mappedFile)
+				{
+					res = ROMFile::createImage(std::move(fd.mappedFile), e.filename, _model);
+				}
+				else
+				{
+					if(!e.presetsFile.empty())
+					{
+						const auto p = loadFile(e.presetsFile);
+						if(p.type != MidiPresets)
+							return {};
+						fd.data.insert(fd.data.end(), p.data.begin(), p.data.end());
+					}
+					res = ROMFile::createImage(std::move(fd.data), e.filename, _model);
+				}
+
+				// the file may have been replaced without changing size and modification time
+				if(res->hash != e.hash)
+					return {};
+
+				return res;
+			});
+
+			roms.emplace_back(e.filename, e.model, e.hash, std::move(image));
+		}
+
+		_roms = std::move(roms);
+		return true;
+	}
 }
@@ -4,6 +4,8 @@
 
 namespace virusLib
 {
+	class ROMIndex;
+
 	class ROMLoader
 	{
 	public:
@@ -18,10 +20,14 @@ namespace virusLib
 		struct FileData
 		{
 			std::string filename;
-			FileType type;
-			std::vector<uint8_t> data;
+			FileType type = Invalid;
+			std::shared_ptr<const synthLib::MemoryMappedFile> mappedFile;	// binary ROMs are mapped into memory as-is
+			std::vector<uint8_t> data;										// MIDI files need to be decoded
+
+			const uint8_t* getData() const { return mappedFile ? mappedFile->data() : data.data(); }
+			size_t getSize() const { return mappedFile ? mappedFile->size() : data.size(); }
 
-			bool isValid() const { return type != Invalid && !data.empty(); }
+			bool isValid() const { return type != Invalid && getSize() > 0; }
 		};
 
 		static std::vector<ROMFile> findROMs(DeviceModel _model = DeviceModel::ABC);
@@ -37,5 +43,7 @@ namespace virusLib
 		static FileData loadFile(const std::string& _name);
 
 		static std::vector<ROMFile> initializeRoms(const std::vector<std::string>& _files, DeviceModel _model);
+		static std::vector<ROMFile> loadRoms(ROMIndex& _index, const std::vector<std::string>& _files, DeviceModel _model);
+		static bool initializeRomsFromIndex(std::vector<ROMFile>& _roms, ROMIndex& _index, const std::vector<std::string>& _files, DeviceModel _model);
 	};
 }
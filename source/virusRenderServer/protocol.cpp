@@ -0,0 +1,344 @@
+#include "protocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "../synthLib/binarystream.h"
+
+namespace virusRenderServer
+{
+	namespace
+	{
+		constexpr uint32_t g_maxChannelCount = 16;
+		constexpr uint32_t g_maxBlockSize = 65536;
+		constexpr float g_maxTailSeconds = 600.0f;
+
+		void writeEvent(synthLib::BinaryStream& _s, const synthLib::SMidiEvent& _e)
+		{
+			_s.write(_e.a);
+			_s.write(_e.b);
+			_s.write(_e.c);
+			_s.write(_e.sysex);
+		}
+
+		void readEvent(synthLib::BinaryStream& _s, synthLib::SMidiEvent& _e)
+		{
+			_e.a = _s.read<uint8_t>();
+			_e.b = _s.read<uint8_t>();
+			_e.c = _s.read<uint8_t>();
+			_s.read(_e.sysex);
+		}
+
+		std::vector<uint8_t> toVector(synthLib::BinaryStream& _s)
+		{
+			std::vector<uint8_t> data;
+			_s.toVector(data);
+			return data;
+		}
+
+		int32_t toInt(const float _v, const float _scale)
+		{
+			return static_cast<int32_t>(std::lround(std::clamp(_v, -1.0f, 1.0f) * _scale));
+		}
+	}
+
+	std::vector<uint8_t> RenderRequest::serialize() const
+	{
+		synthLib::BinaryStream s;
+
+		s.write(ProtocolVersion);
+		s.write(rom);
+		s.write(samplerate);
+		s.write(state);
+
+		s.write(inputType);
+
+		if(inputType == InputType::MidiFile)
+		{
+			s.write(midiFile);
+		}
+		else
+		{
+			s.write(static_cast<uint32_t>(events.size()));
+			for (const auto& e : events)
+			{
+				s.write(e.time);
+				writeEvent(s, e.event);
+			}
+		}
+
+		s.write(format);
+		s.write(channelCount);
+		s.write(blockSize);
+		s.write(tailSeconds);
+
+		return toVector(s);
+	}
+
+	bool RenderRequest::deserialize(const std::vector<uint8_t>& _data, std::string& _error)
+	{
+		synthLib::BinaryStream s(_data);
+
+		try
+		{
+			const auto version = s.read<uint32_t>();
+
+			if(version != ProtocolVersion)
+			{
+				_error = "Unsupported protocol version " + std::to_string(version) + ", expected " + std::to_string(ProtocolVersion);
+				return false;
+			}
+
+			rom = s.readString();
+			samplerate = s.read<float>();
+			s.read(state);
+
+			inputType = s.read<InputType>();
+
+			midiFile.clear();
+			events.clear();
+
+			switch (inputType)
+			{
+			case InputType::MidiFile:
+				s.read(midiFile);
+				break;
+			case InputType::EventList:
+				{
+					const auto count = s.read<uint32_t>();
+					for(uint32_t i=0; i<count; ++i)
+					{
+						auto& e = events.emplace_back();
+						e.time = s.read<double>();
+						readEvent(s, e.event);
+					}
+				}
+				break;
+			default:
+				_error = "Unknown input type " + std::to_string(static_cast<uint32_t>(inputType));
+				return false;
+			}
+
+			format = s.read<synthLib::SampleFormat>();
+			channelCount = s.read<uint32_t>();
+			blockSize = s.read<uint32_t>();
+			tailSeconds = s.read<float>();
+		}
+		catch(const std::range_error&)
+		{
+			_error = "Render request is truncated";
+			return false;
+		}
+
+		if(format != synthLib::SampleFormat::Int16 && format != synthLib::SampleFormat::Int24 && format != synthLib::SampleFormat::Float32)
+		{
+			_error = "Unsupported sample format " + std::to_string(static_cast<uint32_t>(format));
+			return false;
+		}
+
+		if(!channelCount || channelCount > g_maxChannelCount)
+		{
+			_error = "Invalid channel count " + std::to_string(channelCount);
+			return false;
+		}
+
+		if(!blockSize || blockSize > g_maxBlockSize)
+		{
+			_error = "Invalid block size " + std::to_string(blockSize);
+			return false;
+		}
+
+		if(!(tailSeconds >= 0.0f && tailSeconds <= g_maxTailSeconds) || !(samplerate >= 0.0f))
+		{
+			_error = "Invalid tail length or samplerate";
+			return false;
+		}
+
+		return true;
+	}
+
+	std::vector<uint8_t> RenderInfo::serialize() const
+	{
+		synthLib::BinaryStream s;
+
+		s.write(samplerate);
+		s.write(channelCount);
+		s.write(format);
+		s.write(frameCount);
+		s.write(queueSeconds);
+		s.write(static_cast<uint8_t>(warmDevice ? 1 : 0));
+
+		return toVector(s);
+	}
+
+	bool RenderInfo::deserialize(const std::vector<uint8_t>& _data)
+	{
+		synthLib::BinaryStream s(_data);
+
+		try
+		{
+			samplerate = s.read<float>();
+			channelCount = s.read<uint32_t>();
+			format = s.read<synthLib::SampleFormat>();
+			frameCount = s.read<uint64_t>();
+			queueSeconds = s.read<double>();
+			warmDevice = s.read<uint8_t>() != 0;
+		}
+		catch(const std::range_error&)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	std::vector<uint8_t> RenderResult::serialize() const
+	{
+		synthLib::BinaryStream s;
+
+		s.write(frameCount);
+		s.write(renderSeconds);
+
+		return toVector(s);
+	}
+
+	bool RenderResult::deserialize(const std::vector<uint8_t>& _data)
+	{
+		synthLib::BinaryStream s(_data);
+
+		try
+		{
+			frameCount = s.read<uint64_t>();
+			renderSeconds = s.read<double>();
+		}
+		catch(const std::range_error&)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	std::string ServerStats::toString() const
+	{
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(2);
+
+		ss << "Uptime:      " << uptimeSeconds << " seconds, " << workers << " workers, " << connections << " connections" << std::endl;
+		ss << "Jobs:        " << queuedJobs << " queued, " << activeJobs << " active, " << completedJobs << " completed, " << failedJobs << " failed" << std::endl;
+		ss << "Devices:     " << devices << " booted, " << idleDevices << " idle, " << deviceBoots << " boots in " << bootSeconds << " seconds" << std::endl;
+		ss << "Throughput:  " << audioSeconds << " seconds of audio rendered in " << renderSeconds << " seconds, " << getRealtimeFactor() << "x realtime, " << getJobsPerSecond() << " jobs per second" << std::endl;
+		ss << "Queue time:  " << getAverageQueueSeconds() << " seconds on average" << std::endl;
+
+		return ss.str();
+	}
+
+	std::vector<uint8_t> ServerStats::serialize() const
+	{
+		synthLib::BinaryStream s;
+
+		s.write(uptimeSeconds);
+		s.write(workers);
+		s.write(queuedJobs);
+		s.write(activeJobs);
+		s.write(completedJobs);
+		s.write(failedJobs);
+		s.write(connections);
+		s.write(devices);
+		s.write(idleDevices);
+		s.write(deviceBoots);
+		s.write(bootSeconds);
+		s.write(audioSeconds);
+		s.write(renderSeconds);
+		s.write(queueSeconds);
+
+		return toVector(s);
+	}
+
+	bool ServerStats::deserialize(const std::vector<uint8_t>& _data)
+	{
+		synthLib::BinaryStream s(_data);
+
+		try
+		{
+			uptimeSeconds = s.read<double>();
+			workers = s.read<uint32_t>();
+			queuedJobs = s.read<uint32_t>();
+			activeJobs = s.read<uint32_t>();
+			completedJobs = s.read<uint64_t>();
+			failedJobs = s.read<uint64_t>();
+			connections = s.read<uint32_t>();
+			devices = s.read<uint32_t>();
+			idleDevices = s.read<uint32_t>();
+			deviceBoots = s.read<uint64_t>();
+			bootSeconds = s.read<double>();
+			audioSeconds = s.read<double>();
+			renderSeconds = s.read<double>();
+			queueSeconds = s.read<double>();
+		}
+		catch(const std::range_error&)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	void convertSamples(std::vector<uint8_t>& _dst, const float* _src, const size_t _count, const synthLib::SampleFormat _format)
+	{
+		switch (_format)
+		{
+		case synthLib::SampleFormat::Int16:
+			for(size_t i=0; i<_count; ++i)
+			{
+				const auto v = toInt(_src[i], 32767.0f);
+				_dst.push_back(static_cast<uint8_t>(v));
+				_dst.push_back(static_cast<uint8_t>(v >> 8));
+			}
+			break;
+		case synthLib::SampleFormat::Int24:
+			for(size_t i=0; i<_count; ++i)
+			{
+				const auto v = toInt(_src[i], 8388607.0f);
+				_dst.push_back(static_cast<uint8_t>(v));
+				_dst.push_back(static_cast<uint8_t>(v >> 8));
+				_dst.push_back(static_cast<uint8_t>(v >> 16));
+			}
+			break;
+		case synthLib::SampleFormat::Float32:
+			{
+				const auto* p = reinterpret_cast<const uint8_t*>(_src);
+				_dst.insert(_dst.end(), p, p + _count * sizeof(float));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	const char* toString(const synthLib::SampleFormat _format)
+	{
+		switch (_format)
+		{
+		case synthLib::SampleFormat::Int16:		return "int16";
+		case synthLib::SampleFormat::Int24:		return "int24";
+		case synthLib::SampleFormat::Int32:		return "int32";
+		case synthLib::SampleFormat::Float32:	return "float32";
+		case synthLib::SampleFormat::Float64:	return "float64";
+		default:								return "invalid";
+		}
+	}
+
+	bool parseSampleFormat(synthLib::SampleFormat& _format, const std::string& _name)
+	{
+		for (const auto f : {synthLib::SampleFormat::Int16, synthLib::SampleFormat::Int24, synthLib::SampleFormat::Float32})
+		{
+			if(_name == toString(f))
+			{
+				_format = f;
+				return true;
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../synthLib/midiTypes.h"
+#include "../synthLib/wavReader.h"
+
+namespace virusRenderServer
+{
+	// Every message is a frame that consists of a 12 byte header followed by the payload. The header contains the
+	// message type, the id of the job that the message belongs to and the payload size as 32 bit values in native byte
+	// order, client and server always run on the same machine. Payloads are serialized with synthLib::BinaryStream.
+	//
+	// A client sends a render request with a job id of its choice. The server answers with an Accepted message once
+	// the job has been queued, an Info message when rendering starts, any number of Data messages that contain audio
+	// in the requested sample format and a Done message at the end. A Failed message ends a job at any point.
+	// Multiple jobs may be submitted on one connection, messages of different jobs are interleaved in that case
+	constexpr uint32_t ProtocolVersion = 1;
+	constexpr uint32_t MaxPayloadSize = 256 * 1024 * 1024;
+
+	constexpr uint32_t makeMessageType(const char _a, const char _b, const char _c, const char _d)
+	{
+		return static_cast<uint32_t>(static_cast<uint8_t>(_a)) | static_cast<uint32_t>(static_cast<uint8_t>(_b)) << 8 | static_cast<uint32_t>(static_cast<uint8_t>(_c)) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(_d)) << 24;
+	}
+
+	enum class MessageType : uint32_t
+	{
+		// client to server
+		Render		= makeMessageType('R','N','D','R'),		// RenderRequest
+		GetStats	= makeMessageType('G','S','T','A'),		// protocol version
+
+		// server to client
+		Accepted	= makeMessageType('A','C','P','T'),		// number of jobs that are queued in front of this one
+		Info		= makeMessageType('I','N','F','O'),		// RenderInfo
+		Data		= makeMessageType('D','A','T','A'),		// interleaved samples
+		Done		= makeMessageType('D','O','N','E'),		// RenderResult
+		Failed		= makeMessageType('F','A','I','L'),		// error message
+		Stats		= makeMessageType('S','T','A','T'),		// ServerStats
+	};
+
+	struct Frame
+	{
+		MessageType type = MessageType::Failed;
+		uint32_t job = 0;
+		std::vector<uint8_t> payload;
+	};
+
+	enum class InputType : uint8_t
+	{
+		MidiFile,		// Standard MIDI File
+		EventList		// events with timestamps in seconds
+	};
+
+	struct TimedEvent
+	{
+		double time = 0.0;
+		synthLib::SMidiEvent event;
+	};
+
+	struct RenderRequest
+	{
+		std::string rom;							// ROM filename, the default ROM is used if empty
+		float samplerate = 0.0f;					// 0 = default samplerate of the ROM
+		std::vector<uint8_t> state;					// global device state, the state after boot is used if empty
+
+		InputType inputType = InputType::MidiFile;
+		std::vector<uint8_t> midiFile;
+		std::vector<TimedEvent> events;
+
+		synthLib::SampleFormat format = synthLib::SampleFormat::Float32;	// Int16, Int24 or Float32
+		uint32_t channelCount = 2;
+		uint32_t blockSize = 512;
+		float tailSeconds = 3.0f;
+
+		std::vector<uint8_t> serialize() const;
+		bool deserialize(const std::vector<uint8_t>& _data, std::string& _error);
+	};
+
+	struct RenderInfo
+	{
+		float samplerate = 0.0f;
+		uint32_t channelCount = 0;
+		synthLib::SampleFormat format = synthLib::SampleFormat::Float32;
+		uint64_t frameCount = 0;
+		double queueSeconds = 0.0;					// time between accepting the job and the start of rendering
+		bool warmDevice = false;					// false if a device had to be booted for this job
+
+		std::vector<uint8_t> serialize() const;
+		bool deserialize(const std::vector<uint8_t>& _data);
+	};
+
+	struct RenderResult
+	{
+		uint64_t frameCount = 0;
+		double renderSeconds = 0.0;
+
+		std::vector<uint8_t> serialize() const;
+		bool deserialize(const std::vector<uint8_t>& _data);
+	};
+
+	struct ServerStats
+	{
+		double uptimeSeconds = 0.0;
+		uint32_t workers = 0;
+
+		uint32_t queuedJobs = 0;
+		uint32_t activeJobs = 0;
+		uint64_t completedJobs = 0;
+		uint64_t failedJobs = 0;
+		uint32_t connections = 0;
+
+		uint32_t devices = 0;
+		uint32_t idleDevices = 0;
+		uint64_t deviceBoots = 0;
+		double bootSeconds = 0.0;
+
+		double audioSeconds = 0.0;					// of completed jobs
+		double renderSeconds = 0.0;					// time spent rendering completed jobs
+		double queueSeconds = 0.0;					// time that completed jobs have been waiting in the queue
+
+		double getRealtimeFactor() const { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+		double getJobsPerSecond() const { return uptimeSeconds > 0.0 ? static_cast<double>(completedJobs) / uptimeSeconds : 0.0; }
+		double getAverageQueueSeconds() const { return completedJobs ? queueSeconds / static_cast<double>(completedJobs) : 0.0; }
+
+		std::string toString() const;
+
+		std::vector<uint8_t> serialize() const;
+		bool deserialize(const std::vector<uint8_t>& _data);
+	};
+
+	// converts interleaved float samples to the given format and appends them to _dst
+	void convertSamples(std::vector<uint8_t>& _dst, const float* _src, size_t _count, synthLib::SampleFormat _format);
+
+	const char* toString(synthLib::SampleFormat _format);
+	bool parseSampleFormat(synthLib::SampleFormat& _format, const std::string& _name);
+}
@@ -0,0 +1,159 @@
+#include "renderClient.h"
+
+#include <cmath>
+
+#include "../synthLib/audioDiff.h"
+#include "../synthLib/binarystream.h"
+#include "../synthLib/wavWriter.h"
+
+namespace virusRenderServer
+{
+	namespace
+	{
+		std::string readMessage(const Frame& _frame)
+		{
+			try
+			{
+				synthLib::BinaryStream s(_frame.payload);
+				return s.readString();
+			}
+			catch(const std::range_error&)
+			{
+				return "Unknown error";
+			}
+		}
+	}
+
+	bool RenderClient::connect(const std::string& _socketPath)
+	{
+		if(m_socket.connect(_socketPath))
+			return true;
+
+		m_error = m_socket.getError();
+		return false;
+	}
+
+	bool RenderClient::render(const RenderRequest& _request, const std::string& _wavFilename, RenderResult* _result/* = nullptr*/)
+	{
+		const auto job = ++m_nextJob;
+
+		if(!m_socket.send(MessageType::Render, job, _request.serialize()))
+		{
+			m_error = "Failed to send render request";
+			return false;
+		}
+
+		synthLib::WavStreamWriter writer;
+		RenderInfo info;
+		Frame frame;
+
+		while(receive(frame, job))
+		{
+			switch (frame.type)
+			{
+			case MessageType::Accepted:
+				break;
+			case MessageType::Info:
+				{
+					if(!info.deserialize(frame.payload))
+					{
+						m_error = "Invalid render info";
+						return false;
+					}
+
+					const auto bits = static_cast<int>(synthLib::AudioDiff::getSampleSize(info.format) * 8);
+					const auto isFloat = info.format == synthLib::SampleFormat::Float32;
+
+					if(!writer.open(_wavFilename, bits, isFloat, static_cast<int>(info.channelCount), static_cast<int>(std::lround(info.samplerate))))
+					{
+						m_error = "Failed to create output file " + _wavFilename;
+						return false;
+					}
+				}
+				break;
+			case MessageType::Data:
+				if(!writer.isOpen() || !writer.write(frame.payload.data(), frame.payload.size()))
+				{
+					m_error = "Failed to write to output file " + _wavFilename;
+					return false;
+				}
+				break;
+			case MessageType::Done:
+				{
+					RenderResult result;
+					result.deserialize(frame.payload);
+
+					if(_result)
+						*_result = result;
+
+					if(!writer.close())
+					{
+						m_error = "Failed to write to output file " + _wavFilename;
+						return false;
+					}
+					return true;
+				}
+			case MessageType::Failed:
+				m_error = readMessage(frame);
+				return false;
+			default:
+				m_error = "Unexpected message from server";
+				return false;
+			}
+		}
+
+		return false;
+	}
+
+	bool RenderClient::getStats(ServerStats& _stats)
+	{
+		const auto job = ++m_nextJob;
+
+		synthLib::BinaryStream s;
+		s.write(ProtocolVersion);
+
+		std::vector<uint8_t> payload;
+		s.toVector(payload);
+
+		Frame frame;
+
+		if(!m_socket.send(MessageType::GetStats, job, payload) || !receive(frame, job))
+		{
+			if(m_error.empty())
+				m_error = "Failed to request statistics";
+			return false;
+		}
+
+		if(frame.type == MessageType::Failed)
+		{
+			m_error = readMessage(frame);
+			return false;
+		}
+
+		if(frame.type != MessageType::Stats || !_stats.deserialize(frame.payload))
+		{
+			m_error = "Invalid statistics received";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool RenderClient::receive(Frame& _frame, const uint32_t _job)
+	{
+		// jobs are processed one after another, frames of other jobs cannot arrive
+		if(!m_socket.receive(_frame))
+		{
+			m_error = "Connection to server lost";
+			return false;
+		}
+
+		if(_frame.job != _job)
+		{
+			m_error = "Received message for unknown job " + std::to_string(_frame.job);
+			return false;
+		}
+
+		return true;
+	}
+}
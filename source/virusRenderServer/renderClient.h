@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+#include "protocol.h"
+#include "socket.h"
+
+namespace virusRenderServer
+{
+	// Submits jobs to a render server and writes the results to wav files
+	class RenderClient
+	{
+	public:
+		bool connect(const std::string& _socketPath);
+
+		// Blocks until the job has been rendered. Returns false if the server reports an error or the connection fails
+		bool render(const RenderRequest& _request, const std::string& _wavFilename, RenderResult* _result = nullptr);
+
+		bool getStats(ServerStats& _stats);
+
+		const std::string& getError() const { return m_error; }
+
+	private:
+		bool receive(Frame& _frame, uint32_t _job);
+
+		Socket m_socket;
+		uint32_t m_nextJob = 0;
+		std::string m_error;
+	};
+}
@@ -0,0 +1,477 @@
+#include "renderServer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "../synthLib/audioDiff.h"
+#include "../synthLib/binarystream.h"
+#include "../synthLib/device.h"
+#include "../synthLib/midiFileRenderer.h"
+
+namespace virusRenderServer
+{
+	namespace
+	{
+		constexpr uint32_t g_acceptTimeoutMs = 250;
+		constexpr size_t g_dataFrameSize = 64 * 1024;	// audio is sent in chunks of this size
+		constexpr float g_silenceSeconds = 1.0f;		// a pooled device needs to be silent this long before a job starts
+		constexpr float g_maxSilenceWaitSeconds = 30.0f;
+
+		template<typename T> std::vector<uint8_t> serializeValue(const T& _value)
+		{
+			synthLib::BinaryStream s;
+			s.write(_value);
+
+			std::vector<uint8_t> data;
+			s.toVector(data);
+			return data;
+		}
+	}
+
+	RenderServer::RenderServer(DeviceFactory& _factory, const uint32_t _workerCount)
+		: m_factory(_factory)
+		, m_workerCount(std::max(1u, _workerCount))
+		, m_startTime(Clock::now())
+	{
+	}
+
+	RenderServer::~RenderServer()
+	{
+		std::vector<std::shared_ptr<Connection>> connections;
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_quit = true;
+			connections.swap(m_connections);
+		}
+		m_cv.notify_all();
+
+		// shutting down the sockets aborts jobs that are being rendered and unblocks the receiving threads
+		for (const auto& c : connections)
+			c->socket.shutdown();
+
+		for (auto& w : m_workers)
+			w.join();
+
+		for (const auto& c : connections)
+			c->thread.join();
+	}
+
+	bool RenderServer::listen(const std::string& _socketPath)
+	{
+		if(!m_socket.listen(_socketPath))
+		{
+			log(m_socket.getError());
+			return false;
+		}
+
+		for(uint32_t i=0; i<m_workerCount; ++i)
+			m_workers.emplace_back([this] { workerThread(); });
+
+		log("Listening on " + _socketPath + " with " + std::to_string(m_workerCount) + " workers");
+		return true;
+	}
+
+	void RenderServer::run(const std::atomic<bool>& _quit)
+	{
+		uint32_t nextConnectionId = 0;
+
+		while(!_quit)
+		{
+			const auto fd = m_socket.accept(g_acceptTimeoutMs);
+
+			// join the threads of clients that have disconnected. Jobs may still reference their connections
+			std::vector<std::shared_ptr<Connection>> finished;
+			{
+				std::lock_guard lock(m_mutex);
+
+				for(auto it = m_connections.begin(); it != m_connections.end();)
+				{
+					if((*it)->finished)
+					{
+						finished.push_back(*it);
+						it = m_connections.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+
+			for (const auto& c : finished)
+				c->thread.join();
+
+			if(fd < 0)
+				continue;
+
+			auto connection = std::make_shared<Connection>(fd, ++nextConnectionId);
+
+			std::lock_guard lock(m_mutex);
+			m_connections.push_back(connection);
+			connection->thread = std::thread([this, connection] { connectionThread(connection); });
+		}
+	}
+
+	ServerStats RenderServer::getStats()
+	{
+		ServerStats stats;
+
+		stats.uptimeSeconds = std::chrono::duration<double>(Clock::now() - m_startTime).count();
+		stats.workers = m_workerCount;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			stats.queuedJobs = static_cast<uint32_t>(m_queue.size());
+			stats.activeJobs = m_activeJobs;
+			stats.completedJobs = m_completedJobs;
+			stats.failedJobs = m_failedJobs;
+			stats.audioSeconds = m_audioSeconds;
+			stats.renderSeconds = m_renderSeconds;
+			stats.queueSeconds = m_queueSeconds;
+
+			for (const auto& c : m_connections)
+			{
+				if(!c->finished)
+					++stats.connections;
+			}
+		}
+
+		{
+			std::lock_guard lock(m_poolMutex);
+
+			stats.devices = m_deviceCount;
+			stats.deviceBoots = m_deviceBoots;
+			stats.bootSeconds = m_bootSeconds;
+
+			for (const auto& it : m_pool)
+				stats.idleDevices += static_cast<uint32_t>(it.second.size());
+		}
+
+		return stats;
+	}
+
+	uint32_t RenderServer::getDefaultWorkerCount()
+	{
+		// every device runs the DSP emulation in a separate thread next to the thread that drives it
+		return std::max(1u, std::thread::hardware_concurrency() / 2);
+	}
+
+	void RenderServer::connectionThread(const std::shared_ptr<Connection>& _connection)
+	{
+		auto& socket = _connection->socket;
+
+		Frame frame;
+
+		while(socket.receive(frame))
+		{
+			switch (frame.type)
+			{
+			case MessageType::Render:
+				{
+					Job job;
+					std::string error;
+
+					if(!job.request.deserialize(frame.payload, error))
+					{
+						socket.send(MessageType::Failed, frame.job, error);
+						break;
+					}
+
+					job.connection = _connection;
+					job.id = frame.job;
+					job.queued = Clock::now();
+
+					uint32_t position;
+					{
+						std::lock_guard lock(m_mutex);
+						position = static_cast<uint32_t>(m_queue.size());
+					}
+
+					// acknowledge before the job is queued, a worker must not be able to answer first
+					socket.send(MessageType::Accepted, frame.job, serializeValue(position));
+
+					{
+						std::lock_guard lock(m_mutex);
+						m_queue.push_back(std::move(job));
+					}
+					m_cv.notify_one();
+				}
+				break;
+			case MessageType::GetStats:
+				{
+					uint32_t version = 0;
+					if(frame.payload.size() >= sizeof(version))
+						memcpy(&version, frame.payload.data(), sizeof(version));
+
+					if(version == ProtocolVersion)
+						socket.send(MessageType::Stats, frame.job, getStats().serialize());
+					else
+						socket.send(MessageType::Failed, frame.job, "Unsupported protocol version " + std::to_string(version));
+				}
+				break;
+			default:
+				socket.send(MessageType::Failed, frame.job, std::string("Unknown message type"));
+				break;
+			}
+		}
+
+		_connection->finished = true;
+	}
+
+	void RenderServer::workerThread()
+	{
+		while(true)
+		{
+			Job job;
+
+			{
+				std::unique_lock lock(m_mutex);
+				m_cv.wait(lock, [this] { return m_quit || !m_queue.empty(); });
+
+				if(m_quit)
+					return;
+
+				job = std::move(m_queue.front());
+				m_queue.pop_front();
+				++m_activeJobs;
+			}
+
+			std::string error;
+
+			// jobs of clients that have disconnected are dropped
+			const auto success = !job.connection->finished && renderJob(job, error);
+
+			if(!success && !error.empty())
+			{
+				job.connection->socket.send(MessageType::Failed, job.id, error);
+				log("Client " + std::to_string(job.connection->id) + ", job " + std::to_string(job.id) + " failed: " + error);
+			}
+
+			std::lock_guard lock(m_mutex);
+			--m_activeJobs;
+			if(!success)
+				++m_failedJobs;
+		}
+	}
+
+	bool RenderServer::renderJob(const Job& _job, std::string& _error)
+	{
+		const auto& request = _job.request;
+
+		synthLib::MidiFileRenderer renderer;
+
+		if(request.inputType == InputType::MidiFile)
+		{
+			if(!renderer.load(request.midiFile.data(), request.midiFile.size()))
+			{
+				_error = "Failed to load MIDI file";
+				return false;
+			}
+		}
+		else
+		{
+			for (const auto& e : request.events)
+				renderer.addEvent(e.time, e.event);
+		}
+
+		RenderInfo info;
+		info.queueSeconds = std::chrono::duration<double>(Clock::now() - _job.queued).count();
+
+		auto pooled = acquireDevice(request.rom, info.warmDevice, _error);
+
+		if(!pooled)
+			return false;
+
+		const auto success = render(_job, renderer, *pooled, info, _error);
+
+		releaseDevice(request.rom, std::move(pooled));
+
+		return success;
+	}
+
+	bool RenderServer::render(const Job& _job, const synthLib::MidiFileRenderer& _renderer, PooledDevice& _device, RenderInfo& _info, std::string& _error)
+	{
+		const auto& request = _job.request;
+		auto& device = *_device.device;
+
+		const auto start = Clock::now();
+
+		const auto& state = request.state.empty() ? _device.initialState : request.state;
+
+		if(!state.empty() && !device.setState(state, synthLib::StateTypeGlobal))
+		{
+			_error = "Failed to apply device state";
+			return false;
+		}
+
+		const auto samplerate = request.samplerate > 0.0f ? request.samplerate : _device.initialSamplerate;
+
+		if(samplerate != device.getSamplerate() && !device.setSamplerate(samplerate))
+		{
+			_error = "Samplerate " + std::to_string(samplerate) + " is not supported";
+			return false;
+		}
+
+		// the previous job of a pooled device might still be audible, flush it so that it does not end up in this one. A
+		// device that has just been booted did not play anything yet
+		if(_info.warmDevice && !device.processUntilSilent(static_cast<uint32_t>(g_silenceSeconds * device.getSamplerate()), static_cast<uint32_t>(g_maxSilenceWaitSeconds * device.getSamplerate())))
+			log("Client " + std::to_string(_job.connection->id) + ", job " + std::to_string(_job.id) + ": device did not become silent before rendering");
+
+		synthLib::MidiFileRenderer::Config config;
+		config.blockSize = request.blockSize;
+		config.tailSeconds = request.tailSeconds;
+		config.channelCount = request.channelCount;
+
+		m_factory.getSetupEvents(config.setupEvents, _renderer.getChannelMask());
+
+		_info.samplerate = device.getSamplerate();
+		_info.channelCount = synthLib::MidiFileRenderer::getChannelCount(device, config);
+		_info.format = request.format;
+		_info.frameCount = _renderer.getFrameCount(_info.samplerate, config);
+
+		auto& socket = _job.connection->socket;
+
+		if(!socket.send(MessageType::Info, _job.id, _info.serialize()))
+			return false;
+
+		std::vector<uint8_t> data;
+		data.reserve(g_dataFrameSize + static_cast<size_t>(request.blockSize) * _info.channelCount * synthLib::AudioDiff::getSampleSize(request.format));
+
+		synthLib::MidiFileRenderer::Stats stats;
+
+		const auto rendered = _renderer.render(device, [&](const float* _interleaved, const uint32_t _frameCount)
+		{
+			convertSamples(data, _interleaved, static_cast<size_t>(_frameCount) * _info.channelCount, request.format);
+
+			if(data.size() < g_dataFrameSize)
+				return true;
+
+			const auto sent = socket.send(MessageType::Data, _job.id, data);
+			data.clear();
+			return sent;
+		}, config, &stats);
+
+		// the client is gone if sending failed, there is nobody to report an error to
+		if(!rendered)
+			return false;
+
+		if(!data.empty() && !socket.send(MessageType::Data, _job.id, data))
+			return false;
+
+		RenderResult result;
+		result.frameCount = stats.samples;
+		result.renderSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		if(!socket.send(MessageType::Done, _job.id, result.serialize()))
+			return false;
+
+		const auto audioSeconds = static_cast<double>(stats.samples) / _info.samplerate;
+
+		{
+			std::lock_guard lock(m_mutex);
+			++m_completedJobs;
+			m_audioSeconds += audioSeconds;
+			m_renderSeconds += result.renderSeconds;
+			m_queueSeconds += _info.queueSeconds;
+		}
+
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(2) << "Client " << _job.connection->id << ", job " << _job.id << ": " << audioSeconds << " seconds in " << result.renderSeconds << " seconds";
+		if(result.renderSeconds > 0.0)
+			ss << ", " << audioSeconds / result.renderSeconds << "x realtime";
+		if(!_info.warmDevice)
+			ss << ", device booted";
+		log(ss.str());
+
+		return true;
+	}
+
+	std::unique_ptr<RenderServer::PooledDevice> RenderServer::acquireDevice(const std::string& _rom, bool& _warm, std::string& _error)
+	{
+		std::unique_ptr<PooledDevice> evicted;
+
+		{
+			std::lock_guard lock(m_poolMutex);
+
+			auto& idle = m_pool[_rom];
+
+			if(!idle.empty())
+			{
+				auto d = std::move(idle.back());
+				idle.pop_back();
+				_warm = true;
+				return d;
+			}
+
+			// there are never more devices than workers. A worker that needs a new device does not hold one, so if the
+			// limit is reached there is an idle device for another ROM that can be replaced
+			if(m_deviceCount >= m_workerCount)
+			{
+				for (auto& it : m_pool)
+				{
+					if(it.second.empty())
+						continue;
+
+					evicted = std::move(it.second.back());
+					it.second.pop_back();
+					--m_deviceCount;
+					break;
+				}
+			}
+
+			++m_deviceCount;
+		}
+
+		// destroy outside of the lock, stopping the DSP threads takes a while
+		evicted.reset();
+
+		_warm = false;
+
+		const auto start = Clock::now();
+
+		auto d = std::make_unique<PooledDevice>();
+		d->device = m_factory.create(_rom, _error);
+
+		if(!d->device)
+		{
+			std::lock_guard lock(m_poolMutex);
+			--m_deviceCount;
+			return {};
+		}
+
+		d->device->getState(d->initialState, synthLib::StateTypeGlobal);
+		d->initialSamplerate = d->device->getSamplerate();
+
+		const auto bootSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		{
+			std::lock_guard lock(m_poolMutex);
+			++m_deviceBoots;
+			m_bootSeconds += bootSeconds;
+		}
+
+		log("Booted device for ROM '" + (_rom.empty() ? std::string("default") : _rom) + "' in " + std::to_string(bootSeconds) + " seconds");
+
+		return d;
+	}
+
+	void RenderServer::releaseDevice(const std::string& _rom, std::unique_ptr<PooledDevice> _device)
+	{
+		if(!_device)
+			return;
+
+		std::lock_guard lock(m_poolMutex);
+		m_pool[_rom].push_back(std::move(_device));
+	}
+
+	void RenderServer::log(const std::string& _message)
+	{
+		std::lock_guard lock(m_logMutex);
+		std::cout << _message << std::endl;
+	}
+}
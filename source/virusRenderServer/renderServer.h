@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "protocol.h"
+#include "socket.h"
+
+namespace synthLib
+{
+	class Device;
+	class MidiFileRenderer;
+}
+
+namespace virusRenderServer
+{
+	class DeviceFactory
+	{
+	public:
+		virtual ~DeviceFactory() = default;
+
+		// Boots a device for the given ROM. Returns nullptr and sets _error on failure. Called from multiple threads
+		virtual std::unique_ptr<synthLib::Device> create(const std::string& _rom, std::string& _error) = 0;
+
+		// events that are sent to the device before the input of a job, for example to select a play mode
+		virtual void getSetupEvents(std::vector<synthLib::SMidiEvent>& _events, uint16_t _channelMask) {}
+	};
+
+	// Renders jobs that are received via a UNIX domain socket. Each worker thread renders one job at a time on a
+	// device that it takes from a pool of booted devices. Devices are returned to the pool afterwards and are only
+	// destroyed if a device for another ROM is needed, so that jobs do not pay for booting the DSP. The global state of
+	// a device is replaced for each job and the device renders silence until the previous job has decayed, it is not
+	// rebooted though, which means that free running modulation such as LFOs carries over from one job to the next
+	class RenderServer
+	{
+	public:
+		RenderServer(DeviceFactory& _factory, uint32_t _workerCount);
+		RenderServer(const RenderServer&) = delete;
+		RenderServer& operator = (const RenderServer&) = delete;
+		~RenderServer();
+
+		bool listen(const std::string& _socketPath);
+
+		// accepts connections and processes jobs until _quit is set
+		void run(const std::atomic<bool>& _quit);
+
+		ServerStats getStats();
+
+		static uint32_t getDefaultWorkerCount();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Connection
+		{
+			explicit Connection(const int _fd, const uint32_t _id) : socket(_fd), id(_id) {}
+
+			Socket socket;
+			const uint32_t id;
+			std::thread thread;
+			std::atomic<bool> finished{false};
+		};
+
+		struct Job
+		{
+			std::shared_ptr<Connection> connection;
+			uint32_t id = 0;
+			RenderRequest request;
+			Clock::time_point queued;
+		};
+
+		struct PooledDevice
+		{
+			std::unique_ptr<synthLib::Device> device;
+			std::vector<uint8_t> initialState;	// global state after boot, restored for jobs that do not provide one
+			float initialSamplerate = 0.0f;
+		};
+
+		void connectionThread(const std::shared_ptr<Connection>& _connection);
+		void workerThread();
+
+		bool renderJob(const Job& _job, std::string& _error);
+		bool render(const Job& _job, const synthLib::MidiFileRenderer& _renderer, PooledDevice& _device, RenderInfo& _info, std::string& _error);
+
+		std::unique_ptr<PooledDevice> acquireDevice(const std::string& _rom, bool& _warm, std::string& _error);
+		void releaseDevice(const std::string& _rom, std::unique_ptr<PooledDevice> _device);
+
+		void log(const std::string& _message);
+
+		DeviceFactory& m_factory;
+		const uint32_t m_workerCount;
+		const Clock::time_point m_startTime;
+
+		Socket m_socket;
+
+		// job queue and statistics
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<Job> m_queue;
+		bool m_quit = false;
+		uint32_t m_activeJobs = 0;
+		uint64_t m_completedJobs = 0;
+		uint64_t m_failedJobs = 0;
+		double m_audioSeconds = 0.0;
+		double m_renderSeconds = 0.0;
+		double m_queueSeconds = 0.0;
+
+		// idle devices per ROM
+		std::mutex m_poolMutex;
+		std::map<std::string, std::vector<std::unique_ptr<PooledDevice>>> m_pool;
+		uint32_t m_deviceCount = 0;
+		uint64_t m_deviceBoots = 0;
+		double m_bootSeconds = 0.0;
+
+		std::vector<std::shared_ptr<Connection>> m_connections;	// protected by m_mutex
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_logMutex;
+	};
+}
@@ -0,0 +1,239 @@
+#include "socket.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../synthLib/binarystream.h"
+
+namespace virusRenderServer
+{
+	namespace
+	{
+		constexpr size_t g_headerSize = 12;
+
+#ifdef MSG_NOSIGNAL
+		constexpr int g_sendFlags = MSG_NOSIGNAL;
+#else
+		constexpr int g_sendFlags = 0;		// SIGPIPE needs to be ignored by the process
+#endif
+
+		bool createAddress(sockaddr_un& _addr, const std::string& _path, std::string& _error)
+		{
+			memset(&_addr, 0, sizeof(_addr));
+			_addr.sun_family = AF_UNIX;
+
+			if(_path.empty() || _path.size() >= sizeof(_addr.sun_path))
+			{
+				_error = "Invalid socket path " + _path;
+				return false;
+			}
+
+			memcpy(_addr.sun_path, _path.c_str(), _path.size());
+			return true;
+		}
+
+		std::string errorString(const std::string& _what)
+		{
+			return _what + ": " + strerror(errno);
+		}
+	}
+
+	Socket::~Socket()
+	{
+		close();
+	}
+
+	bool Socket::listen(const std::string& _path)
+	{
+		sockaddr_un addr{};
+		if(!createAddress(addr, _path, m_error))
+			return false;
+
+		// a socket file that is left over from a server that has not been shut down properly prevents binding, remove
+		// it unless another server is still accepting connections on it
+		{
+			Socket probe;
+			if(probe.connect(_path))
+			{
+				m_error = "Another server is already listening on " + _path;
+				return false;
+			}
+			::unlink(_path.c_str());
+		}
+
+		m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if(m_fd < 0)
+		{
+			m_error = errorString("Failed to create socket");
+			return false;
+		}
+
+		if(::bind(m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+		{
+			m_error = errorString("Failed to bind socket to " + _path);
+			close();
+			return false;
+		}
+
+		m_path = _path;
+
+		if(::listen(m_fd, SOMAXCONN) != 0)
+		{
+			m_error = errorString("Failed to listen on " + _path);
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Socket::connect(const std::string& _path)
+	{
+		sockaddr_un addr{};
+		if(!createAddress(addr, _path, m_error))
+			return false;
+
+		m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if(m_fd < 0)
+		{
+			m_error = errorString("Failed to create socket");
+			return false;
+		}
+
+		if(::connect(m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+		{
+			m_error = errorString("Failed to connect to " + _path);
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	int Socket::accept(const uint32_t _timeoutMs) const
+	{
+		pollfd pfd{};
+		pfd.fd = m_fd;
+		pfd.events = POLLIN;
+
+		if(::poll(&pfd, 1, static_cast<int>(_timeoutMs)) <= 0 || !(pfd.revents & POLLIN))
+			return -1;
+
+		return ::accept(m_fd, nullptr, nullptr);
+	}
+
+	bool Socket::send(const MessageType _type, const uint32_t _job, const std::vector<uint8_t>& _payload)
+	{
+		if(_payload.size() > MaxPayloadSize)
+			return false;
+
+		uint8_t header[g_headerSize];
+
+		const auto type = static_cast<uint32_t>(_type);
+		const auto size = static_cast<uint32_t>(_payload.size());
+
+		memcpy(&header[0], &type, 4);
+		memcpy(&header[4], &_job, 4);
+		memcpy(&header[8], &size, 4);
+
+		// header and payload must not be interleaved with frames that are sent by other threads
+		std::lock_guard lock(m_sendMutex);
+
+		return sendAll(header, sizeof(header)) && (_payload.empty() || sendAll(_payload.data(), _payload.size()));
+	}
+
+	bool Socket::send(const MessageType _type, const uint32_t _job, const std::string& _message)
+	{
+		synthLib::BinaryStream s;
+		s.write(_message);
+
+		std::vector<uint8_t> payload;
+		s.toVector(payload);
+
+		return send(_type, _job, payload);
+	}
+
+	bool Socket::receive(Frame& _frame) const
+	{
+		uint8_t header[g_headerSize];
+
+		if(!receiveAll(header, sizeof(header)))
+			return false;
+
+		uint32_t type, size;
+
+		memcpy(&type, &header[0], 4);
+		memcpy(&_frame.job, &header[4], 4);
+		memcpy(&size, &header[8], 4);
+
+		if(size > MaxPayloadSize)
+			return false;
+
+		_frame.type = static_cast<MessageType>(type);
+		_frame.payload.resize(size);
+
+		return !size || receiveAll(_frame.payload.data(), size);
+	}
+
+	void Socket::shutdown() const
+	{
+		if(m_fd >= 0)
+			::shutdown(m_fd, SHUT_RDWR);
+	}
+
+	bool Socket::sendAll(const uint8_t* _data, size_t _size) const
+	{
+		while(_size > 0)
+		{
+			const auto res = ::send(m_fd, _data, _size, g_sendFlags);
+
+			if(res < 0 && errno == EINTR)
+				continue;
+			if(res <= 0)
+				return false;
+
+			_data += res;
+			_size -= static_cast<size_t>(res);
+		}
+		return true;
+	}
+
+	bool Socket::receiveAll(uint8_t* _data, size_t _size) const
+	{
+		while(_size > 0)
+		{
+			const auto res = ::recv(m_fd, _data, _size, 0);
+
+			if(res < 0 && errno == EINTR)
+				continue;
+			if(res <= 0)
+				return false;
+
+			_data += res;
+			_size -= static_cast<size_t>(res);
+		}
+		return true;
+	}
+
+	void Socket::close()
+	{
+		if(m_fd < 0)
+			return;
+
+		::close(m_fd);
+		m_fd = -1;
+
+		if(!m_path.empty())
+		{
+			::unlink(m_path.c_str());
+			m_path.clear();
+		}
+	}
+}
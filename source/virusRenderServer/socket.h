@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+namespace virusRenderServer
+{
+	// Stream socket in the UNIX domain that transfers frames. Sending is thread safe, one thread may receive while
+	// others are sending
+	class Socket
+	{
+	public:
+		Socket() = default;
+		explicit Socket(int _fd) : m_fd(_fd) {}
+		Socket(const Socket&) = delete;
+		Socket& operator = (const Socket&) = delete;
+		~Socket();
+
+		bool listen(const std::string& _path);
+		bool connect(const std::string& _path);
+
+		// Waits up to _timeoutMs for a client, returns -1 if there is none. The returned descriptor is owned by the caller
+		int accept(uint32_t _timeoutMs) const;
+
+		bool send(MessageType _type, uint32_t _job, const std::vector<uint8_t>& _payload = {});
+		bool send(MessageType _type, uint32_t _job, const std::string& _message);
+		bool receive(Frame& _frame) const;
+
+		// unblocks a thread that is waiting in receive, the socket is closed when it is destroyed
+		void shutdown() const;
+
+		bool isValid() const { return m_fd >= 0; }
+		const std::string& getError() const { return m_error; }
+
+	private:
+		bool sendAll(const uint8_t* _data, size_t _size) const;
+		bool receiveAll(uint8_t* _data, size_t _size) const;
+		void close();
+
+		int m_fd = -1;
+		std::string m_path;		// removed when a listening socket is closed
+		std::string m_error;
+		std::mutex m_sendMutex;
+	};
+}
@@ -0,0 +1,60 @@
+#include "virusDeviceFactory.h"
+
+#include "../synthLib/deviceException.h"
+
+#include "../virusLib/device.h"
+#include "../virusLib/romloader.h"
+
+namespace virusRenderServer
+{
+	std::unique_ptr<synthLib::Device> VirusDeviceFactory::create(const std::string& _rom, std::string& _error)
+	{
+		const auto* rom = findROM(_rom);
+
+		if(!rom)
+		{
+			_error = _rom.empty() ? std::string("No valid ROM found") : "Failed to find ROM " + _rom;
+			return {};
+		}
+
+		try
+		{
+			return std::make_unique<virusLib::Device>(*rom, 0.0f, static_cast<float>(rom->getSamplerate()));
+		}
+		catch(const synthLib::DeviceException& _e)
+		{
+			_error = std::string("Failed to create device: ") + _e.what();
+			return {};
+		}
+	}
+
+	void VirusDeviceFactory::getSetupEvents(std::vector<synthLib::SMidiEvent>& _events, const uint16_t _channelMask)
+	{
+		// input that uses multiple channels is played in Multi mode, same as in ConsoleApp::renderMidiFile
+		if(!(_channelMask & ~1u))
+			return;
+
+		auto& ev = _events.emplace_back();
+		ev.sysex = {synthLib::M_STARTOFSYSEX, 0x00, 0x20, 0x33, 0x01, virusLib::OMNI_DEVICE_ID, virusLib::PAGE_C, 0x00, virusLib::PLAY_MODE, virusLib::PlayModeMulti, synthLib::M_ENDOFSYSEX};
+	}
+
+	const virusLib::ROMFile* VirusDeviceFactory::findROM(const std::string& _rom)
+	{
+		std::lock_guard lock(m_mutex);
+
+		auto it = m_roms.find(_rom);
+
+		if(it == m_roms.end())
+		{
+			auto rom = _rom.empty() ? virusLib::ROMLoader::findROM() : virusLib::ROMLoader::findROM(_rom);
+
+			// failed lookups are not remembered, the ROM might be copied to the search path later
+			if(!rom.isValid())
+				return nullptr;
+
+			it = m_roms.insert({_rom, std::move(rom)}).first;
+		}
+
+		return &it->second;
+	}
+}
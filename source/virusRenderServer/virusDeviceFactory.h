@@ -0,0 +1,25 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+
+#include "renderServer.h"
+
+#include "../virusLib/romfile.h"
+
+namespace virusRenderServer
+{
+	// Creates Virus devices. ROMs are searched once per name and kept in memory afterwards
+	class VirusDeviceFactory : public DeviceFactory
+	{
+	public:
+		std::unique_ptr<synthLib::Device> create(const std::string& _rom, std::string& _error) override;
+		void getSetupEvents(std::vector<synthLib::SMidiEvent>& _events, uint16_t _channelMask) override;
+
+	private:
+		const virusLib::ROMFile* findROM(const std::string& _rom);
+
+		std::mutex m_mutex;
+		std::map<std::string, virusLib::ROMFile> m_roms;
+	};
+}
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iostream>
+
+#include "renderClient.h"
+#include "renderServer.h"
+#include "virusDeviceFactory.h"
+
+#include "../gearmulatorBench/jsonWriter.h"
+
+#include "../synthLib/os.h"
+
+#include "../dsp56300/source/disassemble/commandline.h"
+
+namespace
+{
+	const char* const g_defaultSocket = "/tmp/virusRenderServer.sock";
+
+	std::atomic<bool> g_quit{false};
+
+	void printUsage()
+	{
+		std::cout << "Usage:" << std::endl;
+		std::cout << "  virusRenderServer [-socket path] [-jobs n]" << std::endl;
+		std::cout << "      Runs the server. Devices are booted on demand and kept running for subsequent jobs" << std::endl;
+		std::cout << "  virusRenderServer [-socket path] -midi file.mid -out file.wav [-rom file] [-state file] [-format int16|int24|float32] [-samplerate n] [-channels n] [-tail seconds]" << std::endl;
+		std::cout << "      Renders a MIDI file on a running server" << std::endl;
+		std::cout << "  virusRenderServer [-socket path] -stats [-json]" << std::endl;
+		std::cout << "      Prints queue and throughput statistics of a running server" << std::endl;
+		std::cout << "The default socket is " << g_defaultSocket << std::endl;
+	}
+
+	void onSignal(int)
+	{
+		g_quit = true;
+	}
+
+	void writeJson(const virusRenderServer::ServerStats& _stats)
+	{
+		{
+			bench::JsonWriter json(std::cout);
+
+			json.beginObject();
+			json.add("uptimeSeconds", _stats.uptimeSeconds);
+			json.add("workers", _stats.workers);
+			json.add("connections", _stats.connections);
+
+			json.beginObject("jobs");
+			json.add("queued", _stats.queuedJobs);
+			json.add("active", _stats.activeJobs);
+			json.add("completed", _stats.completedJobs);
+			json.add("failed", _stats.failedJobs);
+			json.add("averageQueueSeconds", _stats.getAverageQueueSeconds());
+			json.endObject();
+
+			json.beginObject("devices");
+			json.add("booted", _stats.devices);
+			json.add("idle", _stats.idleDevices);
+			json.add("boots", _stats.deviceBoots);
+			json.add("bootSeconds", _stats.bootSeconds);
+			json.endObject();
+
+			json.beginObject("throughput");
+			json.add("audioSeconds", _stats.audioSeconds);
+			json.add("renderSeconds", _stats.renderSeconds);
+			json.add("realtimeFactor", _stats.getRealtimeFactor());
+			json.add("jobsPerSecond", _stats.getJobsPerSecond());
+			json.endObject();
+
+			json.endObject();
+		}
+		std::cout << std::endl;
+	}
+
+	int runServer(const CommandLine& _cmd, const std::string& _socket)
+	{
+		const auto jobs = _cmd.contains("jobs") ? static_cast<uint32_t>(std::max(1, _cmd.getInt("jobs"))) : virusRenderServer::RenderServer::getDefaultWorkerCount();
+
+		std::signal(SIGINT, onSignal);
+		std::signal(SIGTERM, onSignal);
+
+		virusRenderServer::VirusDeviceFactory factory;
+		virusRenderServer::RenderServer server(factory, jobs);
+
+		if(!server.listen(_socket))
+			return -1;
+
+		server.run(g_quit);
+
+		std::cout << "Shutting down" << std::endl << server.getStats().toString();
+		return 0;
+	}
+
+	int runStats(const CommandLine& _cmd, const std::string& _socket)
+	{
+		virusRenderServer::RenderClient client;
+		virusRenderServer::ServerStats stats;
+
+		if(!client.connect(_socket) || !client.getStats(stats))
+		{
+			std::cout << client.getError() << std::endl;
+			return -1;
+		}
+
+		if(_cmd.contains("json"))
+			writeJson(stats);
+		else
+			std::cout << stats.toString();
+
+		return 0;
+	}
+
+	int runClient(const CommandLine& _cmd, const std::string& _socket)
+	{
+		if(!_cmd.contains("out"))
+		{
+			printUsage();
+			return -1;
+		}
+
+		virusRenderServer::RenderRequest request;
+
+		request.inputType = virusRenderServer::InputType::MidiFile;
+
+		if(!synthLib::readFile(request.midiFile, _cmd.get("midi")))
+		{
+			std::cout << "Failed to read MIDI file " << _cmd.get("midi") << std::endl;
+			return -1;
+		}
+
+		if(_cmd.contains("state") && !synthLib::readFile(request.state, _cmd.get("state")))
+		{
+			std::cout << "Failed to read state file " << _cmd.get("state") << std::endl;
+			return -1;
+		}
+
+		if(_cmd.contains("format") && !virusRenderServer::parseSampleFormat(request.format, _cmd.get("format")))
+		{
+			std::cout << "Unsupported sample format " << _cmd.get("format") << std::endl;
+			return -1;
+		}
+
+		if(_cmd.contains("rom"))		request.rom = _cmd.get("rom");
+		if(_cmd.contains("samplerate"))	request.samplerate = std::max(0.0f, _cmd.getFloat("samplerate"));
+		if(_cmd.contains("channels"))	request.channelCount = static_cast<uint32_t>(std::max(1, _cmd.getInt("channels")));
+		if(_cmd.contains("tail"))		request.tailSeconds = std::max(0.0f, _cmd.getFloat("tail"));
+
+		virusRenderServer::RenderClient client;
+		virusRenderServer::RenderResult result;
+
+		if(!client.connect(_socket) || !client.render(request, _cmd.get("out"), &result))
+		{
+			std::cout << client.getError() << std::endl;
+			return -1;
+		}
+
+		std::cout << "Rendered " << result.frameCount << " frames to " << _cmd.get("out") << " in " << result.renderSeconds << " seconds" << std::endl;
+		return 0;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	// writing to a socket of a client that has disconnected must not terminate the process
+	std::signal(SIGPIPE, SIG_IGN);
+
+	try
+	{
+		const CommandLine cmd(_argc, _argv);
+
+		if(cmd.contains("help"))
+		{
+			printUsage();
+			return 0;
+		}
+
+		const auto socket = cmd.contains("socket") ? cmd.get("socket") : std::string(g_defaultSocket);
+
+		if(cmd.contains("stats"))
+			return runStats(cmd, socket);
+
+		if(cmd.contains("midi"))
+			return runClient(cmd, socket);
+
+		return runServer(cmd, socket);
+	}
+	catch(const std::exception& _e)
+	{
+		std::cout << _e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,235 @@
+#include <fstream>
+#include <iostream>
+
+#include "../gearmulatorBench/scenarios.h"
+
+#include "../synthLib/deviceException.h"
+#include "../synthLib/os.h"
+#include "../synthLib/plugin.h"
+#include "../synthLib/rtAudit.h"
+
+#include "../virusLib/device.h"
+#include "../virusLib/romloader.h"
+
+#include "../dsp56300/source/disassemble/commandline.h"
+
+namespace
+{
+	constexpr float g_samplerate = 44100.0f;
+	constexpr uint32_t g_blockSize = 128;
+
+	void render(synthLib::Plugin& _plugin, const bench::Scenario* _scenario, const double _seconds)
+	{
+		std::vector<float> outL(g_blockSize), outR(g_blockSize);
+
+		synthLib::TAudioInputs inputs{};
+		synthLib::TAudioOutputs outputs{};
+
+		outputs[0] = outL.data();
+		outputs[1] = outR.data();
+
+		std::vector<synthLib::SMidiEvent> midiOut;
+
+		const auto totalSamples = static_cast<uint64_t>(_seconds * static_cast<double>(g_samplerate));
+
+		size_t nextEvent = 0;
+
+		for(uint64_t pos = 0; pos < totalSamples; pos += g_blockSize)
+		{
+			if(_scenario)
+			{
+				const auto& events = _scenario->events;
+
+				while(nextEvent < events.size())
+				{
+					const auto& e = events[nextEvent];
+					const auto samplePos = static_cast<uint64_t>(e.time * static_cast<double>(g_samplerate));
+
+					if(samplePos >= pos + g_blockSize)
+						break;
+
+					auto ev = e.event;
+					ev.offset = samplePos > pos ? static_cast<uint32_t>(samplePos - pos) : 0;
+					_plugin.addMidiEvent(ev);
+
+					++nextEvent;
+				}
+			}
+
+			_plugin.process(inputs, outputs, g_blockSize, 0.0f, 0.0f, false);
+			_plugin.getMidiOut(midiOut);
+		}
+	}
+
+	bool loadSuppressions(std::vector<std::string>& _suppressions, const std::string& _filename)
+	{
+		std::ifstream ss(_filename, std::ios::in);
+
+		if(!ss.is_open())
+			return false;
+
+		std::string line;
+
+		while(std::getline(ss, line))
+		{
+			while(!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+				line.pop_back();
+
+			if(line.empty() || line.front() == '#')
+				continue;
+
+			_suppressions.push_back(line);
+		}
+		return true;
+	}
+
+	int runTest(const virusLib::ROMFile& _rom, const std::vector<std::string>& _scenarios, const double _seconds, const std::vector<std::string>& _suppressions)
+	{
+		std::cout << "Testing ROM " << _rom.getFilename() << std::endl;
+
+		std::unique_ptr<virusLib::Device> device;
+
+		try
+		{
+			device.reset(new virusLib::Device(_rom, 0.0f, g_samplerate));
+		}
+		catch(const synthLib::DeviceException& _e)
+		{
+			std::cout << "Failed to boot device: " << _e.what() << std::endl;
+			return -1;
+		}
+
+		synthLib::Plugin plugin(device.get());
+
+		plugin.setHostSamplerate(g_samplerate, 0.0f);
+		plugin.setBlockSize(g_blockSize);
+
+		// buffers and queues grow to their final size during the first blocks, these allocations are expected
+		synthLib::RtAudit::setActive(false);
+		render(plugin, nullptr, 1.0);
+
+		synthLib::RtAudit::clear();
+		synthLib::RtAudit::setActive(true);
+
+		for (const auto& name : _scenarios)
+		{
+			bench::Scenario scenario;
+
+			if(!bench::createScenario(scenario, name, _seconds))
+			{
+				std::cout << "Unknown scenario '" << name << "'" << std::endl;
+				synthLib::RtAudit::setActive(false);
+				return -1;
+			}
+
+			std::cout << "Running scenario " << scenario.name << std::endl;
+
+			render(plugin, &scenario, _seconds);
+		}
+
+		synthLib::RtAudit::setActive(false);
+
+		const auto count = synthLib::RtAudit::writeReports(std::cout, _suppressions);
+
+		if(count > 0)
+		{
+			std::cout << "Found " << count << " real-time safety violations" << std::endl;
+			return -1;
+		}
+
+		std::cout << "No real-time safety violations found" << std::endl;
+		return 0;
+	}
+
+	std::vector<std::string> findRoms(const std::string& _folder)
+	{
+		std::vector<std::string> roms;
+
+		std::vector<std::string> subfolders;
+		synthLib::getDirectoryEntries(subfolders, _folder);
+
+		for (const auto& subfolder : subfolders)
+		{
+			if(subfolder.find("/.") != std::string::npos)
+				continue;
+
+			std::vector<std::string> files;
+			synthLib::getDirectoryEntries(files, subfolder);
+
+			for (const auto& file : files)
+			{
+				if(synthLib::hasExtension(file, ".bin"))
+				{
+					roms.push_back(file);
+					break;
+				}
+			}
+		}
+		return roms;
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	if constexpr (!synthLib::RtAudit::Enabled)
+	{
+		std::cout << "Real-time safety audit is not compiled in, configure with SYNTHLIB_RT_AUDIT=ON" << std::endl;
+		return -1;
+	}
+
+	const CommandLine cmd(_argc, _argv);
+
+	std::vector<std::string> suppressions;
+
+	if(cmd.contains("suppressions") && !loadSuppressions(suppressions, cmd.get("suppressions")))
+	{
+		std::cout << "Failed to load suppressions from " << cmd.get("suppressions") << std::endl;
+		return -1;
+	}
+
+	synthLib::RtAudit::setStrictLocking(cmd.contains("strict"));
+
+	const auto seconds = cmd.contains("seconds") ? static_cast<double>(cmd.getInt("seconds")) : 5.0;
+	const auto scenarios = bench::getScenarioNames();
+
+	std::vector<std::string> romFiles;
+
+	if(cmd.contains("rom"))
+	{
+		romFiles.push_back(cmd.get("rom"));
+	}
+	else if(cmd.contains("folder"))
+	{
+		romFiles = findRoms(cmd.get("folder"));
+
+		if(romFiles.empty())
+		{
+			std::cout << "No ROMs found for testing in folder " << cmd.get("folder") << std::endl;
+			return -1;
+		}
+	}
+	else
+	{
+		std::cout << "Usage: virusRtSafetyTest [-rom file | -folder folder] [-suppressions file] [-seconds n] [-strict]" << std::endl;
+		return -1;
+	}
+
+	for (const auto& romFile : romFiles)
+	{
+		const auto rom = virusLib::ROMLoader::findROM(romFile);
+
+		if(!rom.isValid())
+		{
+			// TI firmwares are not supported, same as in the integration tests
+			std::cout << "Ignoring " << romFile << ", not a supported ROM" << std::endl;
+			continue;
+		}
+
+		const auto res = runTest(rom, scenarios, seconds, suppressions);
+
+		if(res)
+			return res;
+	}
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+include(${CMAKE_CURRENT_LIST_DIR}/../../scripts/rclone.cmake)
+
+set(TEST_DATA_DIR integrationTestsData)
+
+if(EXISTS ${RCLONE_CONF})
+	copyDataFrom("integrationtests" ${TEST_DATA_DIR})
+
+	execute_process(COMMAND ${TEST_RUNNER} -folder ${TEST_DATA_DIR} -suppressions ${SUPPRESSIONS} COMMAND_ECHO STDOUT RESULT_VARIABLE TEST_RESULT)
+	if(TEST_RESULT)
+		message(FATAL_ERROR "Real-time safety test failed: " ${TEST_RESULT})
+	endif()
+else()
+	message(FATAL_ERROR "rclone.conf not found at ${RCLONE_CONF}, unable to run real-time safety tests")
+endif()
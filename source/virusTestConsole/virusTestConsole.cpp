@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 
 #include "../virusConsoleLib/consoleApp.h"
@@ -6,14 +7,45 @@
 #include "dsp56kEmu/interpreterunittests.h"
 
 #include "../synthLib/os.h"
+#include "../synthLib/renderCache.h"
 
 constexpr bool g_createDebugger = false;
 constexpr bool g_dumpAssembly = false;
 
+// one bit per DSP output, 0x3f captures all six outputs
+constexpr uint8_t g_captureOutputs = 0x03;
+// write all captured outputs to one multichannel file instead of one file per stereo pair
+constexpr bool g_captureMultichannel = false;
+
+// MIDI files that have been rendered before are served from a cache next to the executable
+constexpr bool g_useRenderCache = false;
+
+// output that is discarded after seeking in a demo, the device needs some time to process the replayed presets
+constexpr float g_demoFastForwardSeconds = 1.0f;
+
 using namespace dsp56k;
 using namespace virusLib;
 using namespace synthLib;
 
+static int renderSong(const ConsoleApp& _app, const std::string& _midiFile)
+{
+	auto name = getFilenameWithoutPath(_midiFile);
+	name = name.substr(0, name.size() - 4);
+
+	const RenderCache cache(RenderCache::getDefaultFolder());
+
+	if(!_app.renderMidiFile(_midiFile, "virusEmu_" + name + ".wav", g_useRenderCache ? &cache : nullptr))
+	{
+		std::cout << "Failed to render MIDI file '" << _midiFile << "', make sure that it is a valid Standard MIDI File" << std::endl;
+		ConsoleApp::waitReturn();
+		return -1;
+	}
+
+	std::cout << "Program ended. Press key to exit." << std::endl;
+	ConsoleApp::waitReturn();
+	return 0;
+}
+
 int main(int _argc, char* _argv[])
 {
 	if constexpr(true)
@@ -46,7 +78,13 @@ int main(int _argc, char* _argv[])
 	if(_argc > 1)
 	{
 		const std::string name = _argv[1];
-		if(hasExtension(name, ".mid") || hasExtension(name, ".bin"))
+		if(hasExtension(name, ".mid"))
+		{
+			// MIDI files either contain a demo song or a regular song that is rendered via the device
+			if(!app->loadDemo(name))
+				return renderSong(*app, name);
+		}
+		else if(hasExtension(name, ".bin"))
 		{
 			if(!app->loadDemo(name))
 			{
@@ -77,8 +115,13 @@ int main(int _argc, char* _argv[])
 			app->loadSingle(0, 0);
 	}
 
+	// demos can be started at a later position: <demo> <seek seconds> [fast forward seconds]
+	if(_argc > 2)
+		app->setDemoStart(std::strtof(_argv[2], nullptr), _argc > 3 ? std::strtof(_argv[3], nullptr) : g_demoFastForwardSeconds);
+
 	const std::string audioFilename = app->getSingleNameAsFilename();
 
+	app->setOutputCapture(g_captureOutputs, g_captureMultichannel);
 	app->run(audioFilename, 0, g_createDebugger, g_dumpAssembly);
 
 	std::cout << "Program ended. Press key to exit." << std::endl;